@@ -0,0 +1,2416 @@
+#include "TestMocks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdio.h>
+
+using namespace DXL;
+using namespace DXLTests;
+
+// == Test framework =====================================================
+
+struct TestCase
+{
+    const char* Name = nullptr;
+    void (*Function)() = nullptr;
+};
+
+static std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, void (*function)())
+    {
+        GetTestCases().push_back({ .Name = name, .Function = function });
+    }
+};
+
+#define DXL_TEST(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name); \
+    static void name()
+
+static uint32_t numFailedChecks = 0;
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            printf("%s(%d): Check failed: %s\n", __FILE__, __LINE__, #cond); \
+            numFailedChecks += 1; \
+        } \
+    } while(0)
+
+// Errors reported through DXL's error callback instead of hitting a breakpoint. A test fails if it reports errors that
+// it didn't take.
+static uint32_t numReportedErrors = 0;
+
+static void RecordError(const char* function, HRESULT hr, const char* message)
+{
+    printf("    Error reported by '%s' (HRESULT 0x%x): %s\n", function, uint32_t(hr), message);
+    numReportedErrors += 1;
+}
+
+static uint32_t TakeReportedErrors()
+{
+    const uint32_t numErrors = numReportedErrors;
+    numReportedErrors = 0;
+    return numErrors;
+}
+
+template<typename T> static T* FakePointer(uintptr_t value)
+{
+    return reinterpret_cast<T*>(value);
+}
+
+// == Barrier batching =====================================================
+
+static D3D12_GLOBAL_BARRIER MakeGlobalBarrier()
+{
+    return
+    {
+        .SyncBefore = D3D12_BARRIER_SYNC_COMPUTE_SHADING,
+        .SyncAfter = D3D12_BARRIER_SYNC_COMPUTE_SHADING,
+        .AccessBefore = D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+        .AccessAfter = D3D12_BARRIER_ACCESS_UNORDERED_ACCESS,
+    };
+}
+
+static D3D12_BUFFER_BARRIER MakeBufferBarrier(uintptr_t resource)
+{
+    return
+    {
+        .SyncBefore = D3D12_BARRIER_SYNC_COPY,
+        .SyncAfter = D3D12_BARRIER_SYNC_ALL_SHADING,
+        .AccessBefore = D3D12_BARRIER_ACCESS_COPY_DEST,
+        .AccessAfter = D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+        .pResource = FakePointer<ID3D12Resource>(resource),
+        .Offset = 0,
+        .Size = UINT64_MAX,
+    };
+}
+
+static D3D12_TEXTURE_BARRIER MakeTextureBarrier(uintptr_t resource)
+{
+    return
+    {
+        .SyncBefore = D3D12_BARRIER_SYNC_RENDER_TARGET,
+        .SyncAfter = D3D12_BARRIER_SYNC_PIXEL_SHADING,
+        .AccessBefore = D3D12_BARRIER_ACCESS_RENDER_TARGET,
+        .AccessAfter = D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
+        .LayoutBefore = D3D12_BARRIER_LAYOUT_RENDER_TARGET,
+        .LayoutAfter = D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
+        .pResource = FakePointer<ID3D12Resource>(resource),
+        .Subresources = { .IndexOrFirstMipLevel = 0xFFFFFFFF },
+    };
+}
+
+// Creates a command list through IDXLDevice::CreateCommandList on a mock device, and gives back the recording
+// native command list behind it
+struct RecordingCommandListFixture
+{
+    MockDevice* Device = new MockDevice();
+    IDXLCommandList CommandList;
+    RecordingCommandList* Recording = nullptr;
+
+    RecordingCommandListFixture(DXL_COMMAND_LIST_FEATURE_FLAGS features)
+    {
+        CommandList = IDXLDevice(Device).CreateCommandList(D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE, features);
+        Recording = static_cast<RecordingCommandList*>(CommandList.ToNative());
+    }
+
+    ~RecordingCommandListFixture()
+    {
+        Release(CommandList);
+        Device->Release();
+    }
+};
+
+DXL_TEST(BarriersAreNotBatchedByDefault)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_DEFAULT);
+    fixture.CommandList.Barrier(MakeGlobalBarrier());
+    fixture.CommandList.Barrier(MakeBufferBarrier(0x1000));
+
+    CHECK(fixture.Recording->BarrierCalls.size() == 2);
+}
+
+DXL_TEST(BatchedBarriersFlushBeforeGPUWork)
+{
+    struct FlushPoint
+    {
+        const char* Call = nullptr;
+        void (*Record)(IDXLCommandList& commandList) = nullptr;
+    };
+
+    const FlushPoint flushPoints[] =
+    {
+        { "DrawInstanced", [](IDXLCommandList& commandList) { commandList.DrawInstanced(3, 1, 0, 0); } },
+        { "DrawIndexedInstanced", [](IDXLCommandList& commandList) { commandList.DrawIndexedInstanced(3, 1, 0, 0, 0); } },
+        { "Dispatch", [](IDXLCommandList& commandList) { commandList.Dispatch(1, 1, 1); } },
+        { "DispatchMesh", [](IDXLCommandList& commandList) { commandList.DispatchMesh(1, 1, 1); } },
+        { "CopyBufferRegion", [](IDXLCommandList& commandList) { commandList.CopyBufferRegion(IDXLResource(), 0, IDXLResource(), 0, 16); } },
+        { "CopyResource", [](IDXLCommandList& commandList) { commandList.CopyResource(IDXLResource(), IDXLResource()); } },
+        { "ResolveSubresource", [](IDXLCommandList& commandList) { commandList.ResolveSubresource(IDXLResource(), 0, IDXLResource(), 0, DXGI_FORMAT_R8G8B8A8_UNORM); } },
+        { "BeginQuery", [](IDXLCommandList& commandList) { commandList.BeginQuery(IDXLQueryHeap(), D3D12_QUERY_TYPE_OCCLUSION, 0); } },
+        { "EndQuery", [](IDXLCommandList& commandList) { commandList.EndQuery(IDXLQueryHeap(), D3D12_QUERY_TYPE_TIMESTAMP, 0); } },
+        { "ResolveQueryData", [](IDXLCommandList& commandList) { commandList.ResolveQueryData(IDXLQueryHeap(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 1, IDXLResource(), 0); } },
+        { "ExecuteIndirect", [](IDXLCommandList& commandList) { commandList.ExecuteIndirect(IDXLCommandSignature(), 1, IDXLResource(), 0, IDXLResource(), 0); } },
+        { "Close", [](IDXLCommandList& commandList) { commandList.Close(); } },
+    };
+
+    for (const FlushPoint& flushPoint : flushPoints)
+    {
+        RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS);
+        fixture.CommandList.Barrier(MakeTextureBarrier(0x1000));
+        fixture.CommandList.Barrier(MakeBufferBarrier(0x2000));
+        CHECK(fixture.Recording->Calls.empty());
+
+        flushPoint.Record(fixture.CommandList);
+
+        const std::vector<std::string> expected = { "Barrier", flushPoint.Call };
+        if (fixture.Recording->Calls != expected)
+            printf("    Barriers weren't flushed before %s\n", flushPoint.Call);
+        CHECK(fixture.Recording->Calls == expected);
+    }
+}
+
+DXL_TEST(BatchedBarriersKeepSubmissionOrder)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS);
+    fixture.CommandList.Barrier(MakeTextureBarrier(0x1000));
+    fixture.CommandList.Barrier(MakeGlobalBarrier());
+    fixture.CommandList.Barrier(MakeBufferBarrier(0x2000));
+    fixture.CommandList.Barrier(MakeBufferBarrier(0x3000));
+    fixture.CommandList.Barrier(MakeTextureBarrier(0x4000));
+    fixture.CommandList.FlushBarriers();
+
+    CHECK(fixture.Recording->BarrierCalls.size() == 1);
+    if (fixture.Recording->BarrierCalls.size() != 1)
+        return;
+
+    const std::vector<RecordingCommandList::BarrierGroup>& groups = fixture.Recording->BarrierCalls[0];
+    CHECK(groups.size() == 4);
+    if (groups.size() != 4)
+        return;
+
+    CHECK(groups[0].Type == D3D12_BARRIER_TYPE_TEXTURE);
+    CHECK(groups[0].TextureBarriers.size() == 1 && groups[0].TextureBarriers[0].pResource == FakePointer<ID3D12Resource>(0x1000));
+    CHECK(groups[1].Type == D3D12_BARRIER_TYPE_GLOBAL);
+    CHECK(groups[1].GlobalBarriers.size() == 1);
+    CHECK(groups[2].Type == D3D12_BARRIER_TYPE_BUFFER);
+    CHECK(groups[2].BufferBarriers.size() == 2 && groups[2].BufferBarriers[0].pResource == FakePointer<ID3D12Resource>(0x2000));
+    CHECK(groups[2].BufferBarriers.size() == 2 && groups[2].BufferBarriers[1].pResource == FakePointer<ID3D12Resource>(0x3000));
+    CHECK(groups[3].Type == D3D12_BARRIER_TYPE_TEXTURE);
+    CHECK(groups[3].TextureBarriers.size() == 1 && groups[3].TextureBarriers[0].pResource == FakePointer<ID3D12Resource>(0x4000));
+
+    // Nothing left to flush
+    fixture.CommandList.FlushBarriers();
+    CHECK(fixture.Recording->BarrierCalls.size() == 1);
+}
+
+DXL_TEST(BatchedBarriersOnTheSameResourceStayOrdered)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS);
+    fixture.CommandList.Barrier(MakeBufferBarrier(0x1000));
+    fixture.CommandList.Barrier(MakeGlobalBarrier());
+    fixture.CommandList.Barrier(MakeBufferBarrier(0x1000));
+    fixture.CommandList.Dispatch(1, 1, 1);
+
+    const std::vector<std::string> expected = { "Barrier", "Barrier", "Dispatch" };
+    CHECK(fixture.Recording->Calls == expected);
+    CHECK(fixture.Recording->BarrierCalls.size() == 2);
+    if (fixture.Recording->BarrierCalls.size() != 2)
+        return;
+
+    // The global barrier recorded in between stays in the first call, ahead of the second barrier on the buffer
+    const std::vector<RecordingCommandList::BarrierGroup>& firstCall = fixture.Recording->BarrierCalls[0];
+    CHECK(firstCall.size() == 2 && firstCall[0].Type == D3D12_BARRIER_TYPE_BUFFER && firstCall[1].Type == D3D12_BARRIER_TYPE_GLOBAL);
+    CHECK(fixture.Recording->BarrierCalls[1].size() == 1);
+}
+
+DXL_TEST(WrappersOfTheSameCommandListShareBatchedBarriers)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS);
+
+    // A wrapper made from the native list batches into the same pending list as the one CreateCommandList returned
+    IDXLCommandList wrapped(fixture.CommandList.ToNative());
+    wrapped.Barrier(MakeBufferBarrier(0x1000));
+    fixture.CommandList.Barrier(MakeTextureBarrier(0x2000));
+    CHECK(fixture.Recording->Calls.empty());
+
+    // A second barrier on the buffer through the other wrapper still goes after the first one
+    fixture.CommandList.Barrier(MakeBufferBarrier(0x1000));
+    wrapped.Dispatch(1, 1, 1);
+
+    const std::vector<std::string> expected = { "Barrier", "Barrier", "Dispatch" };
+    CHECK(fixture.Recording->Calls == expected);
+    CHECK(fixture.Recording->BarrierCalls.size() == 2);
+    if (fixture.Recording->BarrierCalls.size() != 2)
+        return;
+
+    const std::vector<RecordingCommandList::BarrierGroup>& firstCall = fixture.Recording->BarrierCalls[0];
+    CHECK(firstCall.size() == 2 && firstCall[0].Type == D3D12_BARRIER_TYPE_BUFFER && firstCall[1].Type == D3D12_BARRIER_TYPE_TEXTURE);
+    CHECK(fixture.Recording->BarrierCalls[1].size() == 1);
+}
+
+DXL_TEST(WrappersOfPlainCommandListsDontBatch)
+{
+    RecordingCommandList* native = new RecordingCommandList(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    IDXLCommandList commandList(native);
+    commandList.Barrier(MakeBufferBarrier(0x1000));
+    commandList.Barrier(MakeBufferBarrier(0x2000));
+    CHECK(native->BarrierCalls.size() == 2);
+    native->Release();
+}
+
+DXL_TEST(ResetDropsBatchedBarriers)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS);
+    fixture.CommandList.Barrier(MakeGlobalBarrier());
+    fixture.CommandList.Reset(IDXLCommandAllocator());
+    fixture.CommandList.Close();
+
+    const std::vector<std::string> expected = { "Reset", "Close" };
+    CHECK(fixture.Recording->Calls == expected);
+}
+
+// == Redundant state filtering =====================================================
+
+DXL_TEST(RedundantStateChangesAreFiltered)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_FILTER_REDUNDANT_STATE);
+    MockPipelineState* pso = new MockPipelineState();
+    ID3D12DescriptorHeap* heaps[] = { FakePointer<ID3D12DescriptorHeap>(0x1000), FakePointer<ID3D12DescriptorHeap>(0x2000) };
+
+    fixture.CommandList.SetPipelineState(pso);
+    fixture.CommandList.SetDescriptorHeaps(2, heaps);
+    fixture.CommandList.SetPipelineState(pso);
+    fixture.CommandList.SetDescriptorHeaps(2, heaps);
+
+    // A different heap is a real change
+    heaps[1] = FakePointer<ID3D12DescriptorHeap>(0x3000);
+    fixture.CommandList.SetDescriptorHeaps(2, heaps);
+
+    std::vector<std::string> expected = { "SetPipelineState", "SetDescriptorHeaps", "SetDescriptorHeaps" };
+    CHECK(fixture.Recording->Calls == expected);
+
+    const DXL_COMMAND_LIST_STATE_FILTER_STATS stats = fixture.CommandList.GetStateFilterStats();
+    CHECK(stats.CallsElided == 2);
+    CHECK(stats.CallsForwarded == 3);
+
+    // After invalidating, nothing is assumed about the native list's state
+    fixture.CommandList.InvalidateStateCache();
+    fixture.CommandList.SetPipelineState(pso);
+    expected.push_back("SetPipelineState");
+    CHECK(fixture.Recording->Calls == expected);
+
+    pso->Release();
+}
+
+DXL_TEST(StateIsNotFilteredByDefault)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_DEFAULT);
+    MockPipelineState* pso = new MockPipelineState();
+
+    fixture.CommandList.SetPipelineState(pso);
+    fixture.CommandList.SetPipelineState(pso);
+
+    const std::vector<std::string> expected = { "SetPipelineState", "SetPipelineState" };
+    CHECK(fixture.Recording->Calls == expected);
+
+    pso->Release();
+}
+
+// == Root argument deferral =====================================================
+
+static IDXLRootSignature CreateRootSignatureWithConstants(IDXLDevice device, uint32_t num32BitConstants)
+{
+    const D3D12_ROOT_PARAMETER1 param =
+    {
+        .ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+        .Constants = { .ShaderRegister = 0, .RegisterSpace = 0, .Num32BitValues = num32BitConstants },
+        .ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL,
+    };
+
+    return device.CreateRootSignature({ .NumParameters = 1, .pParameters = &param });
+}
+
+DXL_TEST(RootConstantsAreDeferredUntilTheDispatch)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_DEFER_ROOT_ARGUMENTS);
+    IDXLRootSignature rootSignature = CreateRootSignatureWithConstants(fixture.Device, 4);
+
+    const uint32_t values[] = { 1, 2, 3, 4 };
+    fixture.CommandList.SetComputeRootSignature(rootSignature);
+    fixture.CommandList.SetComputeRoot32BitConstants(0, 2, values, 0);
+    fixture.CommandList.SetComputeRoot32BitConstants(0, 2, values + 2, 2);
+    fixture.CommandList.SetComputeRoot32BitConstant(0, 3, 2);
+    CHECK(fixture.Recording->Calls.size() == 1);
+
+    // The three calls go out as one, right before the dispatch that uses them
+    fixture.CommandList.Dispatch(1, 1, 1);
+    std::vector<std::string> expected = { "SetComputeRootSignature", "SetComputeRoot32BitConstants", "Dispatch" };
+    CHECK(fixture.Recording->Calls == expected);
+
+    // Setting the same values again doesn't need another call, and graphics constants don't flush on a dispatch
+    fixture.CommandList.SetComputeRoot32BitConstants(0, 4, values, 0);
+    fixture.CommandList.Dispatch(1, 1, 1);
+    expected.push_back("Dispatch");
+    CHECK(fixture.Recording->Calls == expected);
+
+    fixture.CommandList.SetComputeRoot32BitConstant(0, 5, 1);
+    fixture.CommandList.DrawInstanced(3, 1, 0, 0);
+    expected.push_back("DrawInstanced");
+    CHECK(fixture.Recording->Calls == expected);
+
+    Release(rootSignature);
+}
+
+DXL_TEST(RootConstantsAreForwardedWithoutALayout)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_DEFER_ROOT_ARGUMENTS);
+    MockRootSignature* rootSignature = new MockRootSignature();
+
+    // Root signatures that weren't created through IDXLDevice::CreateRootSignature can't be staged
+    const uint32_t value = 1;
+    fixture.CommandList.SetGraphicsRootSignature(rootSignature);
+    fixture.CommandList.SetGraphicsRoot32BitConstants(0, 1, &value, 0);
+
+    const std::vector<std::string> expected = { "SetGraphicsRootSignature", "SetGraphicsRoot32BitConstants" };
+    CHECK(fixture.Recording->Calls == expected);
+
+    rootSignature->Release();
+}
+
+// == PSO hashing =====================================================
+
+DXL_TEST(EqualPSODescsHashTheSame)
+{
+    MockDevice* device = new MockDevice();
+    IDXLRootSignature rootSignature = CreateRootSignatureWithConstants(device, 4);
+
+    // Equal bytecode in separate buffers
+    const uint8_t csA[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    const uint8_t csB[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC descA = { .pRootSignature = rootSignature, .CS = { csA, sizeof(csA) } };
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC descB = { .pRootSignature = rootSignature, .CS = { csB, sizeof(csB) } };
+    CHECK(Helpers::HashPSODesc(descA) == Helpers::HashPSODesc(descB));
+
+    DXL_SIMPLE_GRAPHICS_PSO_DESC graphicsA = { .RootSignature = rootSignature, .VertexShaderByteCode = { csA, sizeof(csA) } };
+    DXL_SIMPLE_GRAPHICS_PSO_DESC graphicsB = { .RootSignature = rootSignature, .VertexShaderByteCode = { csB, sizeof(csB) } };
+    CHECK(Helpers::HashPSODesc(graphicsA) == Helpers::HashPSODesc(graphicsB));
+
+    graphicsB.DepthStencilFormat = DXGI_FORMAT_D32_FLOAT;
+    CHECK(Helpers::HashPSODesc(graphicsA) != Helpers::HashPSODesc(graphicsB));
+
+    Release(rootSignature);
+    device->Release();
+}
+
+DXL_TEST(PSODescsThatOnlyDifferInRootSignatureHashDifferently)
+{
+    MockDevice* device = new MockDevice();
+    IDXLRootSignature rootSignatureA = CreateRootSignatureWithConstants(device, 4);
+    IDXLRootSignature rootSignatureB = CreateRootSignatureWithConstants(device, 8);
+    IDXLRootSignature rootSignatureC = CreateRootSignatureWithConstants(device, 8);
+
+    const uint8_t cs[] = { 1, 2, 3, 4 };
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC descA = { .pRootSignature = rootSignatureA, .CS = { cs, sizeof(cs) } };
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC descB = { .pRootSignature = rootSignatureB, .CS = { cs, sizeof(cs) } };
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC descC = { .pRootSignature = rootSignatureC, .CS = { cs, sizeof(cs) } };
+    CHECK(Helpers::HashPSODesc(descA) != Helpers::HashPSODesc(descB));
+
+    // Like the runtime, root signatures with the same contents are treated as the same root signature
+    CHECK(Helpers::HashPSODesc(descB) == Helpers::HashPSODesc(descC));
+
+    Release(rootSignatureA);
+    Release(rootSignatureB);
+    Release(rootSignatureC);
+    device->Release();
+}
+
+DXL_TEST(PSOHashesDontDependOnRootSignatureAddresses)
+{
+    MockDevice* device = new MockDevice();
+    IDXLRootSignature rootSignature = CreateRootSignatureWithConstants(device, 4);
+    IDXLRootSignature replacement = CreateRootSignatureWithConstants(device, 8);
+
+    const uint8_t cs[] = { 1, 2, 3, 4 };
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC desc = { .pRootSignature = rootSignature, .CS = { cs, sizeof(cs) } };
+    const DXL_HASH128 hashBefore = Helpers::HashPSODesc(desc);
+
+    // A different root signature now lives at the same address
+    static_cast<MockRootSignature*>(rootSignature.ToNative())->TakePrivateData(*static_cast<MockRootSignature*>(replacement.ToNative()));
+    CHECK(Helpers::HashPSODesc(desc) != hashBefore);
+
+    Release(rootSignature);
+    Release(replacement);
+    device->Release();
+}
+
+// == PipelineCompiler =====================================================
+
+// Blocks whichever worker picks it up until Release() is called
+struct BlockingCompile
+{
+    std::atomic<bool> Started = false;
+    std::atomic<bool> Released = false;
+
+    std::function<IDXLPipelineState()> GetFunction()
+    {
+        return [this]()
+        {
+            Started = true;
+            while (Released == false)
+                std::this_thread::yield();
+            return IDXLPipelineState();
+        };
+    }
+
+    void WaitUntilStarted()
+    {
+        while (Started == false)
+            std::this_thread::yield();
+    }
+
+    void Release()
+    {
+        Released = true;
+    }
+};
+
+DXL_TEST(PipelineRequestReleasesItsPSO)
+{
+    MockDevice* device = new MockDevice();
+    MockPipelineState* pso = new MockPipelineState();
+
+    PipelineCompiler compiler;
+    compiler.Initialize({ .Device = device, .NumThreads = 1 });
+
+    {
+        // The compile function hands its reference over to the request
+        pso->AddRef();
+        PipelineRequest request = compiler.Compile([pso]() { return IDXLPipelineState(pso); });
+        CHECK(request.Wait() == pso);
+        CHECK(request.IsReady());
+        CHECK(request.IsCancelled() == false);
+        CHECK(pso->GetRefCount() == 2);
+    }
+
+    // The workers can hold on to the job for a little while after it's done
+    compiler.Shutdown();
+    CHECK(pso->GetRefCount() == 1);
+
+    pso->Release();
+    device->Release();
+}
+
+DXL_TEST(EvictedPrewarmRequestsAreCancelled)
+{
+    MockDevice* device = new MockDevice();
+
+    PipelineCompiler compiler;
+    compiler.Initialize({ .Device = device, .NumThreads = 1, .MaxQueuedRequests = 1 });
+
+    BlockingCompile blocker;
+    PipelineRequest blockingRequest = compiler.Compile(blocker.GetFunction());
+    blocker.WaitUntilStarted();
+
+    PipelineRequest prewarmRequest = compiler.Compile([]() { return IDXLPipelineState(); }, PipelinePriority::Prewarm);
+    CHECK(prewarmRequest.IsValid());
+
+    // The queue is full, so another prewarm request is refused and an immediate request replaces the queued one
+    CHECK(compiler.Compile([]() { return IDXLPipelineState(); }, PipelinePriority::Prewarm).IsValid() == false);
+    PipelineRequest immediateRequest = compiler.Compile([]() { return IDXLPipelineState(); });
+
+    CHECK(prewarmRequest.IsCancelled());
+    CHECK(prewarmRequest.IsReady() == false);
+    CHECK(prewarmRequest.Wait() == nullptr);
+    CHECK(immediateRequest.IsCancelled() == false);
+
+    blocker.Release();
+    immediateRequest.Wait();
+    CHECK(immediateRequest.IsReady());
+
+    compiler.Shutdown();
+    device->Release();
+}
+
+DXL_TEST(PipelineCompilerShutdownWaitsForBlockedCallers)
+{
+    MockDevice* device = new MockDevice();
+
+    PipelineCompiler compiler;
+    compiler.Initialize({ .Device = device, .NumThreads = 1, .MaxQueuedRequests = 1 });
+
+    BlockingCompile blocker;
+    PipelineRequest blockingRequest = compiler.Compile(blocker.GetFunction());
+    blocker.WaitUntilStarted();
+    PipelineRequest queuedRequest = compiler.Compile([]() { return IDXLPipelineState(); });
+
+    // With the queue full of immediate requests, this one has to wait for space
+    std::atomic<bool> callerReturned = false;
+    PipelineRequest blockedRequest;
+    std::thread caller([&]()
+    {
+        blockedRequest = compiler.Compile([]() { return IDXLPipelineState(); });
+        callerReturned = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(callerReturned == false);
+
+    std::thread releaser([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        blocker.Release();
+    });
+
+    compiler.Shutdown();
+    caller.join();
+    CHECK(callerReturned);
+    releaser.join();
+
+    CHECK(blockedRequest.IsCancelled());
+    CHECK(queuedRequest.IsCancelled());
+    CHECK(blockingRequest.IsReady());
+
+    device->Release();
+}
+
+// == Shader compilation =====================================================
+
+// DXC isn't checked in, so the tests that compile shaders are skipped unless it's been put in dxc\bin\x64 like the
+// examples expect
+static std::string GetTestDXCPath()
+{
+    char exePath[MAX_PATH] = { };
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+
+    std::error_code error;
+    const std::filesystem::path dxcPath = std::filesystem::path(exePath).parent_path() / "..\\..\\..\\..\\dxc\\bin\\x64\\dxcompiler.dll";
+    if (exePath[0] == 0 || std::filesystem::exists(dxcPath, error) == false)
+    {
+        printf("    Skipped, DXC isn't in dxc\\bin\\x64\n");
+        return std::string();
+    }
+
+    return dxcPath.string();
+}
+
+// Returns an empty directory for the test to write its files to
+static std::filesystem::path MakeTestDirectory(const char* name)
+{
+    std::error_code error;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "DXLatestTests" / name;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory, error);
+    return directory;
+}
+
+static void WriteTestFile(const std::filesystem::path& filePath, const std::string& contents)
+{
+    std::ofstream file(filePath.string(), std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), std::streamsize(contents.size()));
+}
+
+static std::vector<uint8_t> ReadTestFile(const std::filesystem::path& filePath)
+{
+    std::ifstream file(filePath.string(), std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteTestFile(const std::filesystem::path& filePath, const std::vector<uint8_t>& contents)
+{
+    WriteTestFile(filePath, std::string(contents.begin(), contents.end()));
+}
+
+static const char* TestComputeShader = "RWStructuredBuffer<uint> Output : register(u0);\n[numthreads(1, 1, 1)] void main() { Output[0] = 1; }\n";
+
+DXL_TEST(ShaderCacheHitsMissesAndRejectsCorruptFiles)
+{
+    const std::string dxcPath = GetTestDXCPath();
+    if (dxcPath.empty())
+        return;
+
+    const std::filesystem::path directory = MakeTestDirectory("ShaderCache");
+    const std::filesystem::path cacheDirectory = directory / "Cache";
+    const std::string shaderPath = (directory / "Shader.hlsl").string();
+    WriteTestFile(shaderPath, TestComputeShader);
+
+    Helpers::CompileShaderParams params;
+    params.Type = Helpers::ShaderType::Compute;
+    params.FilePath = shaderPath.c_str();
+    params.EntryPoint = "main";
+    params.LoopOnError = false;
+    params.PathToDXC = dxcPath;
+    params.CacheDirectory = cacheDirectory.string();
+
+    // A miss compiles the shader and writes a cache file
+    const Helpers::CompiledShader compiled = Helpers::CompileShaderFromFile(params);
+    CHECK(compiled.Bytecode.size() > 0);
+
+    std::vector<std::filesystem::path> cacheFiles;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(cacheDirectory))
+        cacheFiles.push_back(entry.path());
+    CHECK(cacheFiles.size() == 1);
+    if (cacheFiles.size() != 1 || compiled.Bytecode.empty())
+        return;
+
+    // A hit returns whatever bytecode is in the file, so change it to tell hits from recompiles
+    const std::vector<uint8_t> cacheFile = ReadTestFile(cacheFiles[0]);
+    std::vector<uint8_t> modifiedFile = cacheFile;
+    modifiedFile.back() ^= 0xFF;
+    WriteTestFile(cacheFiles[0], modifiedFile);
+
+    std::vector<uint8_t> expectedBytecode = compiled.Bytecode;
+    expectedBytecode.back() ^= 0xFF;
+    CHECK(Helpers::CompileShaderFromFile(params).Bytecode == expectedBytecode);
+
+    // Section sizes that only add up to the file size by overflowing, and a truncated file, are both misses that
+    // recompile and rewrite the file. The header is 48 bytes and ends with the include table and bytecode sizes.
+    std::vector<uint8_t> corruptFile = cacheFile;
+    const uint64_t corruptSizes[] = { UINT64_MAX - 15, cacheFile.size() - 48 + 16 };
+    memcpy(corruptFile.data() + 32, corruptSizes, sizeof(corruptSizes));
+    WriteTestFile(cacheFiles[0], corruptFile);
+    CHECK(Helpers::CompileShaderFromFile(params).Bytecode == compiled.Bytecode);
+    CHECK(ReadTestFile(cacheFiles[0]) == cacheFile);
+
+    WriteTestFile(cacheFiles[0], std::vector<uint8_t>(cacheFile.begin(), cacheFile.begin() + cacheFile.size() / 2));
+    CHECK(Helpers::CompileShaderFromFile(params).Bytecode == compiled.Bytecode);
+    CHECK(ReadTestFile(cacheFiles[0]) == cacheFile);
+
+    // Changing the source is a different key, so it's a miss that adds a second file
+    WriteTestFile(shaderPath, std::string(TestComputeShader) + "// Changed\n");
+    CHECK(Helpers::CompileShaderFromFile(params).Bytecode.size() > 0);
+    CHECK(std::distance(std::filesystem::directory_iterator(cacheDirectory), std::filesystem::directory_iterator()) == 2);
+}
+
+DXL_TEST(ShaderBatchesCompileInOrderAndReportErrorsPerShader)
+{
+    const std::string dxcPath = GetTestDXCPath();
+    if (dxcPath.empty())
+        return;
+
+    const std::filesystem::path directory = MakeTestDirectory("ShaderBatch");
+
+    // Every third shader has a syntax error
+    const uint32_t numShaders = 12;
+    std::vector<std::string> shaderPaths;
+    for (uint32_t shaderIdx = 0; shaderIdx < numShaders; ++shaderIdx)
+    {
+        shaderPaths.push_back((directory / ("Shader" + std::to_string(shaderIdx) + ".hlsl")).string());
+        WriteTestFile(shaderPaths.back(), shaderIdx % 3 == 1 ? "[numthreads(1, 1, 1)] void main() { error }\n" : TestComputeShader);
+    }
+
+    std::vector<Helpers::CompileShaderParams> params(numShaders);
+    for (uint32_t shaderIdx = 0; shaderIdx < numShaders; ++shaderIdx)
+    {
+        params[shaderIdx].Type = Helpers::ShaderType::Compute;
+        params[shaderIdx].FilePath = shaderPaths[shaderIdx].c_str();
+        params[shaderIdx].EntryPoint = "main";
+        params[shaderIdx].PathToDXC = dxcPath;
+    }
+
+    const std::vector<Helpers::CompileShaderResult> results = Helpers::CompileShadersBatch(Span<const Helpers::CompileShaderParams>(numShaders, params.data()), 4);
+    CHECK(results.size() == numShaders);
+    if (results.size() != numShaders)
+        return;
+
+    for (uint32_t shaderIdx = 0; shaderIdx < numShaders; ++shaderIdx)
+    {
+        const Helpers::CompileShaderResult& result = results[shaderIdx];
+        const std::string fileName = "Shader" + std::to_string(shaderIdx) + ".hlsl";
+
+        // The source file is always the first dependency, which shows which params the result is for
+        CHECK(result.Shader.Dependencies.size() > 0 && result.Shader.Dependencies[0].FilePath.ends_with(fileName));
+
+        if (shaderIdx % 3 == 1)
+        {
+            CHECK(FAILED(result.Result));
+            CHECK(result.ErrorMessage.find(fileName) != std::string::npos);
+            CHECK(result.Shader.Bytecode.empty());
+        }
+        else
+        {
+            CHECK(SUCCEEDED(result.Result));
+            CHECK(result.ErrorMessage.empty());
+            CHECK(result.Shader.Bytecode.size() > 0);
+        }
+    }
+}
+
+DXL_TEST(IncludeChangesMarkTheirDependentShadersStale)
+{
+    const std::filesystem::path directory = MakeTestDirectory("ShaderDependencies");
+    const std::string commonPath = (directory / "Common.hlsli").string();
+    const std::string lightingPath = (directory / "Lighting.hlsli").string();
+    const std::string shaderPaths[] = { (directory / "A.hlsl").string(), (directory / "B.hlsl").string(), (directory / "C.hlsl").string() };
+
+    WriteTestFile(commonPath, "#define COMMON 1\n");
+    WriteTestFile(lightingPath, "#define LIGHTING 1\n");
+    for (const std::string& shaderPath : shaderPaths)
+        WriteTestFile(shaderPath, TestComputeShader);
+
+    // A includes Common, B includes Common and Lighting, C has no includes
+    Helpers::ShaderDependencyGraph graph;
+    auto addShader = [&](uint64_t shaderID, std::vector<std::string> filePaths)
+    {
+        std::vector<Helpers::ShaderDependency> dependencies;
+        for (const std::string& filePath : filePaths)
+            dependencies.push_back(Helpers::GetShaderDependency(filePath.c_str()));
+        graph.AddShader(shaderID, Span<const Helpers::ShaderDependency>(uint32_t(dependencies.size()), dependencies.data()));
+    };
+
+    addShader(0, { shaderPaths[0], commonPath });
+    addShader(1, { shaderPaths[1], commonPath, lightingPath });
+    addShader(2, { shaderPaths[2] });
+    CHECK(graph.NumShaders() == 3);
+
+    std::vector<uint64_t> commonDependents = graph.GetDependentShaders(commonPath.c_str());
+    std::sort(commonDependents.begin(), commonDependents.end());
+    CHECK(commonDependents == std::vector<uint64_t>({ 0, 1 }));
+    CHECK(graph.GetDependentShaders(lightingPath.c_str()) == std::vector<uint64_t>({ 1 }));
+    CHECK(graph.GetDependentShaders(shaderPaths[2].c_str()) == std::vector<uint64_t>({ 2 }));
+
+    CHECK(graph.FindStaleShaders().empty());
+
+    // The size changes along with the contents, so the change is seen even if the write time doesn't move
+    WriteTestFile(lightingPath, "#define LIGHTING 2 // Changed\n");
+    CHECK(graph.FindStaleShaders() == std::vector<uint64_t>({ 1 }));
+
+    WriteTestFile(commonPath, "#define COMMON 2 // Changed\n");
+    CHECK(graph.FindStaleShaders() == std::vector<uint64_t>({ 0, 1 }));
+
+    // Recompiling replaces the old hashes
+    addShader(0, { shaderPaths[0], commonPath });
+    addShader(1, { shaderPaths[1], commonPath, lightingPath });
+    CHECK(graph.FindStaleShaders().empty());
+
+    // Writing back the same contents doesn't make anything stale
+    WriteTestFile(shaderPaths[2], TestComputeShader);
+    CHECK(graph.FindStaleShaders().empty());
+
+    std::filesystem::remove(lightingPath);
+    CHECK(graph.FindStaleShaders() == std::vector<uint64_t>({ 1 }));
+
+    graph.RemoveShader(1);
+    CHECK(graph.GetDependentShaders(lightingPath.c_str()).empty());
+    CHECK(graph.GetDependentShaders(commonPath.c_str()) == std::vector<uint64_t>({ 0 }));
+    CHECK(graph.FindStaleShaders().empty());
+}
+
+DXL_TEST(HotReloadingWaitsForFilesToStopChanging)
+{
+    const std::filesystem::path directory = MakeTestDirectory("ShaderHotReloader");
+    const std::string shaderPath = (directory / "Lighting.hlsl").string();
+    const std::string includePath = (directory / "Lighting.hlsli").string();
+    WriteTestFile(shaderPath, TestComputeShader);
+    WriteTestFile(includePath, "#define NUM_LIGHTS 1\n");
+
+    // The fake compiler makes the bytecode out of the include, and fails if the include has an error in it
+    uint32_t numCompiles = 0;
+    auto compileFunction = [&](Span<const Helpers::CompileShaderParams> params)
+    {
+        std::vector<Helpers::CompileShaderResult> results(params.Count);
+        for (uint32_t shaderIdx = 0; shaderIdx < params.Count; ++shaderIdx)
+        {
+            const std::vector<uint8_t> include = ReadTestFile(includePath);
+            Helpers::CompileShaderResult& result = results[shaderIdx];
+            result.Shader.Dependencies = { Helpers::GetShaderDependency(params.Items[shaderIdx].FilePath), Helpers::GetShaderDependency(includePath.c_str()) };
+            if (std::string(include.begin(), include.end()).find("error") != std::string::npos)
+            {
+                result.Result = E_FAIL;
+                result.ErrorMessage = "Lighting.hlsli has an error";
+            }
+            else
+            {
+                result.Result = S_OK;
+                result.Shader.Bytecode = include;
+            }
+
+            ++numCompiles;
+        }
+
+        return results;
+    };
+
+    uint64_t currentTime = 1000;
+    std::vector<std::pair<uint64_t, std::string>> compiledShaders;
+    std::vector<IDXLPipelineState> retiredPSOs;
+
+    ShaderHotReloader reloader;
+    reloader.Initialize(
+    {
+        .StartWatcherThread = false,
+        .DebounceMS = 100,
+        .OnShaderCompiled = [&](uint64_t shaderID, const char* errorMessage) { compiledShaders.emplace_back(shaderID, errorMessage ? errorMessage : ""); },
+        .OnPSORetired = [&](IDXLPipelineState retiredPSO) { retiredPSOs.push_back(retiredPSO); },
+        .GetTimeMS = [&]() { return currentTime; },
+        .CompileFunction = compileFunction,
+    });
+
+    Helpers::CompileShaderParams params;
+    params.Type = Helpers::ShaderType::Compute;
+    params.FilePath = shaderPath.c_str();
+    params.EntryPoint = "main";
+
+    const uint64_t shaderID = reloader.AddShader(params);
+    CHECK(numCompiles == 1);
+    CHECK(compiledShaders.size() == 1 && compiledShaders[0].first == shaderID && compiledShaders[0].second.empty());
+    CHECK(reloader.GetShader(shaderID)->Bytecode == ReadTestFile(includePath));
+
+    std::vector<MockPipelineState*> psos;
+    const uint64_t pipelineID = reloader.AddPipeline(Span<const uint64_t>(1, &shaderID), [&]()
+    {
+        psos.push_back(new MockPipelineState());
+        return IDXLPipelineState(psos.back());
+    });
+    CHECK(reloader.GetPipeline(pipelineID) == psos[0]);
+
+    CHECK(reloader.ProcessChanges() == 0);
+    CHECK(numCompiles == 1);
+
+    // The file keeps changing, so nothing gets compiled until it's been left alone for the debounce time
+    WriteTestFile(includePath, "#define NUM_LIGHTS 2\n// Saving\n");
+    CHECK(reloader.ProcessChanges() == 0);
+
+    currentTime += 60;
+    WriteTestFile(includePath, "#define NUM_LIGHTS 2\n");
+    CHECK(reloader.ProcessChanges() == 0);
+
+    currentTime += 60;
+    CHECK(reloader.ProcessChanges() == 0);
+    CHECK(numCompiles == 1);
+    CHECK(compiledShaders.size() == 1);
+
+    currentTime += 40;
+    CHECK(reloader.ProcessChanges() == 1);
+    CHECK(numCompiles == 2);
+    CHECK(compiledShaders.size() == 2 && compiledShaders[1].first == shaderID && compiledShaders[1].second.empty());
+    CHECK(reloader.GetShader(shaderID)->Bytecode == ReadTestFile(includePath));
+
+    // The rebuilt PSO is swapped in and the old one gets retired
+    CHECK(psos.size() == 2 && reloader.GetPipeline(pipelineID) == psos[1]);
+    CHECK(retiredPSOs.size() == 1 && retiredPSOs[0] == psos[0]);
+
+    currentTime += 1000;
+    CHECK(reloader.ProcessChanges() == 0);
+    CHECK(numCompiles == 2);
+
+    // A failed compile is reported and keeps the previous bytecode and PSO
+    const std::vector<uint8_t> previousBytecode = reloader.GetShader(shaderID)->Bytecode;
+    WriteTestFile(includePath, "#define NUM_LIGHTS error\n");
+    CHECK(reloader.ProcessChanges() == 0);
+    currentTime += 100;
+    CHECK(reloader.ProcessChanges() == 0);
+    CHECK(numCompiles == 3);
+    CHECK(compiledShaders.size() == 3 && compiledShaders[2].first == shaderID && compiledShaders[2].second == "Lighting.hlsli has an error");
+    CHECK(reloader.GetShader(shaderID)->Bytecode == previousBytecode);
+    CHECK(psos.size() == 2 && reloader.GetPipeline(pipelineID) == psos[1]);
+
+    // Fixing the error triggers another compile
+    WriteTestFile(includePath, "#define NUM_LIGHTS 3\n");
+    CHECK(reloader.ProcessChanges() == 0);
+    currentTime += 100;
+    CHECK(reloader.ProcessChanges() == 1);
+    CHECK(compiledShaders.size() == 4 && compiledShaders[3].second.empty());
+    CHECK(psos.size() == 3 && reloader.GetPipeline(pipelineID) == psos[2]);
+
+    reloader.Shutdown();
+
+    for (IDXLPipelineState& pso : retiredPSOs)
+        Release(pso);
+}
+
+// == UploadRing =====================================================
+
+DXL_TEST(UploadRingWaitsForTheFenceWithoutHoldingTheLock)
+{
+    MockFence* fence = new MockFence();
+
+    const uint64_t ringSize = 256 * 1024;
+    UploadRing ring;
+    ring.Initialize({ .Fence = fence, .Size = ringSize, .BlockSize = 64 * 1024 });
+
+    CHECK(ring.Allocate(ringSize, UploadRing::MaxAlignment).CPUAddress != nullptr);
+    ring.Retire(1);
+
+    // The ring is full until the fence reaches 1, so this blocks
+    std::atomic<bool> allocated = false;
+    UploadAllocation allocation;
+    std::thread allocator([&]()
+    {
+        allocation = ring.Allocate(ringSize / 2, UploadRing::MaxAlignment);
+        allocated = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(allocated == false);
+
+    // Other threads can still use the ring while the allocating thread waits
+    CHECK(ring.GetBytesInUse() == ringSize);
+    ring.ReleaseCompleted(0);
+    ring.Retire(2);
+
+    fence->Signal(1);
+    allocator.join();
+    CHECK(allocated);
+    CHECK(allocation.CPUAddress != nullptr);
+    CHECK(ring.GetBytesInUse() == ringSize / 2);
+
+    ring.Shutdown();
+    fence->Release();
+}
+
+// == OffsetAllocator =====================================================
+
+DXL_TEST(OffsetAllocatorRoundsAndAligns)
+{
+    OffsetAllocator allocator;
+    allocator.Initialize(1024, 16);
+
+    const OffsetAllocation first = allocator.Allocate(1);
+    CHECK(first.IsValid());
+    CHECK(first.Offset == 0);
+    CHECK(first.Size == 16);
+
+    const OffsetAllocation aligned = allocator.Allocate(100, 256);
+    CHECK(aligned.IsValid());
+    CHECK(aligned.Offset % 256 == 0);
+    CHECK(aligned.Size == 112);
+
+    // The padding in front of the aligned allocation stays usable
+    const OffsetAllocation padding = allocator.Allocate(200);
+    CHECK(padding.IsValid());
+    CHECK(padding.Offset + padding.Size <= aligned.Offset);
+
+    CHECK(allocator.Allocate(2048).IsValid() == false);
+
+    const OffsetAllocatorStats stats = allocator.GetStats();
+    CHECK(stats.NumAllocations == 3);
+    CHECK(stats.UsedSize == 16 + 112 + 208);
+
+    allocator.Free(first);
+    allocator.Free(aligned);
+    allocator.Free(padding);
+}
+
+DXL_TEST(OffsetAllocatorMergesFreedRegions)
+{
+    const uint64_t size = 64 * 1024;
+    OffsetAllocator allocator;
+    allocator.Initialize(size);
+
+    std::vector<OffsetAllocation> allocations;
+    for (uint64_t i = 0; i < size / 1024; ++i)
+    {
+        allocations.push_back(allocator.Allocate(1024));
+        CHECK(allocations.back().IsValid());
+    }
+
+    CHECK(allocator.Allocate(1).IsValid() == false);
+    CHECK(allocator.GetStats().NumFreeRegions == 0);
+
+    // Freeing every other allocation leaves holes that can't fit anything larger
+    for (size_t i = 0; i < allocations.size(); i += 2)
+        allocator.Free(allocations[i]);
+
+    OffsetAllocatorStats stats = allocator.GetStats();
+    CHECK(stats.NumFreeRegions == allocations.size() / 2);
+    CHECK(stats.LargestFreeRegion == 1024);
+    CHECK(stats.Fragmentation > 0.9f);
+    CHECK(allocator.Allocate(2048).IsValid() == false);
+
+    for (size_t i = 1; i < allocations.size(); i += 2)
+        allocator.Free(allocations[i]);
+
+    stats = allocator.GetStats();
+    CHECK(stats.NumAllocations == 0);
+    CHECK(stats.UsedSize == 0);
+    CHECK(stats.NumFreeRegions == 1);
+    CHECK(stats.LargestFreeRegion == size);
+    CHECK(stats.Fragmentation == 0.0f);
+    CHECK(allocator.Allocate(size).IsValid());
+}
+
+DXL_TEST(OffsetAllocatorRandomAllocationsDontOverlap)
+{
+    const uint64_t size = 1024 * 1024;
+    OffsetAllocator allocator;
+    allocator.Initialize(size, 4);
+
+    std::mt19937 random(1234);
+    std::vector<OffsetAllocation> allocations;
+    for (uint32_t iteration = 0; iteration < 20000; ++iteration)
+    {
+        if (allocations.size() > 0 && random() % 3 == 0)
+        {
+            const size_t index = random() % allocations.size();
+            allocator.Free(allocations[index]);
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+            continue;
+        }
+
+        const uint64_t alignment = 1ull << (random() % 9);
+        const OffsetAllocation allocation = allocator.Allocate(1 + random() % 4096, alignment);
+        if (allocation.IsValid() == false)
+            continue;
+
+        CHECK(allocation.Offset % std::max<uint64_t>(alignment, 4) == 0);
+        CHECK(allocation.Offset + allocation.Size <= size);
+        allocations.push_back(allocation);
+    }
+
+    std::sort(allocations.begin(), allocations.end(), [](const OffsetAllocation& a, const OffsetAllocation& b) { return a.Offset < b.Offset; });
+    uint64_t usedSize = 0;
+    for (size_t i = 0; i < allocations.size(); ++i)
+    {
+        usedSize += allocations[i].Size;
+        if (i > 0)
+            CHECK(allocations[i - 1].Offset + allocations[i - 1].Size <= allocations[i].Offset);
+    }
+
+    CHECK(allocator.GetStats().UsedSize == usedSize);
+    CHECK(allocator.GetStats().NumAllocations == allocations.size());
+
+    for (const OffsetAllocation& allocation : allocations)
+        allocator.Free(allocation);
+    CHECK(allocator.GetStats().LargestFreeRegion == size);
+}
+
+// == BindlessDescriptorHeap =====================================================
+
+DXL_TEST(BindlessPersistentFreesWaitForTheFence)
+{
+    MockFence* fence = new MockFence();
+
+    BindlessDescriptorHeap heap;
+    heap.Initialize({ .Fence = fence, .NumPersistentDescriptors = 4, .NumTransientDescriptors = 0 });
+
+    DescriptorAllocation allocations[4];
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        allocations[i] = heap.AllocatePersistent();
+        CHECK(allocations[i].Index == i);
+        CHECK(heap.GetCPUHandle(i).ptr == allocations[i].CPUHandle.ptr);
+    }
+
+    CHECK(heap.AllocatePersistent().IsValid() == false);
+    CHECK(heap.GetNumPersistentAllocated() == 4);
+
+    // Freed descriptors can't be reused until the GPU is done with the frame that freed them
+    heap.FreePersistent(allocations[2]);
+    CHECK(allocations[2].IsValid() == false);
+    CHECK(heap.AllocatePersistent().IsValid() == false);
+
+    heap.Retire(1);
+    CHECK(heap.AllocatePersistent().IsValid() == false);
+    CHECK(heap.GetNumPersistentAllocated() == 4);
+
+    fence->Signal(1);
+    allocations[2] = heap.AllocatePersistent();
+    CHECK(allocations[2].Index == 2);
+
+    heap.Shutdown();
+    fence->Release();
+}
+
+DXL_TEST(BindlessFreeListHandlesConcurrentThreads)
+{
+    const uint32_t numDescriptors = 1024;
+    BindlessDescriptorHeap heap;
+    heap.Initialize({ .NumPersistentDescriptors = numDescriptors, .NumTransientDescriptors = 0 });
+
+    // Each thread repeatedly takes a batch of descriptors, marks them as owned, and gives them back
+    std::unique_ptr<std::atomic<uint32_t>[]> owners = std::make_unique<std::atomic<uint32_t>[]>(numDescriptors);
+    std::atomic<uint32_t> numConflicts = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t threadIndex = 0; threadIndex < 4; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            for (uint32_t iteration = 0; iteration < 1000; ++iteration)
+            {
+                DescriptorAllocation allocations[16];
+                for (DescriptorAllocation& allocation : allocations)
+                {
+                    // Running out is fine since frees only come back when the first thread retires them
+                    allocation = heap.AllocatePersistent();
+                    uint32_t noOwner = 0;
+                    if (allocation.IsValid() && owners[allocation.Index].compare_exchange_strong(noOwner, threadIndex + 1) == false)
+                        numConflicts += 1;
+                }
+
+                for (DescriptorAllocation& allocation : allocations)
+                {
+                    if (allocation.IsValid())
+                        owners[allocation.Index] = 0;
+                    heap.FreePersistent(allocation);
+                }
+
+                // Without a fence everything retired so far can be handed back right away
+                if (threadIndex == 0)
+                {
+                    heap.Retire(iteration);
+                    heap.ReleaseCompleted(iteration);
+                }
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    CHECK(numConflicts == 0);
+
+    heap.Retire(UINT64_MAX);
+    heap.ReleaseCompleted(UINT64_MAX);
+    CHECK(heap.GetNumPersistentAllocated() == 0);
+
+    heap.Shutdown();
+}
+
+DXL_TEST(BindlessTransientRingWaitsWithoutHoldingTheLock)
+{
+    MockFence* fence = new MockFence();
+
+    BindlessDescriptorHeap heap;
+    heap.Initialize({ .Fence = fence, .NumPersistentDescriptors = 4, .NumTransientDescriptors = 64 });
+
+    const DescriptorAllocation first = heap.AllocateTransient(48);
+    CHECK(first.Index == 4);
+    heap.Retire(1);
+
+    // Doesn't fit at the end of the ring, so it has to wait for the first frame to be done
+    std::atomic<bool> allocated = false;
+    DescriptorAllocation second;
+    std::thread allocator([&]()
+    {
+        second = heap.AllocateTransient(32);
+        allocated = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(allocated == false);
+
+    // Freeing and retiring take the same lock that the waiting thread used to hold
+    DescriptorAllocation persistent = heap.AllocatePersistent();
+    heap.FreePersistent(persistent);
+    heap.Retire(2);
+
+    fence->Signal(2);
+    allocator.join();
+    CHECK(allocated);
+    CHECK(second.Index == 4);
+    CHECK(second.Count == 32);
+
+    heap.Shutdown();
+    fence->Release();
+}
+
+// == CommandListPool =====================================================
+
+DXL_TEST(CommandListPoolClosesListsThatWereNeverExecuted)
+{
+    MockDevice* device = new MockDevice();
+
+    CommandListPool pool;
+    pool.Initialize({ .Device = device });
+
+    PooledCommandList commandList = pool.Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    RecordingCommandList* recording = static_cast<RecordingCommandList*>(commandList.CommandList.ToNative());
+    CHECK(recording->IsOpen);
+
+    pool.Submit(commandList, 0);
+    CHECK(recording->IsOpen == false);
+
+    // The same list comes back out, and resetting it succeeds now that it's closed
+    pool.ReleaseCompleted(0);
+    commandList = pool.Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    CHECK(commandList.CommandList.ToNative() == recording);
+    CHECK(recording->IsOpen);
+
+    const std::vector<std::string> expected = { "Reset", "Close", "Reset" };
+    CHECK(recording->Calls == expected);
+
+    // Lists that were executed are closed by whoever recorded them
+    commandList.CommandList.Close();
+    pool.Submit(commandList, 1);
+    CHECK(recording->Calls.size() == 4);
+
+    pool.Shutdown();
+    device->Release();
+}
+
+// == ParallelCommandRecorder =====================================================
+
+DXL_TEST(ParallelCommandRecorderRecordsEverySegmentOncePerFrame)
+{
+    CommandListPool pool;
+    pool.Initialize({ });
+
+    uint32_t numExecutedLists = 0;
+    ParallelCommandRecorder recorder;
+    recorder.Initialize(
+    {
+        .Pool = &pool,
+        .NumThreads = 4,
+        .OnExecute = [&](Span<const RecordedCommandList> commandLists)
+        {
+            for (uint32_t i = 0; i < commandLists.Count; ++i)
+                CHECK(commandLists.Items[i].SegmentIndex == i);
+            numExecutedLists += commandLists.Count;
+        },
+    });
+
+    // Frames with a varying number of segments make the recorder grow its segment states between frames, while
+    // workers that woke up late for the previous frame can still be running
+    const uint32_t maxSegments = 32;
+    std::atomic<uint32_t> numRecorded[maxSegments] = { };
+    std::vector<RecordSegmentFunction> segments;
+    for (uint32_t segmentIdx = 0; segmentIdx < maxSegments; ++segmentIdx)
+        segments.push_back([&numRecorded](CommandSegment& segment) { numRecorded[segment.SegmentIndex] += 1; });
+
+    uint32_t expectedLists = 0;
+    for (uint32_t frameIdx = 0; frameIdx < 500; ++frameIdx)
+    {
+        const uint32_t numSegments = 1 + (frameIdx * 7) % maxSegments;
+        recorder.RecordAndExecute(Span<const RecordSegmentFunction>(numSegments, segments.data()), frameIdx + 1);
+        expectedLists += numSegments;
+
+        for (uint32_t segmentIdx = 0; segmentIdx < maxSegments; ++segmentIdx)
+            CHECK(numRecorded[segmentIdx].exchange(0) == (segmentIdx < numSegments ? 1u : 0u));
+    }
+
+    CHECK(numExecutedLists == expectedLists);
+
+    recorder.Shutdown();
+    pool.Shutdown();
+}
+
+// == DescriptorCache =====================================================
+
+DXL_TEST(DescriptorCacheEvictsViewsWhenTheResourceIsDestroyed)
+{
+    BindlessDescriptorHeap heap;
+    heap.Initialize({ .NumPersistentDescriptors = 16, .NumTransientDescriptors = 0 });
+
+    DescriptorCache cache;
+    cache.Initialize({ .ResourceHeap = &heap });
+
+    MockResource* resource = new MockResource();
+    MockResource* counterResource = new MockResource();
+
+    DescriptorAllocation srv = cache.CreateShaderResourceView(resource, nullptr);
+    DescriptorAllocation sameSRV = cache.CreateShaderResourceView(resource, nullptr);
+    CHECK(srv.IsValid());
+    CHECK(sameSRV.Index == srv.Index);
+
+    DescriptorAllocation uav = cache.CreateUnorderedAccessView(resource, counterResource, nullptr);
+    CHECK(uav.IsValid());
+    CHECK(cache.GetStats().NumViews == 2);
+
+    // The cache doesn't hold a reference, so the resources are destroyed as soon as they're released
+    CHECK(resource->GetRefCount() == 1);
+
+    // Destroying the counter resource takes the UAV with it, and destroying the resource takes the rest
+    counterResource->Release();
+    CHECK(cache.GetStats().NumViews == 1);
+    resource->Release();
+    CHECK(cache.GetStats().NumViews == 0);
+
+    // A new view doesn't find anything, even if the new resource happens to get the same address
+    MockResource* newResource = new MockResource();
+    cache.CreateShaderResourceView(newResource, nullptr);
+    CHECK(cache.GetStats().Hits == 1);
+    CHECK(cache.GetStats().Misses == 3);
+
+    // Resources that outlive the cache keep a notifier that doesn't do anything anymore
+    cache.Shutdown();
+    newResource->Release();
+
+    heap.Shutdown();
+}
+
+DXL_TEST(DescriptorCacheKeepsWatchingEvictedResources)
+{
+    BindlessDescriptorHeap heap;
+    heap.Initialize({ .NumPersistentDescriptors = 16, .NumTransientDescriptors = 0 });
+
+    DescriptorCache cache;
+    cache.Initialize({ .ResourceHeap = &heap });
+
+    MockResource* resource = new MockResource();
+    cache.CreateShaderResourceView(resource, nullptr);
+    cache.EvictResource(resource);
+    CHECK(cache.GetStats().NumViews == 0);
+
+    // Views created after a manual eviction are still evicted when the resource goes away
+    cache.CreateShaderResourceView(resource, nullptr);
+    CHECK(cache.GetStats().NumViews == 1);
+    resource->Release();
+    CHECK(cache.GetStats().NumViews == 0);
+
+    cache.Shutdown();
+    heap.Shutdown();
+}
+
+DXL_TEST(DescriptorCacheKeepsEvictedViewsUntilTheyreReleased)
+{
+    BindlessDescriptorHeap heap;
+    heap.Initialize({ .NumPersistentDescriptors = 16, .NumTransientDescriptors = 0 });
+
+    DescriptorCache cache;
+    cache.Initialize({ .ResourceHeap = &heap });
+
+    // Freed descriptors only go back to the heap once the frame they were freed in is done
+    uint64_t frame = 0;
+    auto endFrame = [&]()
+    {
+        heap.Retire(++frame);
+        heap.ReleaseCompleted(frame);
+    };
+
+    MockResource* resource = new MockResource();
+    DescriptorAllocation srv = cache.CreateShaderResourceView(resource, nullptr);
+    DescriptorAllocation sameSRV = cache.CreateShaderResourceView(resource, nullptr);
+    CHECK(heap.GetNumPersistentAllocated() == 1);
+
+    cache.EvictResource(resource);
+    CHECK(cache.GetStats().NumViews == 0);
+    CHECK(cache.GetStats().NumEvictedViews == 1);
+
+    // The evicted descriptor is still held, so a new view needs a new one
+    DescriptorAllocation newSRV = cache.CreateShaderResourceView(resource, nullptr);
+    CHECK(newSRV.Index != srv.Index);
+    CHECK(heap.GetNumPersistentAllocated() == 2);
+
+    cache.ReleaseView(srv);
+    CHECK(srv.IsValid() == false);
+    CHECK(cache.GetStats().NumEvictedViews == 1);
+    endFrame();
+    CHECK(heap.GetNumPersistentAllocated() == 2);
+
+    cache.ReleaseView(sameSRV);
+    CHECK(cache.GetStats().NumEvictedViews == 0);
+    endFrame();
+    CHECK(heap.GetNumPersistentAllocated() == 1);
+
+    // Destroying the resource evicts the new view the same way
+    resource->Release();
+    CHECK(cache.GetStats().NumViews == 0);
+    CHECK(cache.GetStats().NumEvictedViews == 1);
+    cache.ReleaseView(newSRV);
+    endFrame();
+    CHECK(heap.GetNumPersistentAllocated() == 0);
+
+    // Shutdown frees evicted views that were never released
+    MockResource* otherResource = new MockResource();
+    cache.CreateShaderResourceView(otherResource, nullptr);
+    cache.EvictResource(otherResource);
+    cache.Shutdown();
+    endFrame();
+    CHECK(heap.GetNumPersistentAllocated() == 0);
+
+    otherResource->Release();
+    heap.Shutdown();
+}
+
+// == Timeline =====================================================
+
+DXL_TEST(TimelineCachesTheCompletedValue)
+{
+    MockCommandQueue* queue = new MockCommandQueue();
+    MockFence* fence = new MockFence();
+
+    Timeline timeline;
+    timeline.Initialize({ .Queue = queue, .Fence = fence });
+
+    const uint64_t first = timeline.Signal();
+    const uint64_t second = timeline.Signal();
+    CHECK(first == 1 && second == 2);
+    CHECK(queue->SignaledValues == std::vector<uint64_t>({ 1, 2 }));
+    CHECK(timeline.GetLastSignaled() == 2);
+
+    // Tickets newer than the cached value have to go to the fence
+    const uint32_t numReads = fence->NumCompletedValueReads;
+    CHECK(timeline.IsComplete(first) == false);
+    CHECK(fence->NumCompletedValueReads == numReads + 1);
+
+    fence->Signal(2);
+    CHECK(timeline.IsComplete(second));
+    CHECK(fence->NumCompletedValueReads == numReads + 2);
+
+    // Once the fence has been seen at 2, neither ticket needs to read it again, and waits return without an event
+    CHECK(timeline.IsComplete(first));
+    CHECK(timeline.IsComplete(second));
+    CHECK(timeline.Wait(second, 0));
+    CHECK(fence->NumCompletedValueReads == numReads + 2);
+    CHECK(fence->WaitEvents.empty());
+
+    timeline.Shutdown();
+    fence->Release();
+    queue->Release();
+}
+
+DXL_TEST(TimelineWaitsReuseTheirEvents)
+{
+    MockCommandQueue* queue = new MockCommandQueue();
+    MockFence* fence = new MockFence();
+
+    Timeline timeline;
+    timeline.Initialize({ .Queue = queue, .Fence = fence });
+
+    // A wait that times out hands its event back to the pool, and the next wait picks the same one up
+    const uint64_t ticket = timeline.Signal();
+    CHECK(timeline.Wait(ticket, 0) == false);
+    CHECK(timeline.Wait(ticket, 0) == false);
+    CHECK(fence->WaitEvents.size() == 2);
+    CHECK(fence->WaitEvents[0] == fence->WaitEvents[1]);
+
+    // The timed out waits left the event to be signaled later, which a blocking wait on a newer ticket has to see
+    // through instead of returning early
+    const uint64_t nextTicket = timeline.Signal();
+    std::thread gpuThread([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        fence->Signal(ticket);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        fence->Signal(nextTicket);
+    });
+
+    CHECK(timeline.Wait(nextTicket));
+    gpuThread.join();
+    CHECK(timeline.IsComplete(nextTicket));
+    CHECK(std::all_of(fence->WaitEvents.begin(), fence->WaitEvents.end(), [&](HANDLE event) { return event == fence->WaitEvents[0]; }));
+
+    timeline.Shutdown();
+    fence->Release();
+    queue->Release();
+}
+
+// == ReadbackManager =====================================================
+
+DXL_TEST(ReadbackManagerShutdownWaitsForSubmittedCopies)
+{
+    MockFence* fence = new MockFence();
+
+    ReadbackManager readbacks;
+    readbacks.Initialize({ .Fence = fence, .StartWorkerThread = false });
+
+    bool callbackRan = false;
+    readbacks.ReadBuffer(nullptr, nullptr, 0, 256, [&](const ReadbackData&) { callbackRan = true; });
+    readbacks.Submit(1);
+    readbacks.ReadBuffer(nullptr, nullptr, 0, 256);
+    readbacks.Submit(2);
+    readbacks.ReadBuffer(nullptr, nullptr, 0, 256);
+
+    // The buffers can't be destroyed until the fence reaches the last submitted value
+    std::atomic<bool> shutDown = false;
+    std::thread shutdownThread([&]()
+    {
+        readbacks.Shutdown();
+        shutDown = true;
+    });
+
+    fence->Signal(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(shutDown == false);
+
+    fence->Signal(2);
+    shutdownThread.join();
+    CHECK(shutDown);
+
+    // Requests that hadn't completed when Shutdown started are dropped
+    CHECK(callbackRan == false);
+
+    fence->Release();
+}
+
+// == TraceSink =====================================================
+
+DXL_TEST(TraceScopesAreRecordedOnTheActiveSink)
+{
+    {
+        TraceScope beforeSink("BeforeSink");
+
+        TraceSink sink;
+        sink.Initialize({ .StartFlushThread = false });
+
+        {
+            TraceScope scope("Scope");
+        }
+
+        sink.Flush();
+        CHECK(sink.GetNumEvents() == 1);
+        sink.Shutdown();
+    }
+
+    // Scopes that started before the sink existed, or end after it's gone, aren't recorded anywhere
+    TraceSink sink;
+    sink.Initialize({ .StartFlushThread = false });
+    sink.Flush();
+    CHECK(sink.GetNumEvents() == 0);
+    sink.Shutdown();
+}
+
+DXL_TEST(TraceSinkShutdownIsSafeWhileOtherThreadsRecord)
+{
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> numScopes = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t threadIdx = 0; threadIdx < 4; ++threadIdx)
+    {
+        threads.emplace_back([&]()
+        {
+            while (stop == false)
+            {
+                TraceScope scope("Work");
+                numScopes += 1;
+            }
+        });
+    }
+
+    for (uint32_t iteration = 0; iteration < 200; ++iteration)
+    {
+        TraceSink sink;
+        sink.Initialize({ .EventsPerThread = 64, .FlushIntervalMS = 1 });
+
+        const uint64_t startScopes = numScopes;
+        while (numScopes < startScopes + 100)
+            std::this_thread::yield();
+
+        sink.Shutdown();
+    }
+
+    stop = true;
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+// == TextureUploader =====================================================
+
+static D3D12_RESOURCE_DESC1 MakeTexture2DDesc(uint32_t width, uint32_t height, uint16_t mipLevels)
+{
+    D3D12_RESOURCE_DESC1 desc = { };
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = mipLevels;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    return desc;
+}
+
+DXL_TEST(TextureUploaderReportsSubresourcesThatDontFit)
+{
+    TextureUploader uploader;
+    uploader.Initialize({ .StagingSize = 64 * 1024 });
+
+    // 256x256 RGBA8 is 256KB, which can't fit in the staging ring even on its own
+    const D3D12_RESOURCE_DESC1 desc = MakeTexture2DDesc(256, 256, 1);
+    std::vector<uint8_t> texels(256 * 256 * 4);
+    const D3D12_SUBRESOURCE_DATA subresource = { .pData = texels.data(), .RowPitch = 256 * 4, .SlicePitch = 256 * 256 * 4 };
+
+    CHECK(uploader.Upload(nullptr, desc, Span<const D3D12_SUBRESOURCE_DATA>(1, &subresource)) == 0);
+    CHECK(TakeReportedErrors() == 1);
+    CHECK(uploader.GetStats().NumUploads == 0);
+
+    uploader.Shutdown();
+}
+
+DXL_TEST(TextureUploaderSplitsAndPacksConcurrentUploads)
+{
+    TextureUploader uploader;
+    uploader.Initialize({ .StagingSize = 128 * 1024 });
+
+    // The full mip chain is ~85KB, so uploads from several threads keep filling the ring and flushing each other
+    const D3D12_RESOURCE_DESC1 desc = MakeTexture2DDesc(128, 128, 8);
+    const TextureFootprints& footprints = uploader.GetFootprints(desc);
+    CHECK(footprints.Layouts.size() == 8);
+
+    std::vector<std::vector<uint8_t>> texels(8);
+    D3D12_SUBRESOURCE_DATA subresources[8] = { };
+    for (uint32_t mipIdx = 0; mipIdx < 8; ++mipIdx)
+    {
+        const uint32_t mipSize = std::max(128u >> mipIdx, 1u);
+        texels[mipIdx].resize(mipSize * mipSize * 4, uint8_t(mipIdx));
+        subresources[mipIdx] = { .pData = texels[mipIdx].data(), .RowPitch = mipSize * 4, .SlicePitch = mipSize * mipSize * 4 };
+    }
+
+    const uint32_t numThreads = 4;
+    const uint32_t numUploadsPerThread = 50;
+    std::atomic<uint32_t> numFailedUploads = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+    {
+        threads.emplace_back([&]()
+        {
+            for (uint32_t uploadIdx = 0; uploadIdx < numUploadsPerThread; ++uploadIdx)
+            {
+                const uint64_t fenceValue = uploader.Upload(nullptr, desc, Span<const D3D12_SUBRESOURCE_DATA>(8, subresources));
+                if (fenceValue == 0)
+                    numFailedUploads += 1;
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    const uint64_t lastFenceValue = uploader.Flush();
+    CHECK(numFailedUploads == 0);
+    CHECK(uploader.IsComplete(lastFenceValue));
+
+    const TextureUploaderStats stats = uploader.GetStats();
+    CHECK(stats.NumUploads == numThreads * numUploadsPerThread);
+    CHECK(stats.NumSubresources == numThreads * numUploadsPerThread * 8);
+    CHECK(stats.NumFlushes > 1);
+
+    // A texture that only fits a mip at a time gets split up instead of failing
+    const D3D12_RESOURCE_DESC1 largeDesc = MakeTexture2DDesc(128, 256, 2);
+    std::vector<uint8_t> largeTexels(128 * 256 * 4);
+    const D3D12_SUBRESOURCE_DATA largeSubresources[2] =
+    {
+        { .pData = largeTexels.data(), .RowPitch = 128 * 4, .SlicePitch = 128 * 256 * 4 },
+        { .pData = largeTexels.data(), .RowPitch = 64 * 4, .SlicePitch = 64 * 128 * 4 },
+    };
+    CHECK(uploader.Upload(nullptr, largeDesc, Span<const D3D12_SUBRESOURCE_DATA>(2, largeSubresources)) != 0);
+    CHECK(uploader.GetStats().NumSubresources == stats.NumSubresources + 2);
+
+    uploader.Shutdown();
+}
+
+// == FramePacer =====================================================
+
+static void AddFramePacerWindow(FramePacer& pacer, uint32_t windowSize, uint32_t numMissed)
+{
+    for (uint32_t i = 0; i < windowSize; ++i)
+        pacer.AddSample({ .PresentIntervalMS = 16.6, .MissedRefreshes = i < numMissed ? 1u : 0u });
+}
+
+DXL_TEST(FramePacerRaisesLatencyWhenFramesMissTheirRefresh)
+{
+    FramePacer pacer;
+    pacer.Initialize({ .InitialFrameLatency = 1, .MinFrameLatency = 1, .MaxFrameLatency = 3, .AdjustmentWindow = 8, .MaxMissedPerWindow = 1 });
+    CHECK(pacer.GetFrameLatency() == 1);
+
+    // Up to MaxMissedPerWindow is tolerated, and nothing changes until the window is complete
+    AddFramePacerWindow(pacer, 8, 1);
+    CHECK(pacer.GetFrameLatency() == 1);
+    AddFramePacerWindow(pacer, 7, 7);
+    CHECK(pacer.GetFrameLatency() == 1);
+    AddFramePacerWindow(pacer, 1, 0);
+    CHECK(pacer.GetFrameLatency() == 2);
+
+    AddFramePacerWindow(pacer, 8, 8);
+    CHECK(pacer.GetFrameLatency() == 3);
+    AddFramePacerWindow(pacer, 8, 8);
+    CHECK(pacer.GetFrameLatency() == 3);
+
+    CHECK(pacer.GetStats().NumMissedRefreshes == 1 + 7 + 8 + 8);
+    pacer.Shutdown();
+}
+
+DXL_TEST(FramePacerBacksOffLoweringLatencyThatDoesntHold)
+{
+    FramePacer pacer;
+    pacer.Initialize({ .InitialFrameLatency = 2, .MinFrameLatency = 1, .MaxFrameLatency = 3, .AdjustmentWindow = 4, .MaxMissedPerWindow = 0 });
+
+    // A clean window lowers the latency right away
+    AddFramePacerWindow(pacer, 4, 0);
+    CHECK(pacer.GetFrameLatency() == 1);
+
+    // Missing after a decrease raises it again and holds it for twice as many windows as before
+    for (uint32_t holdWindows : { 2u, 4u, 8u })
+    {
+        AddFramePacerWindow(pacer, 4, 1);
+        CHECK(pacer.GetFrameLatency() == 2);
+
+        for (uint32_t window = 0; window < holdWindows; ++window)
+            AddFramePacerWindow(pacer, 4, 0);
+        CHECK(pacer.GetFrameLatency() == 2);
+
+        AddFramePacerWindow(pacer, 4, 0);
+        CHECK(pacer.GetFrameLatency() == 1);
+    }
+
+    // Once the lowest latency holds for a full window the back-off starts over
+    AddFramePacerWindow(pacer, 4, 0);
+    AddFramePacerWindow(pacer, 4, 1);
+    CHECK(pacer.GetFrameLatency() == 2);
+    AddFramePacerWindow(pacer, 4, 0);
+    AddFramePacerWindow(pacer, 4, 0);
+    CHECK(pacer.GetFrameLatency() == 2);
+    AddFramePacerWindow(pacer, 4, 0);
+    CHECK(pacer.GetFrameLatency() == 1);
+
+    pacer.Shutdown();
+}
+
+DXL_TEST(FramePacerOnlyLowersLatencyAboveTheTarget)
+{
+    FramePacer pacer;
+    pacer.Initialize({ .InitialFrameLatency = 3, .MinFrameLatency = 1, .MaxFrameLatency = 3, .TargetLatencyMS = 40.0f, .AdjustmentWindow = 4 });
+
+    for (uint32_t i = 0; i < 4; ++i)
+        pacer.AddSample({ .InputToDisplayMS = 50.0 });
+    CHECK(pacer.GetFrameLatency() == 2);
+
+    for (uint32_t i = 0; i < 4; ++i)
+        pacer.AddSample({ .InputToDisplayMS = 30.0 });
+    CHECK(pacer.GetFrameLatency() == 2);
+
+    pacer.Shutdown();
+}
+
+// == GPUProfiler =====================================================
+
+DXL_TEST(GPUProfilerNestsScopesAndTimesThemFromTheirTimestamps)
+{
+    MockFence* fence = new MockFence();
+
+    // One tick per microsecond, so a timestamp of 1000 is 1ms
+    std::vector<uint64_t> timestamps;
+    size_t nextTimestamp = 0;
+
+    GPUProfiler profiler;
+    profiler.Initialize(
+    {
+        .Fence = fence,
+        .NumFramesInFlight = 2,
+        .FakeTimestamps = [&]() { return timestamps[nextTimestamp++]; },
+        .FakeTimestampFrequency = 1000000,
+    });
+
+    auto isNear = [](double value, double expected) { return std::abs(value - expected) < 1e-9; };
+
+    // Frame 0 is A { B, C } followed by D { B }
+    timestamps = { 100, 200, 500, 600, 650, 1000, 1000, 1100, 1300, 1500 };
+    profiler.BeginFrame();
+    profiler.BeginScope(IDXLCommandList(), "A");
+    profiler.BeginScope(IDXLCommandList(), "B");
+    profiler.EndScope(IDXLCommandList());
+    profiler.BeginScope(IDXLCommandList(), "C");
+    profiler.EndScope(IDXLCommandList());
+    profiler.EndScope(IDXLCommandList());
+    profiler.BeginScope(IDXLCommandList(), "D");
+    profiler.BeginScope(IDXLCommandList(), "B");
+    profiler.EndScope(IDXLCommandList());
+    profiler.EndScope(IDXLCommandList());
+    profiler.EndFrame(IDXLCommandList(), 1);
+    CHECK(nextTimestamp == timestamps.size());
+
+    // Nothing is read back until the fence passes the frame
+    profiler.BeginFrame();
+    CHECK(profiler.GetLastFrame().FrameIndex == UINT64_MAX);
+
+    // Frame 1 is A { B }
+    timestamps = { 2000, 2100, 2200, 3000 };
+    nextTimestamp = 0;
+    profiler.BeginScope(IDXLCommandList(), "A");
+    profiler.BeginScope(IDXLCommandList(), "B");
+    profiler.EndScope(IDXLCommandList());
+    profiler.EndScope(IDXLCommandList());
+    profiler.EndFrame(IDXLCommandList(), 2);
+
+    fence->Signal(1);
+    profiler.BeginFrame();
+
+    const GPUProfileFrame& frame = profiler.GetLastFrame();
+    CHECK(frame.FrameIndex == 0);
+    CHECK(frame.Scopes.size() == 5);
+    if (frame.Scopes.size() == 5)
+    {
+        const char* names[] = { "A", "B", "C", "D", "B" };
+        const uint32_t parents[] = { UINT32_MAX, 0, 0, UINT32_MAX, 3 };
+        const uint32_t depths[] = { 0, 1, 1, 0, 1 };
+        const double startMS[] = { 0.1, 0.2, 0.6, 1.0, 1.1 };
+        const double endMS[] = { 1.0, 0.5, 0.65, 1.5, 1.3 };
+        for (uint32_t scopeIdx = 0; scopeIdx < 5; ++scopeIdx)
+        {
+            const GPUProfileScope& scope = frame.Scopes[scopeIdx];
+            CHECK(strcmp(scope.Name, names[scopeIdx]) == 0);
+            CHECK(scope.Parent == parents[scopeIdx]);
+            CHECK(scope.Depth == depths[scopeIdx]);
+            CHECK(isNear(scope.StartMS, startMS[scopeIdx]));
+            CHECK(isNear(scope.EndMS, endMS[scopeIdx]));
+        }
+    }
+
+    profiler.EndFrame(IDXLCommandList(), 3);
+    fence->Signal(2);
+    profiler.BeginFrame();
+    CHECK(profiler.GetLastFrame().FrameIndex == 1);
+
+    // The B under A is merged across frames, but isn't the same node as the B under D
+    const std::vector<GPUProfileNodeStats> stats = profiler.GetStats();
+    CHECK(stats.size() == 5);
+    if (stats.size() == 5)
+    {
+        CHECK(strcmp(stats[0].Name, "A") == 0 && stats[0].NumSamples == 2);
+        CHECK(isNear(stats[0].MinMS, 0.9) && isNear(stats[0].MaxMS, 1.0) && isNear(stats[0].AvgMS, 0.95) && isNear(stats[0].LastMS, 1.0));
+
+        CHECK(strcmp(stats[1].Name, "B") == 0 && stats[1].Parent == 0 && stats[1].NumSamples == 2);
+        CHECK(isNear(stats[1].MinMS, 0.1) && isNear(stats[1].MaxMS, 0.3) && isNear(stats[1].AvgMS, 0.2));
+
+        CHECK(strcmp(stats[2].Name, "C") == 0 && stats[2].Parent == 0 && stats[2].NumSamples == 1);
+        CHECK(strcmp(stats[3].Name, "D") == 0 && stats[3].Parent == UINT32_MAX && stats[3].Depth == 0);
+        CHECK(strcmp(stats[4].Name, "B") == 0 && stats[4].Parent == 3 && stats[4].NumSamples == 1 && isNear(stats[4].LastMS, 0.2));
+    }
+
+    profiler.EndFrame(IDXLCommandList(), 4);
+    profiler.Shutdown();
+    fence->Release();
+}
+
+// == ResidencyManager =====================================================
+
+DXL_TEST(ResidencyManagerEvictsTheLeastRecentlyUsedObjectsTheGPUIsDoneWith)
+{
+    MockFence* fence = new MockFence();
+
+    // Evicting down to the budget itself means only as much is evicted as needed, which shows the order
+    ResidencyManager residency;
+    residency.Initialize({ .Fence = fence, .Budget = 400, .EvictionTarget = 1.0f });
+
+    const uint32_t a = residency.TrackObject(nullptr, 100);
+    const uint32_t b = residency.TrackObject(nullptr, 100);
+    const uint32_t c = residency.TrackObject(nullptr, 100);
+    const uint32_t d = residency.TrackObject(nullptr, 100);
+    const uint32_t e = residency.TrackObject(nullptr, 100, false);
+    const uint32_t f = residency.TrackObject(nullptr, 400, false);
+    CHECK(residency.GetStats().ResidentBytes == 400);
+
+    auto submit = [&](std::vector<uint32_t> handles, uint64_t fenceValue)
+    {
+        ResidencySet residencySet;
+        for (uint32_t handle : handles)
+            residencySet.Insert(handle);
+
+        const ResidencySet* residencySets[] = { &residencySet };
+        residency.ExecuteCommandLists(IDXLCommandQueue(), Span<ID3D12CommandList* const>(), Span<const ResidencySet* const>(1, residencySets), fenceValue);
+    };
+
+    // From least to most recently used that's D, A, B, C
+    submit({ a, b }, 1);
+    submit({ c }, 2);
+
+    // A, B and C are still in flight, so D is the only one that can make room for E
+    submit({ e }, 3);
+    CHECK(residency.IsResident(d) == false);
+    CHECK(residency.IsResident(a) && residency.IsResident(b) && residency.IsResident(c) && residency.IsResident(e));
+    CHECK(residency.GetStats().NumEvicted == 1);
+
+    // Once the GPU is done with the first submission, A goes before B
+    fence->Signal(1);
+    submit({ d }, 4);
+    CHECK(residency.IsResident(a) == false);
+    CHECK(residency.IsResident(b) && residency.IsResident(c) && residency.IsResident(d) && residency.IsResident(e));
+    CHECK(residency.GetStats().NumEvicted == 2);
+    CHECK(residency.GetStats().NumOverBudget == 0);
+
+    // F needs everything to be evicted, but C is used by the same submission so it stays
+    fence->Signal(4);
+    submit({ c, f }, 5);
+    CHECK(residency.IsResident(c) && residency.IsResident(f));
+    CHECK(residency.IsResident(b) == false && residency.IsResident(d) == false && residency.IsResident(e) == false);
+    CHECK(residency.GetStats().ResidentBytes == 500);
+    CHECK(residency.GetStats().NumOverBudget == 1);
+
+    const ResidencyManagerStats stats = residency.GetStats();
+    CHECK(stats.NumEvicted == 5 && stats.BytesEvicted == 500);
+    CHECK(stats.NumMadeResident == 3 && stats.BytesMadeResident == 600);
+    CHECK(stats.NumResident == 2 && stats.NumObjects == 6);
+
+    residency.Shutdown();
+    fence->Release();
+}
+
+// == TransientResourceAllocator =====================================================
+
+static bool RangesOverlap(uint64_t startA, uint64_t endA, uint64_t startB, uint64_t endB)
+{
+    return startA < endB && startB < endA;
+}
+
+DXL_TEST(PackTransientResourcesOnlyAliasesDisjointPassRanges)
+{
+    std::mt19937 rng(1234);
+    std::vector<TransientPackingRequest> requests;
+    for (uint32_t requestIdx = 0; requestIdx < 200; ++requestIdx)
+    {
+        const uint32_t firstPass = uint32_t(rng() % 50);
+        requests.push_back(
+        {
+            .Size = uint64_t(1 + rng() % 32) * 64 * 1024,
+            .Alignment = (rng() % 4 == 0) ? 4 * 1024 * 1024ull : 64 * 1024ull,
+            .FirstPass = firstPass,
+            .LastPass = firstPass + uint32_t(rng() % 10),
+            .HeapGroup = uint32_t(rng() % 2),
+        });
+    }
+
+    const uint64_t maxHeapSize = 16 * 1024 * 1024;
+    std::vector<TransientPlacement> placements;
+    std::vector<TransientHeapLayout> heaps;
+    PackTransientResources(Span<const TransientPackingRequest>(uint32_t(requests.size()), requests.data()), maxHeapSize, placements, heaps);
+    CHECK(placements.size() == requests.size());
+
+    uint32_t numConflicts = 0;
+    uint64_t unaliasedBytes = 0;
+    for (uint32_t requestIdx = 0; requestIdx < uint32_t(requests.size()); ++requestIdx)
+    {
+        const TransientPackingRequest& request = requests[requestIdx];
+        const TransientPlacement& placement = placements[requestIdx];
+        unaliasedBytes += request.Size;
+
+        CHECK(placement.HeapIndex < heaps.size());
+        CHECK(heaps[placement.HeapIndex].HeapGroup == request.HeapGroup);
+        CHECK(placement.Offset % request.Alignment == 0);
+        CHECK(placement.Offset + request.Size <= heaps[placement.HeapIndex].Size);
+        CHECK(heaps[placement.HeapIndex].Size <= maxHeapSize);
+
+        for (uint32_t otherIdx = 0; otherIdx < requestIdx; ++otherIdx)
+        {
+            const TransientPackingRequest& other = requests[otherIdx];
+            const TransientPlacement& otherPlacement = placements[otherIdx];
+            if (otherPlacement.HeapIndex == placement.HeapIndex && RangesOverlap(request.FirstPass, request.LastPass + 1, other.FirstPass, other.LastPass + 1) &&
+                RangesOverlap(placement.Offset, placement.Offset + request.Size, otherPlacement.Offset, otherPlacement.Offset + other.Size))
+                numConflicts += 1;
+        }
+    }
+
+    CHECK(numConflicts == 0);
+
+    // Short lifetimes spread over 60 passes should need a lot less than the unaliased size
+    uint64_t heapBytes = 0;
+    for (const TransientHeapLayout& heap : heaps)
+        heapBytes += heap.Size;
+    CHECK(heapBytes < unaliasedBytes / 2);
+}
+
+DXL_TEST(PackTransientResourcesSharesMemoryBetweenSequentialResources)
+{
+    const TransientPackingRequest requests[] =
+    {
+        { .Size = 4 * 1024 * 1024, .FirstPass = 0, .LastPass = 1 },
+        { .Size = 4 * 1024 * 1024, .FirstPass = 2, .LastPass = 3 },
+        { .Size = 2 * 1024 * 1024, .FirstPass = 1, .LastPass = 2 },
+    };
+
+    std::vector<TransientPlacement> placements;
+    std::vector<TransientHeapLayout> heaps;
+    PackTransientResources(Span<const TransientPackingRequest>(3, requests), 64 * 1024 * 1024, placements, heaps);
+
+    CHECK(heaps.size() == 1);
+    CHECK(heaps[0].Size == 6 * 1024 * 1024);
+    CHECK(placements[0].Offset == placements[1].Offset);
+    CHECK(placements[2].Offset == 4 * 1024 * 1024);
+
+    // Resources that don't fit in any heap get one of their own instead of failing
+    PackTransientResources(Span<const TransientPackingRequest>(3, requests), 5 * 1024 * 1024, placements, heaps);
+    CHECK(heaps.size() == 2);
+    CHECK(placements[0].HeapIndex == placements[1].HeapIndex);
+    CHECK(placements[2].HeapIndex != placements[0].HeapIndex);
+}
+
+static uint32_t AddDepthBuffer(TransientResourceAllocator& allocator, float clearDepth, uint8_t garbage)
+{
+    // Only the depth and stencil parts of the clear value are meaningful for a depth buffer
+    D3D12_CLEAR_VALUE clearValue;
+    memset(&clearValue, garbage, sizeof(clearValue));
+    clearValue.Format = DXGI_FORMAT_D32_FLOAT;
+    clearValue.DepthStencil.Depth = clearDepth;
+    clearValue.DepthStencil.Stencil = 0;
+
+    TransientResourceDesc desc;
+    desc.Desc = { .Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D, .Width = 256, .Height = 256, .DepthOrArraySize = 1, .MipLevels = 1, .Format = DXGI_FORMAT_D32_FLOAT,
+                  .SampleDesc = { .Count = 1 }, .Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL };
+    desc.OptimizedClearValue = &clearValue;
+    desc.FirstPass = 0;
+    desc.LastPass = 1;
+    return allocator.AddResource(desc);
+}
+
+DXL_TEST(TransientResourcesAreReusedWhenOnlyUnusedClearValueBytesChange)
+{
+    MockDevice* device = new MockDevice();
+
+    TransientResourceAllocator allocator;
+    allocator.Initialize({ .Device = device });
+
+    AddDepthBuffer(allocator, 1.0f, 0x00);
+    allocator.Compile();
+    CHECK(allocator.GetStats().NumResourcesCreated == 1);
+    const IDXLResource depthBuffer = allocator.GetResource(0);
+
+    allocator.Reset();
+    AddDepthBuffer(allocator, 1.0f, 0xCD);
+    allocator.Compile();
+    CHECK(allocator.GetStats().NumResourcesCreated == 0);
+    CHECK(allocator.GetResource(0) == depthBuffer);
+
+    // A different depth does need a new resource
+    allocator.Reset();
+    AddDepthBuffer(allocator, 0.0f, 0xCD);
+    allocator.Compile();
+    CHECK(allocator.GetStats().NumResourcesCreated == 1);
+    CHECK(allocator.GetResource(0) != depthBuffer);
+
+    allocator.Shutdown();
+    device->Release();
+}
+
+DXL_TEST(AcquiringTransientResourcesRecordsOneBarrierCall)
+{
+    RecordingCommandListFixture fixture(DXL_COMMAND_LIST_FEATURE_FLAG_DEFAULT);
+
+    TransientResourceAllocator allocator;
+    allocator.Initialize({ .Device = fixture.Device });
+
+    TransientResourceDesc textureDesc;
+    textureDesc.Desc = { .Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D, .Width = 256, .Height = 256, .DepthOrArraySize = 1, .MipLevels = 1, .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+                         .SampleDesc = { .Count = 1 }, .Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET };
+    textureDesc.FirstLayout = D3D12_BARRIER_LAYOUT_RENDER_TARGET;
+    allocator.AddResource(textureDesc);
+    allocator.AddResource(textureDesc);
+
+    TransientResourceDesc bufferDesc;
+    bufferDesc.Desc = { .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER, .Width = 64 * 1024, .Height = 1, .DepthOrArraySize = 1, .MipLevels = 1,
+                        .SampleDesc = { .Count = 1 }, .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR };
+    allocator.AddResource(bufferDesc);
+
+    // Nothing starts in the second pass
+    textureDesc.FirstPass = 2;
+    textureDesc.LastPass = 2;
+    allocator.AddResource(textureDesc);
+
+    allocator.Compile();
+
+    allocator.AcquireResources(fixture.CommandList, 0);
+    CHECK(fixture.Recording->BarrierCalls.size() == 1);
+    if (fixture.Recording->BarrierCalls.size() == 1)
+    {
+        const std::vector<RecordingCommandList::BarrierGroup>& groups = fixture.Recording->BarrierCalls[0];
+        CHECK(groups.size() == 2);
+        CHECK(groups[0].Type == D3D12_BARRIER_TYPE_BUFFER && groups[0].BufferBarriers.size() == 1);
+        CHECK(groups[1].Type == D3D12_BARRIER_TYPE_TEXTURE && groups[1].TextureBarriers.size() == 2);
+    }
+
+    allocator.AcquireResources(fixture.CommandList, 1);
+    CHECK(fixture.Recording->BarrierCalls.size() == 1);
+
+    allocator.AcquireResources(fixture.CommandList, 2);
+    CHECK(fixture.Recording->BarrierCalls.size() == 2);
+    CHECK(fixture.Recording->BarrierCalls.back().size() == 1);
+
+    allocator.Shutdown();
+}
+
+// == RenderGraph =====================================================
+
+static const RenderGraphUsage RenderTargetUsage = { .Sync = D3D12_BARRIER_SYNC_RENDER_TARGET, .Access = D3D12_BARRIER_ACCESS_RENDER_TARGET, .Layout = D3D12_BARRIER_LAYOUT_RENDER_TARGET };
+static const RenderGraphUsage PixelShaderReadUsage = { .Sync = D3D12_BARRIER_SYNC_PIXEL_SHADING, .Access = D3D12_BARRIER_ACCESS_SHADER_RESOURCE, .Layout = D3D12_BARRIER_LAYOUT_SHADER_RESOURCE };
+static const RenderGraphUsage ComputeShaderReadUsage = { .Sync = D3D12_BARRIER_SYNC_COMPUTE_SHADING, .Access = D3D12_BARRIER_ACCESS_SHADER_RESOURCE, .Layout = D3D12_BARRIER_LAYOUT_SHADER_RESOURCE };
+static const RenderGraphUsage PresentUsage = { .Sync = D3D12_BARRIER_SYNC_NONE, .Access = D3D12_BARRIER_ACCESS_NO_ACCESS, .Layout = D3D12_BARRIER_LAYOUT_PRESENT };
+
+// The barriers for one texture before a pass
+static std::vector<D3D12_TEXTURE_BARRIER> GetTextureBarriers(const RenderGraph& graph, uint32_t passIndex, ID3D12Resource* texture)
+{
+    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
+    graph.GetPassBarriers(passIndex, textureBarriers, bufferBarriers);
+    std::erase_if(textureBarriers, [texture](const D3D12_TEXTURE_BARRIER& barrier) { return barrier.pResource != texture; });
+    return textureBarriers;
+}
+
+DXL_TEST(RenderGraphCullsPassesWhoseResultsAreNeverUsed)
+{
+    TransientResourceAllocator allocator;
+    allocator.Initialize({ });
+
+    RenderGraph graph;
+    graph.Initialize({ .TransientAllocator = &allocator });
+
+    MockResource* backBuffer = new MockResource();
+    const uint32_t backBufferIdx = graph.ImportTexture(backBuffer, PresentUsage);
+    const D3D12_RESOURCE_DESC1 desc = MakeTexture2DDesc(64, 64, 1);
+    const uint32_t gbuffer = graph.CreateTexture(desc);
+    const uint32_t unusedOutput = graph.CreateTexture(desc);
+    const uint32_t debugOutput = graph.CreateTexture(desc);
+
+    std::vector<uint32_t> executedPasses;
+    uint32_t numPasses = 0;
+    auto addPass = [&](const char* name)
+    {
+        const uint32_t passIdx = numPasses++;
+        return graph.AddPass(name, [&executedPasses, passIdx](IDXLCommandList) { executedPasses.push_back(passIdx); });
+    };
+
+    const uint32_t gbufferPass = addPass("GBuffer");
+    graph.Write(gbufferPass, gbuffer, RenderTargetUsage);
+
+    const uint32_t unusedPass = addPass("Unused");
+    graph.Write(unusedPass, unusedOutput, RenderTargetUsage);
+
+    // Reading a needed resource doesn't keep a pass alive, only writing one does
+    const uint32_t debugPass = addPass("Debug");
+    graph.Read(debugPass, gbuffer, PixelShaderReadUsage);
+    graph.Write(debugPass, debugOutput, RenderTargetUsage);
+
+    const uint32_t lightingPass = addPass("Lighting");
+    graph.Read(lightingPass, gbuffer, PixelShaderReadUsage);
+    graph.Write(lightingPass, backBufferIdx, RenderTargetUsage);
+
+    const uint32_t readbackPass = addPass("Readback");
+    graph.SetSideEffects(readbackPass);
+
+    graph.Compile();
+    CHECK(graph.IsPassCulled(gbufferPass) == false);
+    CHECK(graph.IsPassCulled(unusedPass));
+    CHECK(graph.IsPassCulled(debugPass));
+    CHECK(graph.IsPassCulled(lightingPass) == false);
+    CHECK(graph.IsPassCulled(readbackPass) == false);
+    CHECK(graph.GetStats().NumCulledPasses == 2);
+
+    graph.Execute(IDXLCommandList());
+    CHECK(executedPasses.size() == 3 && executedPasses[0] == gbufferPass && executedPasses[1] == lightingPass && executedPasses[2] == readbackPass);
+
+    // Culled passes don't keep transient resources alive
+    CHECK(allocator.GetStats().NumResources == 1);
+
+    graph.Shutdown();
+    allocator.Shutdown();
+    backBuffer->Release();
+}
+
+DXL_TEST(RenderGraphWidensBarriersForReadsThatNeedMoreSync)
+{
+    RenderGraph graph;
+    graph.Initialize({ .EnableSplitBarriers = false });
+
+    MockResource* texture = new MockResource();
+    const uint32_t textureIdx = graph.ImportTexture(texture, RenderTargetUsage);
+
+    const uint32_t writePass = graph.AddPass("Write", nullptr);
+    graph.Write(writePass, textureIdx, RenderTargetUsage);
+    const uint32_t pixelReadPass = graph.AddPass("PixelRead", nullptr);
+    graph.Read(pixelReadPass, textureIdx, PixelShaderReadUsage);
+    const uint32_t computeReadPass = graph.AddPass("ComputeRead", nullptr);
+    graph.Read(computeReadPass, textureIdx, ComputeShaderReadUsage);
+    const uint32_t secondPixelReadPass = graph.AddPass("SecondPixelRead", nullptr);
+    graph.Read(secondPixelReadPass, textureIdx, PixelShaderReadUsage);
+
+    for (uint32_t passIdx = 0; passIdx < 4; ++passIdx)
+        graph.SetSideEffects(passIdx);
+
+    graph.Compile();
+
+    // The transition before the first read also has to cover the compute read that comes after it
+    const std::vector<D3D12_TEXTURE_BARRIER> readBarriers = GetTextureBarriers(graph, pixelReadPass, texture);
+    CHECK(readBarriers.size() == 1);
+    if (readBarriers.size() == 1)
+    {
+        CHECK(readBarriers[0].SyncBefore == D3D12_BARRIER_SYNC_RENDER_TARGET);
+        CHECK(readBarriers[0].SyncAfter == (D3D12_BARRIER_SYNC_PIXEL_SHADING | D3D12_BARRIER_SYNC_COMPUTE_SHADING));
+        CHECK(readBarriers[0].AccessAfter == D3D12_BARRIER_ACCESS_SHADER_RESOURCE);
+        CHECK(readBarriers[0].LayoutAfter == D3D12_BARRIER_LAYOUT_SHADER_RESOURCE);
+    }
+
+    // Writing after the writes from before the graph needs a barrier, reading after other reads doesn't
+    CHECK(GetTextureBarriers(graph, writePass, texture).size() == 1);
+    CHECK(GetTextureBarriers(graph, computeReadPass, texture).empty());
+    CHECK(GetTextureBarriers(graph, secondPixelReadPass, texture).empty());
+    CHECK(graph.GetStats().NumBarriers == 2);
+
+    graph.Shutdown();
+    texture->Release();
+}
+
+DXL_TEST(RenderGraphWidensBothHalvesOfSplitBarriers)
+{
+    RenderGraph graph;
+    graph.Initialize({ .EnableSplitBarriers = true });
+
+    MockResource* texture = new MockResource();
+    MockResource* otherTexture = new MockResource();
+    const uint32_t textureIdx = graph.ImportTexture(texture, RenderTargetUsage);
+    const uint32_t otherTextureIdx = graph.ImportTexture(otherTexture, RenderTargetUsage);
+
+    const uint32_t writePass = graph.AddPass("Write", nullptr);
+    graph.Write(writePass, textureIdx, RenderTargetUsage);
+    const uint32_t unrelatedPass = graph.AddPass("Unrelated", nullptr);
+    graph.Write(unrelatedPass, otherTextureIdx, RenderTargetUsage);
+    const uint32_t pixelReadPass = graph.AddPass("PixelRead", nullptr);
+    graph.Read(pixelReadPass, textureIdx, PixelShaderReadUsage);
+    const uint32_t computeReadPass = graph.AddPass("ComputeRead", nullptr);
+    graph.Read(computeReadPass, textureIdx, ComputeShaderReadUsage);
+
+    for (uint32_t passIdx = 0; passIdx < 4; ++passIdx)
+        graph.SetSideEffects(passIdx);
+
+    graph.Compile();
+    CHECK(graph.GetStats().NumSplitBarriers == 1);
+
+    // The split begins after the write and ends before the first read
+    const std::vector<D3D12_TEXTURE_BARRIER> beginBarriers = GetTextureBarriers(graph, unrelatedPass, texture);
+    const std::vector<D3D12_TEXTURE_BARRIER> endBarriers = GetTextureBarriers(graph, pixelReadPass, texture);
+    CHECK(beginBarriers.size() == 1 && endBarriers.size() == 1);
+    if (beginBarriers.size() == 1 && endBarriers.size() == 1)
+    {
+        CHECK(beginBarriers[0].SyncAfter == D3D12_BARRIER_SYNC_SPLIT);
+        CHECK(beginBarriers[0].AccessAfter == D3D12_BARRIER_ACCESS_SHADER_RESOURCE);
+        CHECK(endBarriers[0].SyncBefore == D3D12_BARRIER_SYNC_SPLIT);
+        CHECK(endBarriers[0].SyncAfter == (D3D12_BARRIER_SYNC_PIXEL_SHADING | D3D12_BARRIER_SYNC_COMPUTE_SHADING));
+    }
+
+    CHECK(GetTextureBarriers(graph, computeReadPass, texture).empty());
+
+    graph.Shutdown();
+    texture->Release();
+    otherTexture->Release();
+}
+
+DXL_TEST(RenderGraphAddsBarriersForNewReadsOfImportedResources)
+{
+    RenderGraph graph;
+    graph.Initialize({ });
+
+    // Nothing in the graph transitioned the texture to its initial state, so there's no barrier to widen
+    MockResource* texture = new MockResource();
+    const uint32_t textureIdx = graph.ImportTexture(texture, PixelShaderReadUsage);
+
+    const uint32_t pixelReadPass = graph.AddPass("PixelRead", nullptr);
+    graph.Read(pixelReadPass, textureIdx, PixelShaderReadUsage);
+    const uint32_t computeReadPass = graph.AddPass("ComputeRead", nullptr);
+    graph.Read(computeReadPass, textureIdx, ComputeShaderReadUsage);
+    graph.SetSideEffects(pixelReadPass);
+    graph.SetSideEffects(computeReadPass);
+
+    graph.Compile();
+    CHECK(GetTextureBarriers(graph, pixelReadPass, texture).empty());
+
+    const std::vector<D3D12_TEXTURE_BARRIER> barriers = GetTextureBarriers(graph, computeReadPass, texture);
+    CHECK(barriers.size() == 1);
+    if (barriers.size() == 1)
+    {
+        CHECK(barriers[0].SyncBefore == D3D12_BARRIER_SYNC_PIXEL_SHADING);
+        CHECK(barriers[0].SyncAfter == (D3D12_BARRIER_SYNC_PIXEL_SHADING | D3D12_BARRIER_SYNC_COMPUTE_SHADING));
+        CHECK(barriers[0].LayoutBefore == D3D12_BARRIER_LAYOUT_SHADER_RESOURCE);
+        CHECK(barriers[0].LayoutAfter == D3D12_BARRIER_LAYOUT_SHADER_RESOURCE);
+    }
+
+    graph.Shutdown();
+    texture->Release();
+}
+
+// Builds a frame like a large renderer's: every pass writes a transient texture and reads the outputs of the two
+// passes before it, and the last one writes the back buffer
+static void Build500PassGraph(RenderGraph& graph, uint32_t backBufferIdx)
+{
+    const uint32_t numPasses = 500;
+    const D3D12_RESOURCE_DESC1 desc = MakeTexture2DDesc(1920, 1080, 1);
+
+    uint32_t outputs[numPasses] = { };
+    for (uint32_t passIdx = 0; passIdx < numPasses; ++passIdx)
+    {
+        const uint32_t passIndex = graph.AddPass("Pass", nullptr);
+        if (passIdx >= 1)
+            graph.Read(passIndex, outputs[passIdx - 1], PixelShaderReadUsage);
+        if (passIdx >= 2)
+            graph.Read(passIndex, outputs[passIdx - 2], ComputeShaderReadUsage);
+
+        if (passIdx + 1 < numPasses)
+        {
+            outputs[passIdx] = graph.CreateTexture(desc);
+            graph.Write(passIndex, outputs[passIdx], RenderTargetUsage);
+        }
+        else
+        {
+            graph.Write(passIndex, backBufferIdx, RenderTargetUsage);
+        }
+    }
+}
+
+DXL_TEST(RenderGraphCompiles500PassesQuickly)
+{
+    TransientResourceAllocator allocator;
+    allocator.Initialize({ });
+
+    RenderGraph graph;
+    graph.Initialize({ .TransientAllocator = &allocator });
+
+    MockResource* backBuffer = new MockResource();
+
+    // The first frames allocate the scratch memory that later ones reuse
+    const uint32_t numFrames = 32;
+    std::vector<double> compileTimes;
+    for (uint32_t frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+    {
+        graph.Reset();
+        const uint32_t backBufferIdx = graph.ImportTexture(backBuffer, PresentUsage);
+        graph.SetFinalUsage(backBufferIdx, PresentUsage);
+        Build500PassGraph(graph, backBufferIdx);
+        graph.Compile();
+        compileTimes.push_back(graph.GetStats().CompileTimeMS);
+    }
+
+    const RenderGraphStats stats = graph.GetStats();
+    CHECK(stats.NumPasses == 500);
+    CHECK(stats.NumCulledPasses == 0);
+    CHECK(allocator.GetStats().NumResources == 499);
+
+    // Each output is only alive for 3 passes, so only a few of them need memory at once
+    CHECK(allocator.GetStats().HeapBytes * 100 < allocator.GetStats().UnaliasedBytes);
+
+    std::sort(compileTimes.begin(), compileTimes.end());
+    const double medianTimeMS = compileTimes[numFrames / 2];
+    printf("    Median compile time for 500 passes: %.3fms\n", medianTimeMS);
+
+    // Debug and sanitizer builds only get a loose bound, it's optimized builds that need to stay under a millisecond
+#ifdef NDEBUG
+    CHECK(medianTimeMS < 1.0);
+#else
+    CHECK(medianTimeMS < 50.0);
+#endif
+
+    graph.Shutdown();
+    allocator.Shutdown();
+    backBuffer->Release();
+}
+
+// == Test runner =====================================================
+
+int main()
+{
+    SetErrorCallback(RecordError);
+
+    uint32_t numFailedTests = 0;
+    for (const TestCase& testCase : GetTestCases())
+    {
+        const uint32_t prevFailedChecks = numFailedChecks;
+        testCase.Function();
+
+        const bool passed = numFailedChecks == prevFailedChecks && TakeReportedErrors() == 0;
+        if (passed == false)
+            numFailedTests += 1;
+        printf("%s %s\n", passed ? "[ PASSED ]" : "[ FAILED ]", testCase.Name);
+    }
+
+    printf("\n%u of %u tests passed\n", uint32_t(GetTestCases().size()) - numFailedTests, uint32_t(GetTestCases().size()));
+
+    return numFailedTests > 0 ? 1 : 0;
+}
@@ -0,0 +1,631 @@
+#pragma once
+
+#include "../dxlatest.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Most of the stubbed out methods don't look at their parameters
+#pragma warning(push)
+#pragma warning(disable : 4100)
+
+// Mock D3D12 objects for testing the wrappers without a GPU. Only the methods that the tests look at do anything,
+// the rest of each interface is stubbed out.
+
+namespace DXLTests
+{
+
+// IUnknown and ID3D12Object for the mocks. Like the runtime, interfaces attached as private data are released when
+// the object is destroyed.
+template<typename T> class MockObject : public T
+{
+
+public:
+
+    virtual ~MockObject()
+    {
+        for (PrivateData& data : privateData)
+            data.Interface->Release();
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+    {
+        AddRef();
+        *object = this;
+        return S_OK;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++refCount;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG newRefCount = --refCount;
+        if (newRefCount == 0)
+            delete this;
+        return newRefCount;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* dataSize, void* data) override
+    {
+        for (PrivateData& existing : privateData)
+        {
+            if (existing.Guid != guid)
+                continue;
+
+            if (data != nullptr)
+            {
+                if (*dataSize < sizeof(IUnknown*))
+                    return E_INVALIDARG;
+                existing.Interface->AddRef();
+                memcpy(data, &existing.Interface, sizeof(IUnknown*));
+            }
+            *dataSize = sizeof(IUnknown*);
+            return S_OK;
+        }
+
+        return E_FAIL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* data) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* data) override
+    {
+        for (uint64_t i = 0; i < privateData.size(); ++i)
+        {
+            if (privateData[i].Guid == guid)
+            {
+                IUnknown* existing = privateData[i].Interface;
+                privateData.erase(privateData.begin() + i);
+                existing->Release();
+                break;
+            }
+        }
+
+        if (data != nullptr)
+        {
+            IUnknown* dataInterface = const_cast<IUnknown*>(data);
+            dataInterface->AddRef();
+            privateData.push_back({ .Guid = guid, .Interface = dataInterface });
+        }
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR name) override
+    {
+        return S_OK;
+    }
+
+    ULONG GetRefCount() const
+    {
+        return refCount;
+    }
+
+    // Replaces this object's private data with another object's, to act as if that object had been created at this
+    // address after this one was destroyed
+    void TakePrivateData(MockObject& other)
+    {
+        for (PrivateData& data : privateData)
+            data.Interface->Release();
+        privateData = std::move(other.privateData);
+        other.privateData.clear();
+    }
+
+private:
+
+    struct PrivateData
+    {
+        GUID Guid = { };
+        IUnknown* Interface = nullptr;
+    };
+
+    std::vector<PrivateData> privateData;
+    std::atomic<ULONG> refCount = 1;
+};
+
+// Records the name of every call made on it, and the contents of every Barrier() call
+class RecordingCommandList final : public MockObject<ID3D12GraphicsCommandList10>
+{
+
+public:
+
+    struct BarrierGroup
+    {
+        D3D12_BARRIER_TYPE Type = D3D12_BARRIER_TYPE_GLOBAL;
+        std::vector<D3D12_GLOBAL_BARRIER> GlobalBarriers;
+        std::vector<D3D12_BUFFER_BARRIER> BufferBarriers;
+        std::vector<D3D12_TEXTURE_BARRIER> TextureBarriers;
+    };
+
+    D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    std::vector<std::string> Calls;
+    std::vector<std::vector<BarrierGroup>> BarrierCalls;
+
+    // Like the runtime, lists are created closed and can only be closed when open and reset when closed
+    bool IsOpen = false;
+
+    RecordingCommandList(D3D12_COMMAND_LIST_TYPE type) : Type(type)
+    {
+    }
+
+    void Record(const char* call)
+    {
+        Calls.push_back(call);
+    }
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12CommandList
+    D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override { return Type; }
+
+    // ID3D12GraphicsCommandList
+    HRESULT STDMETHODCALLTYPE Close() override
+    {
+        Record("Close");
+        if (IsOpen == false)
+            return E_FAIL;
+
+        IsOpen = false;
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator *pAllocator, ID3D12PipelineState *pInitialState) override
+    {
+        Record("Reset");
+        if (IsOpen)
+            return E_FAIL;
+
+        IsOpen = true;
+        return S_OK;
+    }
+
+    // ID3D12GraphicsCommandList7
+    void STDMETHODCALLTYPE Barrier(UINT32 NumBarrierGroups, const D3D12_BARRIER_GROUP *pBarrierGroups) override
+    {
+        Record("Barrier");
+
+        std::vector<BarrierGroup>& groups = BarrierCalls.emplace_back();
+        for (uint32_t groupIdx = 0; groupIdx < NumBarrierGroups; ++groupIdx)
+        {
+            const D3D12_BARRIER_GROUP& src = pBarrierGroups[groupIdx];
+            BarrierGroup& group = groups.emplace_back();
+            group.Type = src.Type;
+            if (src.Type == D3D12_BARRIER_TYPE_GLOBAL)
+                group.GlobalBarriers.assign(src.pGlobalBarriers, src.pGlobalBarriers + src.NumBarriers);
+            else if (src.Type == D3D12_BARRIER_TYPE_BUFFER)
+                group.BufferBarriers.assign(src.pBufferBarriers, src.pBufferBarriers + src.NumBarriers);
+            else
+                group.TextureBarriers.assign(src.pTextureBarriers, src.pTextureBarriers + src.NumBarriers);
+        }
+    }
+
+    // ID3D12GraphicsCommandList
+    void STDMETHODCALLTYPE ClearState(ID3D12PipelineState *pPipelineState) override { Record("ClearState"); }
+    void STDMETHODCALLTYPE DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation) override { Record("DrawInstanced"); }
+    void STDMETHODCALLTYPE DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation) override { Record("DrawIndexedInstanced"); }
+    void STDMETHODCALLTYPE Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override { Record("Dispatch"); }
+    void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource *pDstBuffer, UINT64 DstOffset, ID3D12Resource *pSrcBuffer, UINT64 SrcOffset, UINT64 NumBytes) override { Record("CopyBufferRegion"); }
+    void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION *pDst, UINT DstX, UINT DstY, UINT DstZ, const D3D12_TEXTURE_COPY_LOCATION *pSrc, const D3D12_BOX *pSrcBox) override { Record("CopyTextureRegion"); }
+    void STDMETHODCALLTYPE CopyResource(ID3D12Resource *pDstResource, ID3D12Resource *pSrcResource) override { Record("CopyResource"); }
+    void STDMETHODCALLTYPE CopyTiles(ID3D12Resource *pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE *pTileRegionStartCoordinate, const D3D12_TILE_REGION_SIZE *pTileRegionSize, ID3D12Resource *pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags) override { Record("CopyTiles"); }
+    void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource *pDstResource, UINT DstSubresource, ID3D12Resource *pSrcResource, UINT SrcSubresource, DXGI_FORMAT Format) override { Record("ResolveSubresource"); }
+    void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology) override { Record("IASetPrimitiveTopology"); }
+    void STDMETHODCALLTYPE RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT *pViewports) override { Record("RSSetViewports"); }
+    void STDMETHODCALLTYPE RSSetScissorRects(UINT NumRects, const D3D12_RECT *pRects) override { Record("RSSetScissorRects"); }
+    void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT BlendFactor[4]) override { Record("OMSetBlendFactor"); }
+    void STDMETHODCALLTYPE OMSetStencilRef(UINT StencilRef) override { Record("OMSetStencilRef"); }
+    void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState *pPipelineState) override { Record("SetPipelineState"); }
+    void STDMETHODCALLTYPE ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER *pBarriers) override { Record("ResourceBarrier"); }
+    void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList *pCommandList) override { Record("ExecuteBundle"); }
+    void STDMETHODCALLTYPE SetDescriptorHeaps(UINT NumDescriptorHeaps, ID3D12DescriptorHeap *const *ppDescriptorHeaps) override { Record("SetDescriptorHeaps"); }
+    void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature *pRootSignature) override { Record("SetComputeRootSignature"); }
+    void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature *pRootSignature) override { Record("SetGraphicsRootSignature"); }
+    void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override { Record("SetComputeRootDescriptorTable"); }
+    void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override { Record("SetGraphicsRootDescriptorTable"); }
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override { Record("SetComputeRoot32BitConstant"); }
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override { Record("SetGraphicsRoot32BitConstant"); }
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void *pSrcData, UINT DestOffsetIn32BitValues) override { Record("SetComputeRoot32BitConstants"); }
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void *pSrcData, UINT DestOffsetIn32BitValues) override { Record("SetGraphicsRoot32BitConstants"); }
+    void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record("SetComputeRootConstantBufferView"); }
+    void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record("SetGraphicsRootConstantBufferView"); }
+    void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record("SetComputeRootShaderResourceView"); }
+    void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record("SetGraphicsRootShaderResourceView"); }
+    void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record("SetComputeRootUnorderedAccessView"); }
+    void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record("SetGraphicsRootUnorderedAccessView"); }
+    void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW *pView) override { Record("IASetIndexBuffer"); }
+    void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW *pViews) override { Record("IASetVertexBuffers"); }
+    void STDMETHODCALLTYPE SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW *pViews) override { Record("SOSetTargets"); }
+    void STDMETHODCALLTYPE OMSetRenderTargets(UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE *pRenderTargetDescriptors, BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE *pDepthStencilDescriptor) override { Record("OMSetRenderTargets"); }
+    void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth, UINT8 Stencil, UINT NumRects, const D3D12_RECT *pRects) override { Record("ClearDepthStencilView"); }
+    void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects, const D3D12_RECT *pRects) override { Record("ClearRenderTargetView"); }
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, ID3D12Resource *pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT *pRects) override { Record("ClearUnorderedAccessViewUint"); }
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, ID3D12Resource *pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT *pRects) override { Record("ClearUnorderedAccessViewFloat"); }
+    void STDMETHODCALLTYPE DiscardResource(ID3D12Resource *pResource, const D3D12_DISCARD_REGION *pRegion) override { Record("DiscardResource"); }
+    void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap *pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override { Record("BeginQuery"); }
+    void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap *pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override { Record("EndQuery"); }
+    void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap *pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries, ID3D12Resource *pDestinationBuffer, UINT64 AlignedDestinationBufferOffset) override { Record("ResolveQueryData"); }
+    void STDMETHODCALLTYPE SetPredication(ID3D12Resource *pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation) override { Record("SetPredication"); }
+    void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void *pData, UINT Size) override { Record("SetMarker"); }
+    void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void *pData, UINT Size) override { Record("BeginEvent"); }
+    void STDMETHODCALLTYPE EndEvent() override { Record("EndEvent"); }
+    void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature *pCommandSignature, UINT MaxCommandCount, ID3D12Resource *pArgumentBuffer, UINT64 ArgumentBufferOffset, ID3D12Resource *pCountBuffer, UINT64 CountBufferOffset) override { Record("ExecuteIndirect"); }
+
+    // ID3D12GraphicsCommandList1
+    void STDMETHODCALLTYPE AtomicCopyBufferUINT(ID3D12Resource *pDstBuffer, UINT64 DstOffset, ID3D12Resource *pSrcBuffer, UINT64 SrcOffset, UINT Dependencies, ID3D12Resource *const *ppDependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64 *pDependentSubresourceRanges) override { Record("AtomicCopyBufferUINT"); }
+    void STDMETHODCALLTYPE AtomicCopyBufferUINT64(ID3D12Resource *pDstBuffer, UINT64 DstOffset, ID3D12Resource *pSrcBuffer, UINT64 SrcOffset, UINT Dependencies, ID3D12Resource *const *ppDependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64 *pDependentSubresourceRanges) override { Record("AtomicCopyBufferUINT64"); }
+    void STDMETHODCALLTYPE OMSetDepthBounds(FLOAT Min, FLOAT Max) override { Record("OMSetDepthBounds"); }
+    void STDMETHODCALLTYPE SetSamplePositions(UINT NumSamplesPerPixel, UINT NumPixels, D3D12_SAMPLE_POSITION *pSamplePositions) override { Record("SetSamplePositions"); }
+    void STDMETHODCALLTYPE ResolveSubresourceRegion(ID3D12Resource *pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, ID3D12Resource *pSrcResource, UINT SrcSubresource, D3D12_RECT *pSrcRect, DXGI_FORMAT Format, D3D12_RESOLVE_MODE ResolveMode) override { Record("ResolveSubresourceRegion"); }
+    void STDMETHODCALLTYPE SetViewInstanceMask(UINT Mask) override { Record("SetViewInstanceMask"); }
+
+    // ID3D12GraphicsCommandList2
+    void STDMETHODCALLTYPE WriteBufferImmediate(UINT Count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER *pParams, const D3D12_WRITEBUFFERIMMEDIATE_MODE *pModes) override { Record("WriteBufferImmediate"); }
+
+    // ID3D12GraphicsCommandList3
+    void STDMETHODCALLTYPE SetProtectedResourceSession(ID3D12ProtectedResourceSession *pProtectedResourceSession) override { Record("SetProtectedResourceSession"); }
+
+    // ID3D12GraphicsCommandList4
+    void STDMETHODCALLTYPE BeginRenderPass(UINT NumRenderTargets, const D3D12_RENDER_PASS_RENDER_TARGET_DESC *pRenderTargets, const D3D12_RENDER_PASS_DEPTH_STENCIL_DESC *pDepthStencil, D3D12_RENDER_PASS_FLAGS Flags) override { Record("BeginRenderPass"); }
+    void STDMETHODCALLTYPE EndRenderPass() override { Record("EndRenderPass"); }
+    void STDMETHODCALLTYPE InitializeMetaCommand(ID3D12MetaCommand *pMetaCommand, const void *pInitializationParametersData, SIZE_T InitializationParametersDataSizeInBytes) override { Record("InitializeMetaCommand"); }
+    void STDMETHODCALLTYPE ExecuteMetaCommand(ID3D12MetaCommand *pMetaCommand, const void *pExecutionParametersData, SIZE_T ExecutionParametersDataSizeInBytes) override { Record("ExecuteMetaCommand"); }
+    void STDMETHODCALLTYPE BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc, UINT NumPostbuildInfoDescs, const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC *pPostbuildInfoDescs) override { Record("BuildRaytracingAccelerationStructure"); }
+    void STDMETHODCALLTYPE EmitRaytracingAccelerationStructurePostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC *pDesc, UINT NumSourceAccelerationStructures, const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData) override { Record("EmitRaytracingAccelerationStructurePostbuildInfo"); }
+    void STDMETHODCALLTYPE CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData, D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode) override { Record("CopyRaytracingAccelerationStructure"); }
+    void STDMETHODCALLTYPE SetPipelineState1(ID3D12StateObject *pStateObject) override { Record("SetPipelineState1"); }
+    void STDMETHODCALLTYPE DispatchRays(const D3D12_DISPATCH_RAYS_DESC *pDesc) override { Record("DispatchRays"); }
+
+    // ID3D12GraphicsCommandList5
+    void STDMETHODCALLTYPE RSSetShadingRate(D3D12_SHADING_RATE baseShadingRate, const D3D12_SHADING_RATE_COMBINER *combiners) override { Record("RSSetShadingRate"); }
+    void STDMETHODCALLTYPE RSSetShadingRateImage(ID3D12Resource *shadingRateImage) override { Record("RSSetShadingRateImage"); }
+
+    // ID3D12GraphicsCommandList6
+    void STDMETHODCALLTYPE DispatchMesh(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override { Record("DispatchMesh"); }
+
+    // ID3D12GraphicsCommandList8
+    void STDMETHODCALLTYPE OMSetFrontAndBackStencilRef(UINT FrontStencilRef, UINT BackStencilRef) override { Record("OMSetFrontAndBackStencilRef"); }
+
+    // ID3D12GraphicsCommandList9
+    void STDMETHODCALLTYPE RSSetDepthBias(FLOAT DepthBias, FLOAT DepthBiasClamp, FLOAT SlopeScaledDepthBias) override { Record("RSSetDepthBias"); }
+    void STDMETHODCALLTYPE IASetIndexBufferStripCutValue(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue) override { Record("IASetIndexBufferStripCutValue"); }
+
+    // ID3D12GraphicsCommandList10
+    void STDMETHODCALLTYPE SetProgram(const D3D12_SET_PROGRAM_DESC *pDesc) override { Record("SetProgram"); }
+    void STDMETHODCALLTYPE DispatchGraph(const D3D12_DISPATCH_GRAPH_DESC *pDesc) override { Record("DispatchGraph"); }
+};
+
+class MockCommandAllocator final : public MockObject<ID3D12CommandAllocator>
+{
+
+public:
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12CommandAllocator
+    HRESULT STDMETHODCALLTYPE Reset() override { return S_OK; }
+};
+
+class MockResource final : public MockObject<ID3D12Resource2>
+{
+
+public:
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12Resource
+    HRESULT STDMETHODCALLTYPE Map(UINT Subresource, const D3D12_RANGE *pReadRange, void **ppData) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE Unmap(UINT Subresource, const D3D12_RANGE *pWrittenRange) override { }
+    D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override { return { }; }
+    D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override { return { }; }
+    HRESULT STDMETHODCALLTYPE WriteToSubresource(UINT DstSubresource, const D3D12_BOX *pDstBox, const void *pSrcData, UINT SrcRowPitch, UINT SrcDepthPitch) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE ReadFromSubresource(void *pDstData, UINT DstRowPitch, UINT DstDepthPitch, UINT SrcSubresource, const D3D12_BOX *pSrcBox) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES *pHeapProperties, D3D12_HEAP_FLAGS *pHeapFlags) override { return E_NOTIMPL; }
+
+    // ID3D12Resource1
+    HRESULT STDMETHODCALLTYPE GetProtectedResourceSession(REFIID riid, void **ppProtectedSession) override { return E_NOTIMPL; }
+
+    // ID3D12Resource2
+    D3D12_RESOURCE_DESC1 STDMETHODCALLTYPE GetDesc1() override { return { }; }
+};
+
+class MockHeap final : public MockObject<ID3D12Heap1>
+{
+
+public:
+
+    D3D12_HEAP_DESC Desc = { };
+
+    explicit MockHeap(const D3D12_HEAP_DESC& desc) : Desc(desc)
+    {
+    }
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12Heap
+    D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override { return Desc; }
+
+    // ID3D12Heap1
+    HRESULT STDMETHODCALLTYPE GetProtectedResourceSession(REFIID riid, void **ppProtectedSession) override { return E_NOTIMPL; }
+};
+
+class MockRootSignature final : public MockObject<ID3D12RootSignature>
+{
+
+public:
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+};
+
+// Only creates RecordingCommandLists, MockCommandAllocators, MockHeaps, MockRootSignatures, and placed MockResources,
+// everything else fails
+class MockDevice final : public MockObject<ID3D12Device14>
+{
+
+public:
+
+    HRESULT STDMETHODCALLTYPE CreateCommandList1(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags, REFIID riid, void **ppCommandList) override
+    {
+        *ppCommandList = static_cast<ID3D12GraphicsCommandList10*>(new RecordingCommandList(type));
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void **ppCommandAllocator) override
+    {
+        *ppCommandAllocator = static_cast<ID3D12CommandAllocator*>(new MockCommandAllocator());
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateRootSignature(UINT nodeMask, const void *pBlobWithRootSignature, SIZE_T blobLengthInBytes, REFIID riid, void **ppvRootSignature) override
+    {
+        *ppvRootSignature = static_cast<ID3D12RootSignature*>(new MockRootSignature());
+        return S_OK;
+    }
+
+    UINT STDMETHODCALLTYPE GetNodeCount() override { return 1; }
+
+    // ID3D12Device
+    HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC *pDesc, REFIID riid, void **ppCommandQueue) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC *pDesc, REFIID riid, void **ppPipelineState) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC *pDesc, REFIID riid, void **ppPipelineState) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator *pCommandAllocator, ID3D12PipelineState *pInitialState, REFIID riid, void **ppCommandList) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D12_FEATURE Feature, void *pFeatureSupportData, UINT FeatureSupportDataSize) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC *pDescriptorHeapDesc, REFIID riid, void **ppvHeap) override { return E_NOTIMPL; }
+    UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapType) override { return { }; }
+    void STDMETHODCALLTYPE CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE CreateShaderResourceView(ID3D12Resource *pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D12Resource *pResource, ID3D12Resource *pCounterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE CreateRenderTargetView(ID3D12Resource *pResource, const D3D12_RENDER_TARGET_VIEW_DESC *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE CreateDepthStencilView(ID3D12Resource *pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE CreateSampler(const D3D12_SAMPLER_DESC *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE *pDestDescriptorRangeStarts, const UINT *pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE *pSrcDescriptorRangeStarts, const UINT *pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override { }
+    void STDMETHODCALLTYPE CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart, D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override { }
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC *pResourceDescs) override { return { }; }
+    D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties(UINT nodeMask, D3D12_HEAP_TYPE heapType) override { return { }; }
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource(const D3D12_HEAP_PROPERTIES *pHeapProperties, D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, REFIID riidResource, void **ppvResource) override { return E_NOTIMPL; }
+
+    HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC *pDesc, REFIID riid, void **ppvHeap) override
+    {
+        *ppvHeap = static_cast<ID3D12Heap1*>(new MockHeap(*pDesc));
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap *pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, REFIID riid, void **ppvResource) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateReservedResource(const D3D12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, REFIID riid, void **ppvResource) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateSharedHandle(ID3D12DeviceChild *pObject, const SECURITY_ATTRIBUTES *pAttributes, DWORD Access, LPCWSTR Name, HANDLE *pHandle) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE OpenSharedHandle(HANDLE NTHandle, REFIID riid, void **ppvObj) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE OpenSharedHandleByName(LPCWSTR Name, DWORD Access, /* [annotation][out] */ HANDLE *pNTHandle) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE MakeResident(UINT NumObjects, ID3D12Pageable *const *ppObjects) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE Evict(UINT NumObjects, ID3D12Pageable *const *ppObjects) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void **ppFence) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE GetCopyableFootprints(const D3D12_RESOURCE_DESC *pResourceDesc, UINT FirstSubresource, UINT NumSubresources, UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT *pLayouts, UINT *pNumRows, UINT64 *pRowSizeInBytes, UINT64 *pTotalBytes) override { }
+    HRESULT STDMETHODCALLTYPE CreateQueryHeap(const D3D12_QUERY_HEAP_DESC *pDesc, REFIID riid, void **ppvHeap) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE SetStablePowerState(BOOL Enable) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC *pDesc, ID3D12RootSignature *pRootSignature, REFIID riid, void **ppvCommandSignature) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE GetResourceTiling(ID3D12Resource *pTiledResource, UINT *pNumTilesForEntireResource, D3D12_PACKED_MIP_INFO *pPackedMipDesc, D3D12_TILE_SHAPE *pStandardTileShapeForNonPackedMips, UINT *pNumSubresourceTilings, UINT FirstSubresourceTilingToGet, D3D12_SUBRESOURCE_TILING *pSubresourceTilingsForNonPackedMips) override { }
+    LUID STDMETHODCALLTYPE GetAdapterLuid() override { return { }; }
+
+    // ID3D12Device1
+    HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void *pLibraryBlob, SIZE_T BlobLength, REFIID riid, void **ppPipelineLibrary) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE SetEventOnMultipleFenceCompletion(ID3D12Fence *const *ppFences, const UINT64 *pFenceValues, UINT NumFences, D3D12_MULTIPLE_FENCE_WAIT_FLAGS Flags, HANDLE hEvent) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE SetResidencyPriority(UINT NumObjects, ID3D12Pageable *const *ppObjects, const D3D12_RESIDENCY_PRIORITY *pPriorities) override { return E_NOTIMPL; }
+
+    // ID3D12Device2
+    HRESULT STDMETHODCALLTYPE CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC *pDesc, REFIID riid, void **ppPipelineState) override { return E_NOTIMPL; }
+
+    // ID3D12Device3
+    HRESULT STDMETHODCALLTYPE OpenExistingHeapFromAddress(const void *pAddress, REFIID riid, void **ppvHeap) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE OpenExistingHeapFromFileMapping(HANDLE hFileMapping, REFIID riid, void **ppvHeap) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE EnqueueMakeResident(D3D12_RESIDENCY_FLAGS Flags, UINT NumObjects, ID3D12Pageable *const *ppObjects, ID3D12Fence *pFenceToSignal, UINT64 FenceValueToSignal) override { return E_NOTIMPL; }
+
+    // ID3D12Device4
+    HRESULT STDMETHODCALLTYPE CreateProtectedResourceSession(const D3D12_PROTECTED_RESOURCE_SESSION_DESC *pDesc, REFIID riid, void **ppSession) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource1(const D3D12_HEAP_PROPERTIES *pHeapProperties, D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, ID3D12ProtectedResourceSession *pProtectedSession, REFIID riidResource, void **ppvResource) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateHeap1(const D3D12_HEAP_DESC *pDesc, ID3D12ProtectedResourceSession *pProtectedSession, REFIID riid, void **ppvHeap) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateReservedResource1(const D3D12_RESOURCE_DESC *pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, ID3D12ProtectedResourceSession *pProtectedSession, REFIID riid, void **ppvResource) override { return E_NOTIMPL; }
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo1(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC *pResourceDescs, D3D12_RESOURCE_ALLOCATION_INFO1 *pResourceAllocationInfo1) override { return { }; }
+
+    // ID3D12Device5
+    HRESULT STDMETHODCALLTYPE CreateLifetimeTracker(ID3D12LifetimeOwner *pOwner, REFIID riid, void **ppvTracker) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE RemoveDevice() override { }
+    HRESULT STDMETHODCALLTYPE EnumerateMetaCommands(UINT *pNumMetaCommands, D3D12_META_COMMAND_DESC *pDescs) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE EnumerateMetaCommandParameters(REFGUID CommandId, D3D12_META_COMMAND_PARAMETER_STAGE Stage, UINT *pTotalStructureSizeInBytes, UINT *pParameterCount, D3D12_META_COMMAND_PARAMETER_DESC *pParameterDescs) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateMetaCommand(REFGUID CommandId, UINT NodeMask, const void *pCreationParametersData, SIZE_T CreationParametersDataSizeInBytes, REFIID riid, void **ppMetaCommand) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateStateObject(const D3D12_STATE_OBJECT_DESC *pDesc, REFIID riid, void **ppStateObject) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE GetRaytracingAccelerationStructurePrebuildInfo(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS *pDesc, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO *pInfo) override { }
+    D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS STDMETHODCALLTYPE CheckDriverMatchingIdentifier(D3D12_SERIALIZED_DATA_TYPE SerializedDataType, const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck) override { return { }; }
+
+    // ID3D12Device6
+    HRESULT STDMETHODCALLTYPE SetBackgroundProcessingMode(D3D12_BACKGROUND_PROCESSING_MODE Mode, D3D12_MEASUREMENTS_ACTION MeasurementsAction, HANDLE hEventToSignalUponCompletion, BOOL *pbFurtherMeasurementsDesired) override { return E_NOTIMPL; }
+
+    // ID3D12Device7
+    HRESULT STDMETHODCALLTYPE AddToStateObject(const D3D12_STATE_OBJECT_DESC *pAddition, ID3D12StateObject *pStateObjectToGrowFrom, REFIID riid, void **ppNewStateObject) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateProtectedResourceSession1(const D3D12_PROTECTED_RESOURCE_SESSION_DESC1 *pDesc, REFIID riid, void **ppSession) override { return E_NOTIMPL; }
+
+    // ID3D12Device8
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo2(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC1 *pResourceDescs, D3D12_RESOURCE_ALLOCATION_INFO1 *pResourceAllocationInfo1) override { return { }; }
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource2(const D3D12_HEAP_PROPERTIES *pHeapProperties, D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC1 *pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, ID3D12ProtectedResourceSession *pProtectedSession, REFIID riidResource, void **ppvResource) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreatePlacedResource1(ID3D12Heap *pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC1 *pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE *pOptimizedClearValue, REFIID riid, void **ppvResource) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE CreateSamplerFeedbackUnorderedAccessView(ID3D12Resource *pTargetedResource, ID3D12Resource *pFeedbackResource, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+    void STDMETHODCALLTYPE GetCopyableFootprints1(const D3D12_RESOURCE_DESC1 *pResourceDesc, UINT FirstSubresource, UINT NumSubresources, UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT *pLayouts, UINT *pNumRows, UINT64 *pRowSizeInBytes, UINT64 *pTotalBytes) override { }
+
+    // ID3D12Device9
+    HRESULT STDMETHODCALLTYPE CreateShaderCacheSession(const D3D12_SHADER_CACHE_SESSION_DESC *pDesc, REFIID riid, void **ppvSession) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE ShaderCacheControl(D3D12_SHADER_CACHE_KIND_FLAGS Kinds, D3D12_SHADER_CACHE_CONTROL_FLAGS Control) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateCommandQueue1(const D3D12_COMMAND_QUEUE_DESC *pDesc, REFIID CreatorID, REFIID riid, void **ppCommandQueue) override { return E_NOTIMPL; }
+
+    // ID3D12Device10
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource3(const D3D12_HEAP_PROPERTIES *pHeapProperties, D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC1 *pDesc, D3D12_BARRIER_LAYOUT InitialLayout, const D3D12_CLEAR_VALUE *pOptimizedClearValue, ID3D12ProtectedResourceSession *pProtectedSession, UINT32 NumCastableFormats, const DXGI_FORMAT *pCastableFormats, REFIID riidResource, void **ppvResource) override { return E_NOTIMPL; }
+
+    HRESULT STDMETHODCALLTYPE CreatePlacedResource2(ID3D12Heap *pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC1 *pDesc, D3D12_BARRIER_LAYOUT InitialLayout, const D3D12_CLEAR_VALUE *pOptimizedClearValue, UINT32 NumCastableFormats, const DXGI_FORMAT *pCastableFormats, REFIID riid, void **ppvResource) override
+    {
+        *ppvResource = static_cast<ID3D12Resource2*>(new MockResource());
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateReservedResource2(const D3D12_RESOURCE_DESC *pDesc, D3D12_BARRIER_LAYOUT InitialLayout, const D3D12_CLEAR_VALUE *pOptimizedClearValue, ID3D12ProtectedResourceSession *pProtectedSession, UINT32 NumCastableFormats, const DXGI_FORMAT *pCastableFormats, REFIID riid, void **ppvResource) override { return E_NOTIMPL; }
+
+    // ID3D12Device11
+    void STDMETHODCALLTYPE CreateSampler2(const D3D12_SAMPLER_DESC2 *pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { }
+
+    // ID3D12Device12
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo3(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC1 *pResourceDescs, const UINT32 *pNumCastableFormats, const DXGI_FORMAT *const *ppCastableFormats, D3D12_RESOURCE_ALLOCATION_INFO1 *pResourceAllocationInfo1) override
+    {
+        // Everything is treated as 4 bytes per texel, which is all the tests need
+        const uint64_t size = pResourceDescs->Width * pResourceDescs->Height * pResourceDescs->DepthOrArraySize * 4;
+        return { .SizeInBytes = (size + 0xFFFF) & ~uint64_t(0xFFFF), .Alignment = 0x10000 };
+    }
+
+    // ID3D12Device13
+    HRESULT STDMETHODCALLTYPE OpenExistingHeapFromAddress1(const void *pAddress, SIZE_T size, REFIID riid, void **ppvHeap) override { return E_NOTIMPL; }
+
+    // ID3D12Device14
+    HRESULT STDMETHODCALLTYPE CreateRootSignatureFromSubobjectInLibrary(UINT nodeMask, const void *pLibraryBlob, SIZE_T blobLengthInBytes, LPCWSTR subobjectName, REFIID riid, void **ppvRootSignature) override { return E_NOTIMPL; }
+};
+
+// A fence that's only advanced by the CPU. SetEventOnCompletion with a null event blocks until the value is reached,
+// which is the same thing the runtime does.
+class MockFence final : public MockObject<ID3D12Fence1>
+{
+
+public:
+
+    std::atomic<uint64_t> CompletedValue = 0;
+    std::atomic<uint32_t> NumCompletedValueReads = 0;
+
+    // Every event passed to SetEventOnCompletion, in order
+    std::vector<HANDLE> WaitEvents;
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12Fence
+    UINT64 STDMETHODCALLTYPE GetCompletedValue() override
+    {
+        ++NumCompletedValueReads;
+        return CompletedValue.load();
+    }
+
+    HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 Value, HANDLE hEvent) override
+    {
+        if (hEvent == nullptr)
+        {
+            while (CompletedValue.load() < Value)
+                std::this_thread::yield();
+            return S_OK;
+        }
+
+        std::lock_guard<std::mutex> lock(eventMutex);
+        WaitEvents.push_back(hEvent);
+        if (CompletedValue.load() >= Value)
+            SetEvent(hEvent);
+        else
+            pendingEvents.push_back({ Value, hEvent });
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        CompletedValue.store(Value);
+
+        for (size_t i = 0; i < pendingEvents.size();)
+        {
+            if (pendingEvents[i].first <= Value)
+            {
+                SetEvent(pendingEvents[i].second);
+                pendingEvents.erase(pendingEvents.begin() + i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        return S_OK;
+    }
+
+    // ID3D12Fence1
+    D3D12_FENCE_FLAGS STDMETHODCALLTYPE GetCreationFlags() override { return D3D12_FENCE_FLAG_NONE; }
+
+private:
+
+    std::mutex eventMutex;
+    std::vector<std::pair<uint64_t, HANDLE>> pendingEvents;
+};
+
+// Records the fence values that are signaled instead of executing anything, so the test decides when the "GPU"
+// reaches them by signaling the fence from the CPU
+class MockCommandQueue final : public MockObject<ID3D12CommandQueue>
+{
+
+public:
+
+    std::vector<uint64_t> SignaledValues;
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12CommandQueue
+    void STDMETHODCALLTYPE UpdateTileMappings(ID3D12Resource *pResource, UINT NumResourceRegions, const D3D12_TILED_RESOURCE_COORDINATE *pResourceRegionStartCoordinates, const D3D12_TILE_REGION_SIZE *pResourceRegionSizes, ID3D12Heap *pHeap, UINT NumRanges, const D3D12_TILE_RANGE_FLAGS *pRangeFlags, const UINT *pHeapRangeStartOffsets, const UINT *pRangeTileCounts, D3D12_TILE_MAPPING_FLAGS Flags) override { }
+    void STDMETHODCALLTYPE CopyTileMappings(ID3D12Resource *pDstResource, const D3D12_TILED_RESOURCE_COORDINATE *pDstRegionStartCoordinate, ID3D12Resource *pSrcResource, const D3D12_TILED_RESOURCE_COORDINATE *pSrcRegionStartCoordinate, const D3D12_TILE_REGION_SIZE *pRegionSize, D3D12_TILE_MAPPING_FLAGS Flags) override { }
+    void STDMETHODCALLTYPE ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList *const *ppCommandLists) override { }
+    void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void *pData, UINT Size) override { }
+    void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void *pData, UINT Size) override { }
+    void STDMETHODCALLTYPE EndEvent() override { }
+    HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence *pFence, UINT64 Value) override { SignaledValues.push_back(Value); return S_OK; }
+    HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence *pFence, UINT64 Value) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE GetTimestampFrequency(UINT64 *pFrequency) override { *pFrequency = 1000000; return S_OK; }
+    HRESULT STDMETHODCALLTYPE GetClockCalibration(UINT64 *pGpuTimestamp, UINT64 *pCpuTimestamp) override { *pGpuTimestamp = 0; *pCpuTimestamp = 0; return S_OK; }
+    D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc() override { return { .Type = D3D12_COMMAND_LIST_TYPE_DIRECT }; }
+};
+
+class MockPipelineState final : public MockObject<ID3D12PipelineState>
+{
+
+public:
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void **ppvDevice) override { *ppvDevice = nullptr; return E_NOTIMPL; }
+
+    // ID3D12PipelineState
+    HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob **ppBlob) override { *ppBlob = nullptr; return E_NOTIMPL; }
+};
+
+} // namespace DXLTests
+
+#pragma warning(pop)
@@ -14,6 +14,18 @@
 
 #if DXL_ENABLE_EXTENSIONS
 #include "dxc/inc/dxcapi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #endif
 
 namespace DXL
@@ -49,6 +61,7 @@ static void ShowMessageBox(const char* msg, ...)
     va_list args;
     va_start(args, msg);
     vsnprintf_s(messageBuffer, 1024 - 1, 1024 - 1, msg, args);
+    va_end(args);
 
     MessageBoxA(nullptr, messageBuffer, "DXL", MB_OK | MB_ICONERROR);
 }
@@ -57,18 +70,27 @@ static void PrintAssertMessage(const char* condition, const char* msg, const cha
 {
     const uint64_t BufferSize = 2048;
     char buffer[BufferSize] = { };
-    sprintf_s(buffer, BufferSize, "%s(%d): Assert Failure: ", file, line);
+    size_t length = 0;
+    auto append = [&](const char* format, auto... args)
+    {
+        // Each piece is written after the previous one, since sprintf_s doesn't allow the buffer to also be an argument
+        const int32_t numChars = sprintf_s(buffer + length, BufferSize - length, format, args...);
+        if (numChars > 0)
+            length += size_t(numChars);
+    };
+
+    append("%s(%d): Assert Failure: ", file, line);
 
     if (condition != nullptr)
-        sprintf_s(buffer, BufferSize, "%s'%s' ", buffer, condition);
+        append("'%s' ", condition);
 
     if (msg != nullptr)
-        sprintf_s(buffer, BufferSize, "%s%s", buffer, msg);
+        append("%s", msg);
 
     if (IsDebuggerPresent() == false)
-        ShowMessageBox(buffer);
+        ShowMessageBox("%s", buffer);
 
-    sprintf_s(buffer, BufferSize, "%s\n", buffer);
+    append("\n");
 
     PrintMessageBuffer(buffer);
 }
@@ -141,6 +163,20 @@ struct WideStringConverter
     }
 };
 
+static std::string UTF8FromWide(const wchar_t* str)
+{
+    if (str == nullptr || str[0] == 0)
+        return std::string();
+
+    const int32_t numBytes = WideCharToMultiByte(CP_UTF8, 0, str, -1, nullptr, 0, nullptr, nullptr);
+    if (numBytes <= 1)
+        return std::string();
+
+    std::string result(size_t(numBytes - 1), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, str, -1, result.data(), numBytes, nullptr, nullptr);
+    return result;
+}
+
 static bool FileExists(const char* filePath)
 {
     if(filePath == NULL)
@@ -216,6 +252,70 @@ void SetErrorCallback(ErrorCallbackFunction callback)
 #define DXL_HANDLE_HRESULT(hr) do { if (FAILED(hr) && errorCallback) errorCallback(__FUNCTION__, hr, ""); } while(0)
 #define DXL_HANDLE_HRESULT_MSG(hr, msg) do { if (FAILED(hr) && errorCallback) errorCallback(__FUNCTION__, hr, msg); } while(0)
 
+// Streaming 128-bit hash that consumes input 8 bytes at a time using two independently-seeded lanes
+class HashBuilder
+{
+
+public:
+
+    void Add(const void* data, size_t size)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        while (size >= sizeof(uint64_t))
+        {
+            uint64_t word = 0;
+            memcpy(&word, bytes, sizeof(word));
+            AddWord(word);
+            bytes += sizeof(uint64_t);
+            size -= sizeof(uint64_t);
+        }
+
+        if (size > 0)
+        {
+            uint64_t word = 0;
+            memcpy(&word, bytes, size);
+            AddWord(word ^ (uint64_t(size) << 56));
+        }
+    }
+
+    template<typename T> void AddValue(T value)
+    {
+        static_assert(std::is_scalar_v<T>, "Structs may contain padding, hash their members individually");
+        Add(&value, sizeof(value));
+    }
+
+    DXL_HASH128 Finalize() const
+    {
+        const uint64_t lo = lane0 ^ numWords;
+        const uint64_t hi = lane1 ^ numWords;
+        return { .Lo = Mix(lo + hi), .Hi = Mix(hi + Mix(lo)) };
+    }
+
+private:
+
+    uint64_t lane0 = 0x9e3779b97f4a7c15ull;
+    uint64_t lane1 = 0xc2b2ae3d27d4eb4full;
+    uint64_t numWords = 0;
+
+    // Finalizer from MurmurHash3
+    static uint64_t Mix(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    void AddWord(uint64_t word)
+    {
+        lane0 = std::rotl(lane0 ^ (word * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+        lane1 = std::rotl(lane1 ^ (word * 0x4cf5ad432745937full), 33) * 0x87c37b91114253d5ull;
+        numWords += 1;
+    }
+};
+
 namespace Helpers
 {
 
@@ -455,6 +555,144 @@ D3D12_DEPTH_STENCIL_DESC2 DepthStateDesc(DepthState depthState)
     return depthStateDescs[uint32_t(depthState)];
 }
 
+enum class PSOHashType : uint32_t
+{
+    SimpleGraphics = 0,
+    MeshShaderGraphics,
+    Compute,
+};
+
+static void HashByteCode(HashBuilder& hash, const D3D12_SHADER_BYTECODE& byteCode)
+{
+    hash.AddValue(byteCode.BytecodeLength);
+
+    // DXBC/DXIL containers start with a digest of their contents, which is a lot cheaper to hash than the whole thing.
+    // It's left zeroed when validation is skipped, so fall back to hashing all of the bytecode in that case.
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(byteCode.pShaderBytecode);
+    const size_t digestOffset = 4;
+    const size_t digestSize = 16;
+    const uint8_t zeroDigest[digestSize] = { };
+    if (bytes && byteCode.BytecodeLength >= digestOffset + digestSize && memcmp(bytes, "DXBC", 4) == 0 &&
+        memcmp(bytes + digestOffset, zeroDigest, digestSize) != 0)
+        hash.Add(bytes + digestOffset, digestSize);
+    else if (bytes)
+        hash.Add(bytes, byteCode.BytecodeLength);
+}
+
+static void HashRasterizerState(HashBuilder& hash, const D3D12_RASTERIZER_DESC2& desc)
+{
+    hash.AddValue(desc.FillMode);
+    hash.AddValue(desc.CullMode);
+    hash.AddValue(desc.FrontCounterClockwise);
+    hash.AddValue(desc.DepthBias);
+    hash.AddValue(desc.DepthBiasClamp);
+    hash.AddValue(desc.SlopeScaledDepthBias);
+    hash.AddValue(desc.DepthClipEnable);
+    hash.AddValue(desc.LineRasterizationMode);
+    hash.AddValue(desc.ForcedSampleCount);
+    hash.AddValue(desc.ConservativeRaster);
+}
+
+static void HashBlendState(HashBuilder& hash, const D3D12_BLEND_DESC& desc, uint32_t numRenderTargets)
+{
+    hash.AddValue(desc.AlphaToCoverageEnable);
+    hash.AddValue(desc.IndependentBlendEnable);
+
+    // Only the first render target's blend state is used without independent blending
+    const uint32_t numBlendStates = desc.IndependentBlendEnable ? numRenderTargets : 1;
+    for (uint32_t rtIdx = 0; rtIdx < numBlendStates && rtIdx < DXL_ARRAY_SIZE(desc.RenderTarget); ++rtIdx)
+    {
+        const D3D12_RENDER_TARGET_BLEND_DESC& rtDesc = desc.RenderTarget[rtIdx];
+        hash.AddValue(rtDesc.BlendEnable);
+        hash.AddValue(rtDesc.LogicOpEnable);
+        hash.AddValue(rtDesc.SrcBlend);
+        hash.AddValue(rtDesc.DestBlend);
+        hash.AddValue(rtDesc.BlendOp);
+        hash.AddValue(rtDesc.SrcBlendAlpha);
+        hash.AddValue(rtDesc.DestBlendAlpha);
+        hash.AddValue(rtDesc.BlendOpAlpha);
+        hash.AddValue(rtDesc.LogicOp);
+        hash.AddValue(rtDesc.RenderTargetWriteMask);
+    }
+}
+
+static void HashStencilOp(HashBuilder& hash, const D3D12_DEPTH_STENCILOP_DESC1& desc)
+{
+    hash.AddValue(desc.StencilFailOp);
+    hash.AddValue(desc.StencilDepthFailOp);
+    hash.AddValue(desc.StencilPassOp);
+    hash.AddValue(desc.StencilFunc);
+    hash.AddValue(desc.StencilReadMask);
+    hash.AddValue(desc.StencilWriteMask);
+}
+
+static void HashDepthStencilState(HashBuilder& hash, const D3D12_DEPTH_STENCIL_DESC2& desc)
+{
+    hash.AddValue(desc.DepthEnable);
+    hash.AddValue(desc.DepthWriteMask);
+    hash.AddValue(desc.DepthFunc);
+    hash.AddValue(desc.StencilEnable);
+    HashStencilOp(hash, desc.FrontFace);
+    HashStencilOp(hash, desc.BackFace);
+    hash.AddValue(desc.DepthBoundsTestEnable);
+}
+
+// Defined after RootSignatureLayout, which holds the hash of the serialized root signature
+static void HashRootSignature(HashBuilder& hash, ID3D12RootSignature* rootSignature);
+
+static void HashOutputFormats(HashBuilder& hash, DXGI_FORMAT depthStencilFormat, const D3D12_RT_FORMAT_ARRAY& renderTargetFormats)
+{
+    hash.AddValue(depthStencilFormat);
+    hash.AddValue(renderTargetFormats.NumRenderTargets);
+    for (uint32_t rtIdx = 0; rtIdx < renderTargetFormats.NumRenderTargets && rtIdx < DXL_ARRAY_SIZE(renderTargetFormats.RTFormats); ++rtIdx)
+        hash.AddValue(renderTargetFormats.RTFormats[rtIdx]);
+}
+
+DXL_HASH128 HashPSODesc(const DXL_SIMPLE_GRAPHICS_PSO_DESC& desc)
+{
+    HashBuilder hash;
+    hash.AddValue(PSOHashType::SimpleGraphics);
+    HashRootSignature(hash, desc.RootSignature);
+    hash.AddValue(desc.PrimitiveTopologyType);
+    HashRasterizerState(hash, desc.RasterizerState);
+    HashByteCode(hash, desc.VertexShaderByteCode);
+    HashByteCode(hash, desc.PixelShaderByteCode);
+    HashBlendState(hash, desc.BlendState, desc.RenderTargetFormats.NumRenderTargets);
+    HashDepthStencilState(hash, desc.DepthStencilState);
+    HashOutputFormats(hash, desc.DepthStencilFormat, desc.RenderTargetFormats);
+
+    return hash.Finalize();
+}
+
+DXL_HASH128 HashPSODesc(const DXL_MESH_SHADER_GRAPHICS_PSO_DESC& desc)
+{
+    HashBuilder hash;
+    hash.AddValue(PSOHashType::MeshShaderGraphics);
+    HashRootSignature(hash, desc.RootSignature);
+    hash.AddValue(desc.PrimitiveTopologyType);
+    HashRasterizerState(hash, desc.RasterizerState);
+    HashByteCode(hash, desc.AmplificationShaderByteCode);
+    HashByteCode(hash, desc.MeshShaderByteCode);
+    HashByteCode(hash, desc.PixelShaderByteCode);
+    HashBlendState(hash, desc.BlendState, desc.RenderTargetFormats.NumRenderTargets);
+    HashDepthStencilState(hash, desc.DepthStencilState);
+    HashOutputFormats(hash, desc.DepthStencilFormat, desc.RenderTargetFormats);
+
+    return hash.Finalize();
+}
+
+DXL_HASH128 HashPSODesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    HashBuilder hash;
+    hash.AddValue(PSOHashType::Compute);
+    HashRootSignature(hash, desc.pRootSignature);
+    HashByteCode(hash, desc.CS);
+    hash.AddValue(desc.NodeMask);
+    hash.AddValue(desc.Flags);
+
+    return hash.Finalize();
+}
+
 } // namespace Helpers
 
 #endif // DXL_ENABLE_EXTENSIONS
@@ -535,10 +773,19 @@ void IDXLResource::Unmap(uint32_t subresource, const D3D12_RANGE* writtenRange)
 
 #if DXL_ENABLE_EXTENSIONS
 
+// The first subresource is always index 0, which lets buffers skip fetching the desc
+static uint32_t CalcSubresourceIndex(ID3D12Resource2* resource, uint32_t mipLevel, uint32_t arrayIndex, uint32_t planeIndex)
+{
+    if (mipLevel == 0 && arrayIndex == 0 && planeIndex == 0)
+        return 0;
+
+    const D3D12_RESOURCE_DESC1 desc = resource->GetDesc1();
+    return D3D12CalcSubresource(mipLevel, arrayIndex, planeIndex, desc.MipLevels, desc.DepthOrArraySize);
+}
+
 void* IDXLResource::Map(uint32_t mipLevel, uint32_t arrayIndex, uint32_t planeIndex)
 {
-    const D3D12_RESOURCE_DESC1 desc = ToNative()->GetDesc1();
-    const uint32_t subresourceIndex = D3D12CalcSubresource(mipLevel, arrayIndex, planeIndex, desc.MipLevels, desc.DepthOrArraySize);
+    const uint32_t subresourceIndex = CalcSubresourceIndex(ToNative(), mipLevel, arrayIndex, planeIndex);
 
     void* data = nullptr;
     DXL_HANDLE_HRESULT(ToNative()->Map(subresourceIndex, nullptr, &data));
@@ -547,8 +794,7 @@ void* IDXLResource::Map(uint32_t mipLevel, uint32_t arrayIndex, uint32_t planeIn
 
 void IDXLResource::Unmap(uint32_t mipLevel, uint32_t arrayIndex, uint32_t planeIndex)
 {
-    const D3D12_RESOURCE_DESC1 desc = ToNative()->GetDesc1();
-    const uint32_t subresourceIndex = D3D12CalcSubresource(mipLevel, arrayIndex, planeIndex, desc.MipLevels, desc.DepthOrArraySize);
+    const uint32_t subresourceIndex = CalcSubresourceIndex(ToNative(), mipLevel, arrayIndex, planeIndex);
     ToNative()->Unmap(subresourceIndex, nullptr);
 }
 
@@ -791,1574 +1037,10211 @@ D3D12_GPU_DESCRIPTOR_HANDLE IDXLDescriptorHeap::GetGPUDescriptorHandleForHeapSta
     return ToNative()->GetGPUDescriptorHandleForHeapStart();
 }
 
-// == IDXLCommandList =====================================================
+#if DXL_ENABLE_EXTENSIONS
 
-D3D12_COMMAND_LIST_TYPE IDXLCommandList::GetType() const
-{
-    return ToNative()->GetType();
-}
+// == RefCountedObject =====================================================
 
-HRESULT IDXLCommandList::Close()
+// Minimal ref-counted implementation of a COM interface for objects that DXL hands to D3D12 or DXC
+template<typename TInterface> class RefCountedObject : public TInterface
 {
-    return ToNative()->Close();
-}
 
-HRESULT IDXLCommandList::Reset(IDXLCommandAllocator allocator, IDXLPipelineState pipelineState)
-{
-    return ToNative()->Reset(allocator, pipelineState);
-}
+public:
 
-void IDXLCommandList::ClearState(IDXLPipelineState pipelineState)
-{
-    ToNative()->ClearState(pipelineState);
-}
+    virtual ~RefCountedObject()
+    {
+    }
 
-void IDXLCommandList::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
-{
-    ToNative()->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
-}
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** outObject) override
+    {
+        if (outObject == nullptr)
+            return E_INVALIDARG;
 
-void IDXLCommandList::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
-{
-    ToNative()->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
-}
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(TInterface))
+        {
+            AddRef();
+            *outObject = static_cast<TInterface*>(this);
+            return S_OK;
+        }
 
-void IDXLCommandList::Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
-{
-    ToNative()->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
-}
+        *outObject = nullptr;
+        return E_NOINTERFACE;
+    }
 
-void IDXLCommandList::DispatchRays(const D3D12_DISPATCH_RAYS_DESC* desc)
-{
-    ToNative()->DispatchRays(desc);
-}
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++refCount;
+    }
 
-void IDXLCommandList::DispatchMesh(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
-{
-    ToNative()->DispatchMesh(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
-}
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG newRefCount = --refCount;
+        if (newRefCount == 0)
+            delete this;
+        return newRefCount;
+    }
 
-void IDXLCommandList::DispatchGraph(const D3D12_DISPATCH_GRAPH_DESC* desc)
-{
-    ToNative()->DispatchGraph(desc);
-}
+private:
 
-void IDXLCommandList::CopyBufferRegion(IDXLResource dstBuffer, uint64_t dstOffset, IDXLResource srcBuffer, uint64_t srcOffset, uint64_t numBytes)
-{
-    ToNative()->CopyBufferRegion(dstBuffer, dstOffset, srcBuffer, srcOffset, numBytes);
-}
+    std::atomic<ULONG> refCount = 1;
+};
 
-void IDXLCommandList::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst, uint32_t dstX, uint32_t dstY, uint32_t dstZ, const D3D12_TEXTURE_COPY_LOCATION* src, const D3D12_BOX* srcBox)
-{
-    ToNative()->CopyTextureRegion(dst, dstX, dstY, dstZ, src, srcBox);
-}
+// Extension data that gets attached to native D3D12 objects with SetPrivateDataInterface, so that it's destroyed
+// along with the object it's attached to
+using PrivateDataObject = RefCountedObject<IUnknown>;
 
-void IDXLCommandList::CopyResource(IDXLResource dstResource, IDXLResource srcResource)
-{
-    ToNative()->CopyResource(dstResource, srcResource);
-}
+// == RootSignatureLayout =====================================================
 
-void IDXLCommandList::CopyTiles(IDXLResource tiledResource, const D3D12_TILED_RESOURCE_COORDINATE* tileRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* tileRegionSize, IDXLResource buffer, uint64_t bufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS flags)
-{
-    ToNative()->CopyTiles(tiledResource, tileRegionStartCoordinate, tileRegionSize, buffer, bufferStartOffsetInBytes, flags);
-}
+// {6A0E3C2B-5F8D-4C1E-9B27-D04A6E81F3C5}
+static const GUID RootSignatureLayoutGUID = { 0x6a0e3c2b, 0x5f8d, 0x4c1e, { 0x9b, 0x27, 0xd0, 0x4a, 0x6e, 0x81, 0xf3, 0xc5 } };
 
-void IDXLCommandList::Barrier(uint32_t numBarrierGroups, const D3D12_BARRIER_GROUP* barrierGroups)
+// Parameter layout of a root signature created through IDXLDevice::CreateRootSignature, used for sizing the root
+// argument staging block of command lists with DXL_COMMAND_LIST_FEATURE_FLAG_DEFER_ROOT_ARGUMENTS
+class RootSignatureLayout final : public PrivateDataObject
 {
-    ToNative()->Barrier(numBarrierGroups, barrierGroups);
-}
 
-#if DXL_ENABLE_EXTENSIONS
+public:
 
-void IDXLCommandList::Barrier(D3D12_GLOBAL_BARRIER barrier)
-{
-    const D3D12_BARRIER_GROUP group =
+    struct Parameter
     {
-        .Type = D3D12_BARRIER_TYPE_GLOBAL,
-        .NumBarriers = 1,
-        .pGlobalBarriers = &barrier,
+        D3D12_ROOT_PARAMETER_TYPE Type = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        uint32_t Num32BitValues = 0;
+        uint32_t ConstantsOffset = 0;
     };
-    ToNative()->Barrier(1, &group);
-}
 
-void IDXLCommandList::Barrier(D3D12_BUFFER_BARRIER barrier)
-{
-    const D3D12_BARRIER_GROUP group =
-    {
-        .Type = D3D12_BARRIER_TYPE_BUFFER,
-        .NumBarriers = 1,
-        .pBufferBarriers = &barrier,
-    };
-    ToNative()->Barrier(1, &group);
-}
+    std::vector<Parameter> Parameters;
+    uint32_t Num32BitConstants = 0;
+    DXL_HASH128 BlobHash;   // Hash of the serialized root signature
 
-void IDXLCommandList::Barrier(D3D12_TEXTURE_BARRIER barrier)
-{
-    const D3D12_BARRIER_GROUP group =
+    RootSignatureLayout(const D3D12_ROOT_SIGNATURE_DESC2& desc, const DXL_HASH128& blobHash) : BlobHash(blobHash)
     {
-        .Type = D3D12_BARRIER_TYPE_TEXTURE,
-        .NumBarriers = 1,
-        .pTextureBarriers = &barrier,
-    };
-    ToNative()->Barrier(1, &group);
-}
-
-#endif // DXL_ENABLE_EXTENSIONS
-
-void IDXLCommandList::ResolveSubresource(IDXLResource dstResource, uint32_t dstSubresource, IDXLResource srcResource, uint32_t srcSubresource, DXGI_FORMAT format)
-{
-    ToNative()->ResolveSubresource(dstResource, dstSubresource, srcResource, srcSubresource, format);
-}
+        Parameters.resize(desc.NumParameters);
+        for (uint32_t paramIdx = 0; paramIdx < desc.NumParameters; ++paramIdx)
+        {
+            const D3D12_ROOT_PARAMETER1& srcParam = desc.pParameters[paramIdx];
+            Parameter& param = Parameters[paramIdx];
+            param.Type = srcParam.ParameterType;
+            if (srcParam.ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+            {
+                param.Num32BitValues = srcParam.Constants.Num32BitValues;
+                param.ConstantsOffset = Num32BitConstants;
+                Num32BitConstants += srcParam.Constants.Num32BitValues;
+            }
+        }
+    }
 
-void IDXLCommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology)
-{
-    ToNative()->IASetPrimitiveTopology(primitiveTopology);
-}
+    static ComPtr<RootSignatureLayout> Get(ID3D12RootSignature* rootSignature)
+    {
+        ComPtr<RootSignatureLayout> layout;
+        if (rootSignature == nullptr)
+            return layout;
 
-void IDXLCommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
-{
-    ToNative()->IASetIndexBuffer(view);
-}
+        IUnknown* data = nullptr;
+        UINT dataSize = sizeof(data);
+        if (SUCCEEDED(rootSignature->GetPrivateData(RootSignatureLayoutGUID, &dataSize, &data)) && data != nullptr)
+            layout.Attach(static_cast<RootSignatureLayout*>(data));
 
-#if DXL_ENABLE_EXTENSIONS
+        return layout;
+    }
+};
 
-void IDXLCommandList::IASetIndexBuffer(D3D12_GPU_VIRTUAL_ADDRESS bufferLocation, uint32_t sizeInBytes, DXGI_FORMAT format)
+namespace Helpers
 {
-    D3D12_INDEX_BUFFER_VIEW d3d12View = { .BufferLocation = bufferLocation, .SizeInBytes = sizeInBytes, .Format = format };
-    ToNative()->IASetIndexBuffer(&d3d12View);
-}
-
-#endif
 
-void IDXLCommandList::IASetIndexBufferStripCutValue(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE ibStripCutValue)
+// Root signatures created through IDXLDevice::CreateRootSignature are hashed by their serialized contents, which is
+// also what the runtime compares to decide whether two root signatures are the same. Others can only be hashed by
+// address, so the PSO cache holds a reference to them to keep the address from being reused.
+static void HashRootSignature(HashBuilder& hash, ID3D12RootSignature* rootSignature)
 {
-    ToNative()->IASetIndexBufferStripCutValue(ibStripCutValue);
+    if (ComPtr<RootSignatureLayout> layout = RootSignatureLayout::Get(rootSignature))
+    {
+        hash.AddValue(layout->BlobHash.Lo);
+        hash.AddValue(layout->BlobHash.Hi);
+    }
+    else
+    {
+        hash.AddValue(rootSignature);
+    }
 }
 
-void IDXLCommandList::RSSetViewports(uint32_t numViewports, const D3D12_VIEWPORT* viewports)
-{
-    ToNative()->RSSetViewports(numViewports, viewports);
-}
+} // namespace Helpers
 
-void IDXLCommandList::RSSetScissorRects(uint32_t numRects, const D3D12_RECT* rects)
-{
-    ToNative()->RSSetScissorRects(numRects, rects);
-}
+// == PSOCache =====================================================
 
-void IDXLCommandList::RSSetDepthBias(float depthBias, float depthBiasClamp, float slopeScaledDepthBias)
+// Hash table of PSOs keyed by Helpers::HashPSODesc. Lookups don't take any locks: tables are open-addressed with
+// atomic slots, entries are never modified once they're published, and tables that are replaced when growing are
+// kept alive until Clear() so that readers that are still probing them remain valid.
+class PSOCache
 {
-    ToNative()->RSSetDepthBias(depthBias, depthBiasClamp, slopeScaledDepthBias);
-}
 
-#if DXL_ENABLE_EXTENSIONS
+public:
 
-void IDXLCommandList::RSSetViewportAndScissor(uint32_t width, uint32_t height)
-{
-    D3D12_VIEWPORT viewport =
+    ~PSOCache()
     {
-        .TopLeftX = 0.0f,
-        .TopLeftY = 0.0f,
-        .Width = float(width),
-        .Height = float(height),
-        .MinDepth = 0.0f,
-        .MaxDepth = 1.0f,
-    };
+        Clear();
+    }
 
-    D3D12_RECT scissorRect =
+    // Returns an additional reference to the cached PSO, or null if there is no match
+    ID3D12PipelineState* Find(const DXL_HASH128& hash)
     {
-        scissorRect.left = 0,
-        scissorRect.top = 0,
-        scissorRect.right = uint32_t(width),
-        scissorRect.bottom = uint32_t(height),
-    };
+        const Table* table = currentTable.load(std::memory_order_acquire);
+        if (table != nullptr)
+        {
+            for (uint64_t slotIdx = hash.Lo & table->Mask; ; slotIdx = (slotIdx + 1) & table->Mask)
+            {
+                const Entry* entry = table->Slots[slotIdx].load(std::memory_order_acquire);
+                if (entry == nullptr)
+                    break;
 
-    ToNative()->RSSetViewports(1, &viewport);
-    ToNative()->RSSetScissorRects(1, &scissorRect);
-}
+                if (entry->Hash == hash)
+                {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    entry->PSO->AddRef();
+                    return entry->PSO;
+                }
+            }
+        }
 
-#endif
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
 
-void IDXLCommandList::RSSetShadingRate(D3D12_SHADING_RATE baseShadingRate, const D3D12_SHADING_RATE_COMBINER* combiners)
+    // Adds a newly-created PSO to the cache. If another thread inserted a matching PSO first, the passed-in PSO is
+    // released and an additional reference to the existing one is returned instead. The cache also holds a reference
+    // to the root signature, since the hash may only have its address.
+    ID3D12PipelineState* Insert(const DXL_HASH128& hash, ID3D12RootSignature* rootSignature, ID3D12PipelineState* pso)
+    {
+        std::lock_guard<std::mutex> lock(insertMutex);
+
+        const Table* table = currentTable.load(std::memory_order_relaxed);
+        if (table != nullptr)
+        {
+            for (uint64_t slotIdx = hash.Lo & table->Mask; ; slotIdx = (slotIdx + 1) & table->Mask)
+            {
+                const Entry* entry = table->Slots[slotIdx].load(std::memory_order_relaxed);
+                if (entry == nullptr)
+                    break;
+
+                if (entry->Hash == hash)
+                {
+                    pso->Release();
+                    entry->PSO->AddRef();
+                    return entry->PSO;
+                }
+            }
+        }
+
+        // Keep the load factor at or below 50% so that probe sequences stay short
+        if (table == nullptr || (entries.size() + 1) * 2 > table->Mask + 1)
+        {
+            const uint64_t newSize = table ? (table->Mask + 1) * 2 : 64;
+            tables.push_back(std::make_unique<Table>(newSize));
+            table = tables.back().get();
+            for (const std::unique_ptr<Entry>& entry : entries)
+                AddToTable(*table, entry.get());
+
+            currentTable.store(table, std::memory_order_release);
+        }
+
+        pso->AddRef();
+        if (rootSignature)
+            rootSignature->AddRef();
+        entries.push_back(std::make_unique<Entry>(hash, rootSignature, pso));
+        AddToTable(*table, entries.back().get());
+        inserts.fetch_add(1, std::memory_order_relaxed);
+
+        return pso;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(insertMutex);
+
+        currentTable.store(nullptr, std::memory_order_release);
+        for (const std::unique_ptr<Entry>& entry : entries)
+        {
+            entry->PSO->Release();
+            if (entry->RootSignature)
+                entry->RootSignature->Release();
+        }
+        entries.clear();
+        tables.clear();
+    }
+
+    DXL_PSO_CACHE_STATS GetStats()
+    {
+        std::lock_guard<std::mutex> lock(insertMutex);
+
+        return
+        {
+            .Hits = hits.load(std::memory_order_relaxed),
+            .Misses = misses.load(std::memory_order_relaxed),
+            .Inserts = inserts.load(std::memory_order_relaxed),
+            .NumPipelines = entries.size(),
+        };
+    }
+
+private:
+
+    struct Entry
+    {
+        DXL_HASH128 Hash;
+        ID3D12RootSignature* RootSignature = nullptr;
+        ID3D12PipelineState* PSO = nullptr;
+
+        Entry(const DXL_HASH128& hash, ID3D12RootSignature* rootSignature, ID3D12PipelineState* pso) : Hash(hash), RootSignature(rootSignature), PSO(pso)
+        {
+        }
+    };
+
+    struct Table
+    {
+        uint64_t Mask = 0;
+        std::unique_ptr<std::atomic<const Entry*>[]> Slots;
+
+        Table(uint64_t size) : Mask(size - 1), Slots(new std::atomic<const Entry*>[size])
+        {
+            for (uint64_t slotIdx = 0; slotIdx < size; ++slotIdx)
+                Slots[slotIdx].store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    static void AddToTable(const Table& table, const Entry* entry)
+    {
+        uint64_t slotIdx = entry->Hash.Lo & table.Mask;
+        while (table.Slots[slotIdx].load(std::memory_order_relaxed) != nullptr)
+            slotIdx = (slotIdx + 1) & table.Mask;
+
+        table.Slots[slotIdx].store(entry, std::memory_order_release);
+    }
+
+    std::atomic<const Table*> currentTable = nullptr;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::mutex insertMutex;
+
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+    std::atomic<uint64_t> inserts = 0;
+};
+
+// == DeviceState =====================================================
+
+// {3F7B1D94-8E26-4A5C-B0D3-6C9E2A47F158}
+static const GUID DeviceStateGUID = { 0x3f7b1d94, 0x8e26, 0x4a5c, { 0xb0, 0xd3, 0x6c, 0x9e, 0x2a, 0x47, 0xf1, 0x58 } };
+
+// Extension state for a device created through DXL::CreateDevice
+class DeviceState final : public PrivateDataObject
+{
+
+public:
+
+    std::unique_ptr<PSOCache> PipelineCache;
+};
+
+// == CommandListState =====================================================
+
+// {125959EF-A49B-4A4D-8337-2471058EA05B}
+static const GUID CommandListStateGUID = { 0x125959ef, 0xa49b, 0x4a4d, { 0x83, 0x37, 0x24, 0x71, 0x05, 0x8e, 0xa0, 0x5b } };
+
+// Extension state for a command list created through IDXLDevice::CreateCommandList
+class CommandListState final : public PrivateDataObject
+{
+
+public:
+
+    DXL_COMMAND_LIST_FEATURE_FLAGS Features = DXL_COMMAND_LIST_FEATURE_FLAG_NONE;
+
+    std::vector<D3D12_GLOBAL_BARRIER> PendingGlobalBarriers;
+    std::vector<D3D12_BUFFER_BARRIER> PendingBufferBarriers;
+    std::vector<D3D12_TEXTURE_BARRIER> PendingTextureBarriers;
+    std::unordered_set<ID3D12Resource*> PendingResources;   // Resources with a pending buffer or texture barrier
+
+    // One group per run of same-typed pending barriers, in the order they were recorded. The barrier pointers are
+    // only filled in by FlushBarriers(), since the pending lists can still grow before then.
+    std::vector<D3D12_BARRIER_GROUP> PendingGroups;
+
+    // Shadow copies of the last values passed to the filtered setters, only valid when the matching bool is set
+    struct ShadowState
+    {
+        bool PipelineStateValid = false;
+        ID3D12PipelineState* PipelineState = nullptr;
+
+        bool GraphicsRootSignatureValid = false;
+        ID3D12RootSignature* GraphicsRootSignature = nullptr;
+
+        bool ComputeRootSignatureValid = false;
+        ID3D12RootSignature* ComputeRootSignature = nullptr;
+
+        bool PrimitiveTopologyValid = false;
+        D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+        bool ViewportsValid = false;
+        uint32_t NumViewports = 0;
+        D3D12_VIEWPORT Viewports[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = { };
+
+        bool ScissorRectsValid = false;
+        uint32_t NumScissorRects = 0;
+        D3D12_RECT ScissorRects[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = { };
+
+        bool DescriptorHeapsValid = false;
+        uint32_t NumDescriptorHeaps = 0;
+        ID3D12DescriptorHeap* DescriptorHeaps[2] = { };
+
+        bool RenderTargetsValid = false;
+        uint32_t NumRenderTargets = 0;
+        D3D12_CPU_DESCRIPTOR_HANDLE RenderTargets[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT] = { };
+        bool RenderTargetsAreSingleHandle = false;
+        bool HasDepthStencil = false;
+        D3D12_CPU_DESCRIPTOR_HANDLE DepthStencil = { };
+    };
+
+    ShadowState Shadow;
+    DXL_COMMAND_LIST_STATE_FILTER_STATS FilterStats;
+
+    static constexpr uint8_t RootArgValid = 0x1;
+    static constexpr uint8_t RootArgDirty = 0x2;
+
+    // Root arguments recorded for one bind point (graphics or compute) that haven't been sent to the native command
+    // list yet. Constants are stored per 32-bit value, root descriptors per root parameter.
+    struct RootArgumentStaging
+    {
+        ID3D12RootSignature* RootSignature = nullptr;
+        ComPtr<RootSignatureLayout> Layout;
+        std::vector<uint32_t> Constants;
+        std::vector<uint8_t> ConstantFlags;
+        std::vector<D3D12_GPU_VIRTUAL_ADDRESS> Descriptors;
+        std::vector<uint8_t> ParameterFlags;
+        bool Dirty = false;
+    };
+
+    RootArgumentStaging GraphicsRootArguments;
+    RootArgumentStaging ComputeRootArguments;
+
+    CommandListState(DXL_COMMAND_LIST_FEATURE_FLAGS features) : Features(features)
+    {
+    }
+
+    bool HasFeature(DXL_COMMAND_LIST_FEATURE_FLAGS feature) const
+    {
+        return (Features & feature) != 0;
+    }
+
+    bool HasPendingBarriers() const
+    {
+        return PendingGroups.size() > 0;
+    }
+
+    void AddPendingGroupBarrier(D3D12_BARRIER_TYPE type)
+    {
+        if (PendingGroups.size() > 0 && PendingGroups.back().Type == type)
+            PendingGroups.back().NumBarriers += 1;
+        else
+            PendingGroups.push_back({ .Type = type, .NumBarriers = 1 });
+    }
+
+    void ClearPendingBarriers()
+    {
+        PendingGlobalBarriers.clear();
+        PendingBufferBarriers.clear();
+        PendingTextureBarriers.clear();
+        PendingResources.clear();
+        PendingGroups.clear();
+    }
+
+    void InvalidateShadowState()
+    {
+        Shadow = ShadowState();
+    }
+
+    // Returns true if the setter call should be dropped instead of being forwarded to the native command list
+    bool ElideStateChange(bool redundant)
+    {
+        if (redundant)
+            FilterStats.CallsElided += 1;
+        else
+            FilterStats.CallsForwarded += 1;
+
+        return redundant;
+    }
+
+    void ResetRootArguments()
+    {
+        GraphicsRootArguments = RootArgumentStaging();
+        ComputeRootArguments = RootArgumentStaging();
+    }
+
+    // Setting a different root signature invalidates all root arguments, so anything still pending is dropped
+    static void BindRootSignature(RootArgumentStaging& staging, ID3D12RootSignature* rootSignature)
+    {
+        if (rootSignature == staging.RootSignature)
+            return;
+
+        staging.RootSignature = rootSignature;
+        staging.Layout = RootSignatureLayout::Get(rootSignature);
+        staging.Dirty = false;
+
+        const uint32_t num32BitConstants = staging.Layout ? staging.Layout->Num32BitConstants : 0;
+        const size_t numParameters = staging.Layout ? staging.Layout->Parameters.size() : 0;
+        staging.Constants.assign(num32BitConstants, 0);
+        staging.ConstantFlags.assign(num32BitConstants, 0);
+        staging.Descriptors.assign(numParameters, 0);
+        staging.ParameterFlags.assign(numParameters, 0);
+    }
+
+    // Returns false if the constants can't be staged, in which case they should be forwarded immediately
+    static bool StageConstants(RootArgumentStaging& staging, uint32_t rootParameterIndex, uint32_t num32BitValues, const uint32_t* srcData, uint32_t destOffset)
+    {
+        if (staging.Layout.Get() == nullptr || rootParameterIndex >= staging.Layout->Parameters.size())
+            return false;
+
+        const RootSignatureLayout::Parameter& param = staging.Layout->Parameters[rootParameterIndex];
+        if (param.Type != D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS || destOffset + num32BitValues > param.Num32BitValues)
+            return false;
+
+        uint32_t* dstValues = &staging.Constants[param.ConstantsOffset + destOffset];
+        uint8_t* dstFlags = &staging.ConstantFlags[param.ConstantsOffset + destOffset];
+        for (uint32_t i = 0; i < num32BitValues; ++i)
+        {
+            if ((dstFlags[i] & RootArgValid) && dstValues[i] == srcData[i])
+                continue;
+
+            dstValues[i] = srcData[i];
+            dstFlags[i] = RootArgValid | RootArgDirty;
+            staging.ParameterFlags[rootParameterIndex] |= RootArgDirty;
+            staging.Dirty = true;
+        }
+
+        return true;
+    }
+
+    // Returns false if the root descriptor can't be staged, in which case it should be forwarded immediately
+    static bool StageDescriptor(RootArgumentStaging& staging, uint32_t rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE type, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+    {
+        if (staging.Layout.Get() == nullptr || rootParameterIndex >= staging.Layout->Parameters.size())
+            return false;
+
+        if (staging.Layout->Parameters[rootParameterIndex].Type != type)
+            return false;
+
+        uint8_t& flags = staging.ParameterFlags[rootParameterIndex];
+        if ((flags & RootArgValid) && staging.Descriptors[rootParameterIndex] == bufferLocation)
+            return true;
+
+        staging.Descriptors[rootParameterIndex] = bufferLocation;
+        flags = RootArgValid | RootArgDirty;
+        staging.Dirty = true;
+
+        return true;
+    }
+
+    // Sends all dirty root arguments to the native command list. Each run of dirty constants within a root parameter
+    // is extended over any clean values that are known, so that nearby runs are coalesced into a single call.
+    static void FlushRootArguments(RootArgumentStaging& staging, ID3D12GraphicsCommandList10* commandList, bool graphics)
+    {
+        if (staging.Dirty == false)
+            return;
+
+        const std::vector<RootSignatureLayout::Parameter>& parameters = staging.Layout->Parameters;
+        for (uint32_t paramIdx = 0; paramIdx < uint32_t(parameters.size()); ++paramIdx)
+        {
+            uint8_t& paramFlags = staging.ParameterFlags[paramIdx];
+            if ((paramFlags & RootArgDirty) == 0)
+                continue;
+
+            paramFlags &= ~RootArgDirty;
+
+            const RootSignatureLayout::Parameter& param = parameters[paramIdx];
+            const D3D12_GPU_VIRTUAL_ADDRESS bufferLocation = staging.Descriptors[paramIdx];
+            if (param.Type == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+            {
+                const uint32_t* values = &staging.Constants[param.ConstantsOffset];
+                uint8_t* flags = &staging.ConstantFlags[param.ConstantsOffset];
+
+                uint32_t start = 0;
+                while (start < param.Num32BitValues)
+                {
+                    if ((flags[start] & RootArgDirty) == 0)
+                    {
+                        ++start;
+                        continue;
+                    }
+
+                    uint32_t last = start;
+                    for (uint32_t i = start + 1; i < param.Num32BitValues && (flags[i] & RootArgValid); ++i)
+                    {
+                        if (flags[i] & RootArgDirty)
+                            last = i;
+                    }
+
+                    const uint32_t count = last - start + 1;
+                    if (graphics)
+                        commandList->SetGraphicsRoot32BitConstants(paramIdx, count, values + start, start);
+                    else
+                        commandList->SetComputeRoot32BitConstants(paramIdx, count, values + start, start);
+
+                    for (uint32_t i = start; i <= last; ++i)
+                        flags[i] &= ~RootArgDirty;
+
+                    start = last + 1;
+                }
+            }
+            else if (param.Type == D3D12_ROOT_PARAMETER_TYPE_CBV)
+            {
+                if (graphics)
+                    commandList->SetGraphicsRootConstantBufferView(paramIdx, bufferLocation);
+                else
+                    commandList->SetComputeRootConstantBufferView(paramIdx, bufferLocation);
+            }
+            else if (param.Type == D3D12_ROOT_PARAMETER_TYPE_SRV)
+            {
+                if (graphics)
+                    commandList->SetGraphicsRootShaderResourceView(paramIdx, bufferLocation);
+                else
+                    commandList->SetComputeRootShaderResourceView(paramIdx, bufferLocation);
+            }
+            else if (param.Type == D3D12_ROOT_PARAMETER_TYPE_UAV)
+            {
+                if (graphics)
+                    commandList->SetGraphicsRootUnorderedAccessView(paramIdx, bufferLocation);
+                else
+                    commandList->SetComputeRootUnorderedAccessView(paramIdx, bufferLocation);
+            }
+        }
+
+        staging.Dirty = false;
+    }
+};
+
+static CommandListState* GetStateFilter(CommandListState* state)
+{
+    return (state && state->HasFeature(DXL_COMMAND_LIST_FEATURE_FLAG_FILTER_REDUNDANT_STATE)) ? state : nullptr;
+}
+
+static CommandListState* GetRootArgumentStaging(CommandListState* state)
+{
+    return (state && state->HasFeature(DXL_COMMAND_LIST_FEATURE_FLAG_DEFER_ROOT_ARGUMENTS)) ? state : nullptr;
+}
+
+void IDXLCommandList::LookUpExtensionState() const
+{
+    IUnknown* data = nullptr;
+    UINT dataSize = sizeof(data);
+    cachedExtensionState = nullptr;
+    if (nativeInterface && SUCCEEDED(ToNative()->GetPrivateData(CommandListStateGUID, &dataSize, &data)) && data != nullptr)
+    {
+        // The native command list holds the reference, so don't keep the one GetPrivateData added
+        cachedExtensionState = static_cast<CommandListState*>(data);
+        data->Release();
+    }
+    extensionStateOwner = nativeInterface;
+}
+
+#define DXL_FLUSH_BARRIERS() FlushBarriers()
+
+#define DXL_FLUSH_GRAPHICS_ROOT_ARGUMENTS() do { if (CommandListState* staging = GetRootArgumentStaging(GetExtensionState())) CommandListState::FlushRootArguments(staging->GraphicsRootArguments, ToNative(), true); } while(0)
+#define DXL_FLUSH_COMPUTE_ROOT_ARGUMENTS() do { if (CommandListState* staging = GetRootArgumentStaging(GetExtensionState())) CommandListState::FlushRootArguments(staging->ComputeRootArguments, ToNative(), false); } while(0)
+
+#else
+
+#define DXL_FLUSH_BARRIERS()
+#define DXL_FLUSH_GRAPHICS_ROOT_ARGUMENTS()
+#define DXL_FLUSH_COMPUTE_ROOT_ARGUMENTS()
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+// == IDXLCommandList =====================================================
+
+D3D12_COMMAND_LIST_TYPE IDXLCommandList::GetType() const
+{
+    return ToNative()->GetType();
+}
+
+HRESULT IDXLCommandList::Close()
+{
+    DXL_FLUSH_BARRIERS();
+    return ToNative()->Close();
+}
+
+HRESULT IDXLCommandList::Reset(IDXLCommandAllocator allocator, IDXLPipelineState pipelineState)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState)
+    {
+        extensionState->ClearPendingBarriers();
+        extensionState->ResetRootArguments();
+        extensionState->InvalidateShadowState();
+        extensionState->Shadow.PipelineStateValid = true;
+        extensionState->Shadow.PipelineState = pipelineState;
+    }
+#endif
+
+    return ToNative()->Reset(allocator, pipelineState);
+}
+
+void IDXLCommandList::ClearState(IDXLPipelineState pipelineState)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState)
+    {
+        extensionState->ResetRootArguments();
+        extensionState->InvalidateShadowState();
+        extensionState->Shadow.PipelineStateValid = true;
+        extensionState->Shadow.PipelineState = pipelineState;
+    }
+#endif
+
+    ToNative()->ClearState(pipelineState);
+}
+
+void IDXLCommandList::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_GRAPHICS_ROOT_ARGUMENTS();
+    ToNative()->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+}
+
+void IDXLCommandList::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_GRAPHICS_ROOT_ARGUMENTS();
+    ToNative()->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+void IDXLCommandList::Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_COMPUTE_ROOT_ARGUMENTS();
+    ToNative()->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void IDXLCommandList::DispatchRays(const D3D12_DISPATCH_RAYS_DESC* desc)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_COMPUTE_ROOT_ARGUMENTS();
+    ToNative()->DispatchRays(desc);
+}
+
+void IDXLCommandList::DispatchMesh(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_GRAPHICS_ROOT_ARGUMENTS();
+    ToNative()->DispatchMesh(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void IDXLCommandList::DispatchGraph(const D3D12_DISPATCH_GRAPH_DESC* desc)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_COMPUTE_ROOT_ARGUMENTS();
+    ToNative()->DispatchGraph(desc);
+}
+
+void IDXLCommandList::CopyBufferRegion(IDXLResource dstBuffer, uint64_t dstOffset, IDXLResource srcBuffer, uint64_t srcOffset, uint64_t numBytes)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->CopyBufferRegion(dstBuffer, dstOffset, srcBuffer, srcOffset, numBytes);
+}
+
+void IDXLCommandList::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst, uint32_t dstX, uint32_t dstY, uint32_t dstZ, const D3D12_TEXTURE_COPY_LOCATION* src, const D3D12_BOX* srcBox)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->CopyTextureRegion(dst, dstX, dstY, dstZ, src, srcBox);
+}
+
+void IDXLCommandList::CopyResource(IDXLResource dstResource, IDXLResource srcResource)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->CopyResource(dstResource, srcResource);
+}
+
+void IDXLCommandList::CopyTiles(IDXLResource tiledResource, const D3D12_TILED_RESOURCE_COORDINATE* tileRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* tileRegionSize, IDXLResource buffer, uint64_t bufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS flags)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->CopyTiles(tiledResource, tileRegionStartCoordinate, tileRegionSize, buffer, bufferStartOffsetInBytes, flags);
+}
+
+void IDXLCommandList::Barrier(uint32_t numBarrierGroups, const D3D12_BARRIER_GROUP* barrierGroups)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->Barrier(numBarrierGroups, barrierGroups);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+void IDXLCommandList::Barrier(D3D12_GLOBAL_BARRIER barrier)
+{
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState && extensionState->HasFeature(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS))
+    {
+        extensionState->PendingGlobalBarriers.push_back(barrier);
+        extensionState->AddPendingGroupBarrier(D3D12_BARRIER_TYPE_GLOBAL);
+        return;
+    }
+
+    const D3D12_BARRIER_GROUP group =
+    {
+        .Type = D3D12_BARRIER_TYPE_GLOBAL,
+        .NumBarriers = 1,
+        .pGlobalBarriers = &barrier,
+    };
+    ToNative()->Barrier(1, &group);
+}
+
+void IDXLCommandList::Barrier(D3D12_BUFFER_BARRIER barrier)
+{
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState && extensionState->HasFeature(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS))
+    {
+        // Two barriers on the same resource need to stay in separate Barrier() calls so that they're applied in order
+        if (extensionState->PendingResources.insert(barrier.pResource).second == false)
+        {
+            FlushBarriers();
+            extensionState->PendingResources.insert(barrier.pResource);
+        }
+
+        extensionState->PendingBufferBarriers.push_back(barrier);
+        extensionState->AddPendingGroupBarrier(D3D12_BARRIER_TYPE_BUFFER);
+        return;
+    }
+
+    const D3D12_BARRIER_GROUP group =
+    {
+        .Type = D3D12_BARRIER_TYPE_BUFFER,
+        .NumBarriers = 1,
+        .pBufferBarriers = &barrier,
+    };
+    ToNative()->Barrier(1, &group);
+}
+
+void IDXLCommandList::Barrier(D3D12_TEXTURE_BARRIER barrier)
+{
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState && extensionState->HasFeature(DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS))
+    {
+        // Two barriers on the same resource need to stay in separate Barrier() calls so that they're applied in order
+        if (extensionState->PendingResources.insert(barrier.pResource).second == false)
+        {
+            FlushBarriers();
+            extensionState->PendingResources.insert(barrier.pResource);
+        }
+
+        extensionState->PendingTextureBarriers.push_back(barrier);
+        extensionState->AddPendingGroupBarrier(D3D12_BARRIER_TYPE_TEXTURE);
+        return;
+    }
+
+    const D3D12_BARRIER_GROUP group =
+    {
+        .Type = D3D12_BARRIER_TYPE_TEXTURE,
+        .NumBarriers = 1,
+        .pTextureBarriers = &barrier,
+    };
+    ToNative()->Barrier(1, &group);
+}
+
+void IDXLCommandList::FlushBarriers()
+{
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState == nullptr || extensionState->HasPendingBarriers() == false)
+        return;
+
+    uint64_t numGlobal = 0;
+    uint64_t numBuffer = 0;
+    uint64_t numTexture = 0;
+    for (D3D12_BARRIER_GROUP& group : extensionState->PendingGroups)
+    {
+        if (group.Type == D3D12_BARRIER_TYPE_GLOBAL)
+        {
+            group.pGlobalBarriers = extensionState->PendingGlobalBarriers.data() + numGlobal;
+            numGlobal += group.NumBarriers;
+        }
+        else if (group.Type == D3D12_BARRIER_TYPE_BUFFER)
+        {
+            group.pBufferBarriers = extensionState->PendingBufferBarriers.data() + numBuffer;
+            numBuffer += group.NumBarriers;
+        }
+        else
+        {
+            group.pTextureBarriers = extensionState->PendingTextureBarriers.data() + numTexture;
+            numTexture += group.NumBarriers;
+        }
+    }
+
+    ToNative()->Barrier(uint32_t(extensionState->PendingGroups.size()), extensionState->PendingGroups.data());
+
+    extensionState->ClearPendingBarriers();
+}
+
+void IDXLCommandList::InvalidateStateCache()
+{
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState)
+        extensionState->InvalidateShadowState();
+}
+
+DXL_COMMAND_LIST_STATE_FILTER_STATS IDXLCommandList::GetStateFilterStats() const
+{
+    CommandListState* extensionState = GetExtensionState();
+    return extensionState ? extensionState->FilterStats : DXL_COMMAND_LIST_STATE_FILTER_STATS();
+}
+
+void IDXLCommandList::ResetStateFilterStats()
+{
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState)
+        extensionState->FilterStats = DXL_COMMAND_LIST_STATE_FILTER_STATS();
+}
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+void IDXLCommandList::ResolveSubresource(IDXLResource dstResource, uint32_t dstSubresource, IDXLResource srcResource, uint32_t srcSubresource, DXGI_FORMAT format)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ResolveSubresource(dstResource, dstSubresource, srcResource, srcSubresource, format);
+}
+
+void IDXLCommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (CommandListState* filter = GetStateFilter(extensionState))
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        if (filter->ElideStateChange(shadow.PrimitiveTopologyValid && shadow.PrimitiveTopology == primitiveTopology))
+            return;
+
+        shadow.PrimitiveTopologyValid = true;
+        shadow.PrimitiveTopology = primitiveTopology;
+    }
+#endif
+
+    ToNative()->IASetPrimitiveTopology(primitiveTopology);
+}
+
+void IDXLCommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
+{
+    ToNative()->IASetIndexBuffer(view);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+void IDXLCommandList::IASetIndexBuffer(D3D12_GPU_VIRTUAL_ADDRESS bufferLocation, uint32_t sizeInBytes, DXGI_FORMAT format)
+{
+    D3D12_INDEX_BUFFER_VIEW d3d12View = { .BufferLocation = bufferLocation, .SizeInBytes = sizeInBytes, .Format = format };
+    ToNative()->IASetIndexBuffer(&d3d12View);
+}
+
+#endif
+
+void IDXLCommandList::IASetIndexBufferStripCutValue(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE ibStripCutValue)
+{
+    ToNative()->IASetIndexBufferStripCutValue(ibStripCutValue);
+}
+
+void IDXLCommandList::RSSetViewports(uint32_t numViewports, const D3D12_VIEWPORT* viewports)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* filter = GetStateFilter(extensionState);
+    if (filter && numViewports <= D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE)
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        const size_t viewportsSize = numViewports * sizeof(D3D12_VIEWPORT);
+        if (filter->ElideStateChange(shadow.ViewportsValid && shadow.NumViewports == numViewports && memcmp(shadow.Viewports, viewports, viewportsSize) == 0))
+            return;
+
+        shadow.ViewportsValid = true;
+        shadow.NumViewports = numViewports;
+        memcpy(shadow.Viewports, viewports, viewportsSize);
+    }
+#endif
+
+    ToNative()->RSSetViewports(numViewports, viewports);
+}
+
+void IDXLCommandList::RSSetScissorRects(uint32_t numRects, const D3D12_RECT* rects)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* filter = GetStateFilter(extensionState);
+    if (filter && numRects <= D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE)
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        const size_t rectsSize = numRects * sizeof(D3D12_RECT);
+        if (filter->ElideStateChange(shadow.ScissorRectsValid && shadow.NumScissorRects == numRects && memcmp(shadow.ScissorRects, rects, rectsSize) == 0))
+            return;
+
+        shadow.ScissorRectsValid = true;
+        shadow.NumScissorRects = numRects;
+        memcpy(shadow.ScissorRects, rects, rectsSize);
+    }
+#endif
+
+    ToNative()->RSSetScissorRects(numRects, rects);
+}
+
+void IDXLCommandList::RSSetDepthBias(float depthBias, float depthBiasClamp, float slopeScaledDepthBias)
+{
+    ToNative()->RSSetDepthBias(depthBias, depthBiasClamp, slopeScaledDepthBias);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+void IDXLCommandList::RSSetViewportAndScissor(uint32_t width, uint32_t height)
+{
+    D3D12_VIEWPORT viewport =
+    {
+        .TopLeftX = 0.0f,
+        .TopLeftY = 0.0f,
+        .Width = float(width),
+        .Height = float(height),
+        .MinDepth = 0.0f,
+        .MaxDepth = 1.0f,
+    };
+
+    D3D12_RECT scissorRect =
+    {
+        scissorRect.left = 0,
+        scissorRect.top = 0,
+        scissorRect.right = uint32_t(width),
+        scissorRect.bottom = uint32_t(height),
+    };
+
+    RSSetViewports(1, &viewport);
+    RSSetScissorRects(1, &scissorRect);
+}
+
+#endif
+
+void IDXLCommandList::RSSetShadingRate(D3D12_SHADING_RATE baseShadingRate, const D3D12_SHADING_RATE_COMBINER* combiners)
+{
+    ToNative()->RSSetShadingRate(baseShadingRate, combiners);
+}
+
+void IDXLCommandList::RSSetShadingRateImage(IDXLResource shadingRateImage)
+{
+    ToNative()->RSSetShadingRateImage(shadingRateImage);
+}
+
+void IDXLCommandList::OMSetBlendFactor(const float blendFactor[4])
+{
+    ToNative()->OMSetBlendFactor(blendFactor);
+}
+
+void IDXLCommandList::OMSetStencilRef(uint32_t stencilRef)
+{
+    ToNative()->OMSetStencilRef(stencilRef);
+}
+
+void IDXLCommandList::OMSetFrontAndBackStencilRef(uint32_t frontStencilRef, uint32_t backStencilRef)
+{
+    ToNative()->OMSetFrontAndBackStencilRef(frontStencilRef, backStencilRef);
+}
+
+void IDXLCommandList::SetPipelineState(IDXLPipelineState pipelineState)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (CommandListState* filter = GetStateFilter(extensionState))
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        if (filter->ElideStateChange(shadow.PipelineStateValid && shadow.PipelineState == pipelineState))
+            return;
+
+        shadow.PipelineStateValid = true;
+        shadow.PipelineState = pipelineState;
+    }
+#endif
+
+    ToNative()->SetPipelineState(pipelineState);
+}
+
+void IDXLCommandList::SetPipelineState1(IDXLStateObject stateObject)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    // Setting a state object replaces the current PSO, so the next SetPipelineState always needs to go through
+    if (extensionState)
+        extensionState->Shadow.PipelineStateValid = false;
+#endif
+
+    ToNative()->SetPipelineState1(stateObject);
+}
+
+void IDXLCommandList::SetProgram(const D3D12_SET_PROGRAM_DESC* desc)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (extensionState)
+        extensionState->Shadow.PipelineStateValid = false;
+#endif
+
+    ToNative()->SetProgram(desc);
+}
+
+void IDXLCommandList::SetDescriptorHeaps(uint32_t numDescriptorHeaps, ID3D12DescriptorHeap*const* descriptorHeaps)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* filter = GetStateFilter(extensionState);
+    if (filter && numDescriptorHeaps <= DXL_ARRAY_SIZE(filter->Shadow.DescriptorHeaps))
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        const size_t heapsSize = numDescriptorHeaps * sizeof(ID3D12DescriptorHeap*);
+        if (filter->ElideStateChange(shadow.DescriptorHeapsValid && shadow.NumDescriptorHeaps == numDescriptorHeaps && memcmp(shadow.DescriptorHeaps, descriptorHeaps, heapsSize) == 0))
+            return;
+
+        shadow.DescriptorHeapsValid = true;
+        shadow.NumDescriptorHeaps = numDescriptorHeaps;
+        memcpy(shadow.DescriptorHeaps, descriptorHeaps, heapsSize);
+    }
+#endif
+
+    ToNative()->SetDescriptorHeaps(numDescriptorHeaps, descriptorHeaps);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+void IDXLCommandList::SetDescriptorHeaps(IDXLDescriptorHeap srvUavCbvHeap, IDXLDescriptorHeap samplerHeap)
+{
+    ID3D12DescriptorHeap* heaps[] = { srvUavCbvHeap, samplerHeap };
+    SetDescriptorHeaps(samplerHeap ? 2 : 1, heaps);
+}
+
+#endif
+
+void IDXLCommandList::SetComputeRootSignature(IDXLRootSignature rootSignature)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (CommandListState* staging = GetRootArgumentStaging(extensionState))
+        CommandListState::BindRootSignature(staging->ComputeRootArguments, rootSignature);
+
+    if (CommandListState* filter = GetStateFilter(extensionState))
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        if (filter->ElideStateChange(shadow.ComputeRootSignatureValid && shadow.ComputeRootSignature == rootSignature))
+            return;
+
+        shadow.ComputeRootSignatureValid = true;
+        shadow.ComputeRootSignature = rootSignature;
+    }
+#endif
+
+    ToNative()->SetComputeRootSignature(rootSignature);
+}
+
+void IDXLCommandList::SetGraphicsRootSignature(IDXLRootSignature rootSignature)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    if (CommandListState* staging = GetRootArgumentStaging(extensionState))
+        CommandListState::BindRootSignature(staging->GraphicsRootArguments, rootSignature);
+
+    if (CommandListState* filter = GetStateFilter(extensionState))
+    {
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        if (filter->ElideStateChange(shadow.GraphicsRootSignatureValid && shadow.GraphicsRootSignature == rootSignature))
+            return;
+
+        shadow.GraphicsRootSignatureValid = true;
+        shadow.GraphicsRootSignature = rootSignature;
+    }
+#endif
+
+    ToNative()->SetGraphicsRootSignature(rootSignature);
+}
+
+#if DXL_ENABLE_DESCRIPTOR_TABLES
+
+void IDXLCommandList::SetComputeRootDescriptorTable(uint32_t rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+{
+    ToNative()->SetComputeRootDescriptorTable(rootParameterIndex, baseDescriptor);
+}
+
+void IDXLCommandList::SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+{
+    ToNative()->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+}
+
+#endif
+
+void IDXLCommandList::SetComputeRoot32BitConstant(uint32_t rootParameterIndex, uint32_t srcData, uint32_t destOffsetIn32BitValues)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageConstants(staging->ComputeRootArguments, rootParameterIndex, 1, &srcData, destOffsetIn32BitValues))
+        return;
+#endif
+
+    ToNative()->SetComputeRoot32BitConstant(rootParameterIndex, srcData, destOffsetIn32BitValues);
+}
+
+void IDXLCommandList::SetGraphicsRoot32BitConstant(uint32_t rootParameterIndex, uint32_t srcData, uint32_t destOffsetIn32BitValues)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageConstants(staging->GraphicsRootArguments, rootParameterIndex, 1, &srcData, destOffsetIn32BitValues))
+        return;
+#endif
+
+    ToNative()->SetGraphicsRoot32BitConstant(rootParameterIndex, srcData, destOffsetIn32BitValues);
+}
+
+void IDXLCommandList::SetComputeRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValuesToSet, const void* srcData, uint32_t destOffsetIn32BitValues)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageConstants(staging->ComputeRootArguments, rootParameterIndex, num32BitValuesToSet, reinterpret_cast<const uint32_t*>(srcData), destOffsetIn32BitValues))
+        return;
+#endif
+
+    ToNative()->SetComputeRoot32BitConstants(rootParameterIndex, num32BitValuesToSet, srcData, destOffsetIn32BitValues);
+}
+
+void IDXLCommandList::SetGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValuesToSet, const void* srcData, uint32_t destOffsetIn32BitValues)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageConstants(staging->GraphicsRootArguments, rootParameterIndex, num32BitValuesToSet, reinterpret_cast<const uint32_t*>(srcData), destOffsetIn32BitValues))
+        return;
+#endif
+
+    ToNative()->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValuesToSet, srcData, destOffsetIn32BitValues);
+}
+
+void IDXLCommandList::SetComputeRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageDescriptor(staging->ComputeRootArguments, rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE_CBV, bufferLocation))
+        return;
+#endif
+
+    ToNative()->SetComputeRootConstantBufferView(rootParameterIndex, bufferLocation);
+}
+
+void IDXLCommandList::SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageDescriptor(staging->GraphicsRootArguments, rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE_CBV, bufferLocation))
+        return;
+#endif
+
+    ToNative()->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+}
+
+void IDXLCommandList::SetComputeRootShaderResourceView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageDescriptor(staging->ComputeRootArguments, rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE_SRV, bufferLocation))
+        return;
+#endif
+
+    ToNative()->SetComputeRootShaderResourceView(rootParameterIndex, bufferLocation);
+}
+
+void IDXLCommandList::SetGraphicsRootShaderResourceView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageDescriptor(staging->GraphicsRootArguments, rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE_SRV, bufferLocation))
+        return;
+#endif
+
+    ToNative()->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
+}
+
+void IDXLCommandList::SetComputeRootUnorderedAccessView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageDescriptor(staging->ComputeRootArguments, rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE_UAV, bufferLocation))
+        return;
+#endif
+
+    ToNative()->SetComputeRootUnorderedAccessView(rootParameterIndex, bufferLocation);
+}
+
+void IDXLCommandList::SetGraphicsRootUnorderedAccessView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* staging = GetRootArgumentStaging(extensionState);
+    if (staging && CommandListState::StageDescriptor(staging->GraphicsRootArguments, rootParameterIndex, D3D12_ROOT_PARAMETER_TYPE_UAV, bufferLocation))
+        return;
+#endif
+
+    ToNative()->SetGraphicsRootUnorderedAccessView(rootParameterIndex, bufferLocation);
+}
+
+void IDXLCommandList::OMSetRenderTargets(uint32_t numRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargetDescriptors, bool rtIsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencilDescriptor)
+{
+#if DXL_ENABLE_EXTENSIONS
+    CommandListState* extensionState = GetExtensionState();
+    CommandListState* filter = GetStateFilter(extensionState);
+    if (filter && numRenderTargetDescriptors <= D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT)
+    {
+        // With a single handle to a descriptor range only the first handle is read
+        CommandListState::ShadowState& shadow = filter->Shadow;
+        const uint32_t numHandles = rtIsSingleHandleToDescriptorRange ? std::min(numRenderTargetDescriptors, 1u) : numRenderTargetDescriptors;
+        const size_t handlesSize = numHandles * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE);
+        const bool hasDepthStencil = depthStencilDescriptor != nullptr;
+
+        bool redundant = shadow.RenderTargetsValid && shadow.NumRenderTargets == numRenderTargetDescriptors;
+        redundant = redundant && shadow.RenderTargetsAreSingleHandle == rtIsSingleHandleToDescriptorRange;
+        redundant = redundant && memcmp(shadow.RenderTargets, renderTargetDescriptors, handlesSize) == 0;
+        redundant = redundant && shadow.HasDepthStencil == hasDepthStencil;
+        redundant = redundant && (hasDepthStencil == false || shadow.DepthStencil.ptr == depthStencilDescriptor->ptr);
+        if (filter->ElideStateChange(redundant))
+            return;
+
+        shadow.RenderTargetsValid = true;
+        shadow.NumRenderTargets = numRenderTargetDescriptors;
+        shadow.RenderTargetsAreSingleHandle = rtIsSingleHandleToDescriptorRange;
+        memcpy(shadow.RenderTargets, renderTargetDescriptors, handlesSize);
+        shadow.HasDepthStencil = hasDepthStencil;
+        shadow.DepthStencil = hasDepthStencil ? *depthStencilDescriptor : D3D12_CPU_DESCRIPTOR_HANDLE { };
+    }
+#endif
+
+    ToNative()->OMSetRenderTargets(numRenderTargetDescriptors, renderTargetDescriptors, rtIsSingleHandleToDescriptorRange, depthStencilDescriptor);
+}
+
+void IDXLCommandList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,float depth, uint8_t stencil, uint32_t numRects, const D3D12_RECT* rects)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ClearDepthStencilView(depthStencilView, clearFlags, depth, stencil, numRects, rects);
+}
+
+void IDXLCommandList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const float colorRGBA[4], uint32_t numRects, const D3D12_RECT* rects)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ClearRenderTargetView(renderTargetView, colorRGBA, numRects, rects);
+}
+
+void IDXLCommandList::DiscardResource(IDXLResource resource, const D3D12_DISCARD_REGION* region)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->DiscardResource(resource, region);
+}
+
+void IDXLCommandList::BeginRenderPass(uint32_t numRenderTargets, const D3D12_RENDER_PASS_RENDER_TARGET_DESC* renderTargets, const D3D12_RENDER_PASS_DEPTH_STENCIL_DESC* depthStencil, D3D12_RENDER_PASS_FLAGS flags)
+{
+    CommandListState* extensionState = GetExtensionState();
+    DXL_FLUSH_BARRIERS();
+
+#if DXL_ENABLE_EXTENSIONS
+    // Render passes bind their own render targets
+    if (extensionState)
+        extensionState->Shadow.RenderTargetsValid = false;
+#endif
+
+    ToNative()->BeginRenderPass(numRenderTargets, renderTargets, depthStencil, flags);
+}
+
+void IDXLCommandList::EndRenderPass()
+{
+    ToNative()->EndRenderPass();
+}
+
+#if DXL_ENABLE_CLEAR_UAV
+
+void IDXLCommandList::ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE viewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE viewCPUHandle, IDXLResource resource, const uint32_t values[4], uint32_t numRects, const D3D12_RECT* rects)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ClearUnorderedAccessViewUint(viewGPUHandleInCurrentHeap, viewCPUHandle, resource, values, numRects, rects);
+}
+
+void IDXLCommandList::ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE viewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE viewCPUHandle, IDXLResource resource, const float values[4], uint32_t numRects, const D3D12_RECT* rects)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ClearUnorderedAccessViewFloat(viewGPUHandleInCurrentHeap, viewCPUHandle, resource, values, numRects, rects);
+}
+
+#endif
+
+void IDXLCommandList::BeginQuery(IDXLQueryHeap queryHeap, D3D12_QUERY_TYPE type, uint32_t index)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->BeginQuery(queryHeap, type, index);
+}
+
+void IDXLCommandList::EndQuery(IDXLQueryHeap queryHeap, D3D12_QUERY_TYPE type, uint32_t index)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->EndQuery(queryHeap, type, index);
+}
+
+void IDXLCommandList::ResolveQueryData(IDXLQueryHeap queryHeap, D3D12_QUERY_TYPE type, uint32_t startIndex, uint32_t numQueries, IDXLResource destinationBuffer, uint64_t alignedDestinationBufferOffset)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ResolveQueryData(queryHeap, type, startIndex, numQueries, destinationBuffer, alignedDestinationBufferOffset);
+}
+
+void IDXLCommandList::SetPredication(IDXLResource buffer, uint64_t alignedBufferOffset, D3D12_PREDICATION_OP operation)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->SetPredication(buffer, alignedBufferOffset, operation);
+}
+
+void IDXLCommandList::ExecuteIndirect(IDXLCommandSignature commandSignature, uint32_t maxCommandCount, IDXLResource argumentBuffer, uint64_t argumentBufferOffset, IDXLResource countBuffer, uint64_t countBufferOffset)
+{
+    DXL_FLUSH_BARRIERS();
+    DXL_FLUSH_GRAPHICS_ROOT_ARGUMENTS();
+    DXL_FLUSH_COMPUTE_ROOT_ARGUMENTS();
+    ToNative()->ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset, countBuffer, countBufferOffset);
+}
+
+void IDXLCommandList::AtomicCopyBufferUINT(ID3D12Resource* dstBuffer, uint64_t dstOffset, ID3D12Resource* srcBuffer, uint64_t srcOffset, uint32_t dependencies, ID3D12Resource*const* dependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* dependentSubresourceRanges)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->AtomicCopyBufferUINT(dstBuffer, dstOffset, srcBuffer, srcOffset, dependencies, dependentResources, dependentSubresourceRanges);
+}
+
+// UINT64 is only valid on UMA architectures
+void IDXLCommandList::AtomicCopyBufferUINT64(IDXLResource dstBuffer, uint64_t dstOffset, IDXLResource srcBuffer, uint64_t srcOffset, uint32_t dependencies, ID3D12Resource*const* dependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* dependentSubresourceRanges)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->AtomicCopyBufferUINT64(dstBuffer, dstOffset, srcBuffer, srcOffset, dependencies, dependentResources, dependentSubresourceRanges);
+}
+
+void IDXLCommandList::OMSetDepthBounds(float min, float max)
+{
+    ToNative()->OMSetDepthBounds(min, max);
+}
+
+void IDXLCommandList::SetSamplePositions(uint32_t numSamplesPerPixel, uint32_t numPixels, D3D12_SAMPLE_POSITION* samplePositions)
+{
+    ToNative()->SetSamplePositions(numSamplesPerPixel, numPixels, samplePositions);
+}
+
+void IDXLCommandList::ResolveSubresourceRegion(IDXLResource dstResource, uint32_t dstSubresource, uint32_t dstX, uint32_t dstY, IDXLResource srcResource, uint32_t srcSubresource, D3D12_RECT* srcRect, DXGI_FORMAT format, D3D12_RESOLVE_MODE resolveMode)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->ResolveSubresourceRegion(dstResource, dstSubresource, dstX, dstY, srcResource, srcSubresource, srcRect, format, resolveMode);
+}
+
+#if DXL_ENABLE_VIEW_INSTANCING
+void IDXLCommandList::SetViewInstanceMask(uint32_t mask)
+{
+    ToNative()->SetViewInstanceMask(mask);
+}
+#endif
+
+void IDXLCommandList::WriteBufferImmediate(uint32_t count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER* params, const D3D12_WRITEBUFFERIMMEDIATE_MODE* modes)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->WriteBufferImmediate(count, params, modes);
+}
+
+void IDXLCommandList::BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* desc, uint32_t numPostbuildInfoDescs, const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* postbuildInfoDescs)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->BuildRaytracingAccelerationStructure(desc, numPostbuildInfoDescs, postbuildInfoDescs);
+}
+
+void IDXLCommandList::EmitRaytracingAccelerationStructurePostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* desc, uint32_t numSourceAccelerationStructures, const D3D12_GPU_VIRTUAL_ADDRESS* sourceAccelerationStructureData)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->EmitRaytracingAccelerationStructurePostbuildInfo(desc, numSourceAccelerationStructures, sourceAccelerationStructureData);
+}
+
+void IDXLCommandList::CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS destAccelerationStructureData, D3D12_GPU_VIRTUAL_ADDRESS sourceAccelerationStructureData, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode)
+{
+    DXL_FLUSH_BARRIERS();
+    ToNative()->CopyRaytracingAccelerationStructure(destAccelerationStructureData, sourceAccelerationStructureData, mode);
+}
+
+// == IDXLCommandQueue ======================================================
+
+void IDXLCommandQueue::UpdateTileMappings(IDXLResource resource, uint32_t numResourceRegions, const D3D12_TILED_RESOURCE_COORDINATE* resourceRegionStartCoordinates, const D3D12_TILE_REGION_SIZE* resourceRegionSizes, ID3D12Heap* pHeap, uint32_t numRanges, const D3D12_TILE_RANGE_FLAGS* rangeFlags, const uint32_t* heapRangeStartOffsets, const uint32_t* rangeTileCounts, D3D12_TILE_MAPPING_FLAGS flags)
+{
+    ToNative()->UpdateTileMappings(resource, numResourceRegions, resourceRegionStartCoordinates, resourceRegionSizes, pHeap, numRanges, rangeFlags, heapRangeStartOffsets, rangeTileCounts, flags);
+}
+
+void IDXLCommandQueue::CopyTileMappings(IDXLResource dstResource, const D3D12_TILED_RESOURCE_COORDINATE* dstRegionStartCoordinate, IDXLResource srcResource, const D3D12_TILED_RESOURCE_COORDINATE* srcRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* regionSize, D3D12_TILE_MAPPING_FLAGS flags)
+{
+    ToNative()->CopyTileMappings(dstResource, dstRegionStartCoordinate, srcResource, srcRegionStartCoordinate, regionSize, flags);
+}
+
+void IDXLCommandQueue::ExecuteCommandLists(uint32_t numCommandLists, ID3D12CommandList*const* commandLists)
+{
+    DXL_TRACE_SCOPE("ExecuteCommandLists");
+    ToNative()->ExecuteCommandLists(numCommandLists, commandLists);
+}
+
+HRESULT IDXLCommandQueue::Signal(IDXLFence fence, uint64_t value)
+{
+    return ToNative()->Signal(fence, value);
+}
+
+HRESULT IDXLCommandQueue::Wait(IDXLFence fence, uint64_t value)
+{
+    return ToNative()->Wait(fence, value);
+}
+
+HRESULT IDXLCommandQueue::GetTimestampFrequency(uint64_t* outFrequency) const
+{
+    return ToNative()->GetTimestampFrequency(outFrequency);
+}
+
+HRESULT IDXLCommandQueue::GetClockCalibration(uint64_t* outGpuTimestamp, uint64_t* outCpuTimestamp) const
+{
+    return ToNative()->GetClockCalibration(outGpuTimestamp, outCpuTimestamp);
+}
+
+D3D12_COMMAND_QUEUE_DESC IDXLCommandQueue::GetDesc() const
+{
+    return ToNative()->GetDesc();
+}
+
+/*HRESULT IDXLCommandQueue::SetProcessPriority(D3D12_COMMAND_QUEUE_PROCESS_PRIORITY priority)
+{
+    return ToNative()->SetProcessPriority(priority);
+}
+
+HRESULT IDXLCommandQueue::GetProcessPriority(D3D12_COMMAND_QUEUE_PROCESS_PRIORITY* outValue)
+{
+    return ToNative()->GetProcessPriority(outValue);
+}
+
+HRESULT IDXLCommandQueue::SetGlobalPriority(D3D12_COMMAND_QUEUE_GLOBAL_PRIORITY priority)
+{
+    return ToNative()->SetGlobalPriority(priority);
+}
+
+HRESULT IDXLCommandQueue::GetGlobalPriority(D3D12_COMMAND_QUEUE_GLOBAL_PRIORITY* outValue)
+{
+    return ToNative()->GetGlobalPriority(outValue);
+}*/
+
+// == IDXLDevice ======================================================
+
+uint32_t IDXLDevice::GetNodeCount()
+{
+    return ToNative()->GetNodeCount();
+}
+
+LUID IDXLDevice::GetAdapterLuid()
+{
+    return ToNative()->GetAdapterLuid();
+}
+
+HRESULT IDXLDevice::CheckFeatureSupport(D3D12_FEATURE feature, void* featureSupportData, uint32_t featureSupportDataSize)
+{
+    return ToNative()->CheckFeatureSupport(feature, featureSupportData, featureSupportDataSize);
+}
+
+HRESULT IDXLDevice::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* desc, REFIID riid, void** outCommandQueue)
+{
+    return ToNative()->CreateCommandQueue(desc, riid, outCommandQueue);
+}
+
+HRESULT IDXLDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** outCommandAllocator)
+{
+    return ToNative()->CreateCommandAllocator(type, riid, outCommandAllocator);
+}
+
+HRESULT IDXLDevice::CreateCommandList1(uint32_t nodeMask, D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags, REFIID riid, void** outCommandList)
+{
+    return ToNative()->CreateCommandList1(nodeMask, type, flags, riid, outCommandList);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLCommandQueue IDXLDevice::CreateCommandQueue(D3D12_COMMAND_QUEUE_DESC desc)
+{
+    IDXLCommandQueue commandQueue;
+    DXL_HANDLE_HRESULT(ToNative()->CreateCommandQueue(&desc, DXL_PPV_ARGS(&commandQueue)));
+    return commandQueue;
+}
+
+IDXLCommandAllocator IDXLDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type)
+{
+    IDXLCommandAllocator commandAllocator;
+    DXL_HANDLE_HRESULT(ToNative()->CreateCommandAllocator(type, DXL_PPV_ARGS(&commandAllocator)));
+    return commandAllocator;
+}
+
+IDXLCommandList IDXLDevice::CreateCommandList(D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags, DXL_COMMAND_LIST_FEATURE_FLAGS features)
+{
+    IDXLCommandList commandList;
+    DXL_HANDLE_HRESULT(ToNative()->CreateCommandList1(0, type, flags, DXL_PPV_ARGS(&commandList)));
+
+    if (commandList && features != DXL_COMMAND_LIST_FEATURE_FLAG_NONE)
+    {
+        // The command list takes its own reference through the private data, and releases it when it's destroyed
+        CommandListState* state = new CommandListState(features);
+        DXL_HANDLE_HRESULT_MSG(commandList.ToNative()->SetPrivateDataInterface(CommandListStateGUID, state), "Failed to attach extension state to the command list");
+        state->Release();
+    }
+
+    return commandList;
+}
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+HRESULT IDXLDevice::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, REFIID riid, void** outPipelineState)
+{
+    return ToNative()->CreateComputePipelineState(desc, riid, outPipelineState);
+}
+
+HRESULT IDXLDevice::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* desc, REFIID riid, void** outPipelineState)
+{
+    return ToNative()->CreatePipelineState(desc, riid, outPipelineState);
+}
+
+HRESULT IDXLDevice::CreateStateObject(const D3D12_STATE_OBJECT_DESC* desc, REFIID riid, void** outStateObject)
+{
+    return ToNative()->CreateStateObject(desc, riid, outStateObject);
+}
+
+HRESULT IDXLDevice::AddToStateObject(const D3D12_STATE_OBJECT_DESC* addition, IDXLStateObject stateObjectToGrowFrom, REFIID riid, void** outNewStateObject)
+{
+    return ToNative()->AddToStateObject(addition, stateObjectToGrowFrom, riid, outNewStateObject);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLPipelineState IDXLDevice::CreateComputePSO(D3D12_COMPUTE_PIPELINE_STATE_DESC desc)
+{
+    DXL_TRACE_SCOPE("CreateComputePSO");
+
+    PSOCache* cache = extensionState ? extensionState->PipelineCache.get() : nullptr;
+    const DXL_HASH128 hash = cache ? Helpers::HashPSODesc(desc) : DXL_HASH128();
+    if (cache)
+    {
+        if (ID3D12PipelineState* cachedPSO = cache->Find(hash))
+            return cachedPSO;
+    }
+
+    IDXLPipelineState pso;
+    DXL_HANDLE_HRESULT(ToNative()->CreateComputePipelineState(&desc, DXL_PPV_ARGS(&pso)));
+
+    if (cache && pso)
+        return cache->Insert(hash, desc.pRootSignature, pso);
+
+    return pso;
+}
+
+IDXLPipelineState IDXLDevice::CreateComputePSO(IDXLRootSignature rootSignature, const void* byteCode, size_t byteCodeLength)
+{
+    return CreateComputePSO({ .pRootSignature = rootSignature, .CS = { byteCode, byteCodeLength } });
+}
+
+IDXLPipelineState IDXLDevice::CreateGraphicsPSO(D3D12_PIPELINE_STATE_STREAM_DESC desc)
+{
+    DXL_TRACE_SCOPE("CreateGraphicsPSO");
+
+    IDXLPipelineState pso;
+    DXL_HANDLE_HRESULT(ToNative()->CreatePipelineState(&desc, DXL_PPV_ARGS(&pso)));
+    return pso;
+}
+
+IDXLPipelineState IDXLDevice::CreateGraphicsPSO(DXL_SIMPLE_GRAPHICS_PSO_DESC desc)
+{
+    PSOCache* cache = extensionState ? extensionState->PipelineCache.get() : nullptr;
+    const DXL_HASH128 hash = cache ? Helpers::HashPSODesc(desc) : DXL_HASH128();
+    if (cache)
+    {
+        if (ID3D12PipelineState* cachedPSO = cache->Find(hash))
+            return cachedPSO;
+    }
+
+    CD3DX12_PIPELINE_STATE_STREAM6 stateStream;
+    stateStream.pRootSignature = desc.RootSignature;
+    stateStream.PrimitiveTopologyType = desc.PrimitiveTopologyType;
+    stateStream.VS = desc.VertexShaderByteCode;
+    stateStream.PS = desc.PixelShaderByteCode;
+    stateStream.BlendState = CD3DX12_BLEND_DESC(desc.BlendState);
+    stateStream.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC2(desc.DepthStencilState);
+    stateStream.DSVFormat = desc.DepthStencilFormat;
+    stateStream.RasterizerState = CD3DX12_RASTERIZER_DESC2(desc.RasterizerState);
+    stateStream.RTVFormats = desc.RenderTargetFormats;
+
+    IDXLPipelineState pso = CreateGraphicsPSO({ .SizeInBytes = sizeof(stateStream), .pPipelineStateSubobjectStream = &stateStream, });
+
+    if (cache && pso)
+        return cache->Insert(hash, desc.RootSignature, pso);
+
+    return pso;
+}
+
+IDXLPipelineState IDXLDevice::CreateGraphicsPSO(DXL_MESH_SHADER_GRAPHICS_PSO_DESC desc)
+{
+    PSOCache* cache = extensionState ? extensionState->PipelineCache.get() : nullptr;
+    const DXL_HASH128 hash = cache ? Helpers::HashPSODesc(desc) : DXL_HASH128();
+    if (cache)
+    {
+        if (ID3D12PipelineState* cachedPSO = cache->Find(hash))
+            return cachedPSO;
+    }
+
+    CD3DX12_PIPELINE_STATE_STREAM6 stateStream;
+    stateStream.pRootSignature = desc.RootSignature;
+    stateStream.PrimitiveTopologyType = desc.PrimitiveTopologyType;
+    stateStream.AS = desc.AmplificationShaderByteCode;
+    stateStream.MS = desc.MeshShaderByteCode;
+    stateStream.PS = desc.PixelShaderByteCode;
+    stateStream.BlendState = CD3DX12_BLEND_DESC(desc.BlendState);
+    stateStream.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC2(desc.DepthStencilState);
+    stateStream.DSVFormat = desc.DepthStencilFormat;
+    stateStream.RasterizerState = CD3DX12_RASTERIZER_DESC2(desc.RasterizerState);
+    stateStream.RTVFormats = desc.RenderTargetFormats;
+
+    IDXLPipelineState pso = CreateGraphicsPSO({ .SizeInBytes = sizeof(stateStream), .pPipelineStateSubobjectStream = &stateStream, });
+
+    if (cache && pso)
+        return cache->Insert(hash, desc.RootSignature, pso);
+
+    return pso;
+}
+
+IDXLStateObject IDXLDevice::CreateStateObject(D3D12_STATE_OBJECT_DESC desc)
+{
+    IDXLStateObject  stateObject;
+    DXL_HANDLE_HRESULT(ToNative()->CreateStateObject(&desc, DXL_PPV_ARGS(&stateObject)));
+    return stateObject;
+}
+
+IDXLStateObject  IDXLDevice::AddToStateObject(D3D12_STATE_OBJECT_DESC addition, IDXLStateObject stateObjectToGrowFrom)
+{
+    IDXLStateObject  stateObject;
+    DXL_HANDLE_HRESULT(ToNative()->AddToStateObject(&addition, stateObjectToGrowFrom.ToNative(), DXL_PPV_ARGS(&stateObjectToGrowFrom)));
+    return stateObject;
+}
+
+DXL_PSO_CACHE_STATS IDXLDevice::GetPSOCacheStats() const
+{
+    if (extensionState == nullptr || extensionState->PipelineCache == nullptr)
+        return DXL_PSO_CACHE_STATS();
+
+    return extensionState->PipelineCache->GetStats();
+}
+
+void IDXLDevice::ClearPSOCache()
+{
+    if (extensionState && extensionState->PipelineCache)
+        extensionState->PipelineCache->Clear();
+}
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+HRESULT IDXLDevice::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* descriptorHeapDesc, REFIID riid, void** outHeap)
+{
+    return ToNative()->CreateDescriptorHeap(descriptorHeapDesc, riid, outHeap);
+}
+
+uint32_t IDXLDevice::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType)
+{
+    return ToNative()->GetDescriptorHandleIncrementSize(descriptorHeapType);
+}
+
+HRESULT IDXLDevice::CreateRootSignature(uint32_t nodeMask, const void* blobWithRootSignature, size_t blobLengthInBytes, REFIID riid, void** outRootSignature)
+{
+    return ToNative()->CreateRootSignature(nodeMask, blobWithRootSignature, blobLengthInBytes, riid, outRootSignature);
+}
+
+HRESULT IDXLDevice::CreateRootSignatureFromSubobjectInLibrary(uint32_t nodeMask, const void* libraryBlob, size_t blobLengthInBytes, const wchar_t* subobjectName, REFIID riid, void** rootSignature)
+{
+    return ToNative()->CreateRootSignatureFromSubobjectInLibrary(nodeMask, libraryBlob, blobLengthInBytes, subobjectName, riid, rootSignature);
+}
+
+HRESULT IDXLDevice::CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* desc, REFIID riid, void** outHeap)
+{
+    return ToNative()->CreateQueryHeap(desc, riid, outHeap);
+}
+
+HRESULT IDXLDevice::CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC* desc, IDXLRootSignature rootSignature, REFIID riid, void** outCommandSignature)
+{
+    return ToNative()->CreateCommandSignature(desc, rootSignature, riid, outCommandSignature);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLDescriptorHeap IDXLDevice::CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc)
+{
+    IDXLDescriptorHeap descriptorHeap;
+    DXL_HANDLE_HRESULT(ToNative()->CreateDescriptorHeap(&descriptorHeapDesc, DXL_PPV_ARGS(&descriptorHeap)));
+    return descriptorHeap;
+}
+
+IDXLRootSignature IDXLDevice::CreateRootSignature(D3D12_ROOT_SIGNATURE_DESC2 rootSignatureDesc)
+{
+    D3D12_VERSIONED_ROOT_SIGNATURE_DESC versionedDesc =
+    {
+        .Version = D3D_ROOT_SIGNATURE_VERSION_1_2,
+        .Desc_1_2 = rootSignatureDesc,
+    };
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    HRESULT hr = D3D12SerializeVersionedRootSignature(&versionedDesc, &signature, &error);
+    if (FAILED(hr))
+    {
+        const char* errString = error ? reinterpret_cast<const char*>(error->GetBufferPointer()) : "";
+        DXL_HANDLE_HRESULT_MSG(hr, errString);
+        return IDXLRootSignature();
+    }
+
+    IDXLRootSignature rootSig;
+    DXL_HANDLE_HRESULT(ToNative()->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), DXL_PPV_ARGS(&rootSig)));
+
+    if (rootSig)
+    {
+        // Used by command lists with DXL_COMMAND_LIST_FEATURE_FLAG_DEFER_ROOT_ARGUMENTS to size their root argument staging
+        HashBuilder blobHash;
+        blobHash.Add(signature->GetBufferPointer(), signature->GetBufferSize());
+        RootSignatureLayout* layout = new RootSignatureLayout(rootSignatureDesc, blobHash.Finalize());
+        DXL_HANDLE_HRESULT_MSG(rootSig.ToNative()->SetPrivateDataInterface(RootSignatureLayoutGUID, layout), "Failed to attach the parameter layout to the root signature");
+        layout->Release();
+    }
+
+    return rootSig;
+}
+
+IDXLQueryHeap IDXLDevice::CreateQueryHeap(D3D12_QUERY_HEAP_DESC desc)
+{
+    IDXLQueryHeap queryHeap;
+    DXL_HANDLE_HRESULT(ToNative()->CreateQueryHeap(&desc, DXL_PPV_ARGS(&queryHeap)));
+    return queryHeap;
+}
+
+IDXLCommandSignature IDXLDevice::CreateCommandSignature(D3D12_COMMAND_SIGNATURE_DESC desc, IDXLRootSignature rootSignature)
+{
+    IDXLCommandSignature commandSignature;
+    DXL_HANDLE_HRESULT(ToNative()->CreateCommandSignature(&desc, rootSignature, DXL_PPV_ARGS(&commandSignature)));
+    return commandSignature;
+}
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+void IDXLDevice::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateConstantBufferView(desc, destDescriptor);
+}
+
+void IDXLDevice::CreateShaderResourceView(IDXLResource resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateShaderResourceView(resource, desc, destDescriptor);
+}
+
+void IDXLDevice::CreateUnorderedAccessView(IDXLResource resource, IDXLResource counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateUnorderedAccessView(resource, counterResource, desc, destDescriptor);
+}
+
+void IDXLDevice::CreateSamplerFeedbackUnorderedAccessView(IDXLResource targetedResource, IDXLResource feedbackResource, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateSamplerFeedbackUnorderedAccessView(targetedResource, feedbackResource, destDescriptor);
+}
+
+void IDXLDevice::CreateRenderTargetView(IDXLResource resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateRenderTargetView(resource, desc, destDescriptor);
+}
+
+void IDXLDevice::CreateDepthStencilView(IDXLResource resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateDepthStencilView(resource, desc, destDescriptor);
+}
+
+void IDXLDevice::CreateSampler2(const D3D12_SAMPLER_DESC2* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    ToNative()->CreateSampler2(desc, destDescriptor);
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO IDXLDevice::GetResourceAllocationInfo3(uint32_t visibleMask, uint32_t numResourceDescs, const D3D12_RESOURCE_DESC1* resourceDescs, const uint32_t* numCastableFormats, const DXGI_FORMAT*const* castableFormats, D3D12_RESOURCE_ALLOCATION_INFO1* resourceAllocationInfo)
+{
+    return ToNative()->GetResourceAllocationInfo3(visibleMask, numResourceDescs, resourceDescs, numCastableFormats, castableFormats, resourceAllocationInfo);
+}
+
+HRESULT IDXLDevice::CreateHeap(const D3D12_HEAP_DESC* desc, REFIID riid, void** outHeap)
+{
+    return ToNative()->CreateHeap(desc, riid, outHeap);
+}
+
+HRESULT IDXLDevice::OpenExistingHeapFromAddress1(const void* address, size_t size, REFIID riid, void** outHeap)
+{
+    return ToNative()->OpenExistingHeapFromAddress1(address, size, riid, outHeap);
+}
+
+HRESULT IDXLDevice::OpenExistingHeapFromFileMapping(HANDLE fileMapping, REFIID riid, void** outHeap)
+{
+    return ToNative()->OpenExistingHeapFromFileMapping(fileMapping, riid, outHeap);
+}
+
+D3D12_HEAP_PROPERTIES IDXLDevice::GetCustomHeapProperties(uint32_t nodeMask, D3D12_HEAP_TYPE heapType)
+{
+    return ToNative()->GetCustomHeapProperties(nodeMask, heapType);
+}
+
+HRESULT IDXLDevice::CreateCommittedResource3(const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC1* desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, ID3D12ProtectedResourceSession* protectedSession, uint32_t numCastableFormats, const DXGI_FORMAT* castableFormats, REFIID riid, void** outResource)
+{
+    return ToNative()->CreateCommittedResource3(heapProperties, heapFlags, desc, initialLayout, optimizedClearValue, protectedSession, numCastableFormats, castableFormats, riid, outResource);
+}
+
+HRESULT IDXLDevice::CreatePlacedResource2(IDXLHeap heap, uint64_t heapOffset, const D3D12_RESOURCE_DESC1* desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, uint32_t numCastableFormats, const DXGI_FORMAT* castableFormats, REFIID riid, void** outResource)
+{
+    return ToNative()->CreatePlacedResource2(heap, heapOffset, desc, initialLayout, optimizedClearValue, numCastableFormats, castableFormats, riid, outResource);
+}
+
+HRESULT IDXLDevice::CreateReservedResource2(const D3D12_RESOURCE_DESC* desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, ID3D12ProtectedResourceSession* protectedSession, uint32_t numCastableFormats, const DXGI_FORMAT* castableFormats, REFIID riid, void** outResource)
+{
+    return ToNative()->CreateReservedResource2(desc, initialLayout, optimizedClearValue, protectedSession, numCastableFormats, castableFormats, riid, outResource);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLHeap IDXLDevice::CreateHeap(D3D12_HEAP_DESC desc)
+{
+    IDXLHeap heap;
+    DXL_HANDLE_HRESULT(ToNative()->CreateHeap(&desc, DXL_PPV_ARGS(&heap)));
+    return heap;
+}
+
+IDXLResource IDXLDevice::CreateCommittedResource(D3D12_HEAP_PROPERTIES heapProperties, D3D12_HEAP_FLAGS heapFlags, D3D12_RESOURCE_DESC1 desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
+{
+    IDXLResource resource;
+    DXL_HANDLE_HRESULT(ToNative()->CreateCommittedResource3(&heapProperties, heapFlags, &desc, initialLayout, optimizedClearValue, nullptr, castableFormats.Count, castableFormats.Items, DXL_PPV_ARGS(&resource)));
+    return resource;
+}
+
+IDXLResource IDXLDevice::CreatePlacedResource(IDXLHeap heap, uint64_t heapOffset, D3D12_RESOURCE_DESC1 desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
+{
+    IDXLResource resource;
+    DXL_HANDLE_HRESULT(ToNative()->CreatePlacedResource2(heap, heapOffset, &desc, initialLayout, optimizedClearValue, castableFormats.Count, castableFormats.Items, DXL_PPV_ARGS(&resource)));
+    return resource;
+}
+
+IDXLResource IDXLDevice::CreateTiledResource(D3D12_RESOURCE_DESC desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
+{
+    IDXLResource resource;
+    DXL_HANDLE_HRESULT(ToNative()->CreateReservedResource2(&desc, initialLayout, optimizedClearValue, nullptr, castableFormats.Count, castableFormats.Items, DXL_PPV_ARGS(&resource)));
+    return resource;
+}
+
+#endif // #if DXL_ENABLE_EXTENSIONS
+
+void IDXLDevice::GetResourceTiling(IDXLResource tiledResource, uint32_t* outNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* outPackedMipDesc, D3D12_TILE_SHAPE* outStandardTileShapeForNonPackedMips, uint32_t* numSubresourceTilings, uint32_t firstSubresourceTilingToGet, D3D12_SUBRESOURCE_TILING* outSubresourceTilingsForNonPackedMips)
+{
+    return ToNative()->GetResourceTiling(tiledResource, outNumTilesForEntireResource, outPackedMipDesc, outStandardTileShapeForNonPackedMips, numSubresourceTilings, firstSubresourceTilingToGet, outSubresourceTilingsForNonPackedMips);
+}
+
+HRESULT IDXLDevice::CreateSharedHandle(IDXLDeviceChild object, const SECURITY_ATTRIBUTES* attributes, uint32_t access, const wchar_t* name, HANDLE* outHandle)
+{
+    return ToNative()->CreateSharedHandle(object, attributes, access, name, outHandle);
+}
+
+HRESULT IDXLDevice::OpenSharedHandle(HANDLE ntHandle, REFIID riid, void** outObj)
+{
+    return ToNative()->OpenSharedHandle(ntHandle, riid, outObj);
+}
+
+HRESULT IDXLDevice::OpenSharedHandleByName(const wchar_t* name, uint32_t access, HANDLE* outHandle)
+{
+    return ToNative()->OpenSharedHandleByName(name, access, outHandle);
+}
+
+HRESULT IDXLDevice::MakeResident(uint32_t numObjects, ID3D12Pageable*const* objects)
+{
+    return ToNative()->MakeResident(numObjects, objects);
+}
+
+HRESULT IDXLDevice::EnqueueMakeResident(D3D12_RESIDENCY_FLAGS flags, uint32_t numObjects, ID3D12Pageable*const* objects, ID3D12Fence* fenceToSignal, UINT64 fenceValueToSignal)
+{
+    return ToNative()->EnqueueMakeResident(flags, numObjects, objects, fenceToSignal, fenceValueToSignal);
+}
+
+HRESULT IDXLDevice::Evict(uint32_t numObjects, ID3D12Pageable*const* objects)
+{
+    return ToNative()->Evict(numObjects, objects);
+}
+
+HRESULT IDXLDevice::SetResidencyPriority(uint32_t numObjects, ID3D12Pageable*const* objects, const D3D12_RESIDENCY_PRIORITY* priorities)
+{
+    return ToNative()->SetResidencyPriority(numObjects, objects, priorities);
+}
+
+HRESULT IDXLDevice::CreateFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** outFence)
+{
+    return ToNative()->CreateFence(initialValue, flags, riid, outFence);
+}
+
+HRESULT IDXLDevice::SetEventOnMultipleFenceCompletion(ID3D12Fence*const* fences, const uint64_t* fenceValues, uint32_t numFences, D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags, HANDLE event)
+{
+    return ToNative()->SetEventOnMultipleFenceCompletion(fences, fenceValues, numFences, flags, event);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLFence IDXLDevice::CreateFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags)
+{
+    IDXLFence fence;
+    ToNative()->CreateFence(initialValue, flags, DXL_PPV_ARGS(&fence));
+    return fence;
+}
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+void IDXLDevice::GetRaytracingAccelerationStructurePrebuildInfo(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* desc, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* outInfo)
+{
+    ToNative()->GetRaytracingAccelerationStructurePrebuildInfo(desc, outInfo);
+}
+
+void IDXLDevice::RemoveDevice()
+{
+    ToNative()->RemoveDevice();
+}
+
+HRESULT IDXLDevice::GetDeviceRemovedReason()
+{
+    return ToNative()->GetDeviceRemovedReason();
+}
+
+void IDXLDevice::GetCopyableFootprints1(const D3D12_RESOURCE_DESC1* resourceDesc, uint32_t firstSubresource, uint32_t numSubresources, uint64_t baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, uint32_t* numRows, uint64_t* rowSizeInBytes, uint64_t* totalBytes)
+{
+    ToNative()->GetCopyableFootprints1(resourceDesc, firstSubresource, numSubresources, baseOffset, layouts, numRows, rowSizeInBytes, totalBytes);
+}
+
+#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+
+HRESULT IDXLDevice::SetStablePowerState(bool enable)
+{
+    return ToNative()->SetStablePowerState(enable);
+}
+
+HRESULT IDXLDevice::SetBackgroundProcessingMode(D3D12_BACKGROUND_PROCESSING_MODE mode, D3D12_MEASUREMENTS_ACTION measurementsAction, HANDLE eventToSignalUponCompletion, BOOL* outFurtherMeasurementsDesired)
+{
+    return ToNative()->SetBackgroundProcessingMode(mode, measurementsAction, eventToSignalUponCompletion, outFurtherMeasurementsDesired);
+}
+
+#endif // DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+
+// == IDXLSwapChain ======================================================
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLSwapChain IDXLSwapChain::Create(DXGI_SWAP_CHAIN_DESC desc, IDXLCommandQueue presentQueue)
+{
+    ComPtr<IDXGIFactory7> factory;
+    HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
+    DXL_HANDLE_HRESULT_MSG(hr, "failed to create DXGI factory");
+    if (FAILED(hr))
+        return IDXLSwapChain();
+
+    ComPtr<IDXGISwapChain> tempSwapChain;
+    hr = factory->CreateSwapChain(presentQueue, &desc, &tempSwapChain);
+    DXL_HANDLE_HRESULT_MSG(hr, "failed to create swap chain");
+    if (FAILED(hr))
+        return IDXLSwapChain();
+
+    IDXLSwapChain swapChain;
+    hr = tempSwapChain->QueryInterface(DXL_PPV_ARGS(&swapChain));
+    DXL_HANDLE_HRESULT_MSG(hr, "failed to query swap chain interface");
+
+    return swapChain;
+}
+
+#endif
+
+HRESULT IDXLSwapChain::Present(uint32_t syncInterval, uint32_t presentFlags)
+{
+    DXL_TRACE_SCOPE("Present");
+    return ToNative()->Present(syncInterval, presentFlags);
+}
+
+HRESULT IDXLSwapChain::ResizeBuffers(uint32_t bufferCount, uint32_t width, uint32_t height, DXGI_FORMAT newFormat, UINT swapChainFlags)
+{
+    return ToNative()->ResizeBuffers(bufferCount, width, height, newFormat, swapChainFlags);
+}
+
+uint32_t IDXLSwapChain::GetCurrentBackBufferIndex() const
+{
+    return ToNative()->GetCurrentBackBufferIndex();
+}
+
+HRESULT IDXLSwapChain::GetBuffer(uint32_t buffer, REFIID riid, void** outSurface) const
+{
+    return ToNative()->GetBuffer(buffer, riid, outSurface);
+}
+
+HRESULT IDXLSwapChain::GetDesc1(DXGI_SWAP_CHAIN_DESC1* outDesc)
+{
+    return ToNative()->GetDesc1(outDesc);
+}
+
+HRESULT IDXLSwapChain::GetHwnd(HWND* outHwnd)
+{
+    return ToNative()->GetHwnd(outHwnd);
+}
+
+HRESULT IDXLSwapChain::SetMaximumFrameLatency(uint32_t maxLatency)
+{
+    return ToNative()->SetMaximumFrameLatency(maxLatency);
+}
+
+HRESULT IDXLSwapChain::GetMaximumFrameLatency(uint32_t* maxLatency)
+{
+    return ToNative()->GetMaximumFrameLatency(maxLatency);
+}
+
+HANDLE IDXLSwapChain::GetFrameLatencyWaitableObject()
+{
+    return ToNative()->GetFrameLatencyWaitableObject();
+}
+
+HRESULT IDXLSwapChain::CheckColorSpaceSupport(DXGI_COLOR_SPACE_TYPE colorSpace, uint32_t* colorSpaceSupport)
+{
+    return ToNative()->CheckColorSpaceSupport(colorSpace, colorSpaceSupport);
+}
+
+HRESULT IDXLSwapChain::SetColorSpace1(DXGI_COLOR_SPACE_TYPE colorSpace)
+{
+    return ToNative()->SetColorSpace1(colorSpace);
+}
+
+HRESULT IDXLSwapChain::SetHDRMetaData(DXGI_HDR_METADATA_TYPE type, uint32_t size, void* metaData)
+{
+    return ToNative()->SetHDRMetaData(type, size, metaData);
+}
+
+HRESULT IDXLSwapChain::SetRotation(DXGI_MODE_ROTATION rotation)
+{
+    return ToNative()->SetRotation(rotation);
+}
+
+HRESULT IDXLSwapChain::GetRotation(DXGI_MODE_ROTATION* outRotation)
+{
+    return ToNative()->GetRotation(outRotation);
+}
+
+HRESULT IDXLSwapChain::GetContainingOutput(IDXGIOutput** outOutput)
+{
+    return ToNative()->GetContainingOutput(outOutput);
+}
+
+HRESULT IDXLSwapChain::GetFrameStatistics(DXGI_FRAME_STATISTICS* outStats)
+{
+    return ToNative()->GetFrameStatistics(outStats);
+}
+
+HRESULT IDXLSwapChain::GetLastPresentCount(uint32_t* outLastPresentCount)
+{
+    return ToNative()->GetLastPresentCount(outLastPresentCount);
+}
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLResource IDXLSwapChain::GetBuffer(uint32_t bufferIndex) const
+{
+    IDXLResource resource;
+    ToNative()->GetBuffer(bufferIndex, DXL_PPV_ARGS(&resource));
+    return resource;
+}
+
+DXGI_SWAP_CHAIN_DESC1 IDXLSwapChain::GetDesc() const
+{
+    DXGI_SWAP_CHAIN_DESC1 desc = { };
+    ToNative()->GetDesc1(&desc);
+    return desc;
+}
+
+HWND IDXLSwapChain::GetHwnd() const
+{
+    HWND hwnd = nullptr;
+    ToNative()->GetHwnd(&hwnd);
+    return hwnd;
+}
+
+uint32_t IDXLSwapChain::GetMaximumFrameLatency()
+{
+    uint32_t latency = 0;
+    ToNative()->GetMaximumFrameLatency(&latency);
+    return latency;
+}
+
+DXGI_FRAME_STATISTICS IDXLSwapChain::GetFrameStatistics()
+{
+    DXGI_FRAME_STATISTICS stats = { };
+    ToNative()->GetFrameStatistics(&stats);
+    return stats;
+}
+
+uint32_t IDXLSwapChain::GetLastPresentCount()
+{
+    uint32_t presentCount = 0;
+    ToNative()->GetLastPresentCount(&presentCount);
+    return presentCount;
+}
+
+DXGI_MODE_ROTATION IDXLSwapChain::GetRotation()
+{
+    DXGI_MODE_ROTATION rotation = DXGI_MODE_ROTATION_UNSPECIFIED;
+    ToNative()->GetRotation(&rotation);
+    return rotation;
+}
+
+#endif // DXL_ENABLE_EXTENSIONS
+
+#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+
+// == IDXLDebug ======================================================
+
+void IDXLDebug::EnableDebugLayer()
+{
+    ToNative()->EnableDebugLayer();
+}
+
+void IDXLDebug::DisableDebugLayer()
+{
+    ToNative()->DisableDebugLayer();
+}
+
+void IDXLDebug::SetEnableGPUBasedValidation(bool enable)
+{
+    ToNative()->SetEnableGPUBasedValidation(enable);
+}
+
+void IDXLDebug::SetGPUBasedValidationFlags(D3D12_GPU_BASED_VALIDATION_FLAGS flags)
+{
+    ToNative()->SetGPUBasedValidationFlags(flags);
+}
+
+void IDXLDebug::SetEnableSynchronizedCommandQueueValidation(bool enable)
+{
+    ToNative()->SetEnableSynchronizedCommandQueueValidation(enable);
+}
+
+void IDXLDebug::SetEnableAutoName(bool enable)
+{
+    ToNative()->SetEnableAutoName(enable);
+}
+
+// == IDXLDebugDevice ======================================================
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLDebugDevice IDXLDebugDevice::FromDevice(IDXLDevice device)
+{
+    ID3D12DebugDevice2* debugDevice = nullptr;
+    DXL_HANDLE_HRESULT_MSG(device->QueryInterface(IID_PPV_ARGS(&debugDevice)), "Failed to QueryInterface debug device interface from IDXLDevice. Did you enable the debug layer?");
+    return IDXLDebugDevice(debugDevice);
+}
+
+#endif
+
+HRESULT IDXLDebugDevice::SetFeatureMask(D3D12_DEBUG_FEATURE mask)
+{
+    return ToNative()->SetFeatureMask(mask);
+}
+
+D3D12_DEBUG_FEATURE IDXLDebugDevice::GetFeatureMask()
+{
+    return ToNative()->GetFeatureMask();
+}
+
+HRESULT IDXLDebugDevice::ReportLiveDeviceObjects(D3D12_RLDO_FLAGS flags)
+{
+    return ToNative()->ReportLiveDeviceObjects(flags);
+}
+
+HRESULT IDXLDebugDevice::SetDebugParameter(D3D12_DEBUG_DEVICE_PARAMETER_TYPE type, const void*data, uint32_t dataSize)
+{
+    return ToNative()->SetDebugParameter(type, data, dataSize);
+}
+
+HRESULT IDXLDebugDevice::GetDebugParameter(D3D12_DEBUG_DEVICE_PARAMETER_TYPE type, void* data, uint32_t dataSize)
+{
+    return ToNative()->GetDebugParameter(type, data, dataSize);
+}
+
+// == IDXLDebugCommandQueue ======================================================
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLDebugCommandQueue IDXLDebugCommandQueue::FromCommandQueue(IDXLCommandQueue commandQueue)
+{
+    ID3D12DebugCommandQueue1* debugQueue = nullptr;    
+    DXL_HANDLE_HRESULT_MSG(commandQueue->QueryInterface(IID_PPV_ARGS(&debugQueue)), "Failed to QueryInterface debug command queue interface from IDXLCommandQueue. Did you enable the debug layer?");
+    return IDXLDebugCommandQueue(debugQueue);
+}
+
+#endif
+
+void IDXLDebugCommandQueue::AssertResourceAccess(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_ACCESS access)
+{
+    ToNative()->AssertResourceAccess(resource, subresource, access);
+}
+
+void IDXLDebugCommandQueue::AssertTextureLayout(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_LAYOUT layout)
+{
+    ToNative()->AssertTextureLayout(resource, subresource, layout);
+}
+
+// == IDXLDebugCommandList ======================================================
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLDebugCommandList IDXLDebugCommandList::FromCommandList(IDXLCommandList commandList)
+{
+    ID3D12DebugCommandList3* debugList = nullptr;
+    DXL_HANDLE_HRESULT_MSG(commandList->QueryInterface(IID_PPV_ARGS(&debugList)), "Failed to QueryInterface debug command list interface from IDXLCommandList. Did you enable the debug layer?");
+    return IDXLDebugCommandList(debugList);
+}
+
+#endif
+
+HRESULT IDXLDebugCommandList::SetFeatureMask(D3D12_DEBUG_FEATURE mask)
+{
+    return ToNative()->SetFeatureMask(mask);
+}
+
+D3D12_DEBUG_FEATURE IDXLDebugCommandList::GetFeatureMask()
+{
+    return ToNative()->GetFeatureMask();
+}
+
+HRESULT IDXLDebugCommandList::SetDebugParameter(D3D12_DEBUG_COMMAND_LIST_PARAMETER_TYPE type, const void*data, uint32_t dataSize)
+{
+    return ToNative()->SetDebugParameter(type, data, dataSize);
+}
+
+HRESULT IDXLDebugCommandList::GetDebugParameter(D3D12_DEBUG_COMMAND_LIST_PARAMETER_TYPE type, void* data, uint32_t dataSize)
+{
+    return ToNative()->GetDebugParameter(type, data, dataSize);
+}
+
+void IDXLDebugCommandList::AssertResourceAccess(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_ACCESS access)
+{
+    ToNative()->AssertResourceAccess(resource, subresource, access);
+}
+
+void IDXLDebugCommandList::AssertTextureLayout(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_LAYOUT layout)
+{
+    ToNative()->AssertTextureLayout(resource, subresource, layout);
+}
+
+// == IDXLDebugInfoQueue ======================================================
+
+#if DXL_ENABLE_EXTENSIONS
+
+IDXLDebugInfoQueue IDXLDebugInfoQueue::FromDevice(IDXLDevice device)
+{
+    ID3D12InfoQueue1* infoQueue = nullptr;    
+    DXL_HANDLE_HRESULT_MSG(device->QueryInterface(IID_PPV_ARGS(&infoQueue)), "Failed to QueryInterface debug command info queue interface from IDXLDevice. Did you enable the debug layer?");
+    return IDXLDebugInfoQueue(infoQueue);
+}
+
+#endif
+
+HRESULT IDXLDebugInfoQueue::RegisterMessageCallback(D3D12MessageFunc callbackFunc, D3D12_MESSAGE_CALLBACK_FLAGS callbackFilterFlags, void* context, DWORD* outCallbackCookie)
+{
+    return ToNative()->RegisterMessageCallback(callbackFunc, callbackFilterFlags, context, outCallbackCookie);
+}
+
+HRESULT IDXLDebugInfoQueue::UnregisterMessageCallback(DWORD callbackCookie)
+{
+    return ToNative()->UnregisterMessageCallback(callbackCookie);
+}
+
+void IDXLDebugInfoQueue::SetMuteDebugOutput(bool mute)
+{
+    ToNative()->SetMuteDebugOutput(mute);
+}
+
+bool IDXLDebugInfoQueue::GetMuteDebugOutput()
+{
+    return ToNative()->GetMuteDebugOutput();
+}
+
+#endif // DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+
+#if DXL_ENABLE_EXTENSIONS
+
+static void DefaultDebugLayerCallback([[maybe_unused]] D3D12_MESSAGE_CATEGORY category, D3D12_MESSAGE_SEVERITY severity, [[maybe_unused]] D3D12_MESSAGE_ID ID, const char* description, [[maybe_unused]] void* context)
+{
+    if (severity == D3D12_MESSAGE_SEVERITY_MESSAGE || severity == D3D12_MESSAGE_SEVERITY_MESSAGE)
+    {
+        PrintMessage("D3D Debug Layer: %s", description);
+        return;
+    }
+
+    PrintMessage("D3D Debug Layer Error: %s", description);
+    if (IsDebuggerPresent() == false)
+        ShowMessageBox("D3D Debug Layer Error: %s", description);
+    __debugbreak();
+}
+
+std::string GetDefaultAgilitySDKPath()
+{
+    const char* sdkRelativePath = "..\\..\\..\\..\\..\\AgilitySDK\\bin\\x64";
+
+    char exePath[MAX_PATH] = { };
+    GetModuleFileNameA(nullptr, exePath, DXL_ARRAY_SIZE(exePath));
+    std::string sdkPath = GetDirectoryFromFilePath(exePath) + sdkRelativePath;
+    return ResolveFilePath(sdkPath.c_str());
+}
+
+CreateDeviceResult CreateDevice(CreateDeviceParams params)
+{
+    ComPtr<IDXGIFactory7> factory;
+    HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
+    if (FAILED(hr))
+        return { IDXLDevice(), hr, "Failed to create DXGI factory" };
+
+    ComPtr<IDXGIAdapter4> adapter;
+    hr = factory->EnumAdapterByGpuPreference(0, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE, IID_PPV_ARGS(&adapter));
+    if (FAILED(hr))
+        return { IDXLDevice(), hr, "Failed to enumerate a DXGI adapter" };
+
+    DXGI_ADAPTER_DESC1 desc = { };
+    adapter->GetDesc1(&desc);
+    PrintMessage("Creating D3D12 device on adapter '%ls'", desc.Description);
+
+    ComPtr<ID3D12SDKConfiguration1> sdkConfig;
+    hr = D3D12GetInterface(CLSID_D3D12SDKConfiguration, IID_PPV_ARGS(&sdkConfig));
+    if (FAILED(hr))
+        return { IDXLDevice(), hr, "Failed to aquire the D3D12 SDK configuration interface" };
+
+    ComPtr<ID3D12DeviceFactory> deviceFactory;
+    hr = sdkConfig->CreateDeviceFactory(D3D12_SDK_VERSION, params.AgilitySDKPath.c_str(), IID_PPV_ARGS(&deviceFactory));
+    if (FAILED(hr))
+        return { IDXLDevice(), hr, MakeString("Failed to create a D3D12 device factory using Agility SDK Path '%s'. Did you pass the wrong AgilitySDKPath?", params.AgilitySDKPath.c_str()) };
+
+#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+    if (params.EnableDebugLayer)
+    {
+        ComPtr<ID3D12Debug1> d3d12debug;
+        if (SUCCEEDED(deviceFactory->GetConfigurationInterface(CLSID_D3D12Debug, DXL_PPV_ARGS(d3d12debug.GetAddressOf()))))
+        {
+            d3d12debug->EnableDebugLayer();
+            PrintMessage("Enabled D3D12 debug layer");
+        }
+
+        if (params.EnableGPUBasedValidation)
+            d3d12debug->SetEnableGPUBasedValidation(true);
+    }
+#endif
+
+    ComPtr<ID3D12Device14> device;
+    hr = deviceFactory->CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
+    if (FAILED(hr))
+        return { IDXLDevice(), hr, "Failed to create D3D12 device from the device factory" };
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = { };
+    device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options12, sizeof(options12));
+    if(options12.EnhancedBarriersSupported == false)
+        return { IDXLDevice(), E_FAIL, "The selected GPU does not support enhanced barriers, which is required for DXLatest" };
+
+#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+    {
+        ComPtr<ID3D12InfoQueue1> infoQueue;
+        if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&infoQueue))))
+        {
+            D3D12MessageFunc callback = params.DebugLayerCallbackFunction ? params.DebugLayerCallbackFunction : DefaultDebugLayerCallback;
+
+            DWORD callbackCookie = 0;
+            infoQueue->RegisterMessageCallback(callback, D3D12_MESSAGE_CALLBACK_FLAG_NONE, nullptr, &callbackCookie);
+        }
+    }
+#endif
+
+    IDXLDevice dxlDevice = device.Get();
+    if (params.EnablePSOCache)
+    {
+        // The device takes its own reference through the private data, and releases it when it's destroyed
+        DeviceState* state = new DeviceState();
+        state->PipelineCache = std::make_unique<PSOCache>();
+        hr = device->SetPrivateDataInterface(DeviceStateGUID, state);
+        if (SUCCEEDED(hr))
+            dxlDevice.extensionState = state;
+        state->Release();
+
+        if (FAILED(hr))
+            return { IDXLDevice(), hr, "Failed to attach extension state to the D3D12 device" };
+    }
+
+    device->AddRef();
+    return { dxlDevice, S_OK };
+}
+
+void Release(IUnknown*& unknown)
+{
+    if (unknown)
+    {
+        unknown->Release();
+        unknown = nullptr;
+    }
+}
+
+void Release(IDXLBase& base)
+{
+    if (base)
+    {
+        base->Release();
+        base = IDXLBase();
+    }
+}
+
+void Release(IDXLDevice& device)
+{
+    if (device)
+    {
+#if DXL_ENABLE_EXTENSIONS
+        device->ClearPSOCache();
+#endif
+        device->Release();
+        device = IDXLDevice();
+    }
+}
+
+namespace Helpers
+{
+
+std::string GetDefaultDXCPath()
+{
+    const char* relativePath = "..\\..\\..\\..\\..\\dxc\\bin\\x64\\dxcompiler.dll";
+
+    char exePath[MAX_PATH] = { };
+    GetModuleFileNameA(nullptr, exePath, DXL_ARRAY_SIZE(exePath));
+    std::string dllPath = GetDirectoryFromFilePath(exePath) + relativePath;
+    return ResolveFilePath(dllPath.c_str());
+}
+
+static const char* ShaderTypeStrings[] =
+{
+    "vertex",
+    "hull",
+    "domain",
+    "geometry",
+    "amplification",
+    "mesh",
+    "pixel",
+    "compute",
+    "lib"
+};
+static_assert(DXL_ARRAY_SIZE(ShaderTypeStrings) == uint32_t(ShaderType::NumTypes));
+
+static const wchar_t* ShaderProfileStrings[] =
+{
+    L"vs_6_8",
+    L"hs_6_8",
+    L"ds_6_8",
+    L"gs_6_8",
+    L"as_6_8",
+    L"ms_6_8",
+    L"ps_6_8",
+    L"cs_6_8",
+    L"lib_6_8"
+};
+static_assert(DXL_ARRAY_SIZE(ShaderProfileStrings) == uint32_t(ShaderType::NumTypes));
+
+// == Shader disk cache =====================================================
+
+static const uint32_t ShaderCacheMagic = 0x43535844;    // 'DXSC'
+static const uint32_t ShaderCacheVersion = 1;
+static const char* ShaderCacheExtension = ".dxlshader";
+
+// Cache files start with this header, followed by the include table and then the bytecode. Each include table entry
+// is the hash of the included file's contents, the length of its path, and then the path itself.
+struct ShaderCacheFileHeader
+{
+    uint32_t Magic = ShaderCacheMagic;
+    uint32_t Version = ShaderCacheVersion;
+    DXL_HASH128 Key;
+    uint32_t Type = 0;
+    uint32_t NumIncludes = 0;
+    uint64_t IncludeTableSize = 0;
+    uint64_t BytecodeSize = 0;
+};
+
+static DXL_HASH128 HashContents(const void* data, size_t size)
+{
+    HashBuilder hash;
+    hash.AddValue(size);
+    hash.Add(data, size);
+    return hash.Finalize();
+}
+
+// Size and last write time of a file, used to cheaply check whether a file changed
+struct FileStamp
+{
+    uint64_t Size = 0;
+    uint64_t WriteTime = 0;
+
+    bool operator==(const FileStamp& other) const = default;
+};
+
+static bool GetFileStamp(const char* filePath, FileStamp& stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fileData = { };
+    if (GetFileAttributesExA(filePath, GetFileExInfoStandard, &fileData) == false || (fileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    stamp.Size = (uint64_t(fileData.nFileSizeHigh) << 32) | fileData.nFileSizeLow;
+    stamp.WriteTime = (uint64_t(fileData.ftLastWriteTime.dwHighDateTime) << 32) | fileData.ftLastWriteTime.dwLowDateTime;
+
+    return true;
+}
+
+static bool ReadFileContents(const char* filePath, std::vector<uint8_t>& contents)
+{
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize = { };
+    bool succeeded = GetFileSizeEx(file, &fileSize) != 0;
+    if (succeeded)
+    {
+        contents.resize(size_t(fileSize.QuadPart));
+
+        DWORD bytesRead = 0;
+        if (contents.size() > 0)
+            succeeded = ReadFile(file, contents.data(), DWORD(contents.size()), &bytesRead, nullptr) && bytesRead == contents.size();
+    }
+
+    CloseHandle(file);
+
+    return succeeded;
+}
+
+// Process-wide cache of included files, keyed by the path that DXC asks for. Entries are checked against the file's
+// stamp before being handed out, so edited files get reloaded without having to clear the cache.
+class IncludeFileCache
+{
+
+public:
+
+    static IncludeFileCache& Get()
+    {
+        static IncludeFileCache cache;
+        return cache;
+    }
+
+    // Falls back to the loader on a miss. The dependency's path is left empty if the file couldn't be stamped.
+    HRESULT Load(LPCWSTR fileName, IDxcIncludeHandler* loader, ComPtr<IDxcBlob>& blob, ShaderDependency& dependency)
+    {
+        const std::string path = UTF8FromWide(fileName);
+
+        FileStamp stamp;
+        const bool hasStamp = GetFileStamp(path.c_str(), stamp);
+        if (hasStamp)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto iter = entries.find(path);
+            if (iter != entries.end() && iter->second.Stamp == stamp)
+            {
+                blob = iter->second.Blob.Get();
+                dependency = iter->second.Dependency;
+                return S_OK;
+            }
+        }
+
+        HRESULT hr = loader->LoadSource(fileName, &blob);
+        if (FAILED(hr))
+            return hr;
+        if (blob.Get() == nullptr)
+            return E_FAIL;
+
+        if (hasStamp == false)
+            return S_OK;
+
+        dependency.FilePath = ResolveFilePath(path.c_str());
+        dependency.ContentHash = HashContents(blob->GetBufferPointer(), blob->GetBufferSize());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entries[path];
+        entry.Stamp = stamp;
+        entry.Blob = blob.Get();
+        entry.Dependency = dependency;
+
+        return S_OK;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+private:
+
+    struct Entry
+    {
+        FileStamp Stamp;
+        ComPtr<IDxcBlob> Blob;
+        ShaderDependency Dependency;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+// Loads includes through the IncludeFileCache, and records the path and content hash of every file that gets included
+class TrackingIncludeHandler final : public RefCountedObject<IDxcIncludeHandler>
+{
+
+public:
+
+    std::vector<ShaderDependency> Includes;
+
+    TrackingIncludeHandler(IDxcIncludeHandler* baseHandler) : baseHandler(baseHandler)
+    {
+    }
+
+    HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR fileName, IDxcBlob** includeSource) override
+    {
+        if (includeSource == nullptr)
+            return E_INVALIDARG;
+
+        *includeSource = nullptr;
+
+        ComPtr<IDxcBlob> blob;
+        ShaderDependency dependency;
+        HRESULT hr = IncludeFileCache::Get().Load(fileName, baseHandler.Get(), blob, dependency);
+        if (FAILED(hr))
+            return hr;
+
+        auto isSameFile = [&](const ShaderDependency& include) { return include.FilePath == dependency.FilePath; };
+        if (dependency.FilePath.empty() == false && std::none_of(Includes.begin(), Includes.end(), isSameFile))
+            Includes.push_back(std::move(dependency));
+
+        *includeSource = blob.Detach();
+        return S_OK;
+    }
+
+private:
+
+    ComPtr<IDxcIncludeHandler> baseHandler;
+};
+
+static DXL_HASH128 HashDXCVersion(IDxcCompiler3* compiler)
+{
+    HashBuilder hash;
+
+    ComPtr<IDxcVersionInfo> versionInfo;
+    if (SUCCEEDED(compiler->QueryInterface(IID_PPV_ARGS(&versionInfo))))
+    {
+        uint32_t major = 0;
+        uint32_t minor = 0;
+        versionInfo->GetVersion(&major, &minor);
+        hash.AddValue(major);
+        hash.AddValue(minor);
+
+        ComPtr<IDxcVersionInfo2> versionInfo2;
+        if (SUCCEEDED(versionInfo->QueryInterface(IID_PPV_ARGS(&versionInfo2))))
+        {
+            uint32_t commitCount = 0;
+            char* commitHash = nullptr;
+            if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash)))
+            {
+                hash.AddValue(commitCount);
+                if (commitHash)
+                {
+                    hash.Add(commitHash, strlen(commitHash));
+                    CoTaskMemFree(commitHash);
+                }
+            }
+        }
+    }
+
+    return hash.Finalize();
+}
+
+// Content-addressed cache of compiled shaders. Files are written to a temporary path and then renamed so that readers
+// never see partial files, and the least-recently-used files are deleted once the directory grows past its size limit.
+class ShaderDiskCache
+{
+
+public:
+
+    static ShaderDiskCache& Get()
+    {
+        static ShaderDiskCache cache;
+        return cache;
+    }
+
+    bool Load(const std::string& directory, const DXL_HASH128& key, ShaderType type, IDxcIncludeHandler* includeLoader, CompiledShader& outShader)
+    {
+        const std::string filePath = GetFilePath(directory, key);
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        bool hit = false;
+        LARGE_INTEGER fileSize = { };
+        if (GetFileSizeEx(file, &fileSize) && uint64_t(fileSize.QuadPart) >= sizeof(ShaderCacheFileHeader))
+        {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+            {
+                const uint8_t* fileData = reinterpret_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                if (fileData != nullptr)
+                {
+                    hit = ReadCacheFile(fileData, uint64_t(fileSize.QuadPart), key, type, includeLoader, outShader);
+                    UnmapViewOfFile(fileData);
+                }
+
+                CloseHandle(mapping);
+            }
+        }
+
+        // Hits bump the write time, which is what the size limit uses to find the least-recently-used files
+        if (hit)
+        {
+            FILETIME currentTime = { };
+            GetSystemTimeAsFileTime(&currentTime);
+            SetFileTime(file, nullptr, nullptr, &currentTime);
+        }
+
+        CloseHandle(file);
+
+        return hit;
+    }
+
+    void Store(const std::string& directory, uint64_t sizeLimit, const DXL_HASH128& key, ShaderType type, const std::vector<ShaderDependency>& includes, const void* bytecode, size_t bytecodeSize)
+    {
+        std::vector<uint8_t> includeTable;
+        for (const ShaderDependency& include : includes)
+        {
+            const uint32_t pathLength = uint32_t(include.FilePath.size());
+            const size_t offset = includeTable.size();
+            includeTable.resize(offset + sizeof(DXL_HASH128) + sizeof(uint32_t) + pathLength);
+            memcpy(includeTable.data() + offset, &include.ContentHash, sizeof(DXL_HASH128));
+            memcpy(includeTable.data() + offset + sizeof(DXL_HASH128), &pathLength, sizeof(uint32_t));
+            memcpy(includeTable.data() + offset + sizeof(DXL_HASH128) + sizeof(uint32_t), include.FilePath.data(), pathLength);
+        }
+
+        ShaderCacheFileHeader header;
+        header.Key = key;
+        header.Type = uint32_t(type);
+        header.NumIncludes = uint32_t(includes.size());
+        header.IncludeTableSize = includeTable.size();
+        header.BytecodeSize = bytecodeSize;
+
+        CreateDirectoryA(directory.c_str(), nullptr);
+
+        const std::string filePath = GetFilePath(directory, key);
+        const std::string tempFilePath = filePath + MakeString(".%u.%u.tmp", GetCurrentProcessId(), GetCurrentThreadId());
+        HANDLE file = CreateFileA(tempFilePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        DWORD bytesWritten = 0;
+        bool succeeded = WriteFile(file, &header, sizeof(header), &bytesWritten, nullptr) && bytesWritten == sizeof(header);
+        if (succeeded && includeTable.size() > 0)
+            succeeded = WriteFile(file, includeTable.data(), DWORD(includeTable.size()), &bytesWritten, nullptr) && bytesWritten == includeTable.size();
+        if (succeeded)
+            succeeded = WriteFile(file, bytecode, DWORD(bytecodeSize), &bytesWritten, nullptr) && bytesWritten == bytecodeSize;
+        CloseHandle(file);
+
+        // Losing the rename to another thread or process that wrote the same entry is fine, the contents are identical
+        if (succeeded == false || MoveFileExA(tempFilePath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING) == false)
+        {
+            DeleteFileA(tempFilePath.c_str());
+            return;
+        }
+
+        const uint64_t fileSize = sizeof(header) + includeTable.size() + bytecodeSize;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (trackedDirectory != directory)
+        {
+            trackedDirectory = directory;
+            cacheSize = Trim(directory, UINT64_MAX);
+        }
+        else
+        {
+            cacheSize += fileSize;
+        }
+
+        // Trim down past the limit so that every write doesn't end up scanning the directory
+        if (cacheSize > sizeLimit)
+            cacheSize = Trim(directory, sizeLimit - sizeLimit / 4);
+    }
+
+private:
+
+    std::mutex mutex;
+    std::string trackedDirectory;
+    uint64_t cacheSize = 0;
+
+    static std::string GetFilePath(const std::string& directory, const DXL_HASH128& key)
+    {
+        return directory + MakeString("\\%016llx%016llx", key.Hi, key.Lo) + ShaderCacheExtension;
+    }
+
+    static bool ReadCacheFile(const uint8_t* fileData, uint64_t fileSize, const DXL_HASH128& key, ShaderType type, IDxcIncludeHandler* includeLoader, CompiledShader& outShader)
+    {
+        ShaderCacheFileHeader header;
+        memcpy(&header, fileData, sizeof(header));
+        if (header.Magic != ShaderCacheMagic || header.Version != ShaderCacheVersion || header.Key != key || header.Type != uint32_t(type))
+            return false;
+
+        // Check each size against what's left of the file, since adding up corrupted sizes could overflow
+        const uint64_t sectionsSize = fileSize - sizeof(header);
+        if (header.IncludeTableSize > sectionsSize || header.BytecodeSize != sectionsSize - header.IncludeTableSize)
+            return false;
+        if (header.NumIncludes > header.IncludeTableSize / (sizeof(DXL_HASH128) + sizeof(uint32_t)))
+            return false;
+
+        // The key only covers the main source file, so make sure that none of the includes changed
+        std::vector<ShaderDependency> includes;
+        includes.reserve(header.NumIncludes);
+        const uint8_t* includeData = fileData + sizeof(header);
+        const uint8_t* includeDataEnd = includeData + header.IncludeTableSize;
+        for (uint32_t includeIdx = 0; includeIdx < header.NumIncludes; ++includeIdx)
+        {
+            DXL_HASH128 contentHash;
+            uint32_t pathLength = 0;
+            if (uint64_t(includeDataEnd - includeData) < sizeof(contentHash) + sizeof(pathLength))
+                return false;
+
+            memcpy(&contentHash, includeData, sizeof(contentHash));
+            memcpy(&pathLength, includeData + sizeof(contentHash), sizeof(pathLength));
+            includeData += sizeof(contentHash) + sizeof(pathLength);
+            if (uint64_t(includeDataEnd - includeData) < pathLength)
+                return false;
+
+            const std::string path(reinterpret_cast<const char*>(includeData), pathLength);
+            includeData += pathLength;
+
+            ComPtr<IDxcBlob> includeSource;
+            ShaderDependency& include = includes.emplace_back();
+            if (FAILED(IncludeFileCache::Get().Load(WideStringConverter(path.c_str()).wideString, includeLoader, includeSource, include)))
+                return false;
+
+            if (include.FilePath.empty() || include.ContentHash != contentHash)
+                return false;
+        }
+
+        outShader.Dependencies.insert(outShader.Dependencies.end(), includes.begin(), includes.end());
+        outShader.Bytecode.resize(header.BytecodeSize);
+        memcpy(outShader.Bytecode.data(), includeDataEnd, header.BytecodeSize);
+        outShader.Type = type;
+
+        return true;
+    }
+
+    // Deletes the least-recently-used cache files until the total size is at or below the target, and returns the new total
+    static uint64_t Trim(const std::string& directory, uint64_t targetSize)
+    {
+        struct CacheFile
+        {
+            std::string Path;
+            uint64_t Size = 0;
+            uint64_t LastWriteTime = 0;
+        };
+
+        std::vector<CacheFile> cacheFiles;
+        uint64_t totalSize = 0;
+
+        WIN32_FIND_DATAA findData = { };
+        HANDLE findHandle = FindFirstFileA((directory + "\\*" + ShaderCacheExtension).c_str(), &findData);
+        if (findHandle == INVALID_HANDLE_VALUE)
+            return 0;
+
+        do
+        {
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+
+            CacheFile& cacheFile = cacheFiles.emplace_back();
+            cacheFile.Path = directory + "\\" + findData.cFileName;
+            cacheFile.Size = (uint64_t(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+            cacheFile.LastWriteTime = (uint64_t(findData.ftLastWriteTime.dwHighDateTime) << 32) | findData.ftLastWriteTime.dwLowDateTime;
+            totalSize += cacheFile.Size;
+        }
+        while (FindNextFileA(findHandle, &findData));
+
+        FindClose(findHandle);
+
+        if (totalSize <= targetSize)
+            return totalSize;
+
+        std::sort(cacheFiles.begin(), cacheFiles.end(), [](const CacheFile& a, const CacheFile& b) { return a.LastWriteTime < b.LastWriteTime; });
+        for (const CacheFile& cacheFile : cacheFiles)
+        {
+            if (totalSize <= targetSize)
+                break;
+
+            if (DeleteFileA(cacheFile.Path.c_str()))
+                totalSize -= cacheFile.Size;
+        }
+
+        return totalSize;
+    }
+};
+
+// DXC interfaces used for compiling, which aren't shared between threads
+struct ShaderCompilerContext
+{
+    ComPtr<IDxcUtils> Utils;
+    ComPtr<IDxcCompiler3> Compiler;
+    ComPtr<IDxcIncludeHandler> DefaultIncludeHandler;
+    DXL_HASH128 VersionHash;
+};
+
+static HRESULT CreateShaderCompilerContext(const std::string& pathToDXC, ShaderCompilerContext& context, std::string& errorMessage)
+{
+    // Each DXC library that gets loaded stays loaded, so that different PathToDXC values get their own compiler
+    struct DXCModule
+    {
+        std::string Path;
+        DxcCreateInstanceProc CreateInstance = nullptr;
+    };
+
+    static std::mutex dxcModuleMutex;
+    static std::vector<DXCModule> dxcModules;
+    DxcCreateInstanceProc dxcCreateInstance = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(dxcModuleMutex);
+        for (const DXCModule& dxcModule : dxcModules)
+        {
+            if (dxcModule.Path == pathToDXC)
+                dxcCreateInstance = dxcModule.CreateInstance;
+        }
+
+        if (dxcCreateInstance == nullptr)
+        {
+            if (FileExists(pathToDXC.c_str()) == false)
+            {
+                errorMessage = MakeString("DXC library file path '%s' does not exist", pathToDXC.c_str());
+                return E_FAIL;
+            }
+
+            HMODULE dxcModule = ::LoadLibrary(pathToDXC.c_str());
+            if (dxcModule == nullptr)
+            {
+                errorMessage = MakeString("Failed to load the DXC library from path '%s'", pathToDXC.c_str());
+                return E_FAIL;
+            }
+
+            dxcCreateInstance = (DxcCreateInstanceProc)::GetProcAddress(dxcModule, "DxcCreateInstance");
+            if (dxcCreateInstance == nullptr)
+            {
+                errorMessage = MakeString("Failed to find DxcCreateInstance in the DXC library at path '%s'", pathToDXC.c_str());
+                return E_FAIL;
+            }
+
+            dxcModules.push_back({ .Path = pathToDXC, .CreateInstance = dxcCreateInstance });
+        }
+    }
+
+    HRESULT hr = dxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&context.Utils));
+    if (FAILED(hr))
+    {
+        errorMessage = "Failed to create IDxcUtils instance";
+        return hr;
+    }
+
+    hr = dxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&context.Compiler));
+    if (FAILED(hr))
+    {
+        errorMessage = "Failed to create IDxcCompiler3 instance";
+        return hr;
+    }
+
+    hr = context.Utils->CreateDefaultIncludeHandler(&context.DefaultIncludeHandler);
+    if (FAILED(hr))
+    {
+        errorMessage = "Failed to create default include handler";
+        return hr;
+    }
+
+    context.VersionHash = HashDXCVersion(context.Compiler.Get());
+
+    return S_OK;
+}
+
+static HRESULT ValidateCompileShaderParams(const CompileShaderParams& params, std::string& errorMessage)
+{
+    if (uint32_t(params.Type) >= uint32_t(ShaderType::NumTypes))
+    {
+        errorMessage = "Invalid ShaderType passed to CompileShaderFromFile";
+        return E_FAIL;
+    }
+
+    if (FileExists(params.FilePath) == false)
+    {
+        errorMessage = MakeString("Shader file path '%s' does not exist", params.FilePath);
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+// Runs a single compile, without reporting anything through the error callback
+static CompileShaderResult CompileShader(const CompileShaderParams& params, ShaderCompilerContext& context)
+{
+    DXL_TRACE_SCOPE("CompileShader");
+
+    std::vector<DxcDefine> dxcDefines;
+    std::vector<WideStringConverter> defineStrings;
+    if (params.Defines.Count > 0)
+    {
+        dxcDefines.reserve(params.Defines.Count);
+        defineStrings.reserve(params.Defines.Count * 2);
+        for (const PreprocessorDefine& define : params.Defines)
+        {
+            const wchar_t* defineName = defineStrings.emplace_back(define.Name).wideString;
+            const wchar_t* defineValue = defineStrings.emplace_back(MakeString("%i", define.Value).c_str()).wideString;
+            dxcDefines.emplace_back(defineName, defineValue);
+        }
+    }
+
+    std::vector<const wchar_t*> compileArgs;
+    compileArgs.emplace_back(L"-HV 2021");
+    compileArgs.emplace_back(L"-enable-16bit-types");
+    if (params.WarningsAsErrors)
+        compileArgs.emplace_back(L"-WX");
+    compileArgs.emplace_back(params.EnableOptimizations ? L"-O3" : L"-O0");
+    if (params.EnableDebugInfo)
+    {
+        compileArgs.emplace_back(L"-Zi");
+        compileArgs.emplace_back(L"-Qembed_debug");
+    }
+    if (params.RowMajorByDefault)
+        compileArgs.emplace_back(L"-Zpr");
+
+    std::vector<WideStringConverter> includeDirs;
+    if (params.IncludeDirectories.Count > 0)
+    {
+        includeDirs.reserve(params.IncludeDirectories.Count);
+        for (const char* includeDir : params.IncludeDirectories)
+        {
+            const wchar_t* includeDirW = includeDirs.emplace_back(includeDir).wideString;
+            compileArgs.emplace_back(L"-I");
+            compileArgs.emplace_back(includeDirW);
+        }
+    }
+
+    const wchar_t* profileString = ShaderProfileStrings[uint32_t(params.Type)];
+    const char* entryPoint = params.Type != ShaderType::Library ? params.EntryPoint : "";
+
+    CompileShaderResult result;
+
+    ComPtr<IDxcCompilerArgs> dxcCompilerArgs;
+    result.Result = context.Utils->BuildArguments(WideStringConverter(params.FilePath).wideString, WideStringConverter(entryPoint).wideString, profileString, compileArgs.data(), uint32_t(compileArgs.size()), dxcDefines.data(), uint32_t(dxcDefines.size()), &dxcCompilerArgs);
+    if (FAILED(result.Result))
+    {
+        result.ErrorMessage = "Failed to build DXC compile args";
+        return result;
+    }
+
+    ComPtr<TrackingIncludeHandler> includeHandler;
+    includeHandler.Attach(new TrackingIncludeHandler(context.DefaultIncludeHandler.Get()));
+
+    ComPtr<IDxcBlobEncoding> sourceCode;
+    result.Result = context.Utils->LoadFile(WideStringConverter(params.FilePath).wideString, nullptr, &sourceCode);
+    if (FAILED(result.Result))
+    {
+        result.ErrorMessage = "Failed to create IDxcBlobEncoding from the file path";
+        return result;
+    }
+
+    result.Shader.Dependencies.push_back({ ResolveFilePath(params.FilePath), HashContents(sourceCode->GetBufferPointer(), sourceCode->GetBufferSize()) });
+
+    const bool useCache = params.CacheDirectory.empty() == false;
+
+    // The cache key covers everything that goes into the compile except for the includes, which are stored
+    // in the cache file along with their content hashes and checked when loading
+    DXL_HASH128 cacheKey;
+    if (useCache)
+    {
+        HashBuilder keyHash;
+        keyHash.AddValue(ShaderCacheVersion);
+        keyHash.AddValue(context.VersionHash.Lo);
+        keyHash.AddValue(context.VersionHash.Hi);
+        keyHash.AddValue(strlen(params.FilePath));
+        keyHash.Add(params.FilePath, strlen(params.FilePath));
+
+        LPCWSTR* arguments = dxcCompilerArgs->GetArguments();
+        for (uint32_t argIdx = 0; argIdx < dxcCompilerArgs->GetCount(); ++argIdx)
+        {
+            keyHash.AddValue(wcslen(arguments[argIdx]));
+            keyHash.Add(arguments[argIdx], wcslen(arguments[argIdx]) * sizeof(wchar_t));
+        }
+
+        keyHash.AddValue(sourceCode->GetBufferSize());
+        keyHash.Add(sourceCode->GetBufferPointer(), sourceCode->GetBufferSize());
+        cacheKey = keyHash.Finalize();
+
+        if (ShaderDiskCache::Get().Load(params.CacheDirectory, cacheKey, params.Type, context.DefaultIncludeHandler.Get(), result.Shader))
+            return result;
+    }
+
+    DxcBuffer sourceBuffer;
+    sourceBuffer.Ptr = sourceCode->GetBufferPointer();
+    sourceBuffer.Size = sourceCode->GetBufferSize();
+    sourceBuffer.Encoding = 0;
+
+    ComPtr<IDxcResult> operationResult;
+    result.Result = context.Compiler->Compile(&sourceBuffer, dxcCompilerArgs->GetArguments(), dxcCompilerArgs->GetCount(), includeHandler.Get(), IID_PPV_ARGS(&operationResult));
+    if (FAILED(result.Result))
+    {
+        result.ErrorMessage = "IDxcCompiler3::Compile failed unexpectedly";
+        return result;
+    }
+
+    // Dependencies are kept even when the compile fails, so that fixing an include can trigger a rebuild
+    result.Shader.Dependencies.insert(result.Shader.Dependencies.end(), includeHandler->Includes.begin(), includeHandler->Includes.end());
+
+    operationResult->GetStatus(&result.Result);
+    if (SUCCEEDED(result.Result))
+    {
+        ComPtr<IDxcBlob> compiledShader;
+        result.Result = operationResult->GetResult(&compiledShader);
+        if (FAILED(result.Result))
+        {
+            result.ErrorMessage = "Failed to get compiled shader data from dxc result";
+            return result;
+        }
+
+        const size_t byteCodeSize = compiledShader->GetBufferSize();
+
+        result.Shader.Bytecode.resize(byteCodeSize);
+        memcpy(result.Shader.Bytecode.data(), compiledShader->GetBufferPointer(), byteCodeSize);
+        result.Shader.Type = params.Type;
+
+        if (useCache)
+            ShaderDiskCache::Get().Store(params.CacheDirectory, params.CacheSizeLimit, cacheKey, params.Type, includeHandler->Includes, result.Shader.Bytecode.data(), byteCodeSize);
+    }
+    else
+    {
+        ComPtr<IDxcBlobEncoding> errorMessages;
+        operationResult->GetErrorBuffer(&errorMessages);
+
+        const char* errMsgStr = errorMessages ? reinterpret_cast<const char*>(errorMessages->GetBufferPointer()) : "";
+        result.ErrorMessage = MakeString("Error compiling shader file \"%s\" - ", params.FilePath);
+        result.ErrorMessage += errMsgStr;
+    }
+
+    return result;
+}
+
+CompiledShader CompileShaderFromFile(CompileShaderParams params)
+{
+    std::string errorMessage;
+    HRESULT hr = ValidateCompileShaderParams(params, errorMessage);
+    if (FAILED(hr))
+    {
+        DXL_ERROR(hr, errorMessage.c_str());
+        return {};
+    }
+
+    ShaderCompilerContext context;
+    hr = CreateShaderCompilerContext(params.PathToDXC, context, errorMessage);
+    if (FAILED(hr))
+    {
+        DXL_ERROR(hr, errorMessage.c_str());
+        return {};
+    }
+
+    while (true)
+    {
+        CompileShaderResult result = CompileShader(params, context);
+        if (SUCCEEDED(result.Result))
+            return std::move(result.Shader);
+
+        bool retry = false;
+        if (params.LoopOnError && params.RetryCallback != nullptr)
+        {
+            retry = params.RetryCallback(result.ErrorMessage.c_str());
+        }
+        else if (params.LoopOnError)
+        {
+            // Pop up a message box allowing user to retry compilation
+            int32_t retVal = MessageBox(nullptr, result.ErrorMessage.c_str(), "Shader Compilation Error", MB_RETRYCANCEL);
+            retry = retVal == IDRETRY;
+        }
+
+        if (retry == false)
+        {
+            DXL_ERROR(result.Result, result.ErrorMessage.c_str());
+            break;
+        }
+    }
+
+    return { };
+}
+
+std::vector<CompileShaderResult> CompileShadersBatch(Span<const CompileShaderParams> params, uint32_t numThreads)
+{
+    std::vector<CompileShaderResult> results(params.Count);
+    if (params.Count == 0)
+        return results;
+
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    numThreads = std::min(numThreads, params.Count);
+
+    std::atomic<uint32_t> nextJobIdx = 0;
+
+    auto compileJobs = [&]()
+    {
+        ShaderCompilerContext context;
+        std::string contextPathToDXC;
+
+        while (true)
+        {
+            const uint32_t jobIdx = nextJobIdx.fetch_add(1);
+            if (jobIdx >= params.Count)
+                break;
+
+            const CompileShaderParams& jobParams = params.Items[jobIdx];
+            CompileShaderResult& result = results[jobIdx];
+
+            result.Result = ValidateCompileShaderParams(jobParams, result.ErrorMessage);
+            if (FAILED(result.Result))
+                continue;
+
+            if (context.Compiler.Get() == nullptr || contextPathToDXC != jobParams.PathToDXC)
+            {
+                context = ShaderCompilerContext();
+                contextPathToDXC = jobParams.PathToDXC;
+                result.Result = CreateShaderCompilerContext(jobParams.PathToDXC, context, result.ErrorMessage);
+                if (FAILED(result.Result))
+                    continue;
+            }
+
+            result = CompileShader(jobParams, context);
+        }
+    };
+
+    // The calling thread works through the batch along with the others
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (uint32_t threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+        threads.emplace_back(compileJobs);
+
+    compileJobs();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return results;
+}
+
+void ClearShaderIncludeCache()
+{
+    IncludeFileCache::Get().Clear();
+}
+
+ShaderDependency GetShaderDependency(const char* filePath)
+{
+    ShaderDependency dependency = { .FilePath = ResolveFilePath(filePath) };
+
+    std::vector<uint8_t> contents;
+    if (ReadFileContents(dependency.FilePath.c_str(), contents))
+        dependency.ContentHash = HashContents(contents.data(), contents.size());
+
+    return dependency;
+}
+
+// == ShaderDependencyGraph =====================================================
+
+class ShaderDependencyGraphState
+{
+
+public:
+
+    struct FileNode
+    {
+        std::vector<uint64_t> Shaders;
+
+        // State of the file as of the last FindStaleShaders call
+        bool Checked = false;
+        bool Exists = false;
+        FileStamp Stamp;
+        DXL_HASH128 ContentHash;
+    };
+
+    mutable std::mutex Mutex;
+    std::unordered_map<uint64_t, std::vector<ShaderDependency>> Shaders;
+    std::unordered_map<std::string, FileNode> Files;
+    uint64_t NumFileChanges = 0;
+
+    // The mutex needs to be locked by the caller for these
+
+    void LinkShader(uint64_t shaderID, const std::vector<ShaderDependency>& dependencies)
+    {
+        for (const ShaderDependency& dependency : dependencies)
+            Files[dependency.FilePath].Shaders.push_back(shaderID);
+    }
+
+    // Only removes the first link for each file, and files are dropped once no shaders use them
+    void UnlinkShader(uint64_t shaderID, const std::vector<ShaderDependency>& dependencies)
+    {
+        for (const ShaderDependency& dependency : dependencies)
+        {
+            auto fileIter = Files.find(dependency.FilePath);
+            if (fileIter == Files.end())
+                continue;
+
+            std::vector<uint64_t>& fileShaders = fileIter->second.Shaders;
+            auto shaderIter = std::find(fileShaders.begin(), fileShaders.end(), shaderID);
+            if (shaderIter != fileShaders.end())
+                fileShaders.erase(shaderIter);
+            if (fileShaders.empty())
+                Files.erase(fileIter);
+        }
+    }
+
+    void RemoveShader(uint64_t shaderID)
+    {
+        auto shaderIter = Shaders.find(shaderID);
+        if (shaderIter == Shaders.end())
+            return;
+
+        UnlinkShader(shaderID, shaderIter->second);
+        Shaders.erase(shaderIter);
+    }
+};
+
+ShaderDependencyGraph::ShaderDependencyGraph() : state(std::make_unique<ShaderDependencyGraphState>())
+{
+}
+
+ShaderDependencyGraph::~ShaderDependencyGraph()
+{
+}
+
+void ShaderDependencyGraph::AddShader(uint64_t shaderID, Span<const ShaderDependency> dependencies)
+{
+    std::vector<ShaderDependency> resolvedDependencies;
+    resolvedDependencies.reserve(dependencies.Count);
+    for (const ShaderDependency& dependency : dependencies)
+    {
+        ShaderDependency resolved = { ResolveFilePath(dependency.FilePath.c_str()), dependency.ContentHash };
+        auto isSameFile = [&](const ShaderDependency& other) { return other.FilePath == resolved.FilePath; };
+        if (std::none_of(resolvedDependencies.begin(), resolvedDependencies.end(), isSameFile))
+            resolvedDependencies.push_back(std::move(resolved));
+    }
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+
+    // The new links go in before the old ones are removed, so files that are still used keep their checked state and
+    // the next change to them still counts in NumFileChanges
+    std::vector<ShaderDependency>& shaderDependencies = state->Shaders[shaderID];
+    state->LinkShader(shaderID, resolvedDependencies);
+    state->UnlinkShader(shaderID, shaderDependencies);
+    shaderDependencies = std::move(resolvedDependencies);
+}
+
+void ShaderDependencyGraph::RemoveShader(uint64_t shaderID)
+{
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->RemoveShader(shaderID);
+}
+
+void ShaderDependencyGraph::Clear()
+{
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->Shaders.clear();
+    state->Files.clear();
+}
+
+uint32_t ShaderDependencyGraph::NumShaders() const
+{
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    return uint32_t(state->Shaders.size());
+}
+
+std::vector<uint64_t> ShaderDependencyGraph::GetDependentShaders(const char* filePath) const
+{
+    const std::string resolvedPath = ResolveFilePath(filePath);
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    auto fileIter = state->Files.find(resolvedPath);
+    if (fileIter == state->Files.end())
+        return { };
+
+    return fileIter->second.Shaders;
+}
+
+std::vector<uint64_t> ShaderDependencyGraph::FindStaleShaders()
+{
+    std::lock_guard<std::mutex> lock(state->Mutex);
+
+    // Files only get hashed the first time they're checked and when their stamp changes, however many shaders use them
+    std::vector<uint8_t> contents;
+    for (auto& [filePath, file] : state->Files)
+    {
+        FileStamp stamp;
+        const bool exists = GetFileStamp(filePath.c_str(), stamp);
+        if (file.Checked && exists == file.Exists && stamp == file.Stamp)
+            continue;
+
+        if (file.Checked)
+            ++state->NumFileChanges;
+
+        file.Checked = true;
+        file.Stamp = stamp;
+        file.Exists = exists && ReadFileContents(filePath.c_str(), contents);
+        if (file.Exists)
+            file.ContentHash = HashContents(contents.data(), contents.size());
+    }
+
+    std::vector<uint64_t> staleShaders;
+    for (const auto& [shaderID, dependencies] : state->Shaders)
+    {
+        for (const ShaderDependency& dependency : dependencies)
+        {
+            const ShaderDependencyGraphState::FileNode& file = state->Files.at(dependency.FilePath);
+            if (file.Exists == false || file.ContentHash != dependency.ContentHash)
+            {
+                staleShaders.push_back(shaderID);
+                break;
+            }
+        }
+    }
+
+    std::sort(staleShaders.begin(), staleShaders.end());
+    return staleShaders;
+}
+
+uint64_t ShaderDependencyGraph::NumFileChanges() const
+{
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    return state->NumFileChanges;
+}
+
+} // namespace Helpers
+
+// == PipelineCompiler =====================================================
+
+enum class PipelineJobStatus : uint32_t
+{
+    Queued = 0,
+    Compiling,
+    Complete,
+    Cancelled,
+};
+
+class PipelineCompileJob
+{
+
+public:
+
+    std::function<IDXLPipelineState()> CompileFunction;
+    std::atomic<PipelineJobStatus> Status = PipelineJobStatus::Queued;
+    IDXLPipelineState PSO;
+    std::atomic<ID3D12PipelineState*> FallbackPSO = nullptr;
+
+    PipelineCompileJob(std::function<IDXLPipelineState()> compileFunction) : CompileFunction(std::move(compileFunction))
+    {
+    }
+
+    ~PipelineCompileJob()
+    {
+        Release(PSO);
+    }
+
+    // Whichever thread gets to move the job out of the Queued state runs it, so a job can be picked up by a worker
+    // or by a thread waiting on it without any extra synchronization
+    bool TryExecute()
+    {
+        PipelineJobStatus expected = PipelineJobStatus::Queued;
+        if (Status.compare_exchange_strong(expected, PipelineJobStatus::Compiling) == false)
+            return false;
+
+        PSO = CompileFunction();
+        Finish(PipelineJobStatus::Complete);
+        return true;
+    }
+
+    void Cancel()
+    {
+        PipelineJobStatus expected = PipelineJobStatus::Queued;
+        if (Status.compare_exchange_strong(expected, PipelineJobStatus::Compiling))
+            Finish(PipelineJobStatus::Cancelled);
+    }
+
+    bool IsComplete() const
+    {
+        return Status.load(std::memory_order_acquire) == PipelineJobStatus::Complete;
+    }
+
+    bool IsCancelled() const
+    {
+        return Status.load(std::memory_order_acquire) == PipelineJobStatus::Cancelled;
+    }
+
+    void WaitForCompletion() const
+    {
+        PipelineJobStatus status = Status.load(std::memory_order_acquire);
+        while (status != PipelineJobStatus::Complete && status != PipelineJobStatus::Cancelled)
+        {
+            Status.wait(status, std::memory_order_acquire);
+            status = Status.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+
+    void Finish(PipelineJobStatus status)
+    {
+        CompileFunction = nullptr;
+        Status.store(status, std::memory_order_release);
+        Status.notify_all();
+    }
+};
+
+class PipelineCompilerState
+{
+
+public:
+
+    IDXLDevice Device;
+    uint32_t MaxQueuedRequests = 0;
+    std::vector<std::thread> Threads;
+
+    std::mutex QueueMutex;
+    std::condition_variable WorkAvailable;
+    std::condition_variable SpaceAvailable;
+    std::deque<std::shared_ptr<PipelineCompileJob>> Queues[uint32_t(PipelinePriority::NumValues)];
+    bool ShuttingDown = false;
+
+    // Callers of Compile() that are waiting for space in the queue, which Shutdown() has to wait for before it can
+    // destroy the state they're waiting on
+    uint32_t NumBlockedCallers = 0;
+    std::condition_variable BlockedCallersLeft;
+
+    size_t NumQueued() const
+    {
+        size_t numQueued = 0;
+        for (const auto& queue : Queues)
+            numQueued += queue.size();
+        return numQueued;
+    }
+
+    void WorkerThread()
+    {
+        while (true)
+        {
+            std::shared_ptr<PipelineCompileJob> job;
+
+            {
+                std::unique_lock<std::mutex> lock(QueueMutex);
+                WorkAvailable.wait(lock, [this]() { return ShuttingDown || NumQueued() > 0; });
+                if (ShuttingDown)
+                    return;
+
+                for (auto& queue : Queues)
+                {
+                    if (queue.empty() == false)
+                    {
+                        job = std::move(queue.front());
+                        queue.pop_front();
+                        break;
+                    }
+                }
+            }
+
+            SpaceAvailable.notify_one();
+
+            // This fails if a waiting thread already compiled the job itself
+            job->TryExecute();
+        }
+    }
+};
+
+bool PipelineRequest::IsValid() const
+{
+    return job != nullptr;
+}
+
+bool PipelineRequest::IsReady() const
+{
+    return job && job->IsComplete();
+}
+
+bool PipelineRequest::IsCancelled() const
+{
+    return job && job->IsCancelled();
+}
+
+IDXLPipelineState PipelineRequest::Wait() const
+{
+    if (job == nullptr)
+        return IDXLPipelineState();
+
+    job->TryExecute();
+    job->WaitForCompletion();
+    return job->PSO;
+}
+
+IDXLPipelineState PipelineRequest::GetPSO() const
+{
+    if (job == nullptr)
+        return IDXLPipelineState();
+
+    if (job->IsComplete() && job->PSO)
+        return job->PSO;
+
+    return job->FallbackPSO.load(std::memory_order_relaxed);
+}
+
+void PipelineRequest::SetFallback(IDXLPipelineState fallbackPSO)
+{
+    if (job)
+        job->FallbackPSO.store(fallbackPSO, std::memory_order_relaxed);
+}
+
+PipelineCompiler::PipelineCompiler() = default;
+
+PipelineCompiler::~PipelineCompiler()
+{
+    Shutdown();
+}
+
+void PipelineCompiler::Initialize(PipelineCompilerParams params)
+{
+    DXL_ASSERT(state == nullptr, "PipelineCompiler is already initialized");
+    DXL_ASSERT(params.Device, "PipelineCompiler needs a valid device");
+    DXL_ASSERT(params.MaxQueuedRequests > 0, "MaxQueuedRequests must be at least 1");
+
+    uint32_t numThreads = params.NumThreads;
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    state = std::make_unique<PipelineCompilerState>();
+    state->Device = params.Device;
+    state->MaxQueuedRequests = params.MaxQueuedRequests;
+    for (uint32_t threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+        state->Threads.emplace_back(&PipelineCompilerState::WorkerThread, state.get());
+}
+
+void PipelineCompiler::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(state->QueueMutex);
+        state->ShuttingDown = true;
+    }
+
+    state->WorkAvailable.notify_all();
+    state->SpaceAvailable.notify_all();
+
+    {
+        std::unique_lock<std::mutex> lock(state->QueueMutex);
+        state->BlockedCallersLeft.wait(lock, [this]() { return state->NumBlockedCallers == 0; });
+    }
+
+    for (std::thread& thread : state->Threads)
+        thread.join();
+
+    // Anything that never got picked up completes without a PSO
+    for (auto& queue : state->Queues)
+    {
+        for (const std::shared_ptr<PipelineCompileJob>& job : queue)
+            job->Cancel();
+    }
+
+    state.reset();
+}
+
+PipelineRequest PipelineCompiler::CompileGraphicsPSO(DXL_SIMPLE_GRAPHICS_PSO_DESC desc, PipelinePriority priority)
+{
+    DXL_ASSERT(state != nullptr, "PipelineCompiler isn't initialized");
+    IDXLDevice device = state->Device;
+    return Compile([device, desc]() mutable { return device.CreateGraphicsPSO(desc); }, priority);
+}
+
+PipelineRequest PipelineCompiler::CompileGraphicsPSO(DXL_MESH_SHADER_GRAPHICS_PSO_DESC desc, PipelinePriority priority)
+{
+    DXL_ASSERT(state != nullptr, "PipelineCompiler isn't initialized");
+    IDXLDevice device = state->Device;
+    return Compile([device, desc]() mutable { return device.CreateGraphicsPSO(desc); }, priority);
+}
+
+PipelineRequest PipelineCompiler::CompileComputePSO(D3D12_COMPUTE_PIPELINE_STATE_DESC desc, PipelinePriority priority)
+{
+    DXL_ASSERT(state != nullptr, "PipelineCompiler isn't initialized");
+    IDXLDevice device = state->Device;
+    return Compile([device, desc]() mutable { return device.CreateComputePSO(desc); }, priority);
+}
+
+PipelineRequest PipelineCompiler::Compile(std::function<IDXLPipelineState()> compileFunction, PipelinePriority priority)
+{
+    DXL_ASSERT(state != nullptr, "PipelineCompiler isn't initialized");
+    DXL_ASSERT(uint32_t(priority) < uint32_t(PipelinePriority::NumValues), "Invalid PipelinePriority %u", uint32_t(priority));
+
+    PipelineRequest request;
+    request.job = std::make_shared<PipelineCompileJob>(std::move(compileFunction));
+
+    std::shared_ptr<PipelineCompileJob> droppedJob;
+
+    {
+        std::unique_lock<std::mutex> lock(state->QueueMutex);
+
+        if (state->NumQueued() >= state->MaxQueuedRequests)
+        {
+            if (priority == PipelinePriority::Prewarm)
+                return PipelineRequest();
+
+            auto& prewarmQueue = state->Queues[uint32_t(PipelinePriority::Prewarm)];
+            if (prewarmQueue.empty() == false)
+            {
+                droppedJob = std::move(prewarmQueue.front());
+                prewarmQueue.pop_front();
+            }
+            else
+            {
+                state->NumBlockedCallers += 1;
+                state->SpaceAvailable.wait(lock, [this]() { return state->ShuttingDown || state->NumQueued() < state->MaxQueuedRequests; });
+                state->NumBlockedCallers -= 1;
+                if (state->ShuttingDown && state->NumBlockedCallers == 0)
+                    state->BlockedCallersLeft.notify_all();
+            }
+        }
+
+        if (state->ShuttingDown == false)
+        {
+            state->Queues[uint32_t(priority)].push_back(request.job);
+            state->WorkAvailable.notify_one();
+        }
+        else
+        {
+            droppedJob = request.job;
+        }
+    }
+
+    // The state may already be gone if Shutdown() was waiting on this call, so only the jobs can be touched here
+    if (droppedJob)
+        droppedJob->Cancel();
+
+    return request;
+}
+
+uint32_t PipelineCompiler::NumQueuedRequests() const
+{
+    if (state == nullptr)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(state->QueueMutex);
+    return uint32_t(state->NumQueued());
+}
+
+// == ShaderHotReloader =====================================================
+
+class ShaderHotReloaderState
+{
+
+public:
+
+    struct Shader
+    {
+        // Copies of everything the original params pointed to, which Params points at instead
+        std::string FilePath;
+        std::string EntryPoint;
+        std::vector<std::string> DefineNames;
+        std::vector<Helpers::PreprocessorDefine> Defines;
+        std::vector<std::string> IncludeDirectoryStrings;
+        std::vector<const char*> IncludeDirectories;
+        Helpers::CompileShaderParams Params;
+
+        std::shared_ptr<const Helpers::CompiledShader> Compiled;
+
+        Shader(const Helpers::CompileShaderParams& params) : FilePath(params.FilePath), EntryPoint(params.EntryPoint), Params(params)
+        {
+            DefineNames.reserve(params.Defines.Count);
+            Defines.reserve(params.Defines.Count);
+            for (const Helpers::PreprocessorDefine& define : params.Defines)
+            {
+                const char* name = DefineNames.emplace_back(define.Name).c_str();
+                Defines.push_back({ .Name = name, .Value = define.Value });
+            }
+
+            IncludeDirectoryStrings.reserve(params.IncludeDirectories.Count);
+            for (const char* includeDir : params.IncludeDirectories)
+                IncludeDirectories.push_back(IncludeDirectoryStrings.emplace_back(includeDir).c_str());
+
+            Params.FilePath = FilePath.c_str();
+            Params.EntryPoint = EntryPoint.c_str();
+            Params.Defines = Span<const Helpers::PreprocessorDefine>(uint32_t(Defines.size()), Defines.data());
+            Params.IncludeDirectories = Span<const char*>(uint32_t(IncludeDirectories.size()), IncludeDirectories.data());
+        }
+    };
+
+    struct Pipeline
+    {
+        std::vector<uint64_t> ShaderIDs;
+        std::function<IDXLPipelineState()> CreateFunction;
+        std::atomic<IDXLPipelineState> PSO;
+    };
+
+    ShaderHotReloaderParams Params;
+
+    // The reload mutex is held while compiling and rebuilding, which keeps shaders and pipelines from being removed
+    // out from under the watcher thread. The other mutex only guards the maps, and is never held across a compile.
+    std::mutex ReloadMutex;
+    mutable std::mutex Mutex;
+    std::unordered_map<uint64_t, std::unique_ptr<Shader>> Shaders;
+    std::unordered_map<uint64_t, std::unique_ptr<Pipeline>> Pipelines;
+    std::vector<IDXLPipelineState> RetiredPSOs;
+    uint64_t NextID = 1;
+
+    Helpers::ShaderDependencyGraph DependencyGraph;
+    uint64_t LastNumFileChanges = 0;
+    uint64_t LastFileChangeTime = 0;
+
+    std::thread WatcherThread;
+    std::mutex WatcherMutex;
+    std::condition_variable WatcherWakeup;
+    bool ShuttingDown = false;
+
+    uint64_t GetTimeMS() const
+    {
+        if (Params.GetTimeMS)
+            return Params.GetTimeMS();
+
+        return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    std::vector<Helpers::CompileShaderResult> CompileShaders(Span<const Helpers::CompileShaderParams> params) const
+    {
+        if (Params.CompileFunction)
+            return Params.CompileFunction(params);
+
+        return Helpers::CompileShadersBatch(params, Params.NumCompileThreads);
+    }
+
+    // Updates the dependencies and bytecode of a shader from a compile, and returns true if it succeeded
+    bool ApplyCompileResult(uint64_t shaderID, Shader& shader, Helpers::CompileShaderResult& result)
+    {
+        // A failed compile still has the dependencies that it got through, so fixing any of them triggers a recompile
+        const std::vector<Helpers::ShaderDependency>& dependencies = result.Shader.Dependencies;
+        if (dependencies.size() > 0)
+        {
+            DependencyGraph.AddShader(shaderID, Span<const Helpers::ShaderDependency>(uint32_t(dependencies.size()), dependencies.data()));
+        }
+
+        const bool succeeded = SUCCEEDED(result.Result);
+        if (succeeded)
+        {
+            std::shared_ptr<const Helpers::CompiledShader> compiled = std::make_shared<const Helpers::CompiledShader>(std::move(result.Shader));
+            std::lock_guard<std::mutex> lock(Mutex);
+            shader.Compiled = std::move(compiled);
+        }
+
+        if (Params.OnShaderCompiled)
+            Params.OnShaderCompiled(shaderID, succeeded ? nullptr : result.ErrorMessage.c_str());
+        else if (succeeded == false)
+            PrintMessage("Shader Compilation Error: %s", result.ErrorMessage.c_str());
+
+        return succeeded;
+    }
+
+    void RetirePSO(IDXLPipelineState pso)
+    {
+        if (pso == nullptr)
+            return;
+
+        if (Params.OnPSORetired)
+        {
+            Params.OnPSORetired(pso);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(Mutex);
+        RetiredPSOs.push_back(pso);
+    }
+
+    uint32_t ProcessChanges()
+    {
+        std::lock_guard<std::mutex> reloadLock(ReloadMutex);
+
+        const std::vector<uint64_t> staleShaderIDs = DependencyGraph.FindStaleShaders();
+
+        const uint64_t currentTime = GetTimeMS();
+        const uint64_t numFileChanges = DependencyGraph.NumFileChanges();
+        if (numFileChanges != LastNumFileChanges)
+        {
+            LastNumFileChanges = numFileChanges;
+            LastFileChangeTime = currentTime;
+        }
+
+        if (staleShaderIDs.empty() || currentTime - LastFileChangeTime < Params.DebounceMS)
+            return 0;
+
+        std::vector<Shader*> staleShaders;
+        std::vector<Helpers::CompileShaderParams> compileParams;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            for (uint64_t shaderID : staleShaderIDs)
+            {
+                Shader* shader = Shaders.at(shaderID).get();
+                staleShaders.push_back(shader);
+                compileParams.push_back(shader->Params);
+            }
+        }
+
+        std::vector<Helpers::CompileShaderResult> results = CompileShaders(Span<const Helpers::CompileShaderParams>(uint32_t(compileParams.size()), compileParams.data()));
+
+        uint32_t numCompiled = 0;
+        std::vector<uint64_t> changedShaderIDs;
+        for (size_t shaderIdx = 0; shaderIdx < staleShaders.size(); ++shaderIdx)
+        {
+            if (ApplyCompileResult(staleShaderIDs[shaderIdx], *staleShaders[shaderIdx], results[shaderIdx]))
+            {
+                changedShaderIDs.push_back(staleShaderIDs[shaderIdx]);
+                ++numCompiled;
+            }
+        }
+
+        if (changedShaderIDs.empty())
+            return 0;
+
+        std::vector<Pipeline*> changedPipelines;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            for (const auto& [pipelineID, pipeline] : Pipelines)
+            {
+                auto usesShader = [&](uint64_t shaderID) { return std::find(changedShaderIDs.begin(), changedShaderIDs.end(), shaderID) != changedShaderIDs.end(); };
+                if (std::any_of(pipeline->ShaderIDs.begin(), pipeline->ShaderIDs.end(), usesShader))
+                    changedPipelines.push_back(pipeline.get());
+            }
+        }
+
+        // The old PSO stays in place if the rebuild fails
+        for (Pipeline* pipeline : changedPipelines)
+        {
+            IDXLPipelineState newPSO = pipeline->CreateFunction();
+            if (newPSO)
+                RetirePSO(pipeline->PSO.exchange(newPSO));
+        }
+
+        return numCompiled;
+    }
+
+    // Returns false if the reloader is shutting down
+    bool WaitForPollInterval()
+    {
+        std::unique_lock<std::mutex> lock(WatcherMutex);
+        return WatcherWakeup.wait_for(lock, std::chrono::milliseconds(Params.PollIntervalMS), [this]() { return ShuttingDown; }) == false;
+    }
+
+    bool IsShuttingDown()
+    {
+        std::lock_guard<std::mutex> lock(WatcherMutex);
+        return ShuttingDown;
+    }
+
+    void WatcherThreadFunction()
+    {
+        while (true)
+        {
+            if (WaitForPollInterval() == false)
+                break;
+
+            ProcessChanges();
+        }
+    }
+};
+
+ShaderHotReloader::ShaderHotReloader() = default;
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+    Shutdown();
+}
+
+void ShaderHotReloader::Initialize(ShaderHotReloaderParams params)
+{
+    DXL_ASSERT(state == nullptr, "ShaderHotReloader is already initialized");
+
+    state = std::make_unique<ShaderHotReloaderState>();
+    state->Params = std::move(params);
+
+    if (state->Params.StartWatcherThread)
+    {
+        state->WatcherThread = std::thread(&ShaderHotReloaderState::WatcherThreadFunction, state.get());
+    }
+}
+
+void ShaderHotReloader::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(state->WatcherMutex);
+        state->ShuttingDown = true;
+    }
+
+    state->WatcherWakeup.notify_all();
+    if (state->WatcherThread.joinable())
+        state->WatcherThread.join();
+
+    for (auto& [pipelineID, pipeline] : state->Pipelines)
+    {
+        IDXLPipelineState pso = pipeline->PSO.load();
+        Release(pso);
+    }
+
+    for (IDXLPipelineState& pso : state->RetiredPSOs)
+        Release(pso);
+
+    state.reset();
+}
+
+uint64_t ShaderHotReloader::AddShader(const Helpers::CompileShaderParams& params)
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+
+    std::unique_ptr<ShaderHotReloaderState::Shader> shader = std::make_unique<ShaderHotReloaderState::Shader>(params);
+    std::vector<Helpers::CompileShaderResult> results = state->CompileShaders(Span<const Helpers::CompileShaderParams>(1, &shader->Params));
+
+    std::lock_guard<std::mutex> reloadLock(state->ReloadMutex);
+
+    ShaderHotReloaderState::Shader* shaderPtr = shader.get();
+    uint64_t shaderID = 0;
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        shaderID = state->NextID++;
+        state->Shaders.emplace(shaderID, std::move(shader));
+    }
+
+    state->ApplyCompileResult(shaderID, *shaderPtr, results[0]);
+
+    return shaderID;
+}
+
+void ShaderHotReloader::RemoveShader(uint64_t shaderID)
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+
+    std::lock_guard<std::mutex> reloadLock(state->ReloadMutex);
+    state->DependencyGraph.RemoveShader(shaderID);
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->Shaders.erase(shaderID);
+}
+
+std::shared_ptr<const Helpers::CompiledShader> ShaderHotReloader::GetShader(uint64_t shaderID) const
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    auto iter = state->Shaders.find(shaderID);
+    if (iter == state->Shaders.end() || iter->second->Compiled == nullptr)
+        return std::make_shared<const Helpers::CompiledShader>();
+
+    return iter->second->Compiled;
+}
+
+uint64_t ShaderHotReloader::AddPipeline(Span<const uint64_t> shaderIDs, std::function<IDXLPipelineState()> createFunction)
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+    DXL_ASSERT(createFunction != nullptr, "AddPipeline needs a valid create function");
+
+    std::unique_ptr<ShaderHotReloaderState::Pipeline> pipeline = std::make_unique<ShaderHotReloaderState::Pipeline>();
+    pipeline->ShaderIDs.assign(shaderIDs.begin(), shaderIDs.end());
+    pipeline->CreateFunction = std::move(createFunction);
+
+    // Holding the reload mutex means a reload can't slip in between creating the PSO and registering it
+    std::lock_guard<std::mutex> reloadLock(state->ReloadMutex);
+    pipeline->PSO.store(pipeline->CreateFunction());
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    const uint64_t pipelineID = state->NextID++;
+    state->Pipelines.emplace(pipelineID, std::move(pipeline));
+
+    return pipelineID;
+}
+
+void ShaderHotReloader::RemovePipeline(uint64_t pipelineID)
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+
+    std::lock_guard<std::mutex> reloadLock(state->ReloadMutex);
+
+    std::unique_ptr<ShaderHotReloaderState::Pipeline> pipeline;
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        auto iter = state->Pipelines.find(pipelineID);
+        if (iter == state->Pipelines.end())
+            return;
+
+        pipeline = std::move(iter->second);
+        state->Pipelines.erase(iter);
+    }
+
+    state->RetirePSO(pipeline->PSO.load());
+}
+
+IDXLPipelineState ShaderHotReloader::GetPipeline(uint64_t pipelineID) const
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    auto iter = state->Pipelines.find(pipelineID);
+    if (iter == state->Pipelines.end())
+        return IDXLPipelineState();
+
+    return iter->second->PSO.load();
+}
+
+uint32_t ShaderHotReloader::ProcessChanges()
+{
+    DXL_ASSERT(state != nullptr, "ShaderHotReloader isn't initialized");
+
+    return state->ProcessChanges();
+}
+
+// == UploadRing =====================================================
+
+// Each thread keeps its current block for the last few rings that it allocated from
+struct UploadRingThreadBlock
+{
+    uint64_t RingID = 0;
+    uint64_t Epoch = 0;
+    uint64_t Offset = 0;
+    uint64_t End = 0;
+};
+
+static const uint32_t NumUploadRingThreadBlocks = 4;
+static thread_local UploadRingThreadBlock UploadRingThreadBlocks[NumUploadRingThreadBlocks];
+static thread_local uint32_t NextUploadRingThreadBlock = 0;
+static std::atomic<uint64_t> NextUploadRingID = 1;
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+class UploadRingState
+{
+
+public:
+
+    struct RetiredRange
+    {
+        uint64_t FenceValue = 0;
+        uint64_t End = 0;
+    };
+
+    UploadRingParams Params;
+    uint64_t ID = 0;
+
+    IDXLResource Resource;
+    std::vector<uint8_t> CPUMemory;
+    uint8_t* CPUBase = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS GPUBase = 0;
+
+    // Bumped by Retire, which makes every thread drop its current block
+    std::atomic<uint64_t> Epoch = 0;
+
+    // Offsets keep increasing as the ring wraps around, and only get wrapped when converting to an address
+    std::mutex Mutex;
+    uint64_t Head = 0;
+    uint64_t Tail = 0;
+    uint64_t RetiredHead = 0;
+    std::deque<RetiredRange> RetiredRanges;
+
+    // The mutex needs to be locked by the caller
+    void ReleaseCompleted(uint64_t completedValue)
+    {
+        while (RetiredRanges.size() > 0 && RetiredRanges.front().FenceValue <= completedValue)
+        {
+            Tail = RetiredRanges.front().End;
+            RetiredRanges.pop_front();
+        }
+    }
+
+    // Reserves a range that doesn't cross the end of the ring, and returns its offset (or UINT64_MAX if it won't fit)
+    uint64_t Reserve(uint64_t size)
+    {
+        if (size > Params.Size)
+            return UINT64_MAX;
+
+        std::unique_lock<std::mutex> lock(Mutex);
+        while (true)
+        {
+            // Ranges that would cross the end of the ring start over at the beginning, and the skipped space gets freed
+            // along with the range
+            const uint64_t ringOffset = Head % Params.Size;
+            const uint64_t padding = ringOffset + size > Params.Size ? Params.Size - ringOffset : 0;
+
+            // An empty ring can skip straight to the beginning, so that anything up to the full size fits
+            if (Head == Tail && padding > 0)
+            {
+                Head += padding;
+                Tail = Head;
+                continue;
+            }
+
+            if (Head + padding + size - Tail <= Params.Size)
+            {
+                const uint64_t offset = Head + padding;
+                Head = offset + size;
+                return offset;
+            }
+
+            // Everything in the ring is from the current frame, so waiting won't help
+            if (RetiredRanges.empty() || Params.Fence == nullptr)
+                return UINT64_MAX;
+
+            const uint64_t oldestFenceValue = RetiredRanges.front().FenceValue;
+            uint64_t completedValue = Params.Fence.GetCompletedValue();
+            if (completedValue < oldestFenceValue)
+            {
+                // Passing a null event makes this block until the fence reaches the value. The lock is dropped while
+                // waiting so that other threads can keep retiring and allocating, which means that everything has to
+                // be checked again afterwards.
+                lock.unlock();
+                DXL_HANDLE_HRESULT(Params.Fence.SetEventOnCompletion(oldestFenceValue, nullptr));
+                lock.lock();
+                completedValue = oldestFenceValue;
+            }
+
+            ReleaseCompleted(completedValue);
+        }
+    }
+
+    UploadRingThreadBlock& GetThreadBlock(uint64_t epoch)
+    {
+        for (UploadRingThreadBlock& block : UploadRingThreadBlocks)
+        {
+            if (block.RingID == ID)
+            {
+                if (block.Epoch != epoch)
+                    block = { .RingID = ID, .Epoch = epoch };
+                return block;
+            }
+        }
+
+        // Whatever was left in the evicted block goes unused until it's retired along with the rest of its frame
+        UploadRingThreadBlock& block = UploadRingThreadBlocks[NextUploadRingThreadBlock++ % NumUploadRingThreadBlocks];
+        block = { .RingID = ID, .Epoch = epoch };
+        return block;
+    }
+};
+
+UploadRing::UploadRing() = default;
+
+UploadRing::~UploadRing()
+{
+    Shutdown();
+}
+
+void UploadRing::Initialize(UploadRingParams params)
+{
+    DXL_ASSERT(state == nullptr, "UploadRing is already initialized");
+
+    // Keeping every block aligned to the max alignment means that only the offsets within a block need aligning
+    params.BlockSize = AlignUp(std::max(params.BlockSize, MaxAlignment), MaxAlignment);
+    params.Size = AlignUp(std::max(params.Size, params.BlockSize), MaxAlignment);
+
+    state = std::make_unique<UploadRingState>();
+    state->Params = params;
+    state->ID = NextUploadRingID.fetch_add(1);
+
+    if (params.Device)
+    {
+        const D3D12_HEAP_PROPERTIES heapProperties = { .Type = D3D12_HEAP_TYPE_UPLOAD };
+        const D3D12_RESOURCE_DESC1 desc =
+        {
+            .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+            .Width = params.Size,
+            .Height = 1,
+            .DepthOrArraySize = 1,
+            .MipLevels = 1,
+            .SampleDesc = { .Count = 1 },
+            .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        };
+        state->Resource = params.Device.CreateCommittedResource(heapProperties, D3D12_HEAP_FLAG_NONE, desc);
+
+        // Upload heaps can stay mapped for the lifetime of the resource, and the empty read range says that the CPU
+        // won't read from it
+        const D3D12_RANGE readRange = { };
+        void* mappedData = nullptr;
+        DXL_HANDLE_HRESULT(state->Resource.Map(0, &readRange, &mappedData));
+        state->CPUBase = reinterpret_cast<uint8_t*>(mappedData);
+        state->GPUBase = state->Resource.GetGPUVirtualAddress();
+    }
+    else
+    {
+        state->CPUMemory.resize(size_t(params.Size + MaxAlignment));
+        state->CPUBase = reinterpret_cast<uint8_t*>(AlignUp(uint64_t(uintptr_t(state->CPUMemory.data())), MaxAlignment));
+        state->GPUBase = uint64_t(uintptr_t(state->CPUBase));
+    }
+}
+
+void UploadRing::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    if (state->Resource)
+    {
+        state->Resource.Unmap(0, nullptr);
+        Release(state->Resource);
+    }
+
+    state.reset();
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    DXL_ASSERT(state != nullptr, "UploadRing isn't initialized");
+    DXL_ASSERT(size > 0, "Upload allocations can't be empty");
+    DXL_ASSERT(std::has_single_bit(alignment) && alignment <= MaxAlignment, "Upload allocation alignment must be a power of 2 that's no larger than %llu", MaxAlignment);
+
+    uint64_t offset = UINT64_MAX;
+    if (size <= state->Params.BlockSize)
+    {
+        UploadRingThreadBlock& block = state->GetThreadBlock(state->Epoch.load(std::memory_order_relaxed));
+        offset = AlignUp(block.Offset, alignment);
+        if (offset + size > block.End)
+        {
+            offset = state->Reserve(state->Params.BlockSize);
+            if (offset == UINT64_MAX)
+                return { };
+
+            block.End = offset + state->Params.BlockSize;
+        }
+
+        block.Offset = offset + size;
+    }
+    else
+    {
+        offset = state->Reserve(AlignUp(size, MaxAlignment));
+        if (offset == UINT64_MAX)
+            return { };
+    }
+
+    const uint64_t ringOffset = offset % state->Params.Size;
+    return
+    {
+        .CPUAddress = state->CPUBase + ringOffset,
+        .GPUAddress = state->GPUBase + ringOffset,
+        .Resource = state->Resource,
+        .Offset = ringOffset,
+        .Size = size,
+    };
+}
+
+void UploadRing::Retire(uint64_t fenceValue)
+{
+    DXL_ASSERT(state != nullptr, "UploadRing isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    if (state->Head != state->RetiredHead)
+    {
+        state->RetiredRanges.push_back({ .FenceValue = fenceValue, .End = state->Head });
+        state->RetiredHead = state->Head;
+    }
+
+    state->Epoch.fetch_add(1);
+}
+
+void UploadRing::ReleaseCompleted(uint64_t completedValue)
+{
+    DXL_ASSERT(state != nullptr, "UploadRing isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->ReleaseCompleted(completedValue);
+}
+
+IDXLResource UploadRing::GetResource() const
+{
+    DXL_ASSERT(state != nullptr, "UploadRing isn't initialized");
+    return state->Resource;
+}
+
+uint64_t UploadRing::GetBytesInUse() const
+{
+    DXL_ASSERT(state != nullptr, "UploadRing isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    return state->Head - state->Tail;
+}
+
+// == OffsetAllocator =====================================================
+
+class OffsetAllocatorState
+{
+
+public:
+
+    static constexpr uint32_t SecondLevelBits = 4;
+    static constexpr uint32_t NumSecondLevels = 1 << SecondLevelBits;
+    static constexpr uint32_t NumFirstLevels = 64 - SecondLevelBits + 1;
+    static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+    struct Node
+    {
+        uint64_t Offset = 0;
+        uint64_t Size = 0;
+        uint32_t PrevPhysical = InvalidNode;
+        uint32_t NextPhysical = InvalidNode;
+        uint32_t PrevFree = InvalidNode;
+        uint32_t NextFree = InvalidNode;
+        bool IsFree = false;
+        bool IsAllocated = false;
+    };
+
+    uint64_t Size = 0;
+    uint64_t Granularity = 1;
+    uint64_t UsedSize = 0;
+    uint32_t NumAllocations = 0;
+
+    std::vector<Node> Nodes;
+    std::vector<uint32_t> UnusedNodes;
+
+    // A set bit in the first level means that at least one second level bin in that row has a free region
+    uint64_t FirstLevelBitmap = 0;
+    uint32_t SecondLevelBitmaps[NumFirstLevels] = { };
+    uint32_t FreeLists[NumFirstLevels][NumSecondLevels] = { };
+
+    static void GetBin(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+    {
+        if (size < NumSecondLevels)
+        {
+            firstLevel = 0;
+            secondLevel = uint32_t(size);
+        }
+        else
+        {
+            const uint32_t log2Size = 63 - uint32_t(std::countl_zero(size));
+            firstLevel = log2Size - SecondLevelBits + 1;
+            secondLevel = uint32_t(size >> (log2Size - SecondLevelBits)) - NumSecondLevels;
+        }
+    }
+
+    // Rounds up to the start of the next bin, so that every region in the returned bin is large enough
+    static void GetSearchBin(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+    {
+        if (size >= NumSecondLevels)
+        {
+            const uint32_t log2Size = 63 - uint32_t(std::countl_zero(size));
+            size += (1ull << (log2Size - SecondLevelBits)) - 1;
+        }
+
+        GetBin(size, firstLevel, secondLevel);
+    }
+
+    uint32_t AllocateNode()
+    {
+        if (UnusedNodes.size() > 0)
+        {
+            const uint32_t nodeIndex = UnusedNodes.back();
+            UnusedNodes.pop_back();
+            Nodes[nodeIndex] = Node();
+            return nodeIndex;
+        }
+
+        Nodes.emplace_back();
+        return uint32_t(Nodes.size() - 1);
+    }
+
+    void InsertFreeNode(uint32_t nodeIndex)
+    {
+        Node& node = Nodes[nodeIndex];
+        uint32_t firstLevel = 0;
+        uint32_t secondLevel = 0;
+        GetBin(node.Size, firstLevel, secondLevel);
+
+        node.IsFree = true;
+        node.PrevFree = InvalidNode;
+        node.NextFree = FreeLists[firstLevel][secondLevel];
+        if (node.NextFree != InvalidNode)
+            Nodes[node.NextFree].PrevFree = nodeIndex;
+
+        FreeLists[firstLevel][secondLevel] = nodeIndex;
+        FirstLevelBitmap |= 1ull << firstLevel;
+        SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    }
+
+    void RemoveFreeNode(uint32_t nodeIndex)
+    {
+        Node& node = Nodes[nodeIndex];
+        uint32_t firstLevel = 0;
+        uint32_t secondLevel = 0;
+        GetBin(node.Size, firstLevel, secondLevel);
+
+        if (node.PrevFree != InvalidNode)
+            Nodes[node.PrevFree].NextFree = node.NextFree;
+        else
+            FreeLists[firstLevel][secondLevel] = node.NextFree;
+
+        if (node.NextFree != InvalidNode)
+            Nodes[node.NextFree].PrevFree = node.PrevFree;
+
+        if (FreeLists[firstLevel][secondLevel] == InvalidNode)
+        {
+            SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+            if (SecondLevelBitmaps[firstLevel] == 0)
+                FirstLevelBitmap &= ~(1ull << firstLevel);
+        }
+
+        node.IsFree = false;
+        node.PrevFree = InvalidNode;
+        node.NextFree = InvalidNode;
+    }
+
+    // Returns the first free region in the lowest non-empty bin at or above the given one
+    uint32_t FindFreeNode(uint32_t firstLevel, uint32_t secondLevel) const
+    {
+        if (firstLevel >= NumFirstLevels)
+            return InvalidNode;
+
+        uint32_t secondLevelMap = secondLevel < NumSecondLevels ? SecondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+        if (secondLevelMap == 0)
+        {
+            const uint64_t firstLevelMap = firstLevel + 1 < 64 ? FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+            if (firstLevelMap == 0)
+                return InvalidNode;
+
+            firstLevel = uint32_t(std::countr_zero(firstLevelMap));
+            secondLevelMap = SecondLevelBitmaps[firstLevel];
+        }
+
+        return FreeLists[firstLevel][uint32_t(std::countr_zero(secondLevelMap))];
+    }
+
+    // Splits the end of a node off into a new free node
+    void SplitFreeTail(uint32_t nodeIndex, uint64_t size)
+    {
+        if (Nodes[nodeIndex].Size == size)
+            return;
+
+        const uint32_t tailIndex = AllocateNode();
+        Node& node = Nodes[nodeIndex];
+        Node& tail = Nodes[tailIndex];
+        tail.Offset = node.Offset + size;
+        tail.Size = node.Size - size;
+        tail.PrevPhysical = nodeIndex;
+        tail.NextPhysical = node.NextPhysical;
+        if (tail.NextPhysical != InvalidNode)
+            Nodes[tail.NextPhysical].PrevPhysical = tailIndex;
+
+        node.Size = size;
+        node.NextPhysical = tailIndex;
+        InsertFreeNode(tailIndex);
+    }
+
+    // Merges a free node with its free neighbors and puts the result back into the free lists
+    void MergeAndInsertFreeNode(uint32_t nodeIndex)
+    {
+        const uint32_t prevIndex = Nodes[nodeIndex].PrevPhysical;
+        if (prevIndex != InvalidNode && Nodes[prevIndex].IsFree)
+        {
+            RemoveFreeNode(prevIndex);
+            Node& prev = Nodes[prevIndex];
+            const Node& node = Nodes[nodeIndex];
+            prev.Size += node.Size;
+            prev.NextPhysical = node.NextPhysical;
+            if (prev.NextPhysical != InvalidNode)
+                Nodes[prev.NextPhysical].PrevPhysical = prevIndex;
+
+            UnusedNodes.push_back(nodeIndex);
+            nodeIndex = prevIndex;
+        }
+
+        const uint32_t nextIndex = Nodes[nodeIndex].NextPhysical;
+        if (nextIndex != InvalidNode && Nodes[nextIndex].IsFree)
+        {
+            RemoveFreeNode(nextIndex);
+            Node& node = Nodes[nodeIndex];
+            const Node& next = Nodes[nextIndex];
+            node.Size += next.Size;
+            node.NextPhysical = next.NextPhysical;
+            if (node.NextPhysical != InvalidNode)
+                Nodes[node.NextPhysical].PrevPhysical = nodeIndex;
+
+            UnusedNodes.push_back(nextIndex);
+        }
+
+        InsertFreeNode(nodeIndex);
+    }
+};
+
+OffsetAllocator::OffsetAllocator() = default;
+
+OffsetAllocator::~OffsetAllocator()
+{
+    Shutdown();
+}
+
+void OffsetAllocator::Initialize(uint64_t size, uint64_t granularity)
+{
+    DXL_ASSERT(state == nullptr, "OffsetAllocator is already initialized");
+    DXL_ASSERT(std::has_single_bit(granularity), "OffsetAllocator granularity must be a power of 2");
+
+    state = std::make_unique<OffsetAllocatorState>();
+    state->Size = size & ~(granularity - 1);
+    state->Granularity = granularity;
+    for (auto& freeLists : state->FreeLists)
+        std::fill(std::begin(freeLists), std::end(freeLists), OffsetAllocatorState::InvalidNode);
+
+    if (state->Size > 0)
+    {
+        const uint32_t nodeIndex = state->AllocateNode();
+        state->Nodes[nodeIndex].Size = state->Size;
+        state->InsertFreeNode(nodeIndex);
+    }
+}
+
+void OffsetAllocator::Shutdown()
+{
+    state.reset();
+}
+
+OffsetAllocation OffsetAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    DXL_ASSERT(state != nullptr, "OffsetAllocator isn't initialized");
+    DXL_ASSERT(std::has_single_bit(alignment), "OffsetAllocator alignment must be a power of 2");
+
+    const uint64_t granularity = state->Granularity;
+    alignment = std::max(alignment, granularity);
+    size = (std::max<uint64_t>(size, 1) + granularity - 1) & ~(granularity - 1);
+    if (size > state->Size)
+        return { };
+
+    // Try the first region that's large enough for the size alone, which usually works out when the alignment
+    // isn't any larger than the granularity. Otherwise look for one that has room for the worst-case padding.
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    OffsetAllocatorState::GetSearchBin(size, firstLevel, secondLevel);
+    uint32_t nodeIndex = state->FindFreeNode(firstLevel, secondLevel);
+    if (nodeIndex != OffsetAllocatorState::InvalidNode)
+    {
+        const OffsetAllocatorState::Node& node = state->Nodes[nodeIndex];
+        const uint64_t padding = ((node.Offset + alignment - 1) & ~(alignment - 1)) - node.Offset;
+        if (padding + size > node.Size)
+            nodeIndex = OffsetAllocatorState::InvalidNode;
+    }
+
+    if (nodeIndex == OffsetAllocatorState::InvalidNode && alignment > granularity)
+    {
+        OffsetAllocatorState::GetSearchBin(size + alignment - granularity, firstLevel, secondLevel);
+        nodeIndex = state->FindFreeNode(firstLevel, secondLevel);
+    }
+
+    if (nodeIndex == OffsetAllocatorState::InvalidNode)
+        return { };
+
+    state->RemoveFreeNode(nodeIndex);
+
+    // Leading padding goes back into the free lists as its own region
+    const uint64_t nodeOffset = state->Nodes[nodeIndex].Offset;
+    const uint64_t padding = ((nodeOffset + alignment - 1) & ~(alignment - 1)) - nodeOffset;
+    if (padding > 0)
+    {
+        state->SplitFreeTail(nodeIndex, padding);
+        const uint32_t alignedIndex = state->Nodes[nodeIndex].NextPhysical;
+        state->RemoveFreeNode(alignedIndex);
+        state->InsertFreeNode(nodeIndex);
+        nodeIndex = alignedIndex;
+    }
+
+    state->SplitFreeTail(nodeIndex, size);
+
+    OffsetAllocatorState::Node& node = state->Nodes[nodeIndex];
+    node.IsAllocated = true;
+    state->UsedSize += size;
+    state->NumAllocations += 1;
+
+    return { .Offset = node.Offset, .Size = size, .NodeIndex = nodeIndex };
+}
+
+void OffsetAllocator::Free(OffsetAllocation allocation)
+{
+    DXL_ASSERT(state != nullptr, "OffsetAllocator isn't initialized");
+    if (allocation.IsValid() == false)
+        return;
+
+    DXL_ASSERT(allocation.NodeIndex < state->Nodes.size() && state->Nodes[allocation.NodeIndex].IsAllocated, "Freeing an invalid OffsetAllocation");
+
+    OffsetAllocatorState::Node& node = state->Nodes[allocation.NodeIndex];
+    node.IsAllocated = false;
+    state->UsedSize -= node.Size;
+    state->NumAllocations -= 1;
+    state->MergeAndInsertFreeNode(allocation.NodeIndex);
+}
+
+OffsetAllocatorStats OffsetAllocator::GetStats() const
+{
+    DXL_ASSERT(state != nullptr, "OffsetAllocator isn't initialized");
+
+    OffsetAllocatorStats stats;
+    stats.Size = state->Size;
+    stats.UsedSize = state->UsedSize;
+    stats.NumAllocations = state->NumAllocations;
+
+    for (uint32_t firstLevel = 0; firstLevel < OffsetAllocatorState::NumFirstLevels; ++firstLevel)
+    {
+        for (uint32_t secondLevel = 0; secondLevel < OffsetAllocatorState::NumSecondLevels; ++secondLevel)
+        {
+            for (uint32_t nodeIndex = state->FreeLists[firstLevel][secondLevel]; nodeIndex != OffsetAllocatorState::InvalidNode; nodeIndex = state->Nodes[nodeIndex].NextFree)
+            {
+                stats.LargestFreeRegion = std::max(stats.LargestFreeRegion, state->Nodes[nodeIndex].Size);
+                stats.NumFreeRegions += 1;
+            }
+        }
+    }
+
+    const uint64_t freeSize = state->Size - state->UsedSize;
+    if (freeSize > 0)
+        stats.Fragmentation = 1.0f - float(double(stats.LargestFreeRegion) / double(freeSize));
+
+    return stats;
+}
+
+// == ResourceAllocator =====================================================
+
+class ResourceAllocatorState
+{
+
+public:
+
+    struct Heap
+    {
+        IDXLHeap NativeHeap;
+        OffsetAllocator Allocator;
+    };
+
+    struct Pool
+    {
+        D3D12_HEAP_TYPE HeapType = D3D12_HEAP_TYPE_DEFAULT;
+        D3D12_HEAP_FLAGS HeapFlags = D3D12_HEAP_FLAG_NONE;
+        uint64_t HeapAlignment = 0;
+
+        // Released heaps leave a null entry behind so that the indices in outstanding allocations stay valid
+        std::vector<std::unique_ptr<Heap>> Heaps;
+    };
+
+    ResourceAllocatorParams Params;
+    D3D12_RESOURCE_HEAP_TIER HeapTier = D3D12_RESOURCE_HEAP_TIER_1;
+
+    mutable std::mutex Mutex;
+    std::vector<Pool> Pools;
+
+    // The mutex needs to be locked by the caller
+    uint32_t GetPoolIndex(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC1& desc)
+    {
+        // Tier 1 can't mix buffers, render targets, and other textures in the same heap
+        D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+        if (HeapTier == D3D12_RESOURCE_HEAP_TIER_1)
+        {
+            if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+                heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+            else
+                heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+        }
+
+        for (uint32_t poolIdx = 0; poolIdx < uint32_t(Pools.size()); ++poolIdx)
+        {
+            if (Pools[poolIdx].HeapType == heapType && Pools[poolIdx].HeapFlags == heapFlags)
+                return poolIdx;
+        }
+
+        // Heaps that can hold textures use the MSAA alignment so that they can also hold MSAA textures
+        Pool& pool = Pools.emplace_back();
+        pool.HeapType = heapType;
+        pool.HeapFlags = heapFlags;
+        pool.HeapAlignment = heapFlags == D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS ? D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+
+        return uint32_t(Pools.size() - 1);
+    }
+
+    // The mutex needs to be locked by the caller
+    uint32_t CreateHeap(Pool& pool)
+    {
+        const D3D12_HEAP_DESC heapDesc =
+        {
+            .SizeInBytes = Params.HeapSize,
+            .Properties = { .Type = pool.HeapType },
+            .Alignment = pool.HeapAlignment,
+
+            // Placed resources always need to be initialized before they're used, so there's no point zeroing the heap
+            .Flags = pool.HeapFlags | D3D12_HEAP_FLAG_CREATE_NOT_ZEROED,
+        };
+
+        std::unique_ptr<Heap> heap = std::make_unique<Heap>();
+        heap->NativeHeap = Params.Device.CreateHeap(heapDesc);
+        if (heap->NativeHeap == nullptr)
+            return UINT32_MAX;
+
+        heap->Allocator.Initialize(Params.HeapSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+
+        for (uint32_t heapIdx = 0; heapIdx < uint32_t(pool.Heaps.size()); ++heapIdx)
+        {
+            if (pool.Heaps[heapIdx] == nullptr)
+            {
+                pool.Heaps[heapIdx] = std::move(heap);
+                return heapIdx;
+            }
+        }
+
+        pool.Heaps.push_back(std::move(heap));
+        return uint32_t(pool.Heaps.size() - 1);
+    }
+};
+
+ResourceAllocator::ResourceAllocator() = default;
+
+ResourceAllocator::~ResourceAllocator()
+{
+    Shutdown();
+}
+
+void ResourceAllocator::Initialize(ResourceAllocatorParams params)
+{
+    DXL_ASSERT(state == nullptr, "ResourceAllocator is already initialized");
+    DXL_ASSERT(params.Device, "ResourceAllocator needs a valid device");
+
+    state = std::make_unique<ResourceAllocatorState>();
+    state->Params = params;
+    state->Params.HeapSize = AlignUp(std::max<uint64_t>(params.HeapSize, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT), D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = { };
+    if (SUCCEEDED(params.Device.CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+        state->HeapTier = options.ResourceHeapTier;
+}
+
+void ResourceAllocator::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    for (ResourceAllocatorState::Pool& pool : state->Pools)
+    {
+        for (std::unique_ptr<ResourceAllocatorState::Heap>& heap : pool.Heaps)
+        {
+            if (heap)
+                Release(heap->NativeHeap);
+        }
+    }
+
+    state.reset();
+}
+
+ResourceAllocation ResourceAllocator::CreateResource(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC1 desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
+{
+    DXL_ASSERT(state != nullptr, "ResourceAllocator isn't initialized");
+
+    IDXLDevice device = state->Params.Device;
+    const uint32_t numCastableFormats = castableFormats.Count;
+    const DXGI_FORMAT* castableFormatList = castableFormats.Items;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device.GetResourceAllocationInfo3(0, 1, &desc, &numCastableFormats, &castableFormatList, nullptr);
+    if (allocationInfo.SizeInBytes == UINT64_MAX)
+    {
+        DXL_ERROR(E_INVALIDARG, "GetResourceAllocationInfo3 failed for the resource desc passed to ResourceAllocator::CreateResource");
+        return { };
+    }
+
+    ResourceAllocation allocation;
+    allocation.Size = allocationInfo.SizeInBytes;
+
+    if (allocationInfo.SizeInBytes >= state->Params.DedicatedThreshold || allocationInfo.SizeInBytes > state->Params.HeapSize)
+    {
+        const D3D12_HEAP_PROPERTIES heapProperties = { .Type = heapType };
+        allocation.Resource = device.CreateCommittedResource(heapProperties, D3D12_HEAP_FLAG_NONE, desc, initialLayout, optimizedClearValue, castableFormats);
+        return allocation;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+
+        allocation.PoolIndex = state->GetPoolIndex(heapType, desc);
+        ResourceAllocatorState::Pool& pool = state->Pools[allocation.PoolIndex];
+        for (uint32_t heapIdx = 0; heapIdx < uint32_t(pool.Heaps.size()); ++heapIdx)
+        {
+            if (pool.Heaps[heapIdx] == nullptr)
+                continue;
+
+            allocation.HeapAllocation = pool.Heaps[heapIdx]->Allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            if (allocation.HeapAllocation.IsValid())
+            {
+                allocation.HeapIndex = heapIdx;
+                break;
+            }
+        }
+
+        if (allocation.HeapAllocation.IsValid() == false)
+        {
+            allocation.HeapIndex = state->CreateHeap(pool);
+            if (allocation.HeapIndex == UINT32_MAX)
+                return { };
+
+            allocation.HeapAllocation = pool.Heaps[allocation.HeapIndex]->Allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            DXL_ASSERT(allocation.HeapAllocation.IsValid(), "Failed to allocate a resource from a new heap");
+        }
+
+        allocation.Heap = pool.Heaps[allocation.HeapIndex]->NativeHeap;
+        allocation.HeapOffset = allocation.HeapAllocation.Offset;
+    }
+
+    // The heap can't be released while this allocation is in it, so the lock doesn't need to be held here
+    allocation.Resource = device.CreatePlacedResource(allocation.Heap, allocation.HeapOffset, desc, initialLayout, optimizedClearValue, castableFormats);
+    if (allocation.Resource == nullptr)
+    {
+        Free(allocation);
+        return { };
+    }
+
+    return allocation;
+}
+
+void ResourceAllocator::Free(ResourceAllocation& allocation)
+{
+    DXL_ASSERT(state != nullptr, "ResourceAllocator isn't initialized");
+
+    Release(allocation.Resource);
+
+    if (allocation.PoolIndex != UINT32_MAX && allocation.HeapAllocation.IsValid())
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+
+        ResourceAllocatorState::Pool& pool = state->Pools[allocation.PoolIndex];
+        std::unique_ptr<ResourceAllocatorState::Heap>& heap = pool.Heaps[allocation.HeapIndex];
+        heap->Allocator.Free(allocation.HeapAllocation);
+
+        // Empty heaps get released, except for the first one in each pool so that it doesn't thrash
+        if (allocation.HeapIndex > 0 && heap->Allocator.GetStats().NumAllocations == 0)
+        {
+            Release(heap->NativeHeap);
+            heap.reset();
+        }
+    }
+
+    allocation = ResourceAllocation();
+}
+
+std::vector<ResourceHeapStats> ResourceAllocator::GetHeapStats() const
+{
+    DXL_ASSERT(state != nullptr, "ResourceAllocator isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+
+    std::vector<ResourceHeapStats> heapStats;
+    for (const ResourceAllocatorState::Pool& pool : state->Pools)
+    {
+        for (const std::unique_ptr<ResourceAllocatorState::Heap>& heap : pool.Heaps)
+        {
+            if (heap)
+                heapStats.push_back({ .HeapType = pool.HeapType, .HeapFlags = pool.HeapFlags, .Stats = heap->Allocator.GetStats() });
+        }
+    }
+
+    return heapStats;
+}
+
+// == BindlessDescriptorHeap =====================================================
+
+class BindlessDescriptorHeapState
+{
+
+public:
+
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    struct RetiredFrame
+    {
+        uint64_t FenceValue = 0;
+        uint64_t TransientEnd = 0;
+        std::vector<uint32_t> FreedIndices;
+    };
+
+    BindlessDescriptorHeapParams Params;
+    IDXLDescriptorHeap Heap;
+    uint64_t CPUStart = 0;
+    uint64_t GPUStart = 0;
+    uint32_t IncrementSize = 0;
+
+    // The free list head packs the first free index with a counter that's bumped on every change, which keeps a
+    // compare-exchange from succeeding if the head was popped and pushed back in the meantime
+    std::atomic<uint64_t> FreeListHead = InvalidIndex;
+    std::unique_ptr<std::atomic<uint32_t>[]> FreeListNext;
+    std::atomic<uint32_t> NumPersistentAllocated = 0;
+
+    // Transient offsets keep increasing as the ring wraps around, and only get wrapped when converting to an index
+    std::atomic<uint64_t> TransientHead = 0;
+    std::atomic<uint64_t> TransientTail = 0;
+
+    std::mutex Mutex;
+    std::vector<uint32_t> PendingFrees;
+    uint64_t RetiredTransientHead = 0;
+    std::deque<RetiredFrame> RetiredFrames;
+
+    static uint64_t PackFreeListHead(uint32_t index, uint64_t oldHead)
+    {
+        return (((oldHead >> 32) + 1) << 32) | index;
+    }
+
+    void PushFreeIndex(uint32_t index)
+    {
+        uint64_t head = FreeListHead.load(std::memory_order_relaxed);
+        do
+        {
+            FreeListNext[index].store(uint32_t(head), std::memory_order_relaxed);
+        }
+        while (FreeListHead.compare_exchange_weak(head, PackFreeListHead(index, head), std::memory_order_release, std::memory_order_relaxed) == false);
+    }
+
+    uint32_t PopFreeIndex()
+    {
+        uint64_t head = FreeListHead.load(std::memory_order_acquire);
+        while (uint32_t(head) != InvalidIndex)
+        {
+            // This can read the link of a descriptor that another thread just popped, but then the exchange fails
+            const uint32_t next = FreeListNext[uint32_t(head)].load(std::memory_order_relaxed);
+            if (FreeListHead.compare_exchange_weak(head, PackFreeListHead(next, head), std::memory_order_acquire, std::memory_order_acquire))
+                return uint32_t(head);
+        }
+
+        return InvalidIndex;
+    }
+
+    // The mutex needs to be locked by the caller
+    void ReleaseCompleted(uint64_t completedValue)
+    {
+        while (RetiredFrames.size() > 0 && RetiredFrames.front().FenceValue <= completedValue)
+        {
+            const RetiredFrame& frame = RetiredFrames.front();
+            for (uint32_t index : frame.FreedIndices)
+                PushFreeIndex(index);
+
+            NumPersistentAllocated.fetch_sub(uint32_t(frame.FreedIndices.size()));
+            TransientTail.store(frame.TransientEnd, std::memory_order_release);
+            RetiredFrames.pop_front();
+        }
+    }
+
+    // Frees whatever the GPU has finished with, optionally waiting for the oldest retired frame. Returns false if
+    // there was nothing to wait for.
+    bool ReclaimRetired(bool waitForOldest)
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+        if (RetiredFrames.empty() || Params.Fence == nullptr)
+            return false;
+
+        const uint64_t oldestFenceValue = RetiredFrames.front().FenceValue;
+        uint64_t completedValue = Params.Fence.GetCompletedValue();
+        if (completedValue < oldestFenceValue && waitForOldest)
+        {
+            // Passing a null event makes this block until the fence reaches the value. The lock is dropped while
+            // waiting so that retiring and freeing on other threads doesn't stall behind the GPU.
+            lock.unlock();
+            DXL_HANDLE_HRESULT(Params.Fence.SetEventOnCompletion(oldestFenceValue, nullptr));
+            lock.lock();
+            completedValue = oldestFenceValue;
+        }
+
+        ReleaseCompleted(completedValue);
+        return true;
+    }
+
+    DescriptorAllocation MakeAllocation(uint32_t index, uint32_t count) const
+    {
+        DescriptorAllocation allocation;
+        allocation.Index = index;
+        allocation.Count = count;
+        allocation.CPUHandle.ptr = SIZE_T(CPUStart + uint64_t(index) * IncrementSize);
+        if (GPUStart != 0)
+            allocation.GPUHandle.ptr = GPUStart + uint64_t(index) * IncrementSize;
+
+        return allocation;
+    }
+};
+
+BindlessDescriptorHeap::BindlessDescriptorHeap() = default;
+
+BindlessDescriptorHeap::~BindlessDescriptorHeap()
+{
+    Shutdown();
+}
+
+void BindlessDescriptorHeap::Initialize(BindlessDescriptorHeapParams params)
+{
+    DXL_ASSERT(state == nullptr, "BindlessDescriptorHeap is already initialized");
+
+    const uint32_t numDescriptors = params.NumPersistentDescriptors + params.NumTransientDescriptors;
+    DXL_ASSERT(numDescriptors > 0, "BindlessDescriptorHeap needs at least one descriptor");
+
+    params.ShaderVisible = params.ShaderVisible && (params.Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || params.Type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+
+    state = std::make_unique<BindlessDescriptorHeapState>();
+    state->Params = params;
+
+    if (params.Device)
+    {
+        state->Heap = params.Device.CreateDescriptorHeap({ .Type = params.Type, .NumDescriptors = numDescriptors, .Flags = params.ShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE });
+        state->CPUStart = state->Heap.GetCPUDescriptorHandleForHeapStart().ptr;
+        if (params.ShaderVisible)
+            state->GPUStart = state->Heap.GetGPUDescriptorHandleForHeapStart().ptr;
+        state->IncrementSize = params.Device.GetDescriptorHandleIncrementSize(params.Type);
+    }
+    else
+    {
+        state->CPUStart = 1ull << 32;
+        state->GPUStart = params.ShaderVisible ? 1ull << 48 : 0;
+        state->IncrementSize = 32;
+    }
+
+    // Descriptors start out linked in order, so that the first allocations are at the start of the heap
+    state->FreeListNext = std::make_unique<std::atomic<uint32_t>[]>(std::max(params.NumPersistentDescriptors, 1u));
+    for (uint32_t index = 0; index < params.NumPersistentDescriptors; ++index)
+        state->FreeListNext[index].store(index + 1 < params.NumPersistentDescriptors ? index + 1 : BindlessDescriptorHeapState::InvalidIndex);
+
+    if (params.NumPersistentDescriptors > 0)
+        state->FreeListHead.store(0);
+}
+
+void BindlessDescriptorHeap::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    Release(state->Heap);
+    state.reset();
+}
+
+DescriptorAllocation BindlessDescriptorHeap::AllocatePersistent()
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+
+    uint32_t index = state->PopFreeIndex();
+    if (index == BindlessDescriptorHeapState::InvalidIndex && state->ReclaimRetired(false))
+        index = state->PopFreeIndex();
+
+    if (index == BindlessDescriptorHeapState::InvalidIndex)
+        return { };
+
+    state->NumPersistentAllocated.fetch_add(1);
+    return state->MakeAllocation(index, 1);
+}
+
+void BindlessDescriptorHeap::FreePersistent(DescriptorAllocation& allocation)
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+    if (allocation.IsValid() == false)
+        return;
+
+    DXL_ASSERT(allocation.Index < state->Params.NumPersistentDescriptors, "Freeing a descriptor that wasn't allocated with AllocatePersistent");
+
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        state->PendingFrees.push_back(allocation.Index);
+    }
+
+    allocation = DescriptorAllocation();
+}
+
+DescriptorAllocation BindlessDescriptorHeap::AllocateTransient(uint32_t count)
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+
+    const uint64_t ringSize = state->Params.NumTransientDescriptors;
+    if (count == 0 || count > ringSize)
+        return { };
+
+    uint64_t head = state->TransientHead.load(std::memory_order_relaxed);
+    while (true)
+    {
+        // Ranges that would cross the end of the ring start over at the beginning, and the skipped descriptors get
+        // freed along with the range
+        const uint64_t ringOffset = head % ringSize;
+        const uint64_t padding = ringOffset + count > ringSize ? ringSize - ringOffset : 0;
+        const uint64_t offset = head + padding;
+        if (offset + count - state->TransientTail.load(std::memory_order_acquire) <= ringSize)
+        {
+            if (state->TransientHead.compare_exchange_weak(head, offset + count, std::memory_order_relaxed))
+                return state->MakeAllocation(state->Params.NumPersistentDescriptors + uint32_t(offset % ringSize), count);
+
+            continue;
+        }
+
+        if (state->ReclaimRetired(true) == false)
+            return { };
+
+        head = state->TransientHead.load(std::memory_order_relaxed);
+    }
+}
+
+void BindlessDescriptorHeap::Retire(uint64_t fenceValue)
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+
+    const uint64_t transientHead = state->TransientHead.load(std::memory_order_relaxed);
+    if (transientHead != state->RetiredTransientHead || state->PendingFrees.size() > 0)
+    {
+        BindlessDescriptorHeapState::RetiredFrame& frame = state->RetiredFrames.emplace_back();
+        frame.FenceValue = fenceValue;
+        frame.TransientEnd = transientHead;
+        frame.FreedIndices.swap(state->PendingFrees);
+        state->RetiredTransientHead = transientHead;
+    }
+
+    // Hand back anything that's already done, so that the free list doesn't have to run dry first
+    if (state->Params.Fence)
+        state->ReleaseCompleted(state->Params.Fence.GetCompletedValue());
+}
+
+void BindlessDescriptorHeap::ReleaseCompleted(uint64_t completedValue)
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->ReleaseCompleted(completedValue);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetCPUHandle(uint32_t index) const
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+    return { .ptr = SIZE_T(state->CPUStart + uint64_t(index) * state->IncrementSize) };
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetGPUHandle(uint32_t index) const
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+    DXL_ASSERT(state->GPUStart != 0, "BindlessDescriptorHeap isn't shader visible");
+    return { .ptr = state->GPUStart + uint64_t(index) * state->IncrementSize };
+}
+
+IDXLDescriptorHeap BindlessDescriptorHeap::GetHeap() const
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+    return state->Heap;
+}
+
+uint32_t BindlessDescriptorHeap::GetNumPersistentAllocated() const
+{
+    DXL_ASSERT(state != nullptr, "BindlessDescriptorHeap isn't initialized");
+    return state->NumPersistentAllocated.load(std::memory_order_relaxed);
+}
+
+// == DescriptorCache =====================================================
+
+// Apart from the buffer views, the members of the view desc unions only contain 32-bit values so they don't have any
+// padding and can be hashed as a whole. Bytes past the end of the active member are undefined, so they're skipped.
+template<typename T> static void HashViewDescMember(HashBuilder& hash, const T& member)
+{
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0 && alignof(T) == alignof(uint32_t));
+    hash.Add(&member, sizeof(member));
+}
+
+static DXL_HASH128 HashViewDesc(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+{
+    HashBuilder hash;
+    hash.AddValue(D3D12_DESCRIPTOR_RANGE_TYPE_SRV);
+    hash.AddValue(resource);
+    hash.AddValue(desc != nullptr);
+    if (desc == nullptr)
+        return hash.Finalize();
+
+    hash.AddValue(desc->Format);
+    hash.AddValue(desc->ViewDimension);
+    hash.AddValue(desc->Shader4ComponentMapping);
+    switch (desc->ViewDimension)
+    {
+        case D3D12_SRV_DIMENSION_BUFFER:
+            hash.AddValue(desc->Buffer.FirstElement);
+            hash.AddValue(desc->Buffer.NumElements);
+            hash.AddValue(desc->Buffer.StructureByteStride);
+            hash.AddValue(desc->Buffer.Flags);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE1D:
+            HashViewDescMember(hash, desc->Texture1D);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE1DARRAY:
+            HashViewDescMember(hash, desc->Texture1DArray);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2D:
+            HashViewDescMember(hash, desc->Texture2D);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2DARRAY:
+            HashViewDescMember(hash, desc->Texture2DArray);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY:
+            HashViewDescMember(hash, desc->Texture2DMSArray);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURE3D:
+            HashViewDescMember(hash, desc->Texture3D);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURECUBE:
+            HashViewDescMember(hash, desc->TextureCube);
+            break;
+        case D3D12_SRV_DIMENSION_TEXTURECUBEARRAY:
+            HashViewDescMember(hash, desc->TextureCubeArray);
+            break;
+        case D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE:
+            hash.AddValue(desc->RaytracingAccelerationStructure.Location);
+            break;
+        default:
+            break;
+    }
+
+    return hash.Finalize();
+}
+
+static DXL_HASH128 HashViewDesc(ID3D12Resource* resource, ID3D12Resource* counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc)
+{
+    HashBuilder hash;
+    hash.AddValue(D3D12_DESCRIPTOR_RANGE_TYPE_UAV);
+    hash.AddValue(resource);
+    hash.AddValue(counterResource);
+    hash.AddValue(desc != nullptr);
+    if (desc == nullptr)
+        return hash.Finalize();
+
+    hash.AddValue(desc->Format);
+    hash.AddValue(desc->ViewDimension);
+    switch (desc->ViewDimension)
+    {
+        case D3D12_UAV_DIMENSION_BUFFER:
+            hash.AddValue(desc->Buffer.FirstElement);
+            hash.AddValue(desc->Buffer.NumElements);
+            hash.AddValue(desc->Buffer.StructureByteStride);
+            hash.AddValue(desc->Buffer.CounterOffsetInBytes);
+            hash.AddValue(desc->Buffer.Flags);
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE1D:
+            HashViewDescMember(hash, desc->Texture1D);
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE1DARRAY:
+            HashViewDescMember(hash, desc->Texture1DArray);
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE2D:
+            HashViewDescMember(hash, desc->Texture2D);
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE2DARRAY:
+            HashViewDescMember(hash, desc->Texture2DArray);
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE2DMSARRAY:
+            HashViewDescMember(hash, desc->Texture2DMSArray);
+            break;
+        case D3D12_UAV_DIMENSION_TEXTURE3D:
+            HashViewDescMember(hash, desc->Texture3D);
+            break;
+        default:
+            break;
+    }
+
+    return hash.Finalize();
+}
+
+static DXL_HASH128 HashViewDesc(ID3D12Resource* resource, const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc)
+{
+    HashBuilder hash;
+    hash.AddValue(D3D12_DESCRIPTOR_RANGE_TYPE_CBV);
+    hash.AddValue(resource);
+    hash.AddValue(desc.BufferLocation);
+    hash.AddValue(desc.SizeInBytes);
+    return hash.Finalize();
+}
+
+static DXL_HASH128 HashSamplerDesc(const D3D12_SAMPLER_DESC2& desc)
+{
+    HashBuilder hash;
+    hash.AddValue(desc.Filter);
+    hash.AddValue(desc.AddressU);
+    hash.AddValue(desc.AddressV);
+    hash.AddValue(desc.AddressW);
+    hash.AddValue(desc.MipLODBias);
+    hash.AddValue(desc.MaxAnisotropy);
+    hash.AddValue(desc.ComparisonFunc);
+    for (uint32_t i = 0; i < 4; ++i)
+        hash.AddValue(desc.UintBorderColor[i]);
+    hash.AddValue(desc.MinLOD);
+    hash.AddValue(desc.MaxLOD);
+    hash.AddValue(desc.Flags);
+    return hash.Finalize();
+}
+
+// {5C3E9A71-2D84-4F6B-A0C9-7E15B3D8462F}, with the last 4 bytes replaced by the ID of the cache so that resources
+// can have views in more than one cache
+static const GUID DescriptorCacheNotifierGUID = { 0x5c3e9a71, 0x2d84, 0x4f6b, { 0xa0, 0xc9, 0x7e, 0x15, 0xb3, 0xd8, 0x46, 0x2f } };
+static std::atomic<uint32_t> NextDescriptorCacheID = 1;
+
+class DescriptorCacheState;
+
+// Shared between a cache and its notifiers, so that notifiers that outlive the cache can tell that it's gone
+struct DescriptorCacheLink
+{
+    std::mutex Mutex;
+    DescriptorCacheState* Cache = nullptr;
+};
+
+// Attached to every resource that has cached views. When the resource is destroyed its private data is released
+// along with it, and the notifier evicts the resource's views before the address can be reused by another resource.
+class DescriptorCacheReleaseNotifier final : public PrivateDataObject
+{
+
+public:
+
+    DescriptorCacheReleaseNotifier(std::shared_ptr<DescriptorCacheLink> link, ID3D12Resource* resource) : Link(std::move(link)), Resource(resource)
+    {
+    }
+
+    ~DescriptorCacheReleaseNotifier() override;
+
+private:
+
+    std::shared_ptr<DescriptorCacheLink> Link;
+    ID3D12Resource* Resource = nullptr;
+};
+
+class DescriptorCacheState
+{
+
+public:
+
+    struct Entry
+    {
+        DescriptorAllocation Descriptor;
+        uint32_t NumRefs = 0;
+        ID3D12Resource* Resource = nullptr;
+        ID3D12Resource* CounterResource = nullptr;
+    };
+
+    struct HashHasher
+    {
+        size_t operator()(const DXL_HASH128& hash) const { return size_t(hash.Lo); }
+    };
+
+    struct Table
+    {
+        BindlessDescriptorHeap* Heap = nullptr;
+        std::unordered_map<DXL_HASH128, Entry, HashHasher> Entries;
+        std::unordered_map<uint32_t, DXL_HASH128> HashesByIndex;
+
+        // Evicted entries that are still referenced, by descriptor index. They can't be found by new lookups, but
+        // keep their descriptor until the last reference is released.
+        std::unordered_map<uint32_t, Entry> Orphans;
+    };
+
+    DescriptorCacheParams Params;
+    mutable std::mutex Mutex;
+    Table Views;
+    Table Samplers;
+    std::unordered_map<ID3D12Resource*, std::vector<DXL_HASH128>> ResourceViews;
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+
+    GUID NotifierGUID = DescriptorCacheNotifierGUID;
+    std::shared_ptr<DescriptorCacheLink> Link;
+    std::unordered_set<ID3D12Resource*> WatchedResources;   // Resources with a notifier attached
+
+    // The mutex needs to be locked by the caller. A resource only ever gets one notifier from this cache, so attaching
+    // it can't release another notifier (which would need the mutex).
+    void WatchResource(ID3D12Resource* resource)
+    {
+        if (resource == nullptr || WatchedResources.find(resource) != WatchedResources.end())
+            return;
+
+        DescriptorCacheReleaseNotifier* notifier = new DescriptorCacheReleaseNotifier(Link, resource);
+        const HRESULT hr = resource->SetPrivateDataInterface(NotifierGUID, notifier);
+        notifier->Release();
+
+        if (SUCCEEDED(hr))
+            WatchedResources.insert(resource);
+        else
+            DXL_ERROR(hr, "Failed to attach the release notifier to a resource in the DescriptorCache");
+    }
+
+    // The mutex needs to be locked by the caller
+    void EvictResource(ID3D12Resource* resource)
+    {
+        auto viewsIter = ResourceViews.find(resource);
+        if (viewsIter == ResourceViews.end())
+            return;
+
+        // RemoveEntry also updates the list for the resource, so work from a copy
+        const std::vector<DXL_HASH128> hashes = std::move(viewsIter->second);
+        ResourceViews.erase(viewsIter);
+        for (const DXL_HASH128& hash : hashes)
+            RemoveEntry(Views, hash);
+    }
+
+    void OnResourceDestroyed(ID3D12Resource* resource)
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        WatchedResources.erase(resource);
+        EvictResource(resource);
+    }
+
+    // Returns the matching descriptor if there is one, otherwise allocates a descriptor and passes it to createDescriptor
+    template<typename TCreateFunc> DescriptorAllocation FindOrCreate(Table& table, const DXL_HASH128& hash, ID3D12Resource* resource, ID3D12Resource* counterResource, TCreateFunc&& createDescriptor)
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+
+        auto iter = table.Entries.find(hash);
+        if (iter != table.Entries.end())
+        {
+            Hits += 1;
+            iter->second.NumRefs += 1;
+            return iter->second.Descriptor;
+        }
+
+        Misses += 1;
+
+        DescriptorAllocation descriptor = table.Heap->AllocatePersistent();
+        if (descriptor.IsValid() == false)
+            return { };
+
+        if (Params.Device)
+            createDescriptor(descriptor.CPUHandle);
+
+        table.Entries.emplace(hash, Entry { .Descriptor = descriptor, .NumRefs = 1, .Resource = resource, .CounterResource = counterResource });
+        table.HashesByIndex.emplace(descriptor.Index, hash);
+
+        if (resource != nullptr)
+            ResourceViews[resource].push_back(hash);
+        if (counterResource != nullptr && counterResource != resource)
+            ResourceViews[counterResource].push_back(hash);
+
+        WatchResource(resource);
+        WatchResource(counterResource);
+
+        return descriptor;
+    }
+
+    // The mutex needs to be locked by the caller. Entries that are still referenced become orphans.
+    void RemoveEntry(Table& table, const DXL_HASH128& hash)
+    {
+        auto iter = table.Entries.find(hash);
+        if (iter == table.Entries.end())
+            return;
+
+        Entry& entry = iter->second;
+        for (ID3D12Resource* resource : { entry.Resource, entry.CounterResource })
+        {
+            auto viewsIter = ResourceViews.find(resource);
+            if (resource == nullptr || viewsIter == ResourceViews.end())
+                continue;
+
+            std::vector<DXL_HASH128>& hashes = viewsIter->second;
+            hashes.erase(std::remove(hashes.begin(), hashes.end(), hash), hashes.end());
+            if (hashes.empty())
+                ResourceViews.erase(viewsIter);
+        }
+
+        table.HashesByIndex.erase(entry.Descriptor.Index);
+        if (entry.NumRefs > 0)
+            table.Orphans.emplace(entry.Descriptor.Index, entry);
+        else
+            table.Heap->FreePersistent(entry.Descriptor);
+        table.Entries.erase(iter);
+    }
+
+    void ReleaseDescriptor(Table& table, DescriptorAllocation& descriptor)
+    {
+        if (descriptor.IsValid() == false)
+            return;
+
+        std::lock_guard<std::mutex> lock(Mutex);
+
+        auto indexIter = table.HashesByIndex.find(descriptor.Index);
+        if (indexIter == table.HashesByIndex.end())
+        {
+            auto orphanIter = table.Orphans.find(descriptor.Index);
+            DXL_ASSERT(orphanIter != table.Orphans.end(), "Releasing a descriptor that isn't in the DescriptorCache");
+
+            Entry& orphan = orphanIter->second;
+            orphan.NumRefs -= 1;
+            if (orphan.NumRefs == 0)
+            {
+                table.Heap->FreePersistent(orphan.Descriptor);
+                table.Orphans.erase(orphanIter);
+            }
+
+            descriptor = DescriptorAllocation();
+            return;
+        }
+
+        const DXL_HASH128 hash = indexIter->second;
+        Entry& entry = table.Entries.at(hash);
+        entry.NumRefs -= 1;
+        if (entry.NumRefs == 0)
+            RemoveEntry(table, hash);
+
+        descriptor = DescriptorAllocation();
+    }
+
+    void Clear(Table& table)
+    {
+        for (auto& [hash, entry] : table.Entries)
+            table.Heap->FreePersistent(entry.Descriptor);
+        for (auto& [index, orphan] : table.Orphans)
+            table.Heap->FreePersistent(orphan.Descriptor);
+
+        table.Entries.clear();
+        table.HashesByIndex.clear();
+        table.Orphans.clear();
+    }
+};
+
+DescriptorCacheReleaseNotifier::~DescriptorCacheReleaseNotifier()
+{
+    std::lock_guard<std::mutex> lock(Link->Mutex);
+    if (Link->Cache != nullptr)
+        Link->Cache->OnResourceDestroyed(Resource);
+}
+
+DescriptorCache::DescriptorCache() = default;
+
+DescriptorCache::~DescriptorCache()
+{
+    Shutdown();
+}
+
+void DescriptorCache::Initialize(DescriptorCacheParams params)
+{
+    DXL_ASSERT(state == nullptr, "DescriptorCache is already initialized");
+    DXL_ASSERT(params.ResourceHeap != nullptr || params.SamplerHeap != nullptr, "DescriptorCache needs at least one descriptor heap");
+
+    state = std::make_unique<DescriptorCacheState>();
+    state->Params = params;
+    state->Views.Heap = params.ResourceHeap;
+    state->Samplers.Heap = params.SamplerHeap;
+
+    const uint32_t cacheID = NextDescriptorCacheID.fetch_add(1);
+    memcpy(&state->NotifierGUID.Data4[4], &cacheID, sizeof(cacheID));
+
+    state->Link = std::make_shared<DescriptorCacheLink>();
+    state->Link->Cache = state.get();
+}
+
+void DescriptorCache::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    // Notifiers that are still attached to resources stay there until the resource is destroyed, but stop doing
+    // anything once they're unlinked. This can wait on a notifier that's currently evicting.
+    {
+        std::lock_guard<std::mutex> lock(state->Link->Mutex);
+        state->Link->Cache = nullptr;
+    }
+
+    // The heaps need to outlive the cache, since the descriptors get freed back to them here
+    state->Clear(state->Views);
+    state->Clear(state->Samplers);
+    state.reset();
+}
+
+DescriptorAllocation DescriptorCache::CreateShaderResourceView(IDXLResource resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    DXL_ASSERT(state->Views.Heap != nullptr, "DescriptorCache doesn't have a resource heap");
+
+    const DXL_HASH128 hash = HashViewDesc(resource.ToNative(), desc);
+    return state->FindOrCreate(state->Views, hash, resource.ToNative(), nullptr, [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+    {
+        state->Params.Device.CreateShaderResourceView(resource, desc, handle);
+    });
+}
+
+DescriptorAllocation DescriptorCache::CreateUnorderedAccessView(IDXLResource resource, IDXLResource counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    DXL_ASSERT(state->Views.Heap != nullptr, "DescriptorCache doesn't have a resource heap");
+
+    const DXL_HASH128 hash = HashViewDesc(resource.ToNative(), counterResource.ToNative(), desc);
+    return state->FindOrCreate(state->Views, hash, resource.ToNative(), counterResource.ToNative(), [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+    {
+        state->Params.Device.CreateUnorderedAccessView(resource, counterResource, desc, handle);
+    });
+}
+
+DescriptorAllocation DescriptorCache::CreateConstantBufferView(IDXLResource resource, const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    DXL_ASSERT(state->Views.Heap != nullptr, "DescriptorCache doesn't have a resource heap");
+
+    const DXL_HASH128 hash = HashViewDesc(resource.ToNative(), desc);
+    return state->FindOrCreate(state->Views, hash, resource.ToNative(), nullptr, [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+    {
+        state->Params.Device.CreateConstantBufferView(&desc, handle);
+    });
+}
+
+DescriptorAllocation DescriptorCache::CreateSampler(const D3D12_SAMPLER_DESC2& desc)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    DXL_ASSERT(state->Samplers.Heap != nullptr, "DescriptorCache doesn't have a sampler heap");
+
+    const DXL_HASH128 hash = HashSamplerDesc(desc);
+    return state->FindOrCreate(state->Samplers, hash, nullptr, nullptr, [&](D3D12_CPU_DESCRIPTOR_HANDLE handle)
+    {
+        state->Params.Device.CreateSampler2(&desc, handle);
+    });
+}
+
+void DescriptorCache::ReleaseView(DescriptorAllocation& descriptor)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    state->ReleaseDescriptor(state->Views, descriptor);
+}
+
+void DescriptorCache::ReleaseSampler(DescriptorAllocation& descriptor)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    state->ReleaseDescriptor(state->Samplers, descriptor);
+}
+
+void DescriptorCache::EvictResource(IDXLResource resource)
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+    if (resource == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->EvictResource(resource.ToNative());
+}
+
+DescriptorCacheStats DescriptorCache::GetStats() const
+{
+    DXL_ASSERT(state != nullptr, "DescriptorCache isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    return
+    {
+        .NumViews = uint32_t(state->Views.Entries.size()),
+        .NumSamplers = uint32_t(state->Samplers.Entries.size()),
+        .NumEvictedViews = uint32_t(state->Views.Orphans.size()),
+        .Hits = state->Hits,
+        .Misses = state->Misses,
+    };
+}
+
+// == CommandListPool =====================================================
+
+class CommandListPoolState
+{
+
+public:
+
+    static constexpr uint32_t NumTypes = D3D12_COMMAND_LIST_TYPE_VIDEO_ENCODE + 1;
+
+    struct Allocator
+    {
+        IDXLCommandAllocator Allocator;
+        uint64_t FenceValue = 0;
+        uint64_t HighWaterMark = 0;         // Allocators keep the memory for the most they've ever recorded
+    };
+
+    struct TypePool
+    {
+        mutable std::mutex Mutex;
+        std::vector<Allocator> Allocators;
+        std::vector<uint32_t> FreeAllocators;
+        std::vector<uint32_t> InFlightAllocators;
+        std::vector<IDXLCommandList> FreeCommandLists;
+        uint32_t NumCommandLists = 0;
+        uint64_t NumTrimmed = 0;
+        uint64_t HighWaterMark = 0;
+        double AverageCommands = 0.0;
+    };
+
+    CommandListPoolParams Params;
+    TypePool Pools[NumTypes];
+
+    TypePool& GetPool(D3D12_COMMAND_LIST_TYPE type)
+    {
+        DXL_ASSERT(uint32_t(type) < NumTypes, "Invalid command list type %d", int(type));
+        return Pools[uint32_t(type)];
+    }
+
+    // The pool's mutex needs to be locked by the caller
+    void ReleaseCompleted(TypePool& pool, uint64_t completedValue)
+    {
+        for (uint64_t i = 0; i < pool.InFlightAllocators.size(); )
+        {
+            const uint32_t allocatorIndex = pool.InFlightAllocators[i];
+            Allocator& allocator = pool.Allocators[allocatorIndex];
+            if (allocator.FenceValue > completedValue)
+            {
+                ++i;
+                continue;
+            }
+
+            // Allocators never give back memory when they're reset, so the only way to shrink one that recorded an
+            // unusually large amount of work is to replace it
+            const double trimThreshold = std::max(pool.AverageCommands * Params.TrimRatio, double(Params.MinTrimCommands));
+            if (double(allocator.HighWaterMark) > trimThreshold)
+            {
+                Release(allocator.Allocator);
+                allocator.HighWaterMark = 0;
+                pool.NumTrimmed += 1;
+            }
+            else if (allocator.Allocator)
+            {
+                DXL_HANDLE_HRESULT(allocator.Allocator.Reset());
+            }
+
+            pool.FreeAllocators.push_back(allocatorIndex);
+            pool.InFlightAllocators[i] = pool.InFlightAllocators.back();
+            pool.InFlightAllocators.pop_back();
+        }
+    }
+};
+
+CommandListPool::CommandListPool() = default;
+
+CommandListPool::~CommandListPool()
+{
+    Shutdown();
+}
+
+void CommandListPool::Initialize(CommandListPoolParams params)
+{
+    DXL_ASSERT(state == nullptr, "CommandListPool is already initialized");
+    DXL_ASSERT(params.TrimRatio >= 1.0f, "CommandListPool trim ratio must be at least 1");
+
+    state = std::make_unique<CommandListPoolState>();
+    state->Params = params;
+}
+
+void CommandListPool::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    // Allocators can't be released while the GPU is still executing their commands
+    if (state->Params.Fence)
+    {
+        for (CommandListPoolState::TypePool& pool : state->Pools)
+        {
+            for (uint32_t allocatorIndex : pool.InFlightAllocators)
+                DXL_HANDLE_HRESULT(state->Params.Fence.SetEventOnCompletion(pool.Allocators[allocatorIndex].FenceValue, nullptr));
+        }
+    }
+
+    for (CommandListPoolState::TypePool& pool : state->Pools)
+    {
+        for (CommandListPoolState::Allocator& allocator : pool.Allocators)
+            Release(allocator.Allocator);
+        for (IDXLCommandList& commandList : pool.FreeCommandLists)
+            Release(commandList);
+    }
+
+    state.reset();
+}
+
+PooledCommandList CommandListPool::Acquire(D3D12_COMMAND_LIST_TYPE type)
+{
+    DXL_ASSERT(state != nullptr, "CommandListPool isn't initialized");
+
+    CommandListPoolState::TypePool& pool = state->GetPool(type);
+    IDXLDevice device = state->Params.Device;
+
+    PooledCommandList commandList;
+    commandList.Type = type;
+
+    {
+        std::lock_guard<std::mutex> lock(pool.Mutex);
+
+        if (pool.FreeAllocators.empty() && pool.InFlightAllocators.size() > 0 && state->Params.Fence)
+            state->ReleaseCompleted(pool, state->Params.Fence.GetCompletedValue());
+
+        if (pool.FreeAllocators.size() > 0)
+        {
+            commandList.AllocatorIndex = pool.FreeAllocators.back();
+            pool.FreeAllocators.pop_back();
+        }
+        else
+        {
+            commandList.AllocatorIndex = uint32_t(pool.Allocators.size());
+            pool.Allocators.emplace_back();
+        }
+
+        // Allocators that were trimmed get recreated here, along with new ones
+        CommandListPoolState::Allocator& allocator = pool.Allocators[commandList.AllocatorIndex];
+        if (allocator.Allocator == nullptr && device)
+            allocator.Allocator = device.CreateCommandAllocator(type);
+        commandList.Allocator = allocator.Allocator;
+
+        if (pool.FreeCommandLists.size() > 0)
+        {
+            commandList.CommandList = pool.FreeCommandLists.back();
+            pool.FreeCommandLists.pop_back();
+        }
+        else
+        {
+            pool.NumCommandLists += 1;
+        }
+    }
+
+    // Command lists are created closed, so they get reset the same way whether they're new or recycled
+    if (device)
+    {
+        if (commandList.CommandList == nullptr)
+            commandList.CommandList = device.CreateCommandList(type, D3D12_COMMAND_LIST_FLAG_NONE, state->Params.Features);
+        DXL_HANDLE_HRESULT(commandList.CommandList.Reset(commandList.Allocator, IDXLPipelineState()));
+    }
+
+    return commandList;
+}
+
+void CommandListPool::Submit(PooledCommandList& commandList, uint64_t fenceValue, uint64_t numCommands)
+{
+    DXL_ASSERT(state != nullptr, "CommandListPool isn't initialized");
+    if (commandList.IsValid() == false)
+        return;
+
+    CommandListPoolState::TypePool& pool = state->GetPool(commandList.Type);
+
+    // A list that was never executed is still open, and Acquire can only reset it (and its allocator can only be
+    // reset) once it's closed
+    if (fenceValue == 0 && commandList.CommandList)
+        DXL_HANDLE_HRESULT(commandList.CommandList.Close());
+
+    {
+        std::lock_guard<std::mutex> lock(pool.Mutex);
+
+        CommandListPoolState::Allocator& allocator = pool.Allocators[commandList.AllocatorIndex];
+        allocator.FenceValue = fenceValue;
+        allocator.HighWaterMark = std::max(allocator.HighWaterMark, numCommands);
+        pool.InFlightAllocators.push_back(commandList.AllocatorIndex);
+
+        if (numCommands > 0)
+        {
+            pool.AverageCommands = pool.AverageCommands > 0.0 ? pool.AverageCommands * 0.9 + double(numCommands) * 0.1 : double(numCommands);
+            pool.HighWaterMark = std::max(pool.HighWaterMark, numCommands);
+        }
+
+        if (commandList.CommandList)
+            pool.FreeCommandLists.push_back(commandList.CommandList);
+    }
+
+    commandList = PooledCommandList();
+}
+
+void CommandListPool::ReleaseCompleted(uint64_t completedValue)
+{
+    DXL_ASSERT(state != nullptr, "CommandListPool isn't initialized");
+
+    for (CommandListPoolState::TypePool& pool : state->Pools)
+    {
+        std::lock_guard<std::mutex> lock(pool.Mutex);
+        state->ReleaseCompleted(pool, completedValue);
+    }
+}
+
+CommandListPoolStats CommandListPool::GetStats(D3D12_COMMAND_LIST_TYPE type) const
+{
+    DXL_ASSERT(state != nullptr, "CommandListPool isn't initialized");
+
+    const CommandListPoolState::TypePool& pool = state->GetPool(type);
+    std::lock_guard<std::mutex> lock(pool.Mutex);
+    return
+    {
+        .NumAllocators = uint32_t(pool.Allocators.size()),
+        .NumAllocatorsInFlight = uint32_t(pool.InFlightAllocators.size()),
+        .NumCommandLists = pool.NumCommandLists,
+        .NumTrimmed = pool.NumTrimmed,
+        .HighWaterMark = pool.HighWaterMark,
+    };
+}
+
+// == ParallelCommandRecorder =====================================================
+
+struct TrackedResourceState
+{
+    D3D12_BARRIER_SYNC Sync = D3D12_BARRIER_SYNC_NONE;
+    D3D12_BARRIER_ACCESS Access = D3D12_BARRIER_ACCESS_NO_ACCESS;
+    D3D12_BARRIER_LAYOUT Layout = D3D12_BARRIER_LAYOUT_UNDEFINED;
+    bool IsTexture = false;
+};
+
+static const D3D12_BARRIER_ACCESS WriteBarrierAccessMask = D3D12_BARRIER_ACCESS_RENDER_TARGET | D3D12_BARRIER_ACCESS_UNORDERED_ACCESS |
+                                                           D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE | D3D12_BARRIER_ACCESS_STREAM_OUTPUT |
+                                                           D3D12_BARRIER_ACCESS_COPY_DEST | D3D12_BARRIER_ACCESS_RESOLVE_DEST |
+                                                           D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE |
+                                                           D3D12_BARRIER_ACCESS_VIDEO_DECODE_WRITE | D3D12_BARRIER_ACCESS_VIDEO_PROCESS_WRITE |
+                                                           D3D12_BARRIER_ACCESS_VIDEO_ENCODE_WRITE;
+
+static bool IsReadOnlyAccess(D3D12_BARRIER_ACCESS access)
+{
+    // D3D12_BARRIER_ACCESS_COMMON allows any access, writes included
+    return access != D3D12_BARRIER_ACCESS_COMMON && access != D3D12_BARRIER_ACCESS_NO_ACCESS && (access & WriteBarrierAccessMask) == 0;
+}
+
+// Consecutive reads in the same layout don't need anything between them
+static bool NeedsBarrier(const TrackedResourceState& before, const TrackedResourceState& after)
+{
+    return before.Layout != after.Layout || before.Access != after.Access || IsReadOnlyAccess(after.Access) == false;
+}
+
+static D3D12_TEXTURE_BARRIER MakeTextureBarrier(ID3D12Resource* resource, const TrackedResourceState& before, const TrackedResourceState& after)
+{
+    return
+    {
+        .SyncBefore = before.Sync,
+        .SyncAfter = after.Sync,
+        .AccessBefore = before.Access,
+        .AccessAfter = after.Access,
+        .LayoutBefore = before.Layout,
+        .LayoutAfter = after.Layout,
+        .pResource = resource,
+        .Subresources = { .IndexOrFirstMipLevel = UINT32_MAX },
+        .Flags = D3D12_TEXTURE_BARRIER_FLAG_NONE,
+    };
+}
+
+static D3D12_BUFFER_BARRIER MakeBufferBarrier(ID3D12Resource* resource, const TrackedResourceState& before, const TrackedResourceState& after)
+{
+    return
+    {
+        .SyncBefore = before.Sync,
+        .SyncAfter = after.Sync,
+        .AccessBefore = before.Access,
+        .AccessAfter = after.Access,
+        .pResource = resource,
+        .Offset = 0,
+        .Size = UINT64_MAX,
+    };
+}
+
+class CommandSegmentState
+{
+
+public:
+
+    struct ResourceUse
+    {
+        ID3D12Resource* Resource = nullptr;
+        TrackedResourceState First;
+        TrackedResourceState Last;
+    };
+
+    PooledCommandList CommandList;
+    uint64_t NumCommands = 0;
+    std::vector<ResourceUse> Uses;
+    std::unordered_map<ID3D12Resource*, uint32_t> UseIndices;
+
+    void Transition(IDXLCommandList commandList, ID3D12Resource* resource, const TrackedResourceState& after)
+    {
+        DXL_ASSERT(resource != nullptr, "Transitioning a null resource");
+
+        auto [iter, inserted] = UseIndices.emplace(resource, uint32_t(Uses.size()));
+        if (inserted)
+        {
+            Uses.push_back({ .Resource = resource, .First = after, .Last = after });
+            return;
+        }
+
+        ResourceUse& use = Uses[iter->second];
+        DXL_ASSERT(use.Last.IsTexture == after.IsTexture, "Resource was transitioned as both a buffer and a texture");
+        if (commandList)
+        {
+            if (after.IsTexture)
+                commandList.Barrier(MakeTextureBarrier(resource, use.Last, after));
+            else
+                commandList.Barrier(MakeBufferBarrier(resource, use.Last, after));
+        }
+
+        use.Last = after;
+    }
+
+    void Reset()
+    {
+        CommandList = PooledCommandList();
+        NumCommands = 0;
+        Uses.clear();
+        UseIndices.clear();
+    }
+};
+
+void CommandSegment::TextureBarrier(IDXLResource texture, D3D12_BARRIER_SYNC syncAfter, D3D12_BARRIER_ACCESS accessAfter, D3D12_BARRIER_LAYOUT layoutAfter)
+{
+    DXL_ASSERT(state != nullptr, "CommandSegment isn't being recorded");
+    state->Transition(CommandList, texture.ToNative(), { .Sync = syncAfter, .Access = accessAfter, .Layout = layoutAfter, .IsTexture = true });
+}
+
+void CommandSegment::BufferBarrier(IDXLResource buffer, D3D12_BARRIER_SYNC syncAfter, D3D12_BARRIER_ACCESS accessAfter)
+{
+    DXL_ASSERT(state != nullptr, "CommandSegment isn't being recorded");
+    state->Transition(CommandList, buffer.ToNative(), { .Sync = syncAfter, .Access = accessAfter, .Layout = D3D12_BARRIER_LAYOUT_UNDEFINED, .IsTexture = false });
+}
+
+class ParallelCommandRecorderState
+{
+
+public:
+
+    ParallelCommandRecorderParams Params;
+    std::vector<std::thread> Threads;
+
+    std::mutex Mutex;
+    std::condition_variable WorkAvailable;
+    std::condition_variable WorkDone;
+    uint64_t FrameIndex = 0;
+    uint32_t NumActiveWorkers = 0;
+    uint32_t NumSegmentsDone = 0;
+    bool ShuttingDown = false;
+
+    // Only written with the mutex locked while no workers are active, and only read by workers that became active
+    // during the current frame
+    Span<const RecordSegmentFunction> Segments;
+    std::vector<std::unique_ptr<CommandSegmentState>> SegmentStates;
+    std::atomic<uint32_t> NextSegment = 0;
+
+    // Resource states as of the end of the last submitted segment. Only accessed by the thread submitting.
+    std::unordered_map<ID3D12Resource*, TrackedResourceState> ResourceStates;
+    std::vector<RecordedCommandList> RecordedLists;
+    std::vector<PooledCommandList> FixupLists;
+    std::vector<ID3D12CommandList*> NativeLists;
+    std::vector<D3D12_TEXTURE_BARRIER> FixupTextureBarriers;
+    std::vector<D3D12_BUFFER_BARRIER> FixupBufferBarriers;
+
+    void RecordSegment(uint32_t segmentIdx)
+    {
+        CommandSegmentState& segmentState = *SegmentStates[segmentIdx];
+        segmentState.CommandList = Params.Pool->Acquire(Params.Type);
+
+        CommandSegment segment;
+        segment.CommandList = segmentState.CommandList.CommandList;
+        segment.SegmentIndex = segmentIdx;
+        segment.state = &segmentState;
+
+        Segments.Items[segmentIdx](segment);
+
+        if (segment.CommandList)
+            DXL_HANDLE_HRESULT(segment.CommandList.Close());
+
+        segmentState.NumCommands = segment.NumCommands;
+    }
+
+    // Grabs segments until there are none left, returns the number that were recorded
+    uint32_t RecordSegments()
+    {
+        uint32_t numRecorded = 0;
+        for (uint32_t segmentIdx = NextSegment.fetch_add(1); segmentIdx < Segments.Count; segmentIdx = NextSegment.fetch_add(1))
+        {
+            RecordSegment(segmentIdx);
+            numRecorded += 1;
+        }
+
+        return numRecorded;
+    }
+
+    void WorkerThread()
+    {
+        uint64_t lastFrameIndex = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                WorkAvailable.wait(lock, [&]() { return ShuttingDown || FrameIndex != lastFrameIndex; });
+                if (ShuttingDown)
+                    return;
+
+                // A worker that wakes up after the frame was already finished by the other threads sits it out, since
+                // the next frame can't start until it's inactive again
+                lastFrameIndex = FrameIndex;
+                if (Segments.Count == 0)
+                    continue;
+
+                NumActiveWorkers += 1;
+            }
+
+            const uint32_t numRecorded = RecordSegments();
+
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                DXL_ASSERT(FrameIndex == lastFrameIndex, "A ParallelCommandRecorder frame started while a worker was still recording the previous one");
+                NumActiveWorkers -= 1;
+                NumSegmentsDone += numRecorded;
+            }
+
+            // Both the end of the frame and the start of the next one wait on this
+            WorkDone.notify_all();
+        }
+    }
+
+    // Appends a command list with the barriers needed to get each resource from the state the previous segments left it
+    // in to the state the segment expects, then updates the tracked states with the segment's last uses
+    void AddFixupBarriers(const CommandSegmentState& segmentState)
+    {
+        FixupTextureBarriers.clear();
+        FixupBufferBarriers.clear();
+
+        for (const CommandSegmentState::ResourceUse& use : segmentState.Uses)
+        {
+            auto [iter, inserted] = ResourceStates.emplace(use.Resource, use.Last);
+            if (inserted)
+                continue;
+
+            if (NeedsBarrier(iter->second, use.First))
+            {
+                if (use.First.IsTexture)
+                    FixupTextureBarriers.push_back(MakeTextureBarrier(use.Resource, iter->second, use.First));
+                else
+                    FixupBufferBarriers.push_back(MakeBufferBarrier(use.Resource, iter->second, use.First));
+            }
+
+            iter->second = use.Last;
+        }
+
+        const uint32_t numBarriers = uint32_t(FixupTextureBarriers.size() + FixupBufferBarriers.size());
+        if (numBarriers == 0)
+            return;
+
+        PooledCommandList fixupList = Params.Pool->Acquire(Params.Type);
+        if (fixupList.CommandList)
+        {
+            D3D12_BARRIER_GROUP groups[2] = { };
+            uint32_t numGroups = 0;
+            if (FixupBufferBarriers.size() > 0)
+                groups[numGroups++] = { .Type = D3D12_BARRIER_TYPE_BUFFER, .NumBarriers = uint32_t(FixupBufferBarriers.size()), .pBufferBarriers = FixupBufferBarriers.data() };
+            if (FixupTextureBarriers.size() > 0)
+                groups[numGroups++] = { .Type = D3D12_BARRIER_TYPE_TEXTURE, .NumBarriers = uint32_t(FixupTextureBarriers.size()), .pTextureBarriers = FixupTextureBarriers.data() };
+
+            fixupList.CommandList.Barrier(numGroups, groups);
+            DXL_HANDLE_HRESULT(fixupList.CommandList.Close());
+        }
+
+        RecordedLists.push_back({ .CommandList = fixupList.CommandList, .SegmentIndex = UINT32_MAX, .NumBarriers = numBarriers });
+        FixupLists.push_back(fixupList);
+    }
+};
+
+ParallelCommandRecorder::ParallelCommandRecorder() = default;
+
+ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+    Shutdown();
+}
+
+void ParallelCommandRecorder::Initialize(ParallelCommandRecorderParams params)
+{
+    DXL_ASSERT(state == nullptr, "ParallelCommandRecorder is already initialized");
+    DXL_ASSERT(params.Pool != nullptr, "ParallelCommandRecorder needs a command list pool");
+    DXL_ASSERT(params.Queue || params.OnExecute, "ParallelCommandRecorder needs a queue or an OnExecute callback");
+
+    uint32_t numThreads = params.NumThreads;
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    state = std::make_unique<ParallelCommandRecorderState>();
+    state->Params = std::move(params);
+    for (uint32_t threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+        state->Threads.emplace_back(&ParallelCommandRecorderState::WorkerThread, state.get());
+}
+
+void ParallelCommandRecorder::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        state->ShuttingDown = true;
+    }
+
+    state->WorkAvailable.notify_all();
+
+    for (std::thread& thread : state->Threads)
+        thread.join();
+
+    state.reset();
+}
+
+void ParallelCommandRecorder::RecordAndExecute(Span<const RecordSegmentFunction> segments, uint64_t fenceValue)
+{
+    DXL_ASSERT(state != nullptr, "ParallelCommandRecorder isn't initialized");
+    if (segments.Count == 0)
+        return;
+
+    {
+        // Workers that woke up late for the previous frame can still be active, and they read the segment states
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->WorkDone.wait(lock, [&]() { return state->NumActiveWorkers == 0; });
+
+        while (state->SegmentStates.size() < segments.Count)
+            state->SegmentStates.push_back(std::make_unique<CommandSegmentState>());
+
+        state->Segments = segments;
+        state->NextSegment.store(0);
+        state->NumSegmentsDone = 0;
+        state->FrameIndex += 1;
+    }
+
+    state->WorkAvailable.notify_all();
+
+    // The calling thread records segments too, rather than sitting idle until the workers are done
+    const uint32_t numRecorded = state->RecordSegments();
+
+    {
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->NumSegmentsDone += numRecorded;
+        state->WorkDone.wait(lock, [&]() { return state->NumSegmentsDone == segments.Count && state->NumActiveWorkers == 0; });
+        state->Segments = Span<const RecordSegmentFunction>();
+    }
+
+    // Now that everything is recorded, walk the segments in order to resolve what each one expects from the previous ones
+    state->RecordedLists.clear();
+    state->FixupLists.clear();
+    for (uint32_t segmentIdx = 0; segmentIdx < segments.Count; ++segmentIdx)
+    {
+        const CommandSegmentState& segmentState = *state->SegmentStates[segmentIdx];
+        state->AddFixupBarriers(segmentState);
+        state->RecordedLists.push_back({ .CommandList = segmentState.CommandList.CommandList, .SegmentIndex = segmentIdx });
+    }
+
+    if (state->Params.OnExecute)
+    {
+        state->Params.OnExecute(Span<const RecordedCommandList>(uint32_t(state->RecordedLists.size()), state->RecordedLists.data()));
+    }
+    else
+    {
+        state->NativeLists.clear();
+        for (const RecordedCommandList& recordedList : state->RecordedLists)
+            state->NativeLists.push_back(recordedList.CommandList.ToNative());
+
+        state->Params.Queue.ExecuteCommandLists(uint32_t(state->NativeLists.size()), state->NativeLists.data());
+    }
+
+    for (PooledCommandList& fixupList : state->FixupLists)
+        state->Params.Pool->Submit(fixupList, fenceValue);
+
+    for (uint32_t segmentIdx = 0; segmentIdx < segments.Count; ++segmentIdx)
+    {
+        CommandSegmentState& segmentState = *state->SegmentStates[segmentIdx];
+        state->Params.Pool->Submit(segmentState.CommandList, fenceValue, segmentState.NumCommands);
+        segmentState.Reset();
+    }
+}
+
+void ParallelCommandRecorder::SetResourceState(IDXLResource resource, D3D12_BARRIER_SYNC sync, D3D12_BARRIER_ACCESS access, D3D12_BARRIER_LAYOUT layout)
+{
+    DXL_ASSERT(state != nullptr, "ParallelCommandRecorder isn't initialized");
+    state->ResourceStates[resource.ToNative()] = { .Sync = sync, .Access = access, .Layout = layout, .IsTexture = layout != D3D12_BARRIER_LAYOUT_UNDEFINED };
+}
+
+void ParallelCommandRecorder::RemoveResource(IDXLResource resource)
+{
+    DXL_ASSERT(state != nullptr, "ParallelCommandRecorder isn't initialized");
+    state->ResourceStates.erase(resource.ToNative());
+}
+
+// == Timeline =====================================================
+
+// Process-wide pool of auto-reset events for fence waits. A wait that times out can leave its event to be signaled
+// later, so waiters always re-check the fence after waking up instead of trusting the event.
+class FenceEventPool
+{
+
+public:
+
+    static FenceEventPool& Get()
+    {
+        static FenceEventPool pool;
+        return pool;
+    }
+
+    ~FenceEventPool()
+    {
+        for (HANDLE event : events)
+            CloseHandle(event);
+    }
+
+    HANDLE Acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (events.size() > 0)
+            {
+                HANDLE event = events.back();
+                events.pop_back();
+                return event;
+            }
+        }
+
+        HANDLE event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+        DXL_ASSERT(event != nullptr, "Failed to create a fence event");
+        return event;
+    }
+
+    void Release(HANDLE event)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(event);
+    }
+
+private:
+
+    std::mutex mutex;
+    std::vector<HANDLE> events;
+};
+
+// Waits on the event until isComplete returns true, with the event being set up again by setEvent after every wake-up
+template<typename TIsComplete, typename TSetEvent> static bool WaitOnFenceEvent(uint32_t timeout, TIsComplete&& isComplete, TSetEvent&& setEvent)
+{
+    if (isComplete())
+        return true;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    HANDLE event = FenceEventPool::Get().Acquire();
+
+    bool completed = false;
+    while (true)
+    {
+        DXL_HANDLE_HRESULT(setEvent(event));
+
+        uint32_t remaining = timeout;
+        if (timeout != INFINITE)
+        {
+            const uint64_t elapsedMS = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count());
+            remaining = elapsedMS < timeout ? uint32_t(timeout - elapsedMS) : 0;
+        }
+
+        const bool signaled = WaitForSingleObject(event, remaining) == WAIT_OBJECT_0;
+        completed = isComplete();
+        if (completed || signaled == false)
+            break;
+    }
+
+    FenceEventPool::Get().Release(event);
+    return completed;
+}
+
+class TimelineState
+{
+
+public:
+
+    IDXLDevice Device;
+    IDXLCommandQueue Queue;
+    IDXLFence Fence;
+    bool OwnsFence = false;
+
+    std::mutex SignalMutex;
+    std::atomic<uint64_t> LastSignaled = 0;
+    std::atomic<uint64_t> CompletedValue = 0;
+
+    uint64_t RefreshCompletedValue()
+    {
+        const uint64_t fenceValue = Fence.GetCompletedValue();
+        uint64_t cachedValue = CompletedValue.load(std::memory_order_relaxed);
+        while (cachedValue < fenceValue && CompletedValue.compare_exchange_weak(cachedValue, fenceValue, std::memory_order_relaxed) == false)
+            ;
+
+        return std::max(cachedValue, fenceValue);
+    }
+
+    bool IsComplete(uint64_t ticket)
+    {
+        return ticket <= CompletedValue.load(std::memory_order_relaxed) || ticket <= RefreshCompletedValue();
+    }
+};
+
+Timeline::Timeline() = default;
+
+Timeline::~Timeline()
+{
+    Shutdown();
+}
+
+void Timeline::Initialize(TimelineParams params)
+{
+    DXL_ASSERT(state == nullptr, "Timeline is already initialized");
+    DXL_ASSERT(params.Queue, "Timeline needs a valid command queue");
+    DXL_ASSERT(params.Fence || params.Device, "Timeline needs a valid device or fence");
+
+    state = std::make_unique<TimelineState>();
+    state->Device = params.Device;
+    state->Queue = params.Queue;
+    state->Fence = params.Fence;
+    if (state->Fence == nullptr)
+    {
+        state->Fence = params.Device.CreateFence(params.InitialValue);
+        state->OwnsFence = true;
+    }
+
+    state->LastSignaled.store(params.InitialValue);
+    state->CompletedValue.store(params.InitialValue);
+    state->RefreshCompletedValue();
+}
+
+void Timeline::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    if (state->OwnsFence)
+        Release(state->Fence);
+
+    state.reset();
+}
+
+uint64_t Timeline::Signal()
+{
+    DXL_ASSERT(state != nullptr, "Timeline isn't initialized");
+
+    // Values need to reach the queue in order, otherwise a later ticket could complete before an earlier one
+    std::lock_guard<std::mutex> lock(state->SignalMutex);
+    const uint64_t ticket = state->LastSignaled.load(std::memory_order_relaxed) + 1;
+    DXL_HANDLE_HRESULT(state->Queue.Signal(state->Fence, ticket));
+    state->LastSignaled.store(ticket, std::memory_order_release);
+
+    return ticket;
+}
+
+uint64_t Timeline::GetLastSignaled() const
+{
+    DXL_ASSERT(state != nullptr, "Timeline isn't initialized");
+    return state->LastSignaled.load(std::memory_order_acquire);
+}
+
+bool Timeline::IsComplete(uint64_t ticket)
+{
+    DXL_ASSERT(state != nullptr, "Timeline isn't initialized");
+    return state->IsComplete(ticket);
+}
+
+uint64_t Timeline::GetCompletedValue()
+{
+    DXL_ASSERT(state != nullptr, "Timeline isn't initialized");
+    return state->RefreshCompletedValue();
+}
+
+bool Timeline::Wait(uint64_t ticket, uint32_t timeout)
+{
+    DXL_ASSERT(state != nullptr, "Timeline isn't initialized");
+    DXL_ASSERT(ticket <= GetLastSignaled(), "Waiting on ticket %llu, which hasn't been signaled", ticket);
+
+    TimelineState* timeline = state.get();
+    return WaitOnFenceEvent(timeout, [&]() { return timeline->IsComplete(ticket); },
+                            [&](HANDLE event) { return timeline->Fence.SetEventOnCompletion(ticket, event); });
+}
+
+void Timeline::WaitForIdle()
+{
+    Wait(Signal());
+}
+
+bool Timeline::WaitMultiple(Span<Timeline* const> timelines, Span<const uint64_t> tickets, D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags, uint32_t timeout)
+{
+    DXL_ASSERT(timelines.Count == tickets.Count, "WaitMultiple needs one ticket per timeline");
+    if (timelines.Count == 0)
+        return true;
+
+    const bool waitForAny = (flags & D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY) != 0;
+
+    // Only the timelines that haven't completed yet go to the device
+    std::vector<TimelineState*> pending;
+    std::vector<ID3D12Fence*> fences;
+    std::vector<uint64_t> values;
+    for (uint32_t i = 0; i < timelines.Count; ++i)
+    {
+        TimelineState* timeline = timelines.Items[i]->state.get();
+        DXL_ASSERT(timeline != nullptr, "Timeline isn't initialized");
+        DXL_ASSERT(tickets.Items[i] <= timeline->LastSignaled.load(), "Waiting on ticket %llu, which hasn't been signaled", tickets.Items[i]);
+
+        if (timeline->IsComplete(tickets.Items[i]))
+        {
+            if (waitForAny)
+                return true;
+            continue;
+        }
+
+        pending.push_back(timeline);
+        fences.push_back(timeline->Fence.ToNative());
+        values.push_back(tickets.Items[i]);
+    }
+
+    if (pending.empty())
+        return true;
+
+    if (pending.size() == 1)
+    {
+        TimelineState* timeline = pending[0];
+        return WaitOnFenceEvent(timeout, [&]() { return timeline->IsComplete(values[0]); },
+                                [&](HANDLE event) { return timeline->Fence.SetEventOnCompletion(values[0], event); });
+    }
+
+    IDXLDevice device = pending[0]->Device;
+    DXL_ASSERT(device, "WaitMultiple needs timelines that were initialized with a device");
+
+    auto isComplete = [&]()
+    {
+        for (uint64_t i = 0; i < pending.size(); ++i)
+        {
+            if (pending[i]->IsComplete(values[i]) == waitForAny)
+                return waitForAny;
+        }
+
+        return waitForAny == false;
+    };
+
+    return WaitOnFenceEvent(timeout, isComplete, [&](HANDLE event)
+    {
+        return device.SetEventOnMultipleFenceCompletion(fences.data(), values.data(), uint32_t(fences.size()), flags, event);
+    });
+}
+
+IDXLFence Timeline::GetFence() const
+{
+    DXL_ASSERT(state != nullptr, "Timeline isn't initialized");
+    return state->Fence;
+}
+
+// == FramePacer =====================================================
+
+static uint64_t GetQPCTime()
+{
+    LARGE_INTEGER time = { };
+    QueryPerformanceCounter(&time);
+    return uint64_t(time.QuadPart);
+}
+
+class FramePacerState
+{
+
+public:
+
+    static constexpr uint32_t NumFrameRecords = 16;
+    static constexpr double AverageWeight = 0.1;
+    static constexpr uint32_t MaxHoldWindows = 64;
+    static constexpr uint64_t CalibrationInterval = 60;
+
+    struct FrameRecord
+    {
+        uint64_t FrameIndex = UINT64_MAX;
+        uint32_t PresentCount = 0;
+        uint64_t BeginTime = 0;
+        uint64_t EndTime = 0;
+    };
+
+    FramePacerParams Params;
+    HANDLE WaitableObject = nullptr;
+    uint64_t QPCFrequency = 1;
+    uint64_t GPUFrequency = 0;
+    uint64_t CalibrationGPUTime = 0;
+    uint64_t CalibrationCPUTime = 0;
+
+    uint64_t FrameIndex = 0;
+    double LastWaitMS = 0.0;
+    FrameRecord Records[NumFrameRecords];
+    DXGI_FRAME_STATISTICS LastFrameStats = { };
+
+    uint32_t FrameLatency = 0;
+    FramePacerStats Stats;
+
+    // Control loop state for the current adjustment window
+    uint32_t WindowFrames = 0;
+    uint32_t WindowMissed = 0;
+    uint32_t WindowLatencySamples = 0;
+    double WindowLatencySum = 0.0;
+    uint32_t HoldWindows = 0;
+    uint32_t BackoffWindows = 1;
+    bool LastChangeWasDecrease = false;
+
+    double QPCToMS(int64_t delta) const
+    {
+        return double(delta) * 1000.0 / double(QPCFrequency);
+    }
+
+    static void UpdateAverage(double& average, double value)
+    {
+        if (value > 0.0)
+            average = average > 0.0 ? average + (value - average) * AverageWeight : value;
+    }
+
+    void SetFrameLatency(uint32_t latency)
+    {
+        FrameLatency = latency;
+        Stats.FrameLatency = latency;
+        if (Params.SwapChain)
+            DXL_HANDLE_HRESULT(Params.SwapChain.SetMaximumFrameLatency(latency));
+    }
+
+    const FrameRecord* FindRecordByPresentCount(uint32_t presentCount) const
+    {
+        for (const FrameRecord& record : Records)
+        {
+            if (record.FrameIndex != UINT64_MAX && record.PresentCount == presentCount)
+                return &record;
+        }
+
+        return nullptr;
+    }
+};
+
+FramePacer::FramePacer() = default;
+
+FramePacer::~FramePacer()
+{
+    Shutdown();
+}
+
+void FramePacer::Initialize(FramePacerParams params)
+{
+    DXL_ASSERT(state == nullptr, "FramePacer is already initialized");
+    DXL_ASSERT(params.MinFrameLatency >= 1 && params.MinFrameLatency <= params.MaxFrameLatency, "FramePacer needs 1 <= MinFrameLatency <= MaxFrameLatency");
+    DXL_ASSERT(params.AdjustmentWindow > 0, "FramePacer needs an adjustment window of at least one frame");
+
+    state = std::make_unique<FramePacerState>();
+    state->Params = params;
+
+    LARGE_INTEGER frequency = { };
+    QueryPerformanceFrequency(&frequency);
+    state->QPCFrequency = std::max(uint64_t(frequency.QuadPart), uint64_t(1));
+
+    if (params.SwapChain)
+        state->WaitableObject = params.SwapChain.GetFrameLatencyWaitableObject();
+    if (params.Queue)
+        DXL_HANDLE_HRESULT(params.Queue.GetTimestampFrequency(&state->GPUFrequency));
+
+    state->SetFrameLatency(std::clamp(params.InitialFrameLatency, params.MinFrameLatency, params.MaxFrameLatency));
+}
+
+void FramePacer::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    if (state->WaitableObject != nullptr)
+        CloseHandle(state->WaitableObject);
+
+    state.reset();
+}
+
+uint64_t FramePacer::BeginFrame()
+{
+    DXL_ASSERT(state != nullptr, "FramePacer isn't initialized");
+
+    // Waiting here rather than after Present means input gets sampled as late as possible
+    const uint64_t waitStart = GetQPCTime();
+    if (state->WaitableObject != nullptr)
+        WaitForSingleObject(state->WaitableObject, 1000);
+    const uint64_t waitEnd = GetQPCTime();
+
+    state->LastWaitMS = state->QPCToMS(int64_t(waitEnd - waitStart));
+
+    FramePacerState::FrameRecord& record = state->Records[state->FrameIndex % FramePacerState::NumFrameRecords];
+    record = { .FrameIndex = state->FrameIndex, .BeginTime = waitEnd };
+
+    return state->FrameIndex;
+}
+
+void FramePacer::EndFrame()
+{
+    DXL_ASSERT(state != nullptr, "FramePacer isn't initialized");
+
+    FramePacerState::FrameRecord& record = state->Records[state->FrameIndex % FramePacerState::NumFrameRecords];
+    record.EndTime = GetQPCTime();
+
+    if (state->Params.Queue && state->FrameIndex % FramePacerState::CalibrationInterval == 0)
+        DXL_HANDLE_HRESULT(state->Params.Queue.GetClockCalibration(&state->CalibrationGPUTime, &state->CalibrationCPUTime));
+
+    FramePacerSample sample = { .LatencyWaitMS = state->LastWaitMS };
+
+    IDXLSwapChain swapChain = state->Params.SwapChain;
+    if (swapChain)
+    {
+        record.PresentCount = swapChain.GetLastPresentCount();
+
+        // Statistics only move forward once a present hits a vblank, and the call fails (leaving them zeroed) when
+        // they aren't available, e.g. for windowed swap chains that aren't in independent flip
+        const DXGI_FRAME_STATISTICS frameStats = swapChain.GetFrameStatistics();
+        const DXGI_FRAME_STATISTICS& lastStats = state->LastFrameStats;
+        if (frameStats.PresentCount != 0 && frameStats.PresentCount != lastStats.PresentCount)
+        {
+            if (lastStats.PresentCount != 0)
+            {
+                const uint32_t numPresents = frameStats.PresentCount - lastStats.PresentCount;
+                const uint32_t numRefreshes = frameStats.SyncRefreshCount - lastStats.SyncRefreshCount;
+                sample.PresentIntervalMS = state->QPCToMS(frameStats.SyncQPCTime.QuadPart - lastStats.SyncQPCTime.QuadPart) / numPresents;
+
+                const uint32_t expectedRefreshes = numPresents * state->Params.SyncInterval;
+                if (expectedRefreshes > 0 && numRefreshes > expectedRefreshes)
+                    sample.MissedRefreshes = numRefreshes - expectedRefreshes;
+            }
+
+            if (const FramePacerState::FrameRecord* displayed = state->FindRecordByPresentCount(frameStats.PresentCount))
+                sample.InputToDisplayMS = state->QPCToMS(frameStats.SyncQPCTime.QuadPart - int64_t(displayed->BeginTime));
+
+            state->LastFrameStats = frameStats;
+        }
+    }
+
+    AddSample(sample);
+    state->FrameIndex += 1;
+}
+
+void FramePacer::SetGPUFrameEnd(uint64_t frameIndex, uint64_t gpuTimestamp)
+{
+    DXL_ASSERT(state != nullptr, "FramePacer isn't initialized");
+    if (state->GPUFrequency == 0 || state->CalibrationCPUTime == 0)
+        return;
+
+    const FramePacerState::FrameRecord& record = state->Records[frameIndex % FramePacerState::NumFrameRecords];
+    if (record.FrameIndex != frameIndex || record.EndTime == 0)
+        return;
+
+    const double gpuDeltaSeconds = double(int64_t(gpuTimestamp - state->CalibrationGPUTime)) / double(state->GPUFrequency);
+    const double gpuEndTime = double(state->CalibrationCPUTime) + gpuDeltaSeconds * double(state->QPCFrequency);
+    FramePacerState::UpdateAverage(state->Stats.CPUToGPUMS, (gpuEndTime - double(record.EndTime)) * 1000.0 / double(state->QPCFrequency));
+}
+
+void FramePacer::AddSample(const FramePacerSample& sample)
+{
+    DXL_ASSERT(state != nullptr, "FramePacer isn't initialized");
+
+    FramePacerStats& stats = state->Stats;
+    FramePacerState::UpdateAverage(stats.LatencyWaitMS, sample.LatencyWaitMS);
+    FramePacerState::UpdateAverage(stats.PresentIntervalMS, sample.PresentIntervalMS);
+    FramePacerState::UpdateAverage(stats.InputToDisplayMS, sample.InputToDisplayMS);
+    stats.NumMissedRefreshes += sample.MissedRefreshes;
+
+    state->WindowFrames += 1;
+    state->WindowMissed += sample.MissedRefreshes > 0 ? 1 : 0;
+    if (sample.InputToDisplayMS > 0.0)
+    {
+        state->WindowLatencySum += sample.InputToDisplayMS;
+        state->WindowLatencySamples += 1;
+    }
+
+    if (state->WindowFrames < state->Params.AdjustmentWindow)
+        return;
+
+    const FramePacerParams& params = state->Params;
+    const uint32_t windowMissed = state->WindowMissed;
+    const double windowLatency = state->WindowLatencySamples > 0 ? state->WindowLatencySum / state->WindowLatencySamples : 0.0;
+    state->WindowFrames = 0;
+    state->WindowMissed = 0;
+    state->WindowLatencySamples = 0;
+    state->WindowLatencySum = 0.0;
+
+    if (windowMissed > params.MaxMissedPerWindow)
+    {
+        if (state->FrameLatency < params.MaxFrameLatency)
+        {
+            // A lower latency that didn't hold gets retried less and less often
+            state->BackoffWindows = state->LastChangeWasDecrease ? std::min(state->BackoffWindows * 2, FramePacerState::MaxHoldWindows) : state->BackoffWindows;
+            state->HoldWindows = state->BackoffWindows;
+            state->LastChangeWasDecrease = false;
+            state->SetFrameLatency(state->FrameLatency + 1);
+        }
+    }
+    else if (state->HoldWindows > 0)
+    {
+        state->HoldWindows -= 1;
+    }
+    else if (windowMissed == 0 && state->FrameLatency > params.MinFrameLatency)
+    {
+        const bool overTarget = params.TargetLatencyMS <= 0.0f || windowLatency == 0.0 || windowLatency > params.TargetLatencyMS;
+        if (overTarget)
+        {
+            state->LastChangeWasDecrease = true;
+            state->SetFrameLatency(state->FrameLatency - 1);
+        }
+    }
+    else if (windowMissed == 0 && state->LastChangeWasDecrease)
+    {
+        // The lowest latency held for a full window, so start trusting decreases again
+        state->BackoffWindows = 1;
+    }
+}
+
+uint32_t FramePacer::GetFrameLatency() const
+{
+    DXL_ASSERT(state != nullptr, "FramePacer isn't initialized");
+    return state->FrameLatency;
+}
+
+FramePacerStats FramePacer::GetStats() const
+{
+    DXL_ASSERT(state != nullptr, "FramePacer isn't initialized");
+    return state->Stats;
+}
+
+// == GPUProfiler =====================================================
+
+class GPUProfilerState
+{
+
+public:
+
+    struct ScopeRecord
+    {
+        const char* Name = nullptr;
+        uint32_t Parent = UINT32_MAX;
+        uint32_t Depth = 0;
+        bool Ended = false;
+    };
+
+    struct FrameSlot
+    {
+        uint64_t FrameIndex = UINT64_MAX;
+        uint64_t FenceValue = 0;
+        bool Pending = false;
+        std::vector<ScopeRecord> Scopes;
+
+        // Maps the frame's timestamps to CPU time
+        uint64_t CalibrationGPUTime = 0;
+        double CalibrationCPUTimeMS = 0.0;
+    };
+
+    struct NodeKey
+    {
+        uint32_t Parent = UINT32_MAX;
+        std::string Name;
+
+        bool operator==(const NodeKey& other) const = default;
+    };
+
+    struct NodeKeyHasher
+    {
+        size_t operator()(const NodeKey& key) const { return std::hash<std::string>()(key.Name) ^ (size_t(key.Parent) * 0x9e3779b97f4a7c15ull); }
+    };
+
+    GPUProfilerParams Params;
+    IDXLQueryHeap QueryHeap;
+    IDXLResource ReadbackBuffer;
+    const uint64_t* Timestamps = nullptr;
+    std::vector<uint64_t> FakeTimestamps;
+    uint64_t TimestampFrequency = 1;
+    uint64_t QPCFrequency = 1;
+
+    std::vector<FrameSlot> Slots;
+    uint64_t FrameIndex = 0;
+    bool InFrame = false;
+    std::vector<uint32_t> OpenScopes;
+    uint64_t NumDroppedScopes = 0;
+
+    GPUProfileFrame LastFrame;
+    std::vector<GPUProfileNodeStats> Nodes;
+    std::unordered_map<NodeKey, uint32_t, NodeKeyHasher> NodeIndices;
+    std::vector<uint32_t> ScopeNodes;
+
+    FrameSlot& CurrentSlot()
+    {
+        return Slots[FrameIndex % Slots.size()];
+    }
+
+    uint32_t GetQueryIndex(uint64_t frameIndex, uint32_t scopeIdx, bool end) const
+    {
+        const uint32_t slotIdx = uint32_t(frameIndex % Slots.size());
+        return (slotIdx * Params.MaxScopesPerFrame + scopeIdx) * 2 + (end ? 1 : 0);
+    }
+
+    void WriteTimestamp(IDXLCommandList commandList, uint32_t queryIndex)
+    {
+        if (QueryHeap)
+            commandList.EndQuery(QueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, queryIndex);
+        else
+            FakeTimestamps[queryIndex] = Params.FakeTimestamps ? Params.FakeTimestamps() : 0;
+    }
+
+    double TimestampToMS(const FrameSlot& slot, uint64_t timestamp) const
+    {
+        return slot.CalibrationCPUTimeMS + double(int64_t(timestamp - slot.CalibrationGPUTime)) * 1000.0 / double(TimestampFrequency);
+    }
+
+    uint32_t GetNode(uint32_t parentNode, const char* name, uint32_t depth)
+    {
+        auto [iter, inserted] = NodeIndices.emplace(NodeKey { .Parent = parentNode, .Name = name }, uint32_t(Nodes.size()));
+        if (inserted)
+            Nodes.push_back({ .Name = name, .Parent = parentNode, .Depth = depth });
+
+        return iter->second;
+    }
+
+    void ReadFrame(FrameSlot& slot)
+    {
+        LastFrame.FrameIndex = slot.FrameIndex;
+        LastFrame.Scopes.clear();
+        ScopeNodes.clear();
+
+        for (uint32_t scopeIdx = 0; scopeIdx < uint32_t(slot.Scopes.size()); ++scopeIdx)
+        {
+            const ScopeRecord& record = slot.Scopes[scopeIdx];
+            const uint64_t start = Timestamps[GetQueryIndex(slot.FrameIndex, scopeIdx, false)];
+            const uint64_t end = Timestamps[GetQueryIndex(slot.FrameIndex, scopeIdx, true)];
+
+            GPUProfileScope& scope = LastFrame.Scopes.emplace_back();
+            scope.Name = record.Name;
+            scope.Parent = record.Parent;
+            scope.Depth = record.Depth;
+            scope.StartMS = TimestampToMS(slot, start);
+            scope.EndMS = TimestampToMS(slot, std::max(start, end));
+
+            // Scopes with the same name are merged when they share a parent node, which keeps the tree stable when the
+            // number of scopes changes from frame to frame
+            const uint32_t parentNode = record.Parent != UINT32_MAX ? ScopeNodes[record.Parent] : UINT32_MAX;
+            const uint32_t nodeIdx = GetNode(parentNode, record.Name, record.Depth);
+            ScopeNodes.push_back(nodeIdx);
+
+            GPUProfileNodeStats& node = Nodes[nodeIdx];
+            const double durationMS = scope.EndMS - scope.StartMS;
+            node.NumSamples += 1;
+            node.LastMS = durationMS;
+            node.MinMS = node.NumSamples > 1 ? std::min(node.MinMS, durationMS) : durationMS;
+            node.MaxMS = node.NumSamples > 1 ? std::max(node.MaxMS, durationMS) : durationMS;
+            node.AvgMS += (durationMS - node.AvgMS) / double(node.NumSamples);
+        }
+
+        slot.Pending = false;
+        slot.Scopes.clear();
+    }
+
+    // Reads back every pending frame whose fence has completed, oldest first. Frames up to waitFrameIndex are waited on.
+    void ReadCompletedFrames(uint64_t waitFrameIndex)
+    {
+        const uint64_t firstFrame = FrameIndex >= Slots.size() ? FrameIndex - Slots.size() : 0;
+        for (uint64_t frameIndex = firstFrame; frameIndex < FrameIndex; ++frameIndex)
+        {
+            FrameSlot& slot = Slots[frameIndex % Slots.size()];
+            if (slot.Pending == false || slot.FrameIndex != frameIndex)
+                continue;
+
+            if (Params.Fence && Params.Fence.GetCompletedValue() < slot.FenceValue)
+            {
+                if (frameIndex > waitFrameIndex || waitFrameIndex == UINT64_MAX)
+                    break;
+
+                DXL_HANDLE_HRESULT(Params.Fence.SetEventOnCompletion(slot.FenceValue, nullptr));
+            }
+
+            ReadFrame(slot);
+        }
+    }
+};
+
+GPUProfiler::GPUProfiler() = default;
+
+GPUProfiler::~GPUProfiler()
+{
+    Shutdown();
+}
+
+void GPUProfiler::Initialize(GPUProfilerParams params)
+{
+    DXL_ASSERT(state == nullptr, "GPUProfiler is already initialized");
+    DXL_ASSERT(params.MaxScopesPerFrame > 0 && params.NumFramesInFlight > 0, "GPUProfiler needs at least one scope and one frame");
+    DXL_ASSERT(params.Device == nullptr || (params.Queue && params.Fence), "GPUProfiler needs a queue and a fence when it has a device");
+
+    state = std::make_unique<GPUProfilerState>();
+    state->Params = params;
+    state->Slots.resize(params.NumFramesInFlight);
+
+    LARGE_INTEGER qpcFrequency = { };
+    QueryPerformanceFrequency(&qpcFrequency);
+    state->QPCFrequency = std::max(uint64_t(qpcFrequency.QuadPart), uint64_t(1));
+
+    const uint32_t numQueries = params.MaxScopesPerFrame * 2 * params.NumFramesInFlight;
+    if (params.Device)
+    {
+        state->QueryHeap = params.Device.CreateQueryHeap({ .Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP, .Count = numQueries });
+
+        const D3D12_HEAP_PROPERTIES heapProperties = { .Type = D3D12_HEAP_TYPE_READBACK };
+        const D3D12_RESOURCE_DESC1 desc =
+        {
+            .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+            .Width = uint64_t(numQueries) * sizeof(uint64_t),
+            .Height = 1,
+            .DepthOrArraySize = 1,
+            .MipLevels = 1,
+            .SampleDesc = { .Count = 1 },
+            .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        };
+        state->ReadbackBuffer = params.Device.CreateCommittedResource(heapProperties, D3D12_HEAP_FLAG_NONE, desc);
+
+        // Readback buffers can stay mapped, the fence wait is what makes the GPU's writes visible
+        void* mappedData = nullptr;
+        DXL_HANDLE_HRESULT(state->ReadbackBuffer.Map(0, nullptr, &mappedData));
+        state->Timestamps = reinterpret_cast<const uint64_t*>(mappedData);
+
+        DXL_HANDLE_HRESULT(params.Queue.GetTimestampFrequency(&state->TimestampFrequency));
+    }
+    else
+    {
+        state->FakeTimestamps.resize(numQueries);
+        state->Timestamps = state->FakeTimestamps.data();
+        state->TimestampFrequency = std::max(params.FakeTimestampFrequency, uint64_t(1));
+    }
+}
+
+void GPUProfiler::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    // The empty written range says that the CPU didn't write anything
+    const D3D12_RANGE writtenRange = { };
+    if (state->ReadbackBuffer)
+        state->ReadbackBuffer.Unmap(0, &writtenRange);
+
+    Release(state->ReadbackBuffer);
+    Release(state->QueryHeap);
+    state.reset();
+}
+
+void GPUProfiler::BeginFrame()
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    DXL_ASSERT(state->InFrame == false, "GPUProfiler::BeginFrame was called twice without EndFrame");
+
+    // Only the frame that last used this frame's slot needs to be waited on
+    const uint64_t slotFrame = state->FrameIndex >= state->Slots.size() ? state->FrameIndex - state->Slots.size() : UINT64_MAX;
+    state->ReadCompletedFrames(slotFrame);
+
+    GPUProfilerState::FrameSlot& slot = state->CurrentSlot();
+    DXL_ASSERT(slot.Pending == false, "GPUProfiler frame slot is still in use");
+    slot.FrameIndex = state->FrameIndex;
+    slot.Scopes.clear();
+    state->OpenScopes.clear();
+    state->InFrame = true;
+}
+
+bool GPUProfiler::BeginScope(IDXLCommandList commandList, const char* name)
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    DXL_ASSERT(state->InFrame, "GPUProfiler scopes need to be between BeginFrame and EndFrame");
+
+    GPUProfilerState::FrameSlot& slot = state->CurrentSlot();
+    if (slot.Scopes.size() >= state->Params.MaxScopesPerFrame)
+    {
+        state->NumDroppedScopes += 1;
+        return false;
+    }
+
+    const uint32_t scopeIdx = uint32_t(slot.Scopes.size());
+    const uint32_t parent = state->OpenScopes.empty() ? UINT32_MAX : state->OpenScopes.back();
+    slot.Scopes.push_back({ .Name = name, .Parent = parent, .Depth = uint32_t(state->OpenScopes.size()) });
+    state->OpenScopes.push_back(scopeIdx);
+
+    state->WriteTimestamp(commandList, state->GetQueryIndex(state->FrameIndex, scopeIdx, false));
+    return true;
+}
+
+void GPUProfiler::EndScope(IDXLCommandList commandList)
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    DXL_ASSERT(state->OpenScopes.size() > 0, "GPUProfiler::EndScope doesn't have a matching BeginScope");
+
+    const uint32_t scopeIdx = state->OpenScopes.back();
+    state->OpenScopes.pop_back();
+    state->CurrentSlot().Scopes[scopeIdx].Ended = true;
+
+    state->WriteTimestamp(commandList, state->GetQueryIndex(state->FrameIndex, scopeIdx, true));
+}
+
+void GPUProfiler::EndFrame(IDXLCommandList commandList, uint64_t fenceValue)
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    DXL_ASSERT(state->InFrame, "GPUProfiler::EndFrame doesn't have a matching BeginFrame");
+    DXL_ASSERT(state->OpenScopes.empty(), "GPUProfiler frame ended with %u scopes still open", uint32_t(state->OpenScopes.size()));
+
+    GPUProfilerState::FrameSlot& slot = state->CurrentSlot();
+    const uint32_t numScopes = uint32_t(slot.Scopes.size());
+    if (numScopes > 0 && state->QueryHeap)
+    {
+        // The frame's queries are contiguous, so they resolve with one call into the same offset of the readback buffer
+        const uint32_t firstQuery = state->GetQueryIndex(state->FrameIndex, 0, false);
+        commandList.ResolveQueryData(state->QueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, numScopes * 2, state->ReadbackBuffer, uint64_t(firstQuery) * sizeof(uint64_t));
+    }
+
+    if (state->Params.Queue)
+    {
+        uint64_t cpuTime = 0;
+        DXL_HANDLE_HRESULT(state->Params.Queue.GetClockCalibration(&slot.CalibrationGPUTime, &cpuTime));
+        slot.CalibrationCPUTimeMS = double(cpuTime) * 1000.0 / double(state->QPCFrequency);
+    }
+
+    slot.FenceValue = fenceValue;
+    slot.Pending = numScopes > 0;
+    state->FrameIndex += 1;
+    state->InFrame = false;
+
+    // Without a fence there's nothing to wait for, so fake timestamps can be read back right away
+    if (state->Params.Fence == nullptr)
+        state->ReadCompletedFrames(UINT64_MAX);
+}
+
+const GPUProfileFrame& GPUProfiler::GetLastFrame() const
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    return state->LastFrame;
+}
+
+std::vector<GPUProfileNodeStats> GPUProfiler::GetStats() const
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    return state->Nodes;
+}
+
+void GPUProfiler::ResetStats()
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    state->Nodes.clear();
+    state->NodeIndices.clear();
+}
+
+uint64_t GPUProfiler::GetNumDroppedScopes() const
+{
+    DXL_ASSERT(state != nullptr, "GPUProfiler isn't initialized");
+    return state->NumDroppedScopes;
+}
+
+// == TraceSink =====================================================
+
+// Single-producer ring that's filled by the thread that owns it, and drained by whichever thread flushes the sink
+class TraceThreadBuffer
+{
+
+public:
+
+    std::unique_ptr<TraceEvent[]> Events;
+    uint32_t Capacity = 0;
+    uint32_t ThreadID = 0;
+    std::atomic<uint64_t> WriteIndex = 0;
+    std::atomic<uint64_t> ReadIndex = 0;
+    std::atomic<uint64_t> NumDropped = 0;
+
+    void Push(const TraceEvent& event)
+    {
+        const uint64_t writeIndex = WriteIndex.load(std::memory_order_relaxed);
+        if (writeIndex - ReadIndex.load(std::memory_order_acquire) >= Capacity)
+        {
+            NumDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Events[writeIndex % Capacity] = event;
+        Events[writeIndex % Capacity].ThreadID = ThreadID;
+        WriteIndex.store(writeIndex + 1, std::memory_order_release);
+    }
+
+    void Drain(std::vector<TraceEvent>& events)
+    {
+        const uint64_t readIndex = ReadIndex.load(std::memory_order_relaxed);
+        const uint64_t writeIndex = WriteIndex.load(std::memory_order_acquire);
+        for (uint64_t index = readIndex; index < writeIndex; ++index)
+            events.push_back(Events[index % Capacity]);
+
+        ReadIndex.store(writeIndex, std::memory_order_release);
+    }
+};
+
+struct TraceThreadBufferCache
+{
+    uint64_t SinkID = 0;
+    std::shared_ptr<TraceThreadBuffer> Buffer;
+};
+
+static thread_local TraceThreadBufferCache TraceThreadBuffers;
+static std::atomic<TraceSinkState*> ActiveTraceSink = nullptr;
+static std::atomic<uint64_t> NextTraceSinkID = 1;
+
+// Every thread that ends a scope registers one of these, and publishes the sink it's pushing to in it. Shutdown clears
+// the active sink and then only waits for the threads whose registration still holds it, so scopes ending on
+// different threads don't contend on a shared counter.
+class TraceThreadRegistration
+{
+
+public:
+
+    std::atomic<TraceSinkState*> Sink = nullptr;
+
+    TraceThreadRegistration();
+    ~TraceThreadRegistration();
+};
+
+static std::mutex TraceThreadsMutex;
+static std::vector<TraceThreadRegistration*> TraceThreads;
+static thread_local TraceThreadRegistration TraceThread;
+
+TraceThreadRegistration::TraceThreadRegistration()
+{
+    std::lock_guard<std::mutex> lock(TraceThreadsMutex);
+    TraceThreads.push_back(this);
+}
+
+TraceThreadRegistration::~TraceThreadRegistration()
+{
+    std::lock_guard<std::mutex> lock(TraceThreadsMutex);
+    TraceThreads.erase(std::find(TraceThreads.begin(), TraceThreads.end(), this));
+}
+
+// Threads are numbered from 1, GPU tracks start here so that they sort after the CPU threads
+static const uint32_t FirstGPUTrackID = 0x10000;
+
+class TraceSinkState
+{
+
+public:
+
+    TraceSinkParams Params;
+    uint64_t ID = 0;
+
+    std::mutex BuffersMutex;
+    std::vector<std::shared_ptr<TraceThreadBuffer>> Buffers;
+    uint32_t NextThreadID = 1;
+
+    // Also held while draining, so there's only ever one thread reading from the rings
+    mutable std::mutex EventsMutex;
+    std::vector<TraceEvent> Events;
+    std::vector<TraceThreadName> ThreadNames;
+    uint64_t NumDroppedAtClear = 0;
+
+    std::thread FlushThread;
+    std::mutex FlushMutex;
+    std::condition_variable FlushWake;
+    bool ShuttingDown = false;
+
+    TraceThreadBuffer& GetThreadBuffer()
+    {
+        TraceThreadBufferCache& cache = TraceThreadBuffers;
+        if (cache.SinkID != ID)
+        {
+            std::shared_ptr<TraceThreadBuffer> buffer = std::make_shared<TraceThreadBuffer>();
+            buffer->Capacity = Params.EventsPerThread;
+            buffer->Events = std::make_unique<TraceEvent[]>(Params.EventsPerThread);
+
+            {
+                std::lock_guard<std::mutex> lock(BuffersMutex);
+                buffer->ThreadID = NextThreadID++;
+                Buffers.push_back(buffer);
+            }
+
+            cache.SinkID = ID;
+            cache.Buffer = std::move(buffer);
+        }
+
+        return *cache.Buffer;
+    }
+
+    void Flush()
+    {
+        std::vector<std::shared_ptr<TraceThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(BuffersMutex);
+            buffers = Buffers;
+        }
+
+        std::lock_guard<std::mutex> lock(EventsMutex);
+        for (const std::shared_ptr<TraceThreadBuffer>& buffer : buffers)
+            buffer->Drain(Events);
+    }
+
+    uint64_t GetNumDropped()
+    {
+        uint64_t numDropped = 0;
+        std::lock_guard<std::mutex> lock(BuffersMutex);
+        for (const std::shared_ptr<TraceThreadBuffer>& buffer : Buffers)
+            numDropped += buffer->NumDropped.load(std::memory_order_relaxed);
+
+        return numDropped;
+    }
+
+    void FlushThreadFunction()
+    {
+        std::unique_lock<std::mutex> lock(FlushMutex);
+        while (ShuttingDown == false)
+        {
+            FlushWake.wait_for(lock, std::chrono::milliseconds(Params.FlushIntervalMS), [this]() { return ShuttingDown; });
+
+            lock.unlock();
+            Flush();
+            lock.lock();
+        }
+    }
+};
+
+uint64_t GetTraceTime()
 {
-    ToNative()->RSSetShadingRate(baseShadingRate, combiners);
+    static const uint64_t qpcFrequency = []()
+    {
+        LARGE_INTEGER frequency = { };
+        QueryPerformanceFrequency(&frequency);
+        return std::max(uint64_t(frequency.QuadPart), uint64_t(1));
+    }();
+
+    // Split up so that the conversion can't overflow
+    const uint64_t time = GetQPCTime();
+    return (time / qpcFrequency) * 1000000000ull + ((time % qpcFrequency) * 1000000000ull) / qpcFrequency;
 }
 
-void IDXLCommandList::RSSetShadingRateImage(IDXLResource shadingRateImage)
+static void AppendJSONString(std::string& output, const char* string)
 {
-    ToNative()->RSSetShadingRateImage(shadingRateImage);
+    output += '"';
+    for (const char* c = string ? string : ""; *c != 0; ++c)
+    {
+        const uint8_t ch = uint8_t(*c);
+        if (ch == '"' || ch == '\\')
+        {
+            output += '\\';
+            output += char(ch);
+        }
+        else if (ch < 0x20)
+        {
+            char escaped[8] = { };
+            snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+            output += escaped;
+        }
+        else
+        {
+            output += char(ch);
+        }
+    }
+    output += '"';
 }
 
-void IDXLCommandList::OMSetBlendFactor(const float blendFactor[4])
+// Chrome traces use microseconds, which are written with the nanoseconds as decimals
+static void AppendTraceTime(std::string& output, uint64_t timeNS)
 {
-    ToNative()->OMSetBlendFactor(blendFactor);
+    char buffer[32] = { };
+    snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(timeNS / 1000), static_cast<unsigned long long>(timeNS % 1000));
+    output += buffer;
 }
 
-void IDXLCommandList::OMSetStencilRef(uint32_t stencilRef)
+std::string FormatChromeTrace(Span<const TraceEvent> events, Span<const TraceThreadName> threadNames)
 {
-    ToNative()->OMSetStencilRef(stencilRef);
+    std::string output;
+    output.reserve(size_t(events.Count) * 96 + 64);
+    output += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for (const TraceThreadName& threadName : threadNames)
+    {
+        output += first ? "" : ",\n";
+        output += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(threadName.ThreadID) + ",\"args\":{\"name\":";
+        AppendJSONString(output, threadName.Name.c_str());
+        output += "}}";
+        first = false;
+    }
+
+    for (const TraceEvent& event : events)
+    {
+        output += first ? "{\"name\":" : ",\n{\"name\":";
+        AppendJSONString(output, event.Name);
+        output += ",\"cat\":";
+        AppendJSONString(output, event.Category);
+        output += ",\"ph\":\"X\",\"ts\":";
+        AppendTraceTime(output, event.StartNS);
+        output += ",\"dur\":";
+        AppendTraceTime(output, event.DurationNS);
+        output += ",\"pid\":1,\"tid\":" + std::to_string(event.ThreadID) + "}";
+        first = false;
+    }
+
+    output += "\n]}\n";
+    return output;
 }
 
-void IDXLCommandList::OMSetFrontAndBackStencilRef(uint32_t frontStencilRef, uint32_t backStencilRef)
+TraceScope::TraceScope(const char* name, const char* category) : name(name), category(category)
 {
-    ToNative()->OMSetFrontAndBackStencilRef(frontStencilRef, backStencilRef);
+    if (ActiveTraceSink.load(std::memory_order_relaxed) != nullptr)
+        startTime = GetTraceTime();
 }
 
-void IDXLCommandList::SetPipelineState(IDXLPipelineState pipelineState)
+TraceScope::~TraceScope()
 {
-    ToNative()->SetPipelineState(pipelineState);
+    if (startTime == 0)
+        return;
+
+    const uint64_t endTime = GetTraceTime();
+
+    TraceSinkState* sink = ActiveTraceSink.load();
+    if (sink == nullptr)
+        return;
+
+    // Publishing the sink and checking that it's still active both need to be sequentially consistent, so that either
+    // Shutdown sees it in the registration or this sees the cleared sink
+    TraceThreadRegistration& thread = TraceThread;
+    thread.Sink.store(sink);
+    if (ActiveTraceSink.load() == sink)
+        sink->GetThreadBuffer().Push({ .Name = name, .Category = category, .StartNS = startTime, .DurationNS = endTime - startTime });
+    thread.Sink.store(nullptr, std::memory_order_release);
 }
 
-void IDXLCommandList::SetPipelineState1(IDXLStateObject stateObject)
+TraceSink::TraceSink() = default;
+
+TraceSink::~TraceSink()
 {
-    ToNative()->SetPipelineState1(stateObject);
+    Shutdown();
 }
 
-void IDXLCommandList::SetProgram(const D3D12_SET_PROGRAM_DESC* desc)
+void TraceSink::Initialize(TraceSinkParams params)
 {
-    ToNative()->SetProgram(desc);
+    DXL_ASSERT(state == nullptr, "TraceSink is already initialized");
+    DXL_ASSERT(params.EventsPerThread > 0, "TraceSink needs room for at least one event per thread");
+
+    state = std::make_unique<TraceSinkState>();
+    state->Params = params;
+    state->ID = NextTraceSinkID.fetch_add(1);
+
+    TraceSinkState* expected = nullptr;
+    const bool activated = ActiveTraceSink.compare_exchange_strong(expected, state.get());
+    DXL_ASSERT(activated, "Only one TraceSink can be initialized at a time");
+    (void)activated;
+
+    if (params.StartFlushThread)
+        state->FlushThread = std::thread(&TraceSinkState::FlushThreadFunction, state.get());
 }
 
-void IDXLCommandList::SetDescriptorHeaps(uint32_t numDescriptorHeaps, ID3D12DescriptorHeap*const* descriptorHeaps)
+void TraceSink::Shutdown()
 {
-    ToNative()->SetDescriptorHeaps(numDescriptorHeaps, descriptorHeaps);
+    if (state == nullptr)
+        return;
+
+    TraceSinkState* expected = state.get();
+    ActiveTraceSink.compare_exchange_strong(expected, nullptr);
+
+    // Scopes on other threads that still see the sink finish quickly, since pushing never blocks for long. Threads
+    // don't need this mutex while they're pushing, only when they start or exit.
+    {
+        std::lock_guard<std::mutex> lock(TraceThreadsMutex);
+        for (TraceThreadRegistration* thread : TraceThreads)
+        {
+            while (thread->Sink.load() == state.get())
+                std::this_thread::yield();
+        }
+    }
+
+    if (state->FlushThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->FlushMutex);
+            state->ShuttingDown = true;
+        }
+
+        state->FlushWake.notify_all();
+        state->FlushThread.join();
+    }
+
+    state.reset();
 }
 
-#if DXL_ENABLE_EXTENSIONS
+void TraceSink::SetThreadName(const char* name)
+{
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
 
-void IDXLCommandList::SetDescriptorHeaps(IDXLDescriptorHeap srvUavCbvHeap, IDXLDescriptorHeap samplerHeap)
+    const uint32_t threadID = state->GetThreadBuffer().ThreadID;
+    std::lock_guard<std::mutex> lock(state->EventsMutex);
+    state->ThreadNames.push_back({ .ThreadID = threadID, .Name = name });
+}
+
+void TraceSink::AddGPUFrame(const GPUProfileFrame& frame, const char* trackName)
 {
-    ID3D12DescriptorHeap* heaps[] = { srvUavCbvHeap, samplerHeap };
-    ToNative()->SetDescriptorHeaps(samplerHeap ? 2 : 1, heaps);
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->EventsMutex);
+
+    uint32_t trackID = FirstGPUTrackID;
+    auto isTrack = [&](const TraceThreadName& threadName) { return threadName.ThreadID >= FirstGPUTrackID && threadName.Name == trackName; };
+    auto trackIter = std::find_if(state->ThreadNames.begin(), state->ThreadNames.end(), isTrack);
+    if (trackIter != state->ThreadNames.end())
+    {
+        trackID = trackIter->ThreadID;
+    }
+    else
+    {
+        for (const TraceThreadName& threadName : state->ThreadNames)
+            trackID = std::max(trackID, threadName.ThreadID + 1);
+        state->ThreadNames.push_back({ .ThreadID = trackID, .Name = trackName });
+    }
+
+    for (const GPUProfileScope& scope : frame.Scopes)
+    {
+        const uint64_t startNS = uint64_t(std::max(scope.StartMS, 0.0) * 1000000.0);
+        const uint64_t endNS = uint64_t(std::max(scope.EndMS, 0.0) * 1000000.0);
+        state->Events.push_back({ .Name = scope.Name, .Category = "GPU", .StartNS = startNS, .DurationNS = endNS - std::min(startNS, endNS), .ThreadID = trackID });
+    }
 }
 
-#endif
+void TraceSink::Flush()
+{
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
+    state->Flush();
+}
 
-void IDXLCommandList::SetComputeRootSignature(IDXLRootSignature rootSignature)
+bool TraceSink::WriteChromeTrace(const char* filePath)
 {
-    ToNative()->SetComputeRootSignature(rootSignature);
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
+
+    state->Flush();
+
+    std::string output;
+    {
+        std::lock_guard<std::mutex> lock(state->EventsMutex);
+
+        // Events arrive in the order their scopes ended, and viewers expect enclosing events to come first
+        std::stable_sort(state->Events.begin(), state->Events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.StartNS < b.StartNS; });
+        output = FormatChromeTrace(Span<const TraceEvent>(uint32_t(state->Events.size()), state->Events.data()),
+                                   Span<const TraceThreadName>(uint32_t(state->ThreadNames.size()), state->ThreadNames.data()));
+    }
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == nullptr)
+        return false;
+
+    const bool succeeded = fwrite(output.data(), 1, output.size(), file) == output.size();
+    return fclose(file) == 0 && succeeded;
 }
 
-void IDXLCommandList::SetGraphicsRootSignature(IDXLRootSignature rootSignature)
+void TraceSink::Clear()
 {
-    ToNative()->SetGraphicsRootSignature(rootSignature);
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
+
+    state->Flush();
+
+    const uint64_t numDropped = state->GetNumDropped();
+    std::lock_guard<std::mutex> lock(state->EventsMutex);
+    state->Events.clear();
+    state->NumDroppedAtClear = numDropped;
 }
 
-#if DXL_ENABLE_DESCRIPTOR_TABLES
+uint64_t TraceSink::GetNumEvents() const
+{
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
 
-void IDXLCommandList::SetComputeRootDescriptorTable(uint32_t rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+    std::lock_guard<std::mutex> lock(state->EventsMutex);
+    return state->Events.size();
+}
+
+uint64_t TraceSink::GetNumDroppedEvents() const
 {
-    ToNative()->SetComputeRootDescriptorTable(rootParameterIndex, baseDescriptor);
+    DXL_ASSERT(state != nullptr, "TraceSink isn't initialized");
+
+    const uint64_t numDropped = state->GetNumDropped();
+    std::lock_guard<std::mutex> lock(state->EventsMutex);
+    return numDropped - state->NumDroppedAtClear;
 }
 
-void IDXLCommandList::SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+// == TextureUploader =====================================================
+
+struct FormatBlockInfo
 {
-    ToNative()->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+    uint32_t BytesPerBlock = 0;
+    uint32_t BlockSize = 1;                 // Width and height of a block in texels
+};
+
+// Only covers single-plane formats, which is all that the CPU footprint path needs to handle
+static FormatBlockInfo GetFormatBlockInfo(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+        return { .BytesPerBlock = 16 };
+    case DXGI_FORMAT_R32G32B32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+        return { .BytesPerBlock = 12 };
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+    case DXGI_FORMAT_R32G32_TYPELESS:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+        return { .BytesPerBlock = 8 };
+    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UINT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_R16G16_TYPELESS:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R32_TYPELESS:
+    case DXGI_FORMAT_D32_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        return { .BytesPerBlock = 4 };
+    case DXGI_FORMAT_R8G8_TYPELESS:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_UINT:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R8G8_SINT:
+    case DXGI_FORMAT_R16_TYPELESS:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_D16_UNORM:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_B4G4R4A4_UNORM:
+        return { .BytesPerBlock = 2 };
+    case DXGI_FORMAT_R8_TYPELESS:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R8_UINT:
+    case DXGI_FORMAT_R8_SNORM:
+    case DXGI_FORMAT_R8_SINT:
+    case DXGI_FORMAT_A8_UNORM:
+        return { .BytesPerBlock = 1 };
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return { .BytesPerBlock = 8, .BlockSize = 4 };
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return { .BytesPerBlock = 16, .BlockSize = 4 };
+    default:
+        return { };
+    }
 }
 
-#endif
+static TextureFootprints ComputeTextureFootprintsOnCPU(const D3D12_RESOURCE_DESC1& desc)
+{
+    const FormatBlockInfo blockInfo = GetFormatBlockInfo(desc.Format);
+    DXL_ASSERT(blockInfo.BytesPerBlock > 0, "Footprints for format %u can't be computed without a device", uint32_t(desc.Format));
 
-void IDXLCommandList::SetComputeRoot32BitConstant(uint32_t rootParameterIndex, uint32_t srcData, uint32_t destOffsetIn32BitValues)
+    const bool is3D = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+    const uint32_t numMips = std::max<uint32_t>(desc.MipLevels, 1);
+    const uint32_t numSlices = is3D ? 1 : desc.DepthOrArraySize;
+
+    TextureFootprints footprints;
+    for (uint32_t sliceIdx = 0; sliceIdx < numSlices; ++sliceIdx)
+    {
+        for (uint32_t mipIdx = 0; mipIdx < numMips; ++mipIdx)
+        {
+            const uint32_t width = std::max(uint32_t(desc.Width >> mipIdx), 1u);
+            const uint32_t height = std::max(desc.Height >> mipIdx, 1u);
+            const uint32_t depth = is3D ? std::max(uint32_t(desc.DepthOrArraySize) >> mipIdx, 1u) : 1;
+            const uint32_t numRows = (height + blockInfo.BlockSize - 1) / blockInfo.BlockSize;
+            const uint64_t rowSize = uint64_t((width + blockInfo.BlockSize - 1) / blockInfo.BlockSize) * blockInfo.BytesPerBlock;
+            const uint64_t rowPitch = AlignUp(rowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            const uint64_t offset = AlignUp(footprints.TotalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            footprints.Layouts.push_back(
+            {
+                .Offset = offset,
+                .Footprint =
+                {
+                    .Format = desc.Format,
+                    .Width = uint32_t(AlignUp(width, blockInfo.BlockSize)),
+                    .Height = uint32_t(AlignUp(height, blockInfo.BlockSize)),
+                    .Depth = depth,
+                    .RowPitch = uint32_t(rowPitch),
+                },
+            });
+            footprints.NumRows.push_back(numRows);
+            footprints.RowSizes.push_back(rowSize);
+
+            // The last row of the last slice doesn't need the pitch padding
+            footprints.TotalSize = offset + rowPitch * (uint64_t(numRows) * depth - 1) + rowSize;
+        }
+    }
+
+    return footprints;
+}
+
+TextureFootprints ComputeTextureFootprints(IDXLDevice device, const D3D12_RESOURCE_DESC1& desc)
 {
-    ToNative()->SetComputeRoot32BitConstant(rootParameterIndex, srcData, destOffsetIn32BitValues);
+    DXL_ASSERT(desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && desc.Dimension != D3D12_RESOURCE_DIMENSION_UNKNOWN, "Footprints can only be computed for textures");
+
+    if (device == nullptr)
+        return ComputeTextureFootprintsOnCPU(desc);
+
+    D3D12_FEATURE_DATA_FORMAT_INFO formatInfo = { .Format = desc.Format };
+    if (FAILED(device.CheckFeatureSupport(D3D12_FEATURE_FORMAT_INFO, &formatInfo, sizeof(formatInfo))))
+        formatInfo.PlaneCount = 1;
+
+    const uint32_t numSlices = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+    const uint32_t numSubresources = std::max<uint32_t>(desc.MipLevels, 1) * numSlices * std::max<uint32_t>(formatInfo.PlaneCount, 1);
+
+    TextureFootprints footprints;
+    footprints.Layouts.resize(numSubresources);
+    footprints.NumRows.resize(numSubresources);
+    footprints.RowSizes.resize(numSubresources);
+    device.GetCopyableFootprints1(&desc, 0, numSubresources, 0, footprints.Layouts.data(), footprints.NumRows.data(), footprints.RowSizes.data(), &footprints.TotalSize);
+
+    return footprints;
+}
+
+void PackSubresources(void* stagingMemory, const TextureFootprints& footprints, uint32_t firstSubresource, Span<const D3D12_SUBRESOURCE_DATA> subresources)
+{
+    DXL_ASSERT(firstSubresource + subresources.Count <= footprints.Layouts.size(), "Subresources %u through %u are out of range", firstSubresource, firstSubresource + subresources.Count - 1);
+
+    if (subresources.Count == 0)
+        return;
+
+    uint8_t* stagingBase = reinterpret_cast<uint8_t*>(stagingMemory) - footprints.Layouts[firstSubresource].Offset;
+    for (uint32_t i = 0; i < subresources.Count; ++i)
+    {
+        const D3D12_SUBRESOURCE_DATA& src = subresources.Items[i];
+        const uint32_t subresourceIdx = firstSubresource + i;
+        const D3D12_SUBRESOURCE_FOOTPRINT& footprint = footprints.Layouts[subresourceIdx].Footprint;
+        const uint32_t numRows = footprints.NumRows[subresourceIdx];
+        const uint64_t rowSize = footprints.RowSizes[subresourceIdx];
+        const uint64_t dstSlicePitch = uint64_t(footprint.RowPitch) * numRows;
+
+        uint8_t* dstSlice = stagingBase + footprints.Layouts[subresourceIdx].Offset;
+        const uint8_t* srcSlice = reinterpret_cast<const uint8_t*>(src.pData);
+        for (uint32_t z = 0; z < footprint.Depth; ++z)
+        {
+            // Tightly matching pitches can go in one copy, otherwise it's a copy per row
+            if (uint64_t(src.RowPitch) == footprint.RowPitch)
+            {
+                memcpy(dstSlice, srcSlice, size_t(footprint.RowPitch * (numRows - 1) + rowSize));
+            }
+            else
+            {
+                for (uint32_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                    memcpy(dstSlice + uint64_t(footprint.RowPitch) * rowIdx, srcSlice + uint64_t(src.RowPitch) * rowIdx, size_t(rowSize));
+            }
+
+            dstSlice += dstSlicePitch;
+            srcSlice += src.SlicePitch;
+        }
+    }
+}
+
+class TextureUploaderState
+{
+
+public:
+
+    struct HashHasher
+    {
+        size_t operator()(const DXL_HASH128& hash) const { return size_t(hash.Lo); }
+    };
+
+    TextureUploaderParams Params;
+
+    Timeline CopyTimeline;
+    CommandListPool Pool;
+    UploadRing Staging;
+
+    std::mutex FootprintsMutex;
+    std::unordered_map<DXL_HASH128, std::unique_ptr<TextureFootprints>, HashHasher> Footprints;
+
+    // Guards the command list that copies are batched into
+    std::mutex Mutex;
+    PooledCommandList CommandList;
+    uint64_t NumPendingCopies = 0;
+    uint64_t LastSignaled = 0;              // Only used without a device, where uploads complete as soon as they're flushed
+    TextureUploaderStats Stats;
+
+    // Uploads whose copies are recorded but whose data is still being packed without the mutex. The copies can't
+    // be executed until this drops back to zero.
+    uint32_t NumPacking = 0;
+    std::condition_variable PackingDone;
+
+    static DXL_HASH128 HashResourceDesc(const D3D12_RESOURCE_DESC1& desc)
+    {
+        HashBuilder hash;
+        hash.AddValue(desc.Dimension);
+        hash.AddValue(desc.Width);
+        hash.AddValue(desc.Height);
+        hash.AddValue(desc.DepthOrArraySize);
+        hash.AddValue(desc.MipLevels);
+        hash.AddValue(desc.Format);
+        hash.AddValue(desc.SampleDesc.Count);
+        hash.AddValue(desc.SampleDesc.Quality);
+        hash.AddValue(desc.Layout);
+        return hash.Finalize();
+    }
+
+    const TextureFootprints& GetFootprints(const D3D12_RESOURCE_DESC1& desc)
+    {
+        const DXL_HASH128 hash = HashResourceDesc(desc);
+
+        std::lock_guard<std::mutex> lock(FootprintsMutex);
+        std::unique_ptr<TextureFootprints>& footprints = Footprints[hash];
+        if (footprints == nullptr)
+            footprints = std::make_unique<TextureFootprints>(ComputeTextureFootprints(Params.Device, desc));
+
+        return *footprints;
+    }
+
+    uint64_t GetNextFenceValue() const
+    {
+        return (Params.Device ? CopyTimeline.GetLastSignaled() : LastSignaled) + 1;
+    }
+
+    // The mutex needs to be locked by the caller, and gets unlocked while waiting for other threads to finish packing
+    uint64_t Flush(std::unique_lock<std::mutex>& lock)
+    {
+        PackingDone.wait(lock, [this]() { return NumPacking == 0; });
+        if (NumPendingCopies == 0)
+            return GetNextFenceValue() - 1;
+
+        uint64_t fenceValue = 0;
+        if (Params.Device)
+        {
+            DXL_HANDLE_HRESULT(CommandList.CommandList.Close());
+
+            ID3D12CommandList* nativeList = CommandList.CommandList.ToNative();
+            Params.CopyQueue.ExecuteCommandLists(1, &nativeList);
+            fenceValue = CopyTimeline.Signal();
+
+            Pool.Submit(CommandList, fenceValue, NumPendingCopies);
+            Staging.Retire(fenceValue);
+        }
+        else
+        {
+            fenceValue = ++LastSignaled;
+            Staging.Retire(fenceValue);
+            Staging.ReleaseCompleted(fenceValue);
+        }
+
+        CommandList = { };
+        NumPendingCopies = 0;
+        Stats.NumFlushes += 1;
+
+        return fenceValue;
+    }
+
+    // Allocates staging memory, flushing the pending copies and trying again if the ring is full of them. The mutex
+    // needs to be locked by the caller.
+    UploadAllocation AllocateStaging(std::unique_lock<std::mutex>& lock, uint64_t size)
+    {
+        UploadAllocation allocation = Staging.Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        if (allocation.IsValid() == false && (NumPendingCopies > 0 || NumPacking > 0))
+        {
+            Flush(lock);
+            allocation = Staging.Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        }
+
+        return allocation;
+    }
+
+    // The mutex needs to be locked by the caller
+    void RecordCopies(IDXLResource dstTexture, const TextureFootprints& footprints, uint32_t firstSubresource, uint32_t numSubresources, const UploadAllocation& allocation)
+    {
+        if (Params.Device && CommandList.IsValid() == false)
+            CommandList = Pool.Acquire(D3D12_COMMAND_LIST_TYPE_COPY);
+
+        const uint64_t baseOffset = footprints.Layouts[firstSubresource].Offset;
+        for (uint32_t subresourceIdx = firstSubresource; subresourceIdx < firstSubresource + numSubresources; ++subresourceIdx)
+        {
+            if (Params.Device)
+            {
+                D3D12_TEXTURE_COPY_LOCATION dst = { .pResource = dstTexture, .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX };
+                dst.SubresourceIndex = subresourceIdx;
+
+                D3D12_TEXTURE_COPY_LOCATION src = { .pResource = allocation.Resource, .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT };
+                src.PlacedFootprint = footprints.Layouts[subresourceIdx];
+                src.PlacedFootprint.Offset += allocation.Offset - baseOffset;
+
+                CommandList.CommandList.CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+            }
+
+            NumPendingCopies += 1;
+        }
+    }
+
+    static uint64_t GetRangeSize(const TextureFootprints& footprints, uint32_t firstSubresource, uint32_t numSubresources)
+    {
+        const uint32_t lastSubresource = firstSubresource + numSubresources - 1;
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& lastLayout = footprints.Layouts[lastSubresource];
+        const uint64_t lastSize = uint64_t(lastLayout.Footprint.RowPitch) * footprints.NumRows[lastSubresource] * lastLayout.Footprint.Depth;
+        return lastLayout.Offset + lastSize - footprints.Layouts[firstSubresource].Offset;
+    }
+};
+
+TextureUploader::TextureUploader() = default;
+
+TextureUploader::~TextureUploader()
+{
+    Shutdown();
+}
+
+void TextureUploader::Initialize(TextureUploaderParams params)
+{
+    DXL_ASSERT(state == nullptr, "TextureUploader is already initialized");
+    DXL_ASSERT(params.Device == nullptr || params.CopyQueue, "TextureUploader needs a copy queue when it has a device");
+
+    state = std::make_unique<TextureUploaderState>();
+    state->Params = params;
+
+    if (params.Device)
+    {
+        state->CopyTimeline.Initialize({ .Device = params.Device, .Queue = params.CopyQueue });
+        state->Pool.Initialize({ .Device = params.Device, .Fence = state->CopyTimeline.GetFence() });
+        state->Staging.Initialize({ .Device = params.Device, .Fence = state->CopyTimeline.GetFence(), .Size = params.StagingSize });
+    }
+    else
+    {
+        state->Staging.Initialize({ .Size = params.StagingSize });
+    }
+}
+
+void TextureUploader::Shutdown()
+{
+    if (state == nullptr)
+        return;
+
+    // Everything needs to be off the GPU before the staging ring and command allocators go away
+    {
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->Flush(lock);
+    }
+
+    if (state->Params.Device)
+        state->CopyTimeline.WaitForIdle();
+
+    state->Staging.Shutdown();
+    state->Pool.Shutdown();
+    state->CopyTimeline.Shutdown();
+
+    state.reset();
 }
 
-void IDXLCommandList::SetGraphicsRoot32BitConstant(uint32_t rootParameterIndex, uint32_t srcData, uint32_t destOffsetIn32BitValues)
-{
-    ToNative()->SetGraphicsRoot32BitConstant(rootParameterIndex, srcData, destOffsetIn32BitValues);
+uint64_t TextureUploader::Upload(IDXLResource dstTexture, const D3D12_RESOURCE_DESC1& desc, Span<const D3D12_SUBRESOURCE_DATA> subresources, uint32_t firstSubresource)
+{
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
+    DXL_TRACE_SCOPE("TextureUploader::Upload");
+
+    const TextureFootprints& footprints = state->GetFootprints(desc);
+    DXL_ASSERT(firstSubresource + subresources.Count <= footprints.Layouts.size(), "Subresources %u through %u are out of range", firstSubresource, firstSubresource + subresources.Count - 1);
+
+    if (subresources.Count == 0)
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        return state->GetNextFenceValue();
+    }
+
+    // Subresources can be split across staging allocations, but each one has to fit in the ring on its own
+    for (uint32_t i = 0; i < subresources.Count; ++i)
+    {
+        const uint64_t size = TextureUploaderState::GetRangeSize(footprints, firstSubresource + i, 1);
+        if (size > state->Params.StagingSize)
+        {
+            DXL_ERROR(E_INVALIDARG, MakeString("Subresource %u needs %llu bytes, which doesn't fit in the %llu byte staging ring", firstSubresource + i, size, state->Params.StagingSize).c_str());
+            return 0;
+        }
+    }
+
+    // Everything goes in one staging allocation when it fits, otherwise the subresources are split up so that each
+    // can be flushed on its own
+    const uint64_t totalSize = TextureUploaderState::GetRangeSize(footprints, firstSubresource, subresources.Count);
+    const uint32_t subresourcesPerAllocation = totalSize <= state->Params.StagingSize ? subresources.Count : 1;
+
+    uint64_t fenceValue = 0;
+    for (uint32_t i = 0; i < subresources.Count; i += subresourcesPerAllocation)
+    {
+        const uint32_t subresourceIdx = firstSubresource + i;
+        const uint64_t size = TextureUploaderState::GetRangeSize(footprints, subresourceIdx, subresourcesPerAllocation);
+
+        UploadAllocation allocation;
+        {
+            std::unique_lock<std::mutex> lock(state->Mutex);
+            allocation = state->AllocateStaging(lock, size);
+            if (allocation.IsValid() == false)
+            {
+                DXL_ERROR(E_OUTOFMEMORY, MakeString("Failed to allocate %llu bytes of staging memory for subresource %u", size, subresourceIdx).c_str());
+                return 0;
+            }
+
+            // The copies only read the staging memory once they're flushed, which waits for the packing below
+            state->RecordCopies(dstTexture, footprints, subresourceIdx, subresourcesPerAllocation, allocation);
+            state->NumPacking += 1;
+            fenceValue = state->GetNextFenceValue();
+        }
+
+        // Packing is where the time goes, so it happens without the mutex to let other threads record their uploads
+        PackSubresources(allocation.CPUAddress, footprints, subresourceIdx, Span<const D3D12_SUBRESOURCE_DATA>(subresourcesPerAllocation, &subresources.Items[i]));
+
+        {
+            std::lock_guard<std::mutex> lock(state->Mutex);
+            state->NumPacking -= 1;
+        }
+
+        state->PackingDone.notify_all();
+    }
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->Stats.NumUploads += 1;
+    state->Stats.NumSubresources += subresources.Count;
+    state->Stats.NumBytes += totalSize;
+
+    return fenceValue;
 }
 
-void IDXLCommandList::SetComputeRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValuesToSet, const void* srcData, uint32_t destOffsetIn32BitValues)
+uint64_t TextureUploader::Flush()
 {
-    ToNative()->SetComputeRoot32BitConstants(rootParameterIndex, num32BitValuesToSet, srcData, destOffsetIn32BitValues);
-}
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
 
-void IDXLCommandList::SetGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValuesToSet, const void* srcData, uint32_t destOffsetIn32BitValues)
-{
-    ToNative()->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValuesToSet, srcData, destOffsetIn32BitValues);
+    std::unique_lock<std::mutex> lock(state->Mutex);
+    return state->Flush(lock);
 }
 
-void IDXLCommandList::SetComputeRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+void TextureUploader::QueueWait(IDXLCommandQueue queue, uint64_t fenceValue)
 {
-    ToNative()->SetComputeRootConstantBufferView(rootParameterIndex, bufferLocation);
-}
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
 
-void IDXLCommandList::SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
-{
-    ToNative()->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
-}
+    if (state->Params.Device == nullptr)
+        return;
 
-void IDXLCommandList::SetComputeRootShaderResourceView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
-{
-    ToNative()->SetComputeRootShaderResourceView(rootParameterIndex, bufferLocation);
+    DXL_ASSERT(fenceValue <= state->CopyTimeline.GetLastSignaled(), "Fence value %llu hasn't been flushed yet, so the queue would wait forever", fenceValue);
+    DXL_HANDLE_HRESULT(queue.Wait(state->CopyTimeline.GetFence(), fenceValue));
 }
 
-void IDXLCommandList::SetGraphicsRootShaderResourceView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+bool TextureUploader::IsComplete(uint64_t fenceValue)
 {
-    ToNative()->SetGraphicsRootShaderResourceView(rootParameterIndex, bufferLocation);
-}
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
 
-void IDXLCommandList::SetComputeRootUnorderedAccessView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
-{
-    ToNative()->SetComputeRootUnorderedAccessView(rootParameterIndex, bufferLocation);
-}
+    if (state->Params.Device == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        return fenceValue <= state->LastSignaled;
+    }
 
-void IDXLCommandList::SetGraphicsRootUnorderedAccessView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
-{
-    ToNative()->SetGraphicsRootUnorderedAccessView(rootParameterIndex, bufferLocation);
+    return state->CopyTimeline.IsComplete(fenceValue);
 }
 
-void IDXLCommandList::OMSetRenderTargets(uint32_t numRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargetDescriptors, bool rtIsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencilDescriptor)
+void TextureUploader::WaitForIdle()
 {
-    ToNative()->OMSetRenderTargets(numRenderTargetDescriptors, renderTargetDescriptors, rtIsSingleHandleToDescriptorRange, depthStencilDescriptor);
-}
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
 
-void IDXLCommandList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,float depth, uint8_t stencil, uint32_t numRects, const D3D12_RECT* rects)
-{
-    ToNative()->ClearDepthStencilView(depthStencilView, clearFlags, depth, stencil, numRects, rects);
-}
+    {
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->Flush(lock);
+    }
 
-void IDXLCommandList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const float colorRGBA[4], uint32_t numRects, const D3D12_RECT* rects)
-{
-    ToNative()->ClearRenderTargetView(renderTargetView, colorRGBA, numRects, rects);
+    if (state->Params.Device)
+        state->CopyTimeline.WaitForIdle();
 }
 
-void IDXLCommandList::DiscardResource(IDXLResource resource, const D3D12_DISCARD_REGION* region)
+const TextureFootprints& TextureUploader::GetFootprints(const D3D12_RESOURCE_DESC1& desc)
 {
-    ToNative()->DiscardResource(resource, region);
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
+    return state->GetFootprints(desc);
 }
 
-void IDXLCommandList::BeginRenderPass(uint32_t numRenderTargets, const D3D12_RENDER_PASS_RENDER_TARGET_DESC* renderTargets, const D3D12_RENDER_PASS_DEPTH_STENCIL_DESC* depthStencil, D3D12_RENDER_PASS_FLAGS flags)
+TextureUploaderStats TextureUploader::GetStats() const
 {
-    ToNative()->BeginRenderPass(numRenderTargets, renderTargets, depthStencil, flags);
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
+
+    TextureUploaderStats stats;
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        stats = state->Stats;
+    }
+
+    std::lock_guard<std::mutex> lock(state->FootprintsMutex);
+    stats.NumCachedFootprints = uint32_t(state->Footprints.size());
+    return stats;
 }
 
-void IDXLCommandList::EndRenderPass()
+IDXLFence TextureUploader::GetFence() const
 {
-    ToNative()->EndRenderPass();
+    DXL_ASSERT(state != nullptr, "TextureUploader isn't initialized");
+    return state->Params.Device ? state->CopyTimeline.GetFence() : IDXLFence();
 }
 
-#if DXL_ENABLE_CLEAR_UAV
+// == ReadbackManager =====================================================
 
-void IDXLCommandList::ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE viewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE viewCPUHandle, IDXLResource resource, const uint32_t values[4], uint32_t numRects, const D3D12_RECT* rects)
+class ReadbackManagerState
 {
-    ToNative()->ClearUnorderedAccessViewUint(viewGPUHandleInCurrentHeap, viewCPUHandle, resource, values, numRects, rects);
-}
 
-void IDXLCommandList::ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE viewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE viewCPUHandle, IDXLResource resource, const float values[4], uint32_t numRects, const D3D12_RECT* rects)
-{
-    ToNative()->ClearUnorderedAccessViewFloat(viewGPUHandleInCurrentHeap, viewCPUHandle, resource, values, numRects, rects);
-}
+public:
 
-#endif
+    struct Buffer
+    {
+        IDXLResource Resource;
+        std::unique_ptr<uint8_t[]> CPUMemory;
+        const uint8_t* CPUAddress = nullptr;
+        uint64_t Size = 0;
+    };
 
-void IDXLCommandList::BeginQuery(IDXLQueryHeap queryHeap, D3D12_QUERY_TYPE type, uint32_t index)
-{
-    ToNative()->BeginQuery(queryHeap, type, index);
-}
+    enum class RequestStatus
+    {
+        Recorded,
+        Submitted,
+        Completing,                         // Waiting for the callback to run, or running it
+        Ready,
+    };
 
-void IDXLCommandList::EndQuery(IDXLQueryHeap queryHeap, D3D12_QUERY_TYPE type, uint32_t index)
-{
-    ToNative()->EndQuery(queryHeap, type, index);
-}
+    struct Request
+    {
+        RequestStatus Status = RequestStatus::Recorded;
+        uint64_t FenceValue = 0;
+        bool Discarded = false;
+        Buffer ReadbackBuffer;
+        ReadbackData Data;
+        ReadbackCallback Callback;
+    };
 
-void IDXLCommandList::ResolveQueryData(IDXLQueryHeap queryHeap, D3D12_QUERY_TYPE type, uint32_t startIndex, uint32_t numQueries, IDXLResource destinationBuffer, uint64_t alignedDestinationBufferOffset)
-{
-    ToNative()->ResolveQueryData(queryHeap, type, startIndex, numQueries, destinationBuffer, alignedDestinationBufferOffset);
-}
+    ReadbackManagerParams Params;
 
-void IDXLCommandList::SetPredication(IDXLResource buffer, uint64_t alignedBufferOffset, D3D12_PREDICATION_OP operation)
-{
-    ToNative()->SetPredication(buffer, alignedBufferOffset, operation);
-}
+    mutable std::mutex Mutex;
+    std::unordered_map<uint64_t, Request> Requests;
+    std::vector<uint64_t> RecordedTickets;
+    std::deque<uint64_t> SubmittedTickets;  // In the order that they were submitted, so also in fence value order
+    uint64_t NextTicket = 1;
 
-void IDXLCommandList::ExecuteIndirect(IDXLCommandSignature commandSignature, uint32_t maxCommandCount, IDXLResource argumentBuffer, uint64_t argumentBufferOffset, IDXLResource countBuffer, uint64_t countBufferOffset)
-{
-    ToNative()->ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset, countBuffer, countBufferOffset);
-}
+    std::unordered_map<uint64_t, std::vector<Buffer>> FreeBuffers;
+    uint32_t NumBuffers = 0;
+    uint64_t NumBytesAllocated = 0;
 
-void IDXLCommandList::AtomicCopyBufferUINT(ID3D12Resource* dstBuffer, uint64_t dstOffset, ID3D12Resource* srcBuffer, uint64_t srcOffset, uint32_t dependencies, ID3D12Resource*const* dependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* dependentSubresourceRanges)
-{
-    ToNative()->AtomicCopyBufferUINT(dstBuffer, dstOffset, srcBuffer, srcOffset, dependencies, dependentResources, dependentSubresourceRanges);
-}
+    std::thread WorkerThread;
+    std::condition_variable WorkerWake;
+    std::condition_variable CallbacksDone;
+    std::deque<uint64_t> CallbackTickets;
+    uint32_t NumRunningCallbacks = 0;
+    bool ShuttingDown = false;
 
-// UINT64 is only valid on UMA architectures
-void IDXLCommandList::AtomicCopyBufferUINT64(IDXLResource dstBuffer, uint64_t dstOffset, IDXLResource srcBuffer, uint64_t srcOffset, uint32_t dependencies, ID3D12Resource*const* dependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* dependentSubresourceRanges)
-{
-    ToNative()->AtomicCopyBufferUINT64(dstBuffer, dstOffset, srcBuffer, srcOffset, dependencies, dependentResources, dependentSubresourceRanges);
-}
+    // The mutex needs to be locked by the caller
+    Buffer AcquireBuffer(uint64_t size)
+    {
+        const uint64_t bufferSize = std::bit_ceil(std::max(size, Params.MinBufferSize));
+        std::vector<Buffer>& freeBuffers = FreeBuffers[bufferSize];
+        if (freeBuffers.size() > 0)
+        {
+            Buffer buffer = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+            return buffer;
+        }
 
-void IDXLCommandList::OMSetDepthBounds(float min, float max)
-{
-    ToNative()->OMSetDepthBounds(min, max);
-}
+        Buffer buffer;
+        buffer.Size = bufferSize;
+        if (Params.Device)
+        {
+            const D3D12_HEAP_PROPERTIES heapProperties = { .Type = D3D12_HEAP_TYPE_READBACK };
+            const D3D12_RESOURCE_DESC1 desc =
+            {
+                .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+                .Width = bufferSize,
+                .Height = 1,
+                .DepthOrArraySize = 1,
+                .MipLevels = 1,
+                .SampleDesc = { .Count = 1 },
+                .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+            };
+            buffer.Resource = Params.Device.CreateCommittedResource(heapProperties, D3D12_HEAP_FLAG_NONE, desc);
+
+            // Readback buffers can stay mapped, the CPU just can't read a range while the GPU is writing to it
+            void* mappedData = nullptr;
+            DXL_HANDLE_HRESULT(buffer.Resource.Map(0, nullptr, &mappedData));
+            buffer.CPUAddress = reinterpret_cast<const uint8_t*>(mappedData);
+        }
+        else
+        {
+            buffer.CPUMemory = std::make_unique<uint8_t[]>(size_t(bufferSize));
+            buffer.CPUAddress = buffer.CPUMemory.get();
+        }
 
-void IDXLCommandList::SetSamplePositions(uint32_t numSamplesPerPixel, uint32_t numPixels, D3D12_SAMPLE_POSITION* samplePositions)
-{
-    ToNative()->SetSamplePositions(numSamplesPerPixel, numPixels, samplePositions);
-}
+        NumBuffers += 1;
+        NumBytesAllocated += bufferSize;
 
-void IDXLCommandList::ResolveSubresourceRegion(IDXLResource dstResource, uint32_t dstSubresource, uint32_t dstX, uint32_t dstY, IDXLResource srcResource, uint32_t srcSubresource, D3D12_RECT* srcRect, DXGI_FORMAT format, D3D12_RESOLVE_MODE resolveMode)
-{
-    ToNative()->ResolveSubresourceRegion(dstResource, dstSubresource, dstX, dstY, srcResource, srcSubresource, srcRect, format, resolveMode);
-}
+        return buffer;
+    }
 
-#if DXL_ENABLE_VIEW_INSTANCING
-void IDXLCommandList::SetViewInstanceMask(uint32_t mask)
-{
-    ToNative()->SetViewInstanceMask(mask);
-}
-#endif
+    // The mutex needs to be locked by the caller
+    void FreeBuffer(Buffer& buffer)
+    {
+        std::vector<Buffer>& freeBuffers = FreeBuffers[buffer.Size];
+        if (freeBuffers.size() < Params.MaxFreeBuffersPerSize)
+        {
+            freeBuffers.push_back(std::move(buffer));
+            return;
+        }
 
-void IDXLCommandList::WriteBufferImmediate(uint32_t count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER* params, const D3D12_WRITEBUFFERIMMEDIATE_MODE* modes)
-{
-    ToNative()->WriteBufferImmediate(count, params, modes);
-}
+        DestroyBuffer(buffer);
+    }
 
-void IDXLCommandList::BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* desc, uint32_t numPostbuildInfoDescs, const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* postbuildInfoDescs)
-{
-    ToNative()->BuildRaytracingAccelerationStructure(desc, numPostbuildInfoDescs, postbuildInfoDescs);
-}
+    // The mutex needs to be locked by the caller
+    void DestroyBuffer(Buffer& buffer)
+    {
+        if (buffer.Resource)
+        {
+            const D3D12_RANGE writtenRange = { };
+            buffer.Resource.Unmap(0, &writtenRange);
+            Release(buffer.Resource);
+        }
 
-void IDXLCommandList::EmitRaytracingAccelerationStructurePostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* desc, uint32_t numSourceAccelerationStructures, const D3D12_GPU_VIRTUAL_ADDRESS* sourceAccelerationStructureData)
-{
-    ToNative()->EmitRaytracingAccelerationStructurePostbuildInfo(desc, numSourceAccelerationStructures, sourceAccelerationStructureData);
-}
+        NumBuffers -= 1;
+        NumBytesAllocated -= buffer.Size;
+        buffer = { };
+    }
 
-void IDXLCommandList::CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS destAccelerationStructureData, D3D12_GPU_VIRTUAL_ADDRESS sourceAccelerationStructureData, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode)
-{
-    ToNative()->CopyRaytracingAccelerationStructure(destAccelerationStructureData, sourceAccelerationStructureData, mode);
-}
+    // The mutex needs to be locked by the caller
+    uint64_t AddRequest(Buffer&& buffer, const ReadbackData& data, ReadbackCallback&& callback)
+    {
+        const uint64_t ticket = NextTicket++;
 
-// == IDXLCommandQueue ======================================================
+        Request& request = Requests[ticket];
+        request.ReadbackBuffer = std::move(buffer);
+        request.Data = data;
+        request.Data.Ticket = ticket;
+        request.Data.Data = request.ReadbackBuffer.CPUAddress;
+        request.Callback = std::move(callback);
 
-void IDXLCommandQueue::UpdateTileMappings(IDXLResource resource, uint32_t numResourceRegions, const D3D12_TILED_RESOURCE_COORDINATE* resourceRegionStartCoordinates, const D3D12_TILE_REGION_SIZE* resourceRegionSizes, ID3D12Heap* pHeap, uint32_t numRanges, const D3D12_TILE_RANGE_FLAGS* rangeFlags, const uint32_t* heapRangeStartOffsets, const uint32_t* rangeTileCounts, D3D12_TILE_MAPPING_FLAGS flags)
-{
-    ToNative()->UpdateTileMappings(resource, numResourceRegions, resourceRegionStartCoordinates, resourceRegionSizes, pHeap, numRanges, rangeFlags, heapRangeStartOffsets, rangeTileCounts, flags);
-}
+        RecordedTickets.push_back(ticket);
 
-void IDXLCommandQueue::CopyTileMappings(IDXLResource dstResource, const D3D12_TILED_RESOURCE_COORDINATE* dstRegionStartCoordinate, IDXLResource srcResource, const D3D12_TILED_RESOURCE_COORDINATE* srcRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* regionSize, D3D12_TILE_MAPPING_FLAGS flags)
-{
-    ToNative()->CopyTileMappings(dstResource, dstRegionStartCoordinate, srcResource, srcRegionStartCoordinate, regionSize, flags);
-}
+        return ticket;
+    }
 
-void IDXLCommandQueue::ExecuteCommandLists(uint32_t numCommandLists, ID3D12CommandList*const* commandLists)
-{
-    ToNative()->ExecuteCommandLists(numCommandLists, commandLists);
-}
+    // Runs the request's callback with the mutex unlocked, and frees it afterwards
+    void RunCallback(std::unique_lock<std::mutex>& lock, uint64_t ticket)
+    {
+        Request& request = Requests.at(ticket);
+        if (request.Discarded == false)
+        {
+            const ReadbackData data = request.Data;
+            ReadbackCallback callback = std::move(request.Callback);
 
-HRESULT IDXLCommandQueue::Signal(IDXLFence fence, uint64_t value)
-{
-    return ToNative()->Signal(fence, value);
-}
+            lock.unlock();
+            callback(data);
+            lock.lock();
+        }
 
-HRESULT IDXLCommandQueue::Wait(IDXLFence fence, uint64_t value)
-{
-    return ToNative()->Wait(fence, value);
-}
+        // Discard can't remove a request while its callback is running, so this is still the same one
+        FreeRequest(ticket);
+    }
 
-HRESULT IDXLCommandQueue::GetTimestampFrequency(uint64_t* outFrequency) const
-{
-    return ToNative()->GetTimestampFrequency(outFrequency);
-}
+    // The mutex needs to be locked by the caller
+    void FreeRequest(uint64_t ticket)
+    {
+        auto iter = Requests.find(ticket);
+        FreeBuffer(iter->second.ReadbackBuffer);
+        Requests.erase(iter);
+    }
 
-HRESULT IDXLCommandQueue::GetClockCalibration(uint64_t* outGpuTimestamp, uint64_t* outCpuTimestamp) const
-{
-    return ToNative()->GetClockCalibration(outGpuTimestamp, outCpuTimestamp);
-}
+    // Returns the tickets whose callbacks need to run on the calling thread
+    std::vector<uint64_t> ProcessCompleted(uint64_t completedValue)
+    {
+        std::vector<uint64_t> callbackTickets;
+        while (SubmittedTickets.size() > 0)
+        {
+            const uint64_t ticket = SubmittedTickets.front();
+            Request& request = Requests.at(ticket);
+            if (request.FenceValue > completedValue)
+                break;
 
-D3D12_COMMAND_QUEUE_DESC IDXLCommandQueue::GetDesc() const
-{
-    return ToNative()->GetDesc();
-}
+            SubmittedTickets.pop_front();
 
-/*HRESULT IDXLCommandQueue::SetProcessPriority(D3D12_COMMAND_QUEUE_PROCESS_PRIORITY priority)
-{
-    return ToNative()->SetProcessPriority(priority);
-}
+            if (request.Discarded)
+            {
+                FreeRequest(ticket);
+            }
+            else if (request.Callback)
+            {
+                request.Status = RequestStatus::Completing;
+                if (WorkerThread.joinable())
+                    CallbackTickets.push_back(ticket);
+                else
+                    callbackTickets.push_back(ticket);
+            }
+            else
+            {
+                request.Status = RequestStatus::Ready;
+            }
+        }
 
-HRESULT IDXLCommandQueue::GetProcessPriority(D3D12_COMMAND_QUEUE_PROCESS_PRIORITY* outValue)
-{
-    return ToNative()->GetProcessPriority(outValue);
-}
+        if (CallbackTickets.size() > 0)
+            WorkerWake.notify_one();
 
-HRESULT IDXLCommandQueue::SetGlobalPriority(D3D12_COMMAND_QUEUE_GLOBAL_PRIORITY priority)
-{
-    return ToNative()->SetGlobalPriority(priority);
-}
+        return callbackTickets;
+    }
 
-HRESULT IDXLCommandQueue::GetGlobalPriority(D3D12_COMMAND_QUEUE_GLOBAL_PRIORITY* outValue)
-{
-    return ToNative()->GetGlobalPriority(outValue);
-}*/
+    void WorkerThreadFunction()
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+        while (true)
+        {
+            WorkerWake.wait(lock, [this]() { return ShuttingDown || CallbackTickets.size() > 0; });
+            if (CallbackTickets.empty())
+                break;
 
-// == IDXLDevice ======================================================
+            const uint64_t ticket = CallbackTickets.front();
+            CallbackTickets.pop_front();
 
-uint32_t IDXLDevice::GetNodeCount()
-{
-    return ToNative()->GetNodeCount();
-}
+            NumRunningCallbacks += 1;
+            RunCallback(lock, ticket);
+            NumRunningCallbacks -= 1;
 
-LUID IDXLDevice::GetAdapterLuid()
+            if (CallbackTickets.empty() && NumRunningCallbacks == 0)
+                CallbacksDone.notify_all();
+        }
+    }
+};
+
+ReadbackManager::ReadbackManager() = default;
+
+ReadbackManager::~ReadbackManager()
 {
-    return ToNative()->GetAdapterLuid();
+    Shutdown();
 }
 
-HRESULT IDXLDevice::CheckFeatureSupport(D3D12_FEATURE feature, void* featureSupportData, uint32_t featureSupportDataSize)
+void ReadbackManager::Initialize(ReadbackManagerParams params)
 {
-    return ToNative()->CheckFeatureSupport(feature, featureSupportData, featureSupportDataSize);
+    DXL_ASSERT(state == nullptr, "ReadbackManager is already initialized");
+
+    params.MinBufferSize = std::bit_ceil(std::max<uint64_t>(params.MinBufferSize, 1));
+
+    state = std::make_unique<ReadbackManagerState>();
+    state->Params = params;
+
+    if (params.StartWorkerThread)
+        state->WorkerThread = std::thread(&ReadbackManagerState::WorkerThreadFunction, state.get());
 }
 
-HRESULT IDXLDevice::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* desc, REFIID riid, void** outCommandQueue)
+void ReadbackManager::Shutdown()
 {
-    return ToNative()->CreateCommandQueue(desc, riid, outCommandQueue);
-}
+    if (state == nullptr)
+        return;
+
+    // The worker drains the callback queue before it exits
+    if (state->WorkerThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->Mutex);
+            state->ShuttingDown = true;
+        }
+
+        state->WorkerWake.notify_all();
+        state->WorkerThread.join();
+    }
+
+    // The GPU might still be copying into the buffers of submitted requests, so they can't be destroyed until the
+    // fence passes the last submitted value
+    const uint64_t lastSubmittedValue = state->SubmittedTickets.empty() ? 0 : state->Requests.at(state->SubmittedTickets.back()).FenceValue;
+    if (state->Params.Fence && lastSubmittedValue > 0)
+        DXL_HANDLE_HRESULT(state->Params.Fence.SetEventOnCompletion(lastSubmittedValue, nullptr));
+
+    {
+        std::lock_guard<std::mutex> lock(state->Mutex);
+        for (auto& [ticket, request] : state->Requests)
+            state->DestroyBuffer(request.ReadbackBuffer);
+
+        for (auto& [size, freeBuffers] : state->FreeBuffers)
+        {
+            for (ReadbackManagerState::Buffer& buffer : freeBuffers)
+                state->DestroyBuffer(buffer);
+        }
+    }
 
-HRESULT IDXLDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** outCommandAllocator)
-{
-    return ToNative()->CreateCommandAllocator(type, riid, outCommandAllocator);
+    state.reset();
 }
 
-HRESULT IDXLDevice::CreateCommandList1(uint32_t nodeMask, D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags, REFIID riid, void** outCommandList)
+uint64_t ReadbackManager::ReadBuffer(IDXLCommandList commandList, IDXLResource srcBuffer, uint64_t srcOffset, uint64_t size, ReadbackCallback callback)
 {
-    return ToNative()->CreateCommandList1(nodeMask, type, flags, riid, outCommandList);
-}
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
+    DXL_ASSERT(size > 0, "Readbacks can't be empty");
 
-#if DXL_ENABLE_EXTENSIONS
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    ReadbackManagerState::Buffer buffer = state->AcquireBuffer(size);
 
-IDXLCommandQueue IDXLDevice::CreateCommandQueue(D3D12_COMMAND_QUEUE_DESC desc)
-{
-    IDXLCommandQueue commandQueue;
-    DXL_HANDLE_HRESULT(ToNative()->CreateCommandQueue(&desc, DXL_PPV_ARGS(&commandQueue)));
-    return commandQueue;
-}
+    if (commandList)
+        commandList.CopyBufferRegion(buffer.Resource, 0, srcBuffer, srcOffset, size);
 
-IDXLCommandAllocator IDXLDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type)
-{
-    IDXLCommandAllocator commandAllocator;
-    DXL_HANDLE_HRESULT(ToNative()->CreateCommandAllocator(type, DXL_PPV_ARGS(&commandAllocator)));
-    return commandAllocator;
+    return state->AddRequest(std::move(buffer), { .Size = size }, std::move(callback));
 }
 
-IDXLCommandList IDXLDevice::CreateCommandList(D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags)
+uint64_t ReadbackManager::ReadTexture(IDXLCommandList commandList, IDXLResource srcTexture, const D3D12_RESOURCE_DESC1& desc, uint32_t subresource, ReadbackCallback callback)
 {
-    IDXLCommandList commandList;
-    DXL_HANDLE_HRESULT(ToNative()->CreateCommandList1(0, type, flags, DXL_PPV_ARGS(&commandList)));
-    return commandList;
-}
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
 
-#endif // DXL_ENABLE_EXTENSIONS
+    // Only the one subresource is needed, so its footprint gets rebased to the start of the readback buffer
+    const TextureFootprints footprints = ComputeTextureFootprints(state->Params.Device, desc);
+    DXL_ASSERT(subresource < footprints.Layouts.size(), "Subresource %u is out of range", subresource);
 
-HRESULT IDXLDevice::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, REFIID riid, void** outPipelineState)
-{
-    return ToNative()->CreateComputePipelineState(desc, riid, outPipelineState);
-}
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = footprints.Layouts[subresource];
+    layout.Offset = 0;
 
-HRESULT IDXLDevice::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* desc, REFIID riid, void** outPipelineState)
-{
-    return ToNative()->CreatePipelineState(desc, riid, outPipelineState);
-}
+    const uint32_t numRows = footprints.NumRows[subresource];
+    const uint64_t rowSize = footprints.RowSizes[subresource];
+    const uint64_t size = uint64_t(layout.Footprint.RowPitch) * (uint64_t(numRows) * layout.Footprint.Depth - 1) + rowSize;
 
-HRESULT IDXLDevice::CreateStateObject(const D3D12_STATE_OBJECT_DESC* desc, REFIID riid, void** outStateObject)
-{
-    return ToNative()->CreateStateObject(desc, riid, outStateObject);
-}
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    ReadbackManagerState::Buffer buffer = state->AcquireBuffer(size);
 
-HRESULT IDXLDevice::AddToStateObject(const D3D12_STATE_OBJECT_DESC* addition, IDXLStateObject stateObjectToGrowFrom, REFIID riid, void** outNewStateObject)
-{
-    return ToNative()->AddToStateObject(addition, stateObjectToGrowFrom, riid, outNewStateObject);
-}
+    if (commandList)
+    {
+        D3D12_TEXTURE_COPY_LOCATION dst = { .pResource = buffer.Resource, .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT };
+        dst.PlacedFootprint = layout;
 
-#if DXL_ENABLE_EXTENSIONS
+        D3D12_TEXTURE_COPY_LOCATION src = { .pResource = srcTexture, .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX };
+        src.SubresourceIndex = subresource;
 
-IDXLPipelineState IDXLDevice::CreateComputePSO(D3D12_COMPUTE_PIPELINE_STATE_DESC desc)
-{
-    IDXLPipelineState pso;
-    DXL_HANDLE_HRESULT(ToNative()->CreateComputePipelineState(&desc, DXL_PPV_ARGS(&pso)));
-    return pso;
-}
+        commandList.CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    }
 
-IDXLPipelineState IDXLDevice::CreateComputePSO(IDXLRootSignature rootSignature, const void* byteCode, size_t byteCodeLength)
-{
-    return CreateComputePSO({ .pRootSignature = rootSignature, .CS = { byteCode, byteCodeLength } });
+    const ReadbackData data =
+    {
+        .Size = size,
+        .Footprint = layout.Footprint,
+        .NumRows = numRows,
+        .RowSize = rowSize,
+    };
+
+    return state->AddRequest(std::move(buffer), data, std::move(callback));
 }
 
-IDXLPipelineState IDXLDevice::CreateGraphicsPSO(D3D12_PIPELINE_STATE_STREAM_DESC desc)
+void ReadbackManager::Submit(uint64_t fenceValue)
 {
-    IDXLPipelineState pso;
-    DXL_HANDLE_HRESULT(ToNative()->CreatePipelineState(&desc, DXL_PPV_ARGS(&pso)));
-    return pso;
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    DXL_ASSERT(state->SubmittedTickets.empty() || state->Requests.at(state->SubmittedTickets.back()).FenceValue <= fenceValue, "Readbacks need to be submitted with increasing fence values");
+
+    for (uint64_t ticket : state->RecordedTickets)
+    {
+        ReadbackManagerState::Request& request = state->Requests.at(ticket);
+        request.Status = ReadbackManagerState::RequestStatus::Submitted;
+        request.FenceValue = fenceValue;
+        state->SubmittedTickets.push_back(ticket);
+    }
+
+    state->RecordedTickets.clear();
 }
 
-IDXLPipelineState IDXLDevice::CreateGraphicsPSO(DXL_SIMPLE_GRAPHICS_PSO_DESC desc)
+void ReadbackManager::Update()
 {
-    CD3DX12_PIPELINE_STATE_STREAM6 stateStream;
-    stateStream.pRootSignature = desc.RootSignature;
-    stateStream.PrimitiveTopologyType = desc.PrimitiveTopologyType;
-    stateStream.VS = desc.VertexShaderByteCode;
-    stateStream.PS = desc.PixelShaderByteCode;
-    stateStream.BlendState = CD3DX12_BLEND_DESC(desc.BlendState);
-    stateStream.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC2(desc.DepthStencilState);
-    stateStream.DSVFormat = desc.DepthStencilFormat;
-    stateStream.RasterizerState = CD3DX12_RASTERIZER_DESC2(desc.RasterizerState);
-    stateStream.RTVFormats = desc.RenderTargetFormats;
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
 
-    return CreateGraphicsPSO({ .SizeInBytes = sizeof(stateStream), .pPipelineStateSubobjectStream = &stateStream, });
+    if (state->Params.Fence)
+        ProcessCompleted(state->Params.Fence.GetCompletedValue());
 }
 
-IDXLPipelineState IDXLDevice::CreateGraphicsPSO(DXL_MESH_SHADER_GRAPHICS_PSO_DESC desc)
+void ReadbackManager::ProcessCompleted(uint64_t completedValue)
 {
-    CD3DX12_PIPELINE_STATE_STREAM6 stateStream;
-    stateStream.pRootSignature = desc.RootSignature;
-    stateStream.PrimitiveTopologyType = desc.PrimitiveTopologyType;
-    stateStream.AS = desc.AmplificationShaderByteCode;
-    stateStream.MS = desc.MeshShaderByteCode;
-    stateStream.PS = desc.PixelShaderByteCode;
-    stateStream.BlendState = CD3DX12_BLEND_DESC(desc.BlendState);
-    stateStream.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC2(desc.DepthStencilState);
-    stateStream.DSVFormat = desc.DepthStencilFormat;
-    stateStream.RasterizerState = CD3DX12_RASTERIZER_DESC2(desc.RasterizerState);
-    stateStream.RTVFormats = desc.RenderTargetFormats;
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
 
-    return CreateGraphicsPSO({ .SizeInBytes = sizeof(stateStream), .pPipelineStateSubobjectStream = &stateStream, });
+    std::unique_lock<std::mutex> lock(state->Mutex);
+    const std::vector<uint64_t> callbackTickets = state->ProcessCompleted(completedValue);
+    for (uint64_t ticket : callbackTickets)
+        state->RunCallback(lock, ticket);
 }
 
-IDXLStateObject IDXLDevice::CreateStateObject(D3D12_STATE_OBJECT_DESC desc)
+bool ReadbackManager::IsReady(uint64_t ticket) const
 {
-    IDXLStateObject  stateObject;
-    DXL_HANDLE_HRESULT(ToNative()->CreateStateObject(&desc, DXL_PPV_ARGS(&stateObject)));
-    return stateObject;
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    auto iter = state->Requests.find(ticket);
+    return iter != state->Requests.end() && iter->second.Status == ReadbackManagerState::RequestStatus::Ready && iter->second.Discarded == false;
 }
 
-IDXLStateObject  IDXLDevice::AddToStateObject(D3D12_STATE_OBJECT_DESC addition, IDXLStateObject stateObjectToGrowFrom)
+bool ReadbackManager::Read(uint64_t ticket, const ReadbackCallback& function)
 {
-    IDXLStateObject  stateObject;
-    DXL_HANDLE_HRESULT(ToNative()->AddToStateObject(&addition, stateObjectToGrowFrom.ToNative(), DXL_PPV_ARGS(&stateObjectToGrowFrom)));
-    return stateObject;
-}
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
 
-#endif // DXL_ENABLE_EXTENSIONS
+    std::unique_lock<std::mutex> lock(state->Mutex);
+    auto iter = state->Requests.find(ticket);
+    if (iter == state->Requests.end() || iter->second.Status != ReadbackManagerState::RequestStatus::Ready || iter->second.Discarded)
+        return false;
 
-HRESULT IDXLDevice::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* descriptorHeapDesc, REFIID riid, void** outHeap)
-{
-    return ToNative()->CreateDescriptorHeap(descriptorHeapDesc, riid, outHeap);
-}
+    // Marking it as completing keeps other threads from reading or freeing it while the function runs
+    iter->second.Status = ReadbackManagerState::RequestStatus::Completing;
+    iter->second.Callback = function;
+    state->RunCallback(lock, ticket);
 
-uint32_t IDXLDevice::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType)
-{
-    return ToNative()->GetDescriptorHandleIncrementSize(descriptorHeapType);
+    return true;
 }
 
-HRESULT IDXLDevice::CreateRootSignature(uint32_t nodeMask, const void* blobWithRootSignature, size_t blobLengthInBytes, REFIID riid, void** outRootSignature)
+void ReadbackManager::Discard(uint64_t ticket)
 {
-    return ToNative()->CreateRootSignature(nodeMask, blobWithRootSignature, blobLengthInBytes, riid, outRootSignature);
-}
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
 
-HRESULT IDXLDevice::CreateRootSignatureFromSubobjectInLibrary(uint32_t nodeMask, const void* libraryBlob, size_t blobLengthInBytes, const wchar_t* subobjectName, REFIID riid, void** rootSignature)
-{
-    return ToNative()->CreateRootSignatureFromSubobjectInLibrary(nodeMask, libraryBlob, blobLengthInBytes, subobjectName, riid, rootSignature);
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    auto iter = state->Requests.find(ticket);
+    if (iter == state->Requests.end())
+        return;
+
+    // Buffers that the GPU might still write to are freed once their copy completes, and running callbacks free theirs
+    if (iter->second.Status == ReadbackManagerState::RequestStatus::Ready)
+        state->FreeRequest(ticket);
+    else
+        iter->second.Discarded = true;
 }
 
-HRESULT IDXLDevice::CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* desc, REFIID riid, void** outHeap)
+void ReadbackManager::WaitForCallbacks()
 {
-    return ToNative()->CreateQueryHeap(desc, riid, outHeap);
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
+
+    std::unique_lock<std::mutex> lock(state->Mutex);
+    state->CallbacksDone.wait(lock, [this]() { return state->CallbackTickets.empty() && state->NumRunningCallbacks == 0; });
 }
 
-HRESULT IDXLDevice::CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC* desc, IDXLRootSignature rootSignature, REFIID riid, void** outCommandSignature)
+ReadbackManagerStats ReadbackManager::GetStats() const
 {
-    return ToNative()->CreateCommandSignature(desc, rootSignature, riid, outCommandSignature);
-}
+    DXL_ASSERT(state != nullptr, "ReadbackManager isn't initialized");
 
-#if DXL_ENABLE_EXTENSIONS
+    std::lock_guard<std::mutex> lock(state->Mutex);
 
-IDXLDescriptorHeap IDXLDevice::CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc)
-{
-    IDXLDescriptorHeap descriptorHeap;
-    DXL_HANDLE_HRESULT(ToNative()->CreateDescriptorHeap(&descriptorHeapDesc, DXL_PPV_ARGS(&descriptorHeap)));
-    return descriptorHeap;
+    ReadbackManagerStats stats =
+    {
+        .NumBuffers = state->NumBuffers,
+        .NumBytesAllocated = state->NumBytesAllocated,
+    };
+
+    for (const auto& [ticket, request] : state->Requests)
+    {
+        if (request.Status == ReadbackManagerState::RequestStatus::Ready)
+            stats.NumReady += 1;
+        else if (request.Status != ReadbackManagerState::RequestStatus::Completing)
+            stats.NumPending += 1;
+    }
+
+    for (const auto& [size, freeBuffers] : state->FreeBuffers)
+        stats.NumFreeBuffers += uint32_t(freeBuffers.size());
+
+    return stats;
 }
 
-IDXLRootSignature IDXLDevice::CreateRootSignature(D3D12_ROOT_SIGNATURE_DESC2 rootSignatureDesc)
+// == ResidencyManager =====================================================
+
+class ResidencyManagerState
 {
-    D3D12_VERSIONED_ROOT_SIGNATURE_DESC versionedDesc =
+
+public:
+
+    struct Object
     {
-        .Version = D3D_ROOT_SIGNATURE_VERSION_1_2,
-        .Desc_1_2 = rootSignatureDesc,
+        ID3D12Pageable* Pageable = nullptr;
+        uint64_t Size = 0;
+        uint64_t LastUsedSerial = 0;
+        uint64_t LastUsedFenceValue = 0;
+        bool IsTracked = false;
+        bool IsResident = false;
+
+        // Links in the LRU, which only has resident objects in it
+        uint32_t Prev = ResidencyManager::InvalidHandle;
+        uint32_t Next = ResidencyManager::InvalidHandle;
     };
 
-    ComPtr<ID3DBlob> signature;
-    ComPtr<ID3DBlob> error;
-    HRESULT hr = D3D12SerializeVersionedRootSignature(&versionedDesc, &signature, &error);
-    if (FAILED(hr))
+    ResidencyManagerParams Params;
+    IDXLFence PagingFence;
+    uint64_t PagingFenceValue = 0;
+
+    mutable std::mutex Mutex;
+    std::vector<Object> Objects;
+    std::vector<uint32_t> FreeHandles;
+    uint32_t MostRecent = ResidencyManager::InvalidHandle;
+    uint32_t LeastRecent = ResidencyManager::InvalidHandle;
+    uint64_t Serial = 0;
+    uint64_t CompletedValue = 0;
+    ResidencyManagerStats Stats;
+
+    std::vector<uint32_t> MakeResidentHandles;
+    std::vector<ID3D12Pageable*> Pageables;
+
+    // The mutex needs to be locked by the caller
+    void Unlink(uint32_t handle)
     {
-        const char* errString = error ? reinterpret_cast<const char*>(error->GetBufferPointer()) : "";
-        DXL_HANDLE_HRESULT_MSG(hr, errString);
-        return IDXLRootSignature();
+        Object& object = Objects[handle];
+        if (object.Prev != ResidencyManager::InvalidHandle)
+            Objects[object.Prev].Next = object.Next;
+        else
+            MostRecent = object.Next;
+
+        if (object.Next != ResidencyManager::InvalidHandle)
+            Objects[object.Next].Prev = object.Prev;
+        else
+            LeastRecent = object.Prev;
+
+        object.Prev = ResidencyManager::InvalidHandle;
+        object.Next = ResidencyManager::InvalidHandle;
     }
 
-    IDXLRootSignature rootSig;
-    DXL_HANDLE_HRESULT(ToNative()->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), DXL_PPV_ARGS(&rootSig)));
+    // The mutex needs to be locked by the caller
+    void LinkAsMostRecent(uint32_t handle)
+    {
+        Object& object = Objects[handle];
+        object.Prev = ResidencyManager::InvalidHandle;
+        object.Next = MostRecent;
+        if (MostRecent != ResidencyManager::InvalidHandle)
+            Objects[MostRecent].Prev = handle;
+        else
+            LeastRecent = handle;
 
-    return rootSig;
-}
+        MostRecent = handle;
+    }
 
-IDXLQueryHeap IDXLDevice::CreateQueryHeap(D3D12_QUERY_HEAP_DESC desc)
-{
-    IDXLQueryHeap queryHeap;
-    DXL_HANDLE_HRESULT(ToNative()->CreateQueryHeap(&desc, DXL_PPV_ARGS(&queryHeap)));
-    return queryHeap;
-}
+    // Evicts the least recently used objects that the GPU is done with until the resident size is <= targetBytes.
+    // The mutex needs to be locked by the caller.
+    void EvictDownTo(uint64_t targetBytes)
+    {
+        Pageables.clear();
 
-IDXLCommandSignature IDXLDevice::CreateCommandSignature(D3D12_COMMAND_SIGNATURE_DESC desc, IDXLRootSignature rootSignature)
-{
-    IDXLCommandSignature commandSignature;
-    DXL_HANDLE_HRESULT(ToNative()->CreateCommandSignature(&desc, rootSignature, DXL_PPV_ARGS(&commandSignature)));
-    return commandSignature;
-}
+        uint32_t handle = LeastRecent;
+        while (handle != ResidencyManager::InvalidHandle && Stats.ResidentBytes > targetBytes)
+        {
+            Object& object = Objects[handle];
+            const uint32_t nextHandle = object.Prev;
 
-#endif // DXL_ENABLE_EXTENSIONS
+            // Objects in the current submission have the current serial, so they're skipped here too
+            if (object.LastUsedSerial != Serial && object.LastUsedFenceValue <= CompletedValue)
+            {
+                Unlink(handle);
+                object.IsResident = false;
 
-void IDXLDevice::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+                Stats.NumResident -= 1;
+                Stats.ResidentBytes -= object.Size;
+                Stats.NumEvicted += 1;
+                Stats.BytesEvicted += object.Size;
+
+                if (object.Pageable)
+                    Pageables.push_back(object.Pageable);
+            }
+
+            handle = nextHandle;
+        }
+
+        if (Params.Device && Pageables.size() > 0)
+            DXL_HANDLE_HRESULT(Params.Device.Evict(uint32_t(Pageables.size()), Pageables.data()));
+    }
+};
+
+ResidencyManager::ResidencyManager() = default;
+
+ResidencyManager::~ResidencyManager()
 {
-    ToNative()->CreateConstantBufferView(desc, destDescriptor);
+    Shutdown();
 }
 
-void IDXLDevice::CreateShaderResourceView(IDXLResource resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+void ResidencyManager::Initialize(ResidencyManagerParams params)
 {
-    ToNative()->CreateShaderResourceView(resource, desc, destDescriptor);
+    DXL_ASSERT(state == nullptr, "ResidencyManager is already initialized");
+
+    params.EvictionTarget = std::clamp(params.EvictionTarget, 0.0f, 1.0f);
+
+    state = std::make_unique<ResidencyManagerState>();
+    state->Params = params;
+    state->Stats.Budget = params.Budget;
+
+    if (params.Device)
+        state->PagingFence = params.Device.CreateFence(0);
 }
 
-void IDXLDevice::CreateUnorderedAccessView(IDXLResource resource, IDXLResource counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+void ResidencyManager::Shutdown()
 {
-    ToNative()->CreateUnorderedAccessView(resource, counterResource, desc, destDescriptor);
+    if (state == nullptr)
+        return;
+
+    Release(state->PagingFence);
+
+    state.reset();
 }
 
-void IDXLDevice::CreateSamplerFeedbackUnorderedAccessView(IDXLResource targetedResource, IDXLResource feedbackResource, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+uint32_t ResidencyManager::TrackObject(ID3D12Pageable* pageable, uint64_t size, bool isResident)
 {
-    ToNative()->CreateSamplerFeedbackUnorderedAccessView(targetedResource, feedbackResource, destDescriptor);
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
+    DXL_ASSERT(state->Params.Device == nullptr || pageable != nullptr, "ResidencyManager can't track a null pageable");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+
+    uint32_t handle = InvalidHandle;
+    if (state->FreeHandles.size() > 0)
+    {
+        handle = state->FreeHandles.back();
+        state->FreeHandles.pop_back();
+    }
+    else
+    {
+        handle = uint32_t(state->Objects.size());
+        state->Objects.emplace_back();
+    }
+
+    state->Objects[handle] = { .Pageable = pageable, .Size = size, .IsTracked = true, .IsResident = isResident };
+    state->Stats.NumObjects += 1;
+
+    if (isResident)
+    {
+        state->LinkAsMostRecent(handle);
+        state->Stats.NumResident += 1;
+        state->Stats.ResidentBytes += size;
+    }
+
+    return handle;
 }
 
-void IDXLDevice::CreateRenderTargetView(IDXLResource resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+void ResidencyManager::UntrackObject(uint32_t handle)
 {
-    ToNative()->CreateRenderTargetView(resource, desc, destDescriptor);
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    DXL_ASSERT(handle < state->Objects.size() && state->Objects[handle].IsTracked, "Residency handle %u isn't being tracked", handle);
+
+    ResidencyManagerState::Object& object = state->Objects[handle];
+    if (object.IsResident)
+    {
+        state->Unlink(handle);
+        state->Stats.NumResident -= 1;
+        state->Stats.ResidentBytes -= object.Size;
+    }
+
+    object = { };
+    state->FreeHandles.push_back(handle);
+    state->Stats.NumObjects -= 1;
 }
 
-void IDXLDevice::CreateDepthStencilView(IDXLResource resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+void ResidencyManager::SetPriority(uint32_t handle, D3D12_RESIDENCY_PRIORITY priority)
 {
-    ToNative()->CreateDepthStencilView(resource, desc, destDescriptor);
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    DXL_ASSERT(handle < state->Objects.size() && state->Objects[handle].IsTracked, "Residency handle %u isn't being tracked", handle);
+
+    if (state->Params.Device)
+        DXL_HANDLE_HRESULT(state->Params.Device.SetResidencyPriority(1, &state->Objects[handle].Pageable, &priority));
 }
 
-void IDXLDevice::CreateSampler2(const D3D12_SAMPLER_DESC2* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+void ResidencyManager::ExecuteCommandLists(IDXLCommandQueue queue, Span<ID3D12CommandList* const> commandLists, Span<const ResidencySet* const> residencySets, uint64_t fenceValue)
 {
-    ToNative()->CreateSampler2(desc, destDescriptor);
-}
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
+    DXL_TRACE_SCOPE("ResidencyManager::ExecuteCommandLists");
+
+    // Everything happens under the lock so that queues wait on the paging fence in the same order that it's signaled
+    std::lock_guard<std::mutex> lock(state->Mutex);
+
+    if (state->Params.Fence)
+        state->CompletedValue = std::max(state->CompletedValue, state->Params.Fence.GetCompletedValue());
+
+    const uint64_t serial = ++state->Serial;
+    uint64_t makeResidentBytes = 0;
+    state->MakeResidentHandles.clear();
+    for (const ResidencySet* residencySet : residencySets)
+    {
+        for (uint32_t handle : residencySet->Handles)
+        {
+            DXL_ASSERT(handle < state->Objects.size() && state->Objects[handle].IsTracked, "Residency handle %u isn't being tracked", handle);
+
+            ResidencyManagerState::Object& object = state->Objects[handle];
+            if (object.LastUsedSerial == serial)
+                continue;
+
+            object.LastUsedSerial = serial;
+            object.LastUsedFenceValue = std::max(object.LastUsedFenceValue, fenceValue);
+
+            if (object.IsResident)
+            {
+                state->Unlink(handle);
+                state->LinkAsMostRecent(handle);
+            }
+            else
+            {
+                state->MakeResidentHandles.push_back(handle);
+                makeResidentBytes += object.Size;
+            }
+        }
+    }
+
+    const uint64_t budget = state->Params.Budget;
+    if (budget > 0 && state->Stats.ResidentBytes + makeResidentBytes > budget)
+    {
+        const uint64_t targetBytes = uint64_t(double(budget) * state->Params.EvictionTarget);
+        state->EvictDownTo(targetBytes > makeResidentBytes ? targetBytes - makeResidentBytes : 0);
+
+        if (state->Stats.ResidentBytes + makeResidentBytes > budget)
+            state->Stats.NumOverBudget += 1;
+    }
+
+    state->Pageables.clear();
+    for (uint32_t handle : state->MakeResidentHandles)
+    {
+        ResidencyManagerState::Object& object = state->Objects[handle];
+        object.IsResident = true;
+        state->LinkAsMostRecent(handle);
+
+        state->Stats.NumResident += 1;
+        state->Stats.ResidentBytes += object.Size;
+        state->Stats.NumMadeResident += 1;
+        state->Stats.BytesMadeResident += object.Size;
+
+        if (object.Pageable)
+            state->Pageables.push_back(object.Pageable);
+    }
+
+    if (state->Params.Device == nullptr)
+        return;
+
+    // The queue waits on the GPU for the paging operations, instead of the CPU waiting for them here
+    if (state->Pageables.size() > 0)
+    {
+        state->PagingFenceValue += 1;
+        DXL_HANDLE_HRESULT(state->Params.Device.EnqueueMakeResident(D3D12_RESIDENCY_FLAG_NONE, uint32_t(state->Pageables.size()), state->Pageables.data(),
+                                                                    state->PagingFence, state->PagingFenceValue));
+        DXL_HANDLE_HRESULT(queue.Wait(state->PagingFence, state->PagingFenceValue));
+    }
 
-D3D12_RESOURCE_ALLOCATION_INFO IDXLDevice::GetResourceAllocationInfo3(uint32_t visibleMask, uint32_t numResourceDescs, const D3D12_RESOURCE_DESC1* resourceDescs, const uint32_t* numCastableFormats, const DXGI_FORMAT*const* castableFormats, D3D12_RESOURCE_ALLOCATION_INFO1* resourceAllocationInfo)
-{
-    return ToNative()->GetResourceAllocationInfo3(visibleMask, numResourceDescs, resourceDescs, numCastableFormats, castableFormats, resourceAllocationInfo);
+    if (commandLists.Count > 0)
+        queue.ExecuteCommandLists(commandLists.Count, commandLists.Items);
 }
 
-HRESULT IDXLDevice::CreateHeap(const D3D12_HEAP_DESC* desc, REFIID riid, void** outHeap)
+void ResidencyManager::ProcessCompleted(uint64_t completedValue)
 {
-    return ToNative()->CreateHeap(desc, riid, outHeap);
-}
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
 
-HRESULT IDXLDevice::OpenExistingHeapFromAddress1(const void* address, size_t size, REFIID riid, void** outHeap)
-{
-    return ToNative()->OpenExistingHeapFromAddress1(address, size, riid, outHeap);
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->CompletedValue = std::max(state->CompletedValue, completedValue);
 }
 
-HRESULT IDXLDevice::OpenExistingHeapFromFileMapping(HANDLE fileMapping, REFIID riid, void** outHeap)
+void ResidencyManager::SetBudget(uint64_t budget)
 {
-    return ToNative()->OpenExistingHeapFromFileMapping(fileMapping, riid, outHeap);
-}
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
 
-D3D12_HEAP_PROPERTIES IDXLDevice::GetCustomHeapProperties(uint32_t nodeMask, D3D12_HEAP_TYPE heapType)
-{
-    return ToNative()->GetCustomHeapProperties(nodeMask, heapType);
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    state->Params.Budget = budget;
+    state->Stats.Budget = budget;
 }
 
-HRESULT IDXLDevice::CreateCommittedResource3(const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC1* desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, ID3D12ProtectedResourceSession* protectedSession, uint32_t numCastableFormats, const DXGI_FORMAT* castableFormats, REFIID riid, void** outResource)
+bool ResidencyManager::IsResident(uint32_t handle) const
 {
-    return ToNative()->CreateCommittedResource3(heapProperties, heapFlags, desc, initialLayout, optimizedClearValue, protectedSession, numCastableFormats, castableFormats, riid, outResource);
-}
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
 
-HRESULT IDXLDevice::CreatePlacedResource2(IDXLHeap heap, uint64_t heapOffset, const D3D12_RESOURCE_DESC1* desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, uint32_t numCastableFormats, const DXGI_FORMAT* castableFormats, REFIID riid, void** outResource)
-{
-    return ToNative()->CreatePlacedResource2(heap, heapOffset, desc, initialLayout, optimizedClearValue, numCastableFormats, castableFormats, riid, outResource);
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    DXL_ASSERT(handle < state->Objects.size() && state->Objects[handle].IsTracked, "Residency handle %u isn't being tracked", handle);
+    return state->Objects[handle].IsResident;
 }
 
-HRESULT IDXLDevice::CreateReservedResource2(const D3D12_RESOURCE_DESC* desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, ID3D12ProtectedResourceSession* protectedSession, uint32_t numCastableFormats, const DXGI_FORMAT* castableFormats, REFIID riid, void** outResource)
+ResidencyManagerStats ResidencyManager::GetStats() const
 {
-    return ToNative()->CreateReservedResource2(desc, initialLayout, optimizedClearValue, protectedSession, numCastableFormats, castableFormats, riid, outResource);
+    DXL_ASSERT(state != nullptr, "ResidencyManager isn't initialized");
+
+    std::lock_guard<std::mutex> lock(state->Mutex);
+    return state->Stats;
 }
 
-#if DXL_ENABLE_EXTENSIONS
+// == TransientResourceAllocator =====================================================
 
-IDXLHeap IDXLDevice::CreateHeap(D3D12_HEAP_DESC desc)
+void PackTransientResources(Span<const TransientPackingRequest> requests, uint64_t maxHeapSize, std::vector<TransientPlacement>& placements, std::vector<TransientHeapLayout>& heaps)
 {
-    IDXLHeap heap;
-    DXL_HANDLE_HRESULT(ToNative()->CreateHeap(&desc, DXL_PPV_ARGS(&heap)));
-    return heap;
-}
+    placements.assign(requests.Count, TransientPlacement());
+    heaps.clear();
 
-IDXLResource IDXLDevice::CreateCommittedResource(D3D12_HEAP_PROPERTIES heapProperties, D3D12_HEAP_FLAGS heapFlags, D3D12_RESOURCE_DESC1 desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
-{
-    IDXLResource resource;
-    DXL_HANDLE_HRESULT(ToNative()->CreateCommittedResource3(&heapProperties, heapFlags, &desc, initialLayout, optimizedClearValue, nullptr, castableFormats.Count, castableFormats.Items, DXL_PPV_ARGS(&resource)));
-    return resource;
-}
+    // Placing the largest resources first leaves the smaller ones to fill in the gaps between them
+    std::vector<uint32_t> order(requests.Count);
+    for (uint32_t i = 0; i < requests.Count; ++i)
+        order[i] = i;
 
-IDXLResource IDXLDevice::CreatePlacedResource(IDXLHeap heap, uint64_t heapOffset, D3D12_RESOURCE_DESC1 desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
-{
-    IDXLResource resource;
-    DXL_HANDLE_HRESULT(ToNative()->CreatePlacedResource2(heap, heapOffset, &desc, initialLayout, optimizedClearValue, castableFormats.Count, castableFormats.Items, DXL_PPV_ARGS(&resource)));
-    return resource;
-}
+    auto isLarger = [&](uint32_t a, uint32_t b)
+    {
+        if (requests.Items[a].Size != requests.Items[b].Size)
+            return requests.Items[a].Size > requests.Items[b].Size;
+        return requests.Items[a].FirstPass < requests.Items[b].FirstPass;
+    };
+    std::sort(order.begin(), order.end(), isLarger);
 
-IDXLResource IDXLDevice::CreateTiledResource(D3D12_RESOURCE_DESC desc, D3D12_BARRIER_LAYOUT initialLayout, const D3D12_CLEAR_VALUE* optimizedClearValue, Span<const DXGI_FORMAT> castableFormats)
-{
-    IDXLResource resource;
-    DXL_HANDLE_HRESULT(ToNative()->CreateReservedResource2(&desc, initialLayout, optimizedClearValue, nullptr, castableFormats.Count, castableFormats.Items, DXL_PPV_ARGS(&resource)));
-    return resource;
-}
+    struct Range
+    {
+        uint64_t Start = 0;
+        uint64_t End = 0;
+    };
 
-#endif // #if DXL_ENABLE_EXTENSIONS
+    // Each heap's resources are kept sorted by their first pass, so that only the ones that start close enough to
+    // overlap with a request need to be looked at
+    std::vector<std::vector<uint32_t>> heapResources;
+    std::vector<uint32_t> heapMaxLifetimes;
+    std::vector<Range> conflicts;
+    auto startsBefore = [&](uint32_t resourceIdx, uint32_t pass) { return requests.Items[resourceIdx].FirstPass < pass; };
+    auto startsAfter = [&](uint32_t pass, uint32_t resourceIdx) { return pass < requests.Items[resourceIdx].FirstPass; };
+    for (uint32_t requestIdx : order)
+    {
+        const TransientPackingRequest& request = requests.Items[requestIdx];
+        const uint64_t alignment = std::max<uint64_t>(request.Alignment, 1);
 
-void IDXLDevice::GetResourceTiling(IDXLResource tiledResource, uint32_t* outNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* outPackedMipDesc, D3D12_TILE_SHAPE* outStandardTileShapeForNonPackedMips, uint32_t* numSubresourceTilings, uint32_t firstSubresourceTilingToGet, D3D12_SUBRESOURCE_TILING* outSubresourceTilingsForNonPackedMips)
-{
-    return ToNative()->GetResourceTiling(tiledResource, outNumTilesForEntireResource, outPackedMipDesc, outStandardTileShapeForNonPackedMips, numSubresourceTilings, firstSubresourceTilingToGet, outSubresourceTilingsForNonPackedMips);
-}
+        for (uint32_t heapIdx = 0; heapIdx < uint32_t(heaps.size()); ++heapIdx)
+        {
+            if (heaps[heapIdx].HeapGroup != request.HeapGroup)
+                continue;
+
+            // Only the resources that are alive at the same time take up space
+            conflicts.clear();
+            const std::vector<uint32_t>& resources = heapResources[heapIdx];
+            const uint32_t earliestFirstPass = request.FirstPass - std::min(request.FirstPass, heapMaxLifetimes[heapIdx]);
+            for (auto iter = std::lower_bound(resources.begin(), resources.end(), earliestFirstPass, startsBefore); iter != resources.end(); ++iter)
+            {
+                const TransientPackingRequest& other = requests.Items[*iter];
+                if (other.FirstPass > request.LastPass)
+                    break;
 
-HRESULT IDXLDevice::CreateSharedHandle(IDXLDeviceChild object, const SECURITY_ATTRIBUTES* attributes, uint32_t access, const wchar_t* name, HANDLE* outHandle)
-{
-    return ToNative()->CreateSharedHandle(object, attributes, access, name, outHandle);
-}
+                if (request.FirstPass <= other.LastPass)
+                    conflicts.push_back({ .Start = placements[*iter].Offset, .End = placements[*iter].Offset + other.Size });
+            }
 
-HRESULT IDXLDevice::OpenSharedHandle(HANDLE ntHandle, REFIID riid, void** outObj)
-{
-    return ToNative()->OpenSharedHandle(ntHandle, riid, outObj);
-}
+            std::sort(conflicts.begin(), conflicts.end(), [](const Range& a, const Range& b) { return a.Start < b.Start; });
 
-HRESULT IDXLDevice::OpenSharedHandleByName(const wchar_t* name, uint32_t access, HANDLE* outHandle)
-{
-    return ToNative()->OpenSharedHandleByName(name, access, outHandle);
-}
+            uint64_t offset = 0;
+            for (const Range& conflict : conflicts)
+            {
+                if (AlignUp(offset, alignment) + request.Size <= conflict.Start)
+                    break;
 
-HRESULT IDXLDevice::MakeResident(uint32_t numObjects, ID3D12Pageable*const* objects)
-{
-    return ToNative()->MakeResident(numObjects, objects);
-}
+                offset = std::max(offset, conflict.End);
+            }
 
-HRESULT IDXLDevice::EnqueueMakeResident(D3D12_RESIDENCY_FLAGS flags, uint32_t numObjects, ID3D12Pageable*const* objects, ID3D12Fence* fenceToSignal, UINT64 fenceValueToSignal)
-{
-    return ToNative()->EnqueueMakeResident(flags, numObjects, objects, fenceToSignal, fenceValueToSignal);
-}
+            offset = AlignUp(offset, alignment);
+            if (offset + request.Size <= maxHeapSize)
+            {
+                placements[requestIdx] = { .HeapIndex = heapIdx, .Offset = offset };
+                break;
+            }
+        }
 
-HRESULT IDXLDevice::Evict(uint32_t numObjects, ID3D12Pageable*const* objects)
-{
-    return ToNative()->Evict(numObjects, objects);
-}
+        // Resources larger than the max heap size still get a heap of their own
+        if (placements[requestIdx].HeapIndex == UINT32_MAX)
+        {
+            placements[requestIdx] = { .HeapIndex = uint32_t(heaps.size()), .Offset = 0 };
+            heaps.push_back({ .HeapGroup = request.HeapGroup });
+            heapResources.emplace_back();
+            heapMaxLifetimes.push_back(0);
+        }
 
-HRESULT IDXLDevice::SetResidencyPriority(uint32_t numObjects, ID3D12Pageable*const* objects, const D3D12_RESIDENCY_PRIORITY* priorities)
-{
-    return ToNative()->SetResidencyPriority(numObjects, objects, priorities);
-}
+        const TransientPlacement& placement = placements[requestIdx];
+        heaps[placement.HeapIndex].Size = std::max(heaps[placement.HeapIndex].Size, placement.Offset + request.Size);
 
-HRESULT IDXLDevice::CreateFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** outFence)
-{
-    return ToNative()->CreateFence(initialValue, flags, riid, outFence);
+        std::vector<uint32_t>& resources = heapResources[placement.HeapIndex];
+        resources.insert(std::upper_bound(resources.begin(), resources.end(), request.FirstPass, startsAfter), requestIdx);
+        heapMaxLifetimes[placement.HeapIndex] = std::max(heapMaxLifetimes[placement.HeapIndex], request.LastPass - request.FirstPass);
+    }
 }
 
-HRESULT IDXLDevice::SetEventOnMultipleFenceCompletion(ID3D12Fence*const* fences, const uint64_t* fenceValues, uint32_t numFences, D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags, HANDLE event)
+class TransientResourceAllocatorState
 {
-    return ToNative()->SetEventOnMultipleFenceCompletion(fences, fenceValues, numFences, flags, event);
-}
 
-#if DXL_ENABLE_EXTENSIONS
+public:
 
-IDXLFence IDXLDevice::CreateFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags)
-{
-    IDXLFence fence;
-    ToNative()->CreateFence(initialValue, flags, DXL_PPV_ARGS(&fence));
-    return fence;
-}
+    enum HeapGroup : uint32_t
+    {
+        HeapGroupAll = 0,
 
-#endif // DXL_ENABLE_EXTENSIONS
+        // Tier 1 can't mix buffers, render targets, and other textures in the same heap
+        HeapGroupBuffers = 0,
+        HeapGroupRTDSTextures = 1,
+        HeapGroupOtherTextures = 2,
+    };
 
-void IDXLDevice::GetRaytracingAccelerationStructurePrebuildInfo(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* desc, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* outInfo)
-{
-    ToNative()->GetRaytracingAccelerationStructurePrebuildInfo(desc, outInfo);
-}
+    struct Resource
+    {
+        TransientResourceDesc Desc;             // With a null clear value pointer, since the vector can move it
+        D3D12_CLEAR_VALUE ClearValue = { };
+        bool HasClearValue = false;
+        DXL_HASH128 DescHash;
+        TransientPackingRequest Packing;
+        TransientPlacement Placement;
+        IDXLResource NativeResource;
+        IDXLHeap NativeHeap;                    // The heap that the resource was created in
+    };
 
-void IDXLDevice::RemoveDevice()
-{
-    ToNative()->RemoveDevice();
-}
+    struct Heap
+    {
+        IDXLHeap NativeHeap;
+        uint32_t HeapGroup = 0;
+        uint64_t Size = 0;
+    };
 
-HRESULT IDXLDevice::GetDeviceRemovedReason()
-{
-    return ToNative()->GetDeviceRemovedReason();
-}
+    struct RetiredObjects
+    {
+        uint64_t FenceValue = 0;
+        std::vector<IDXLResource> Resources;
+        std::vector<IDXLHeap> Heaps;
+    };
 
-void IDXLDevice::GetCopyableFootprints1(const D3D12_RESOURCE_DESC1* resourceDesc, uint32_t firstSubresource, uint32_t numSubresources, uint64_t baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, uint32_t* numRows, uint64_t* rowSizeInBytes, uint64_t* totalBytes)
-{
-    ToNative()->GetCopyableFootprints1(resourceDesc, firstSubresource, numSubresources, baseOffset, layouts, numRows, rowSizeInBytes, totalBytes);
-}
+    TransientResourceAllocatorParams Params;
+    D3D12_RESOURCE_HEAP_TIER HeapTier = D3D12_RESOURCE_HEAP_TIER_2;
 
-#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+    std::vector<Resource> Resources;
+    std::vector<Resource> PrevResources;        // Swapped in by Reset, so that the resources stay valid until Compile
+    std::vector<std::pair<DXL_HASH128, uint32_t>> PrevResourcesByHash;
+    std::vector<Heap> Heaps;
+    std::vector<std::vector<uint32_t>> ResourcesByFirstPass;
+    TransientResourceStats Stats;
 
-HRESULT IDXLDevice::SetStablePowerState(bool enable)
-{
-    return ToNative()->SetStablePowerState(enable);
-}
+    // Replaced by Compile, and waiting for the next Retire
+    std::vector<IDXLResource> PendingResources;
+    std::vector<IDXLHeap> PendingHeaps;
+    std::deque<RetiredObjects> Retired;
 
-HRESULT IDXLDevice::SetBackgroundProcessingMode(D3D12_BACKGROUND_PROCESSING_MODE mode, D3D12_MEASUREMENTS_ACTION measurementsAction, HANDLE eventToSignalUponCompletion, BOOL* outFurtherMeasurementsDesired)
-{
-    return ToNative()->SetBackgroundProcessingMode(mode, measurementsAction, eventToSignalUponCompletion, outFurtherMeasurementsDesired);
-}
+    uint32_t GetHeapGroup(const D3D12_RESOURCE_DESC1& desc) const
+    {
+        if (HeapTier != D3D12_RESOURCE_HEAP_TIER_1)
+            return HeapGroupAll;
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            return HeapGroupBuffers;
+        if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+            return HeapGroupRTDSTextures;
+        return HeapGroupOtherTextures;
+    }
 
-#endif // DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+    D3D12_HEAP_FLAGS GetHeapFlags(uint32_t heapGroup) const
+    {
+        if (HeapTier != D3D12_RESOURCE_HEAP_TIER_1)
+            return D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+        if (heapGroup == HeapGroupBuffers)
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        if (heapGroup == HeapGroupRTDSTextures)
+            return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+        return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    }
 
-// == IDXLSwapChain ======================================================
+    // Without a device the sizes are only estimates, which is close enough for testing the placement
+    static D3D12_RESOURCE_ALLOCATION_INFO EstimateAllocationInfo(const D3D12_RESOURCE_DESC1& desc)
+    {
+        const uint64_t alignment = desc.SampleDesc.Count > 1 ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            return { .SizeInBytes = AlignUp(desc.Width, alignment), .Alignment = alignment };
 
-#if DXL_ENABLE_EXTENSIONS
+        FormatBlockInfo blockInfo = GetFormatBlockInfo(desc.Format);
+        if (blockInfo.BytesPerBlock == 0)
+            blockInfo = { .BytesPerBlock = 4 };
 
-IDXLSwapChain IDXLSwapChain::Create(DXGI_SWAP_CHAIN_DESC desc, IDXLCommandQueue presentQueue)
-{
-    ComPtr<IDXGIFactory7> factory;
-    HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
-    DXL_HANDLE_HRESULT_MSG(hr, "failed to create DXGI factory");
-    if (FAILED(hr))
-        return IDXLSwapChain();
+        const bool is3D = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+        uint64_t size = 0;
+        for (uint32_t mipIdx = 0; mipIdx < std::max<uint32_t>(desc.MipLevels, 1); ++mipIdx)
+        {
+            const uint64_t width = std::max(desc.Width >> mipIdx, uint64_t(1));
+            const uint64_t height = std::max(desc.Height >> mipIdx, 1u);
+            const uint64_t depth = is3D ? std::max(uint32_t(desc.DepthOrArraySize) >> mipIdx, 1u) : 1;
+            const uint64_t numBlocks = ((width + blockInfo.BlockSize - 1) / blockInfo.BlockSize) * ((height + blockInfo.BlockSize - 1) / blockInfo.BlockSize) * depth;
+            size += numBlocks * blockInfo.BytesPerBlock;
+        }
 
-    ComPtr<IDXGISwapChain> tempSwapChain;
-    hr = factory->CreateSwapChain(presentQueue, &desc, &tempSwapChain);
-    DXL_HANDLE_HRESULT_MSG(hr, "failed to create swap chain");
-    if (FAILED(hr))
-        return IDXLSwapChain();
+        size *= (is3D ? 1 : desc.DepthOrArraySize) * std::max(desc.SampleDesc.Count, 1u);
+        return { .SizeInBytes = AlignUp(size, alignment), .Alignment = alignment };
+    }
 
-    IDXLSwapChain swapChain;
-    hr = tempSwapChain->QueryInterface(DXL_PPV_ARGS(&swapChain));
-    DXL_HANDLE_HRESULT_MSG(hr, "failed to query swap chain interface");
+    static DXL_HASH128 HashResource(const Resource& resource)
+    {
+        const D3D12_RESOURCE_DESC1& desc = resource.Desc.Desc;
+
+        HashBuilder hash;
+        hash.AddValue(desc.Dimension);
+        hash.AddValue(desc.Alignment);
+        hash.AddValue(desc.Width);
+        hash.AddValue(desc.Height);
+        hash.AddValue(desc.DepthOrArraySize);
+        hash.AddValue(desc.MipLevels);
+        hash.AddValue(desc.Format);
+        hash.AddValue(desc.SampleDesc.Count);
+        hash.AddValue(desc.SampleDesc.Quality);
+        hash.AddValue(desc.Layout);
+        hash.AddValue(desc.Flags);
+
+        hash.AddValue(resource.HasClearValue);
+        if (resource.HasClearValue)
+        {
+            // Depth clear values only use part of the union, and the rest of it can be garbage
+            hash.AddValue(resource.ClearValue.Format);
+            if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+            {
+                hash.AddValue(resource.ClearValue.DepthStencil.Depth);
+                hash.AddValue(resource.ClearValue.DepthStencil.Stencil);
+            }
+            else
+            {
+                hash.Add(resource.ClearValue.Color, sizeof(resource.ClearValue.Color));
+            }
+        }
 
-    return swapChain;
-}
+        return hash.Finalize();
+    }
 
-#endif
+    void UpdateHeaps(const std::vector<TransientHeapLayout>& layouts)
+    {
+        for (uint32_t heapIdx = 0; heapIdx < uint32_t(layouts.size()); ++heapIdx)
+        {
+            const TransientHeapLayout& layout = layouts[heapIdx];
+            if (heapIdx >= Heaps.size())
+                Heaps.emplace_back();
 
-HRESULT IDXLSwapChain::Present(uint32_t syncInterval, uint32_t presentFlags)
+            Heap& heap = Heaps[heapIdx];
+            if (heap.HeapGroup == layout.HeapGroup && heap.Size >= layout.Size && (heap.NativeHeap || Params.Device == nullptr))
+                continue;
+
+            if (heap.NativeHeap)
+                PendingHeaps.push_back(heap.NativeHeap);
+
+            // Rounding the size up gives heaps some room to grow before they need to be replaced
+            heap.HeapGroup = layout.HeapGroup;
+            heap.Size = AlignUp(layout.Size, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+            heap.NativeHeap = IDXLHeap();
+
+            if (Params.Device)
+            {
+                const D3D12_HEAP_DESC heapDesc =
+                {
+                    .SizeInBytes = heap.Size,
+                    .Properties = { .Type = D3D12_HEAP_TYPE_DEFAULT },
+                    .Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT,
+                    .Flags = GetHeapFlags(heap.HeapGroup) | D3D12_HEAP_FLAG_CREATE_NOT_ZEROED,
+                };
+                heap.NativeHeap = Params.Device.CreateHeap(heapDesc);
+            }
+        }
+
+        while (Heaps.size() > layouts.size())
+        {
+            if (Heaps.back().NativeHeap)
+                PendingHeaps.push_back(Heaps.back().NativeHeap);
+            Heaps.pop_back();
+        }
+    }
+
+    void ReleaseRetired(RetiredObjects& retired)
+    {
+        for (IDXLResource& resource : retired.Resources)
+            Release(resource);
+        for (IDXLHeap& heap : retired.Heaps)
+            Release(heap);
+    }
+};
+
+TransientResourceAllocator::TransientResourceAllocator() = default;
+
+TransientResourceAllocator::~TransientResourceAllocator()
 {
-    return ToNative()->Present(syncInterval, presentFlags);
+    Shutdown();
 }
 
-HRESULT IDXLSwapChain::ResizeBuffers(uint32_t bufferCount, uint32_t width, uint32_t height, DXGI_FORMAT newFormat, UINT swapChainFlags)
+void TransientResourceAllocator::Initialize(TransientResourceAllocatorParams params)
 {
-    return ToNative()->ResizeBuffers(bufferCount, width, height, newFormat, swapChainFlags);
+    DXL_ASSERT(state == nullptr, "TransientResourceAllocator is already initialized");
+
+    params.MaxHeapSize = AlignUp(std::max<uint64_t>(params.MaxHeapSize, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT), D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    state = std::make_unique<TransientResourceAllocatorState>();
+    state->Params = params;
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = { };
+    if (params.Device && SUCCEEDED(params.Device.CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+        state->HeapTier = options.ResourceHeapTier;
 }
 
-uint32_t IDXLSwapChain::GetCurrentBackBufferIndex() const
+void TransientResourceAllocator::Shutdown()
 {
-    return ToNative()->GetCurrentBackBufferIndex();
+    if (state == nullptr)
+        return;
+
+    // Everything is released right away, so the GPU needs to be done with all of it
+    for (TransientResourceAllocatorState::RetiredObjects& retired : state->Retired)
+        state->ReleaseRetired(retired);
+
+    TransientResourceAllocatorState::RetiredObjects remaining;
+    remaining.Resources = std::move(state->PendingResources);
+    remaining.Heaps = std::move(state->PendingHeaps);
+    for (TransientResourceAllocatorState::Resource& resource : state->Resources)
+        remaining.Resources.push_back(resource.NativeResource);
+    for (TransientResourceAllocatorState::Resource& resource : state->PrevResources)
+        remaining.Resources.push_back(resource.NativeResource);
+    for (TransientResourceAllocatorState::Heap& heap : state->Heaps)
+        remaining.Heaps.push_back(heap.NativeHeap);
+    state->ReleaseRetired(remaining);
+
+    state.reset();
 }
 
-HRESULT IDXLSwapChain::GetBuffer(uint32_t buffer, REFIID riid, void** outSurface) const
+void TransientResourceAllocator::Reset()
 {
-    return ToNative()->GetBuffer(buffer, riid, outSurface);
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
+
+    // Swapping keeps both vectors' memory around, so that steady frames don't allocate
+    std::swap(state->PrevResources, state->Resources);
+    state->Resources.clear();
 }
 
-HRESULT IDXLSwapChain::GetDesc1(DXGI_SWAP_CHAIN_DESC1* outDesc)
+uint32_t TransientResourceAllocator::AddResource(const TransientResourceDesc& desc)
 {
-    return ToNative()->GetDesc1(outDesc);
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
+    DXL_ASSERT(desc.FirstPass <= desc.LastPass, "A transient resource's first pass (%u) can't be after its last pass (%u)", desc.FirstPass, desc.LastPass);
+
+    // The clear value pointer only needs to be valid for this call
+    TransientResourceAllocatorState::Resource& resource = state->Resources.emplace_back();
+    resource.Desc = desc;
+    resource.Desc.OptimizedClearValue = nullptr;
+    resource.HasClearValue = desc.OptimizedClearValue != nullptr;
+    if (resource.HasClearValue)
+        resource.ClearValue = *desc.OptimizedClearValue;
+
+    resource.DescHash = TransientResourceAllocatorState::HashResource(resource);
+
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = TransientResourceAllocatorState::EstimateAllocationInfo(desc.Desc);
+    if (state->Params.Device)
+    {
+        const uint32_t numCastableFormats = 0;
+        const DXGI_FORMAT* castableFormats = nullptr;
+        allocationInfo = state->Params.Device.GetResourceAllocationInfo3(0, 1, &desc.Desc, &numCastableFormats, &castableFormats, nullptr);
+        DXL_ASSERT(allocationInfo.SizeInBytes != UINT64_MAX, "GetResourceAllocationInfo3 failed for a transient resource desc");
+    }
+    resource.Packing =
+    {
+        .Size = allocationInfo.SizeInBytes,
+        .Alignment = allocationInfo.Alignment,
+        .FirstPass = desc.FirstPass,
+        .LastPass = desc.LastPass,
+        .HeapGroup = state->GetHeapGroup(desc.Desc),
+    };
+
+    return uint32_t(state->Resources.size() - 1);
 }
 
-HRESULT IDXLSwapChain::GetHwnd(HWND* outHwnd)
+void TransientResourceAllocator::Compile()
 {
-    return ToNative()->GetHwnd(outHwnd);
-}
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
+    DXL_TRACE_SCOPE("TransientResourceAllocator::Compile");
+
+    if (state->Params.Fence)
+        ReleaseCompleted(state->Params.Fence.GetCompletedValue());
+
+    std::vector<TransientPackingRequest> requests;
+    requests.reserve(state->Resources.size());
+    for (const TransientResourceAllocatorState::Resource& resource : state->Resources)
+        requests.push_back(resource.Packing);
+
+    std::vector<TransientPlacement> placements;
+    std::vector<TransientHeapLayout> heapLayouts;
+    PackTransientResources(Span<const TransientPackingRequest>(uint32_t(requests.size()), requests.data()), state->Params.MaxHeapSize, placements, heapLayouts);
+
+    state->UpdateHeaps(heapLayouts);
+
+    // Resources from the previous frame with the same desc in the same spot of the same heap are reused as is. They're
+    // looked up by hash in a sorted array, which is cheaper to build every frame than a hash map.
+    auto hashLess = [](const std::pair<DXL_HASH128, uint32_t>& a, const std::pair<DXL_HASH128, uint32_t>& b)
+    {
+        return a.first.Hi != b.first.Hi ? a.first.Hi < b.first.Hi : a.first.Lo < b.first.Lo;
+    };
+
+    std::vector<std::pair<DXL_HASH128, uint32_t>>& prevResources = state->PrevResourcesByHash;
+    prevResources.clear();
+    for (uint32_t prevIdx = 0; prevIdx < uint32_t(state->PrevResources.size()); ++prevIdx)
+        prevResources.push_back({ state->PrevResources[prevIdx].DescHash, prevIdx });
+    std::sort(prevResources.begin(), prevResources.end(), hashLess);
+
+    state->Stats = { .NumHeaps = uint32_t(state->Heaps.size()) };
+    for (std::vector<uint32_t>& resources : state->ResourcesByFirstPass)
+        resources.clear();
+    for (uint32_t resourceIdx = 0; resourceIdx < uint32_t(state->Resources.size()); ++resourceIdx)
+    {
+        TransientResourceAllocatorState::Resource& resource = state->Resources[resourceIdx];
+        resource.Placement = placements[resourceIdx];
+
+        const TransientResourceAllocatorState::Heap& heap = state->Heaps[resource.Placement.HeapIndex];
+        auto [first, last] = std::equal_range(prevResources.begin(), prevResources.end(), std::make_pair(resource.DescHash, 0u), hashLess);
+        for (auto iter = first; iter != last; ++iter)
+        {
+            // Reused resources are taken out by clearing their native resource
+            TransientResourceAllocatorState::Resource& prevResource = state->PrevResources[iter->second];
+            if (prevResource.NativeResource && prevResource.NativeHeap == heap.NativeHeap && prevResource.Placement.Offset == resource.Placement.Offset)
+            {
+                resource.NativeResource = prevResource.NativeResource;
+                resource.NativeHeap = prevResource.NativeHeap;
+                prevResource.NativeResource = IDXLResource();
+                break;
+            }
+        }
+
+        if (resource.NativeResource == nullptr && heap.NativeHeap)
+        {
+            resource.NativeResource = state->Params.Device.CreatePlacedResource(heap.NativeHeap, resource.Placement.Offset, resource.Desc.Desc, D3D12_BARRIER_LAYOUT_UNDEFINED,
+                                                                                resource.HasClearValue ? &resource.ClearValue : nullptr);
+            resource.NativeHeap = heap.NativeHeap;
+            state->Stats.NumResourcesCreated += 1;
+        }
+
+        if (resource.Desc.FirstPass >= state->ResourcesByFirstPass.size())
+            state->ResourcesByFirstPass.resize(resource.Desc.FirstPass + 1);
+        state->ResourcesByFirstPass[resource.Desc.FirstPass].push_back(resourceIdx);
+
+        state->Stats.UnaliasedBytes += resource.Packing.Size;
+    }
 
-HRESULT IDXLSwapChain::SetMaximumFrameLatency(uint32_t maxLatency)
-{
-    return ToNative()->SetMaximumFrameLatency(maxLatency);
-}
+    // Whatever wasn't reused goes away once the GPU is done with the previous frame
+    for (TransientResourceAllocatorState::Resource& prevResource : state->PrevResources)
+    {
+        if (prevResource.NativeResource)
+            state->PendingResources.push_back(prevResource.NativeResource);
+    }
 
-HRESULT IDXLSwapChain::GetMaximumFrameLatency(uint32_t* maxLatency)
-{
-    return ToNative()->GetMaximumFrameLatency(maxLatency);
-}
+    // Everything in there was either reused or retired, and the next Reset swaps this frame's resources in
+    state->PrevResources.clear();
 
-HANDLE IDXLSwapChain::GetFrameLatencyWaitableObject()
-{
-    return ToNative()->GetFrameLatencyWaitableObject();
+    state->Stats.NumResources = uint32_t(state->Resources.size());
+    for (const TransientResourceAllocatorState::Heap& heap : state->Heaps)
+        state->Stats.HeapBytes += heap.Size;
 }
 
-HRESULT IDXLSwapChain::CheckColorSpaceSupport(DXGI_COLOR_SPACE_TYPE colorSpace, uint32_t* colorSpaceSupport)
+IDXLResource TransientResourceAllocator::GetResource(uint32_t resourceIndex) const
 {
-    return ToNative()->CheckColorSpaceSupport(colorSpace, colorSpaceSupport);
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
+    DXL_ASSERT(resourceIndex < state->Resources.size(), "Transient resource index %u is out of range", resourceIndex);
+    return state->Resources[resourceIndex].NativeResource;
 }
 
-HRESULT IDXLSwapChain::SetColorSpace1(DXGI_COLOR_SPACE_TYPE colorSpace)
+TransientPlacement TransientResourceAllocator::GetPlacement(uint32_t resourceIndex) const
 {
-    return ToNative()->SetColorSpace1(colorSpace);
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
+    DXL_ASSERT(resourceIndex < state->Resources.size(), "Transient resource index %u is out of range", resourceIndex);
+    return state->Resources[resourceIndex].Placement;
 }
 
-HRESULT IDXLSwapChain::SetHDRMetaData(DXGI_HDR_METADATA_TYPE type, uint32_t size, void* metaData)
+void TransientResourceAllocator::GetAcquireBarriers(uint32_t passIndex, std::vector<D3D12_TEXTURE_BARRIER>& textureBarriers, std::vector<D3D12_BUFFER_BARRIER>& bufferBarriers) const
 {
-    return ToNative()->SetHDRMetaData(type, size, metaData);
-}
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
 
-HRESULT IDXLSwapChain::SetRotation(DXGI_MODE_ROTATION rotation)
-{
-    return ToNative()->SetRotation(rotation);
-}
+    if (passIndex >= state->ResourcesByFirstPass.size())
+        return;
 
-HRESULT IDXLSwapChain::GetRotation(DXGI_MODE_ROTATION* outRotation)
-{
-    return ToNative()->GetRotation(outRotation);
+    // Syncing with everything before the barrier makes sure that whatever was in the memory before is done with it
+    for (uint32_t resourceIdx : state->ResourcesByFirstPass[passIndex])
+    {
+        const TransientResourceAllocatorState::Resource& resource = state->Resources[resourceIdx];
+        if (resource.Desc.Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            bufferBarriers.push_back(
+            {
+                .SyncBefore = D3D12_BARRIER_SYNC_ALL,
+                .SyncAfter = resource.Desc.FirstSync,
+                .AccessBefore = D3D12_BARRIER_ACCESS_NO_ACCESS,
+                .AccessAfter = resource.Desc.FirstAccess,
+                .pResource = resource.NativeResource,
+                .Offset = 0,
+                .Size = UINT64_MAX,
+            });
+        }
+        else
+        {
+            textureBarriers.push_back(
+            {
+                .SyncBefore = D3D12_BARRIER_SYNC_ALL,
+                .SyncAfter = resource.Desc.FirstSync,
+                .AccessBefore = D3D12_BARRIER_ACCESS_NO_ACCESS,
+                .AccessAfter = resource.Desc.FirstAccess,
+                .LayoutBefore = D3D12_BARRIER_LAYOUT_UNDEFINED,
+                .LayoutAfter = resource.Desc.FirstLayout,
+                .pResource = resource.NativeResource,
+                .Subresources = { .IndexOrFirstMipLevel = 0xFFFFFFFF },
+                .Flags = D3D12_TEXTURE_BARRIER_FLAG_DISCARD,
+            });
+        }
+    }
 }
 
-HRESULT IDXLSwapChain::GetContainingOutput(IDXGIOutput** outOutput)
+void TransientResourceAllocator::AcquireResources(IDXLCommandList commandList, uint32_t passIndex) const
 {
-    return ToNative()->GetContainingOutput(outOutput);
-}
+    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
+    GetAcquireBarriers(passIndex, textureBarriers, bufferBarriers);
 
-HRESULT IDXLSwapChain::GetFrameStatistics(DXGI_FRAME_STATISTICS* outStats)
-{
-    return ToNative()->GetFrameStatistics(outStats);
+    D3D12_BARRIER_GROUP groups[2] = { };
+    uint32_t numGroups = 0;
+    if (bufferBarriers.size() > 0)
+    {
+        groups[numGroups].Type = D3D12_BARRIER_TYPE_BUFFER;
+        groups[numGroups].NumBarriers = uint32_t(bufferBarriers.size());
+        groups[numGroups].pBufferBarriers = bufferBarriers.data();
+        numGroups += 1;
+    }
+    if (textureBarriers.size() > 0)
+    {
+        groups[numGroups].Type = D3D12_BARRIER_TYPE_TEXTURE;
+        groups[numGroups].NumBarriers = uint32_t(textureBarriers.size());
+        groups[numGroups].pTextureBarriers = textureBarriers.data();
+        numGroups += 1;
+    }
+
+    if (numGroups > 0)
+        commandList.Barrier(numGroups, groups);
 }
 
-HRESULT IDXLSwapChain::GetLastPresentCount(uint32_t* outLastPresentCount)
+void TransientResourceAllocator::Retire(uint64_t fenceValue)
 {
-    return ToNative()->GetLastPresentCount(outLastPresentCount);
-}
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
 
-#if DXL_ENABLE_EXTENSIONS
+    if (state->PendingResources.empty() && state->PendingHeaps.empty())
+        return;
 
-IDXLResource IDXLSwapChain::GetBuffer(uint32_t bufferIndex) const
-{
-    IDXLResource resource;
-    ToNative()->GetBuffer(bufferIndex, DXL_PPV_ARGS(&resource));
-    return resource;
+    TransientResourceAllocatorState::RetiredObjects& retired = state->Retired.emplace_back();
+    retired.FenceValue = fenceValue;
+    retired.Resources = std::move(state->PendingResources);
+    retired.Heaps = std::move(state->PendingHeaps);
+    state->PendingResources.clear();
+    state->PendingHeaps.clear();
 }
 
-DXGI_SWAP_CHAIN_DESC1 IDXLSwapChain::GetDesc() const
+void TransientResourceAllocator::ReleaseCompleted(uint64_t completedValue)
 {
-    DXGI_SWAP_CHAIN_DESC1 desc = { };
-    ToNative()->GetDesc1(&desc);
-    return desc;
-}
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
 
-HWND IDXLSwapChain::GetHwnd() const
-{
-    HWND hwnd = nullptr;
-    ToNative()->GetHwnd(&hwnd);
-    return hwnd;
+    while (state->Retired.size() > 0 && state->Retired.front().FenceValue <= completedValue)
+    {
+        state->ReleaseRetired(state->Retired.front());
+        state->Retired.pop_front();
+    }
 }
 
-uint32_t IDXLSwapChain::GetMaximumFrameLatency()
+TransientResourceStats TransientResourceAllocator::GetStats() const
 {
-    uint32_t latency = 0;
-    ToNative()->GetMaximumFrameLatency(&latency);
-    return latency;
+    DXL_ASSERT(state != nullptr, "TransientResourceAllocator isn't initialized");
+    return state->Stats;
 }
 
-DXGI_FRAME_STATISTICS IDXLSwapChain::GetFrameStatistics()
-{
-    DXGI_FRAME_STATISTICS stats = { };
-    ToNative()->GetFrameStatistics(&stats);
-    return stats;
-}
+// == RenderGraph =====================================================
 
-uint32_t IDXLSwapChain::GetLastPresentCount()
+class RenderGraphState
 {
-    uint32_t presentCount = 0;
-    ToNative()->GetLastPresentCount(&presentCount);
-    return presentCount;
-}
 
-DXGI_MODE_ROTATION IDXLSwapChain::GetRotation()
-{
-    DXGI_MODE_ROTATION rotation = DXGI_MODE_ROTATION_UNSPECIFIED;
-    ToNative()->GetRotation(&rotation);
-    return rotation;
-}
+public:
 
-#endif // DXL_ENABLE_EXTENSIONS
+    struct BarrierLocation
+    {
+        uint32_t Batch = RenderGraph::InvalidIndex;
+        uint32_t Index = 0;
+    };
 
-#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+    struct Resource
+    {
+        IDXLResource NativeResource;
+        bool IsTexture = false;
+        bool IsImported = false;
+        TrackedResourceState Initial;
+        TrackedResourceState Final;
+        bool HasFinalUsage = false;
+
+        // Transient resources only
+        D3D12_RESOURCE_DESC1 Desc = { };
+        D3D12_CLEAR_VALUE ClearValue = { };
+        bool HasClearValue = false;
+        uint32_t TransientIndex = RenderGraph::InvalidIndex;
+
+        // Filled out by Compile
+        TrackedResourceState Current;
+        uint32_t FirstPass = RenderGraph::InvalidIndex;
+        uint32_t LastPass = RenderGraph::InvalidIndex;
+        uint64_t MergeStamp = 0;
+        uint32_t MergedIndex = 0;
+
+        // Where the most recent barrier for the resource ended up, so that later reads can be added to it
+        BarrierLocation LastBarrier;
+        BarrierLocation LastSplitBegin;
+    };
 
-// == IDXLDebug ======================================================
+    struct Usage
+    {
+        uint32_t Pass = 0;
+        uint32_t Resource = 0;
+        TrackedResourceState State;
+        bool IsWrite = false;
+    };
 
-void IDXLDebug::EnableDebugLayer()
-{
-    ToNative()->EnableDebugLayer();
-}
+    struct Pass
+    {
+        const char* Name = nullptr;
+        RenderGraphPassFunction Function;
+        bool HasSideEffects = false;
+        bool IsCulled = false;
+        uint32_t FirstUsage = 0;
+        uint32_t NumUsages = 0;
+        uint32_t CompiledIndex = RenderGraph::InvalidIndex;
+    };
 
-void IDXLDebug::DisableDebugLayer()
-{
-    ToNative()->DisableDebugLayer();
-}
+    struct BarrierBatch
+    {
+        std::vector<D3D12_TEXTURE_BARRIER> TextureBarriers;
+        std::vector<D3D12_BUFFER_BARRIER> BufferBarriers;
 
-void IDXLDebug::SetEnableGPUBasedValidation(bool enable)
-{
-    ToNative()->SetEnableGPUBasedValidation(enable);
-}
+        void Clear()
+        {
+            TextureBarriers.clear();
+            BufferBarriers.clear();
+        }
+    };
 
-void IDXLDebug::SetGPUBasedValidationFlags(D3D12_GPU_BASED_VALIDATION_FLAGS flags)
-{
-    ToNative()->SetGPUBasedValidationFlags(flags);
-}
+    struct MergedUsage
+    {
+        uint32_t Resource = 0;
+        TrackedResourceState State;
+    };
 
-void IDXLDebug::SetEnableSynchronizedCommandQueueValidation(bool enable)
-{
-    ToNative()->SetEnableSynchronizedCommandQueueValidation(enable);
-}
+    RenderGraphParams Params;
 
-void IDXLDebug::SetEnableAutoName(bool enable)
-{
-    ToNative()->SetEnableAutoName(enable);
-}
+    std::vector<Resource> Resources;
+    std::vector<Usage> Usages;
+    std::vector<Pass> Passes;
+    bool IsCompiled = false;
 
-// == IDXLDebugDevice ======================================================
+    // Kept around between frames so that compiling doesn't need to allocate once the graph stops changing
+    std::vector<Usage> SortedUsages;
+    std::vector<uint32_t> AlivePasses;
+    std::vector<uint8_t> NeededResources;
+    std::vector<MergedUsage> Merged;
+    uint64_t MergeStamp = 0;
+    std::vector<BarrierBatch> Batches;
+    RenderGraphStats Stats;
 
-#if DXL_ENABLE_EXTENSIONS
+    uint32_t AddResource(Resource&& resource)
+    {
+        IsCompiled = false;
+        Resources.push_back(std::move(resource));
+        return uint32_t(Resources.size() - 1);
+    }
 
-IDXLDebugDevice IDXLDebugDevice::FromDevice(IDXLDevice device)
-{
-    ID3D12DebugDevice2* debugDevice = nullptr;
-    DXL_HANDLE_HRESULT_MSG(device->QueryInterface(IID_PPV_ARGS(&debugDevice)), "Failed to QueryInterface debug device interface from IDXLDevice. Did you enable the debug layer?");
-    return IDXLDebugDevice(debugDevice);
-}
+    void AddUsage(uint32_t passIndex, uint32_t resourceIndex, const RenderGraphUsage& usage, bool isWrite)
+    {
+        DXL_ASSERT(passIndex < Passes.size(), "Render graph pass index %u is out of range", passIndex);
+        DXL_ASSERT(resourceIndex < Resources.size(), "Render graph resource index %u is out of range", resourceIndex);
+
+        // Buffers don't have layouts, so leaving them undefined keeps them from causing barriers
+        const bool isTexture = Resources[resourceIndex].IsTexture;
+        const TrackedResourceState state = { .Sync = usage.Sync, .Access = usage.Access, .Layout = isTexture ? usage.Layout : D3D12_BARRIER_LAYOUT_UNDEFINED, .IsTexture = isTexture };
+        Usages.push_back({ .Pass = passIndex, .Resource = resourceIndex, .State = state, .IsWrite = isWrite });
+        IsCompiled = false;
+    }
 
-#endif
+    // Combines every usage of a resource in the pass into one, which ends up in Merged
+    void MergePassUsages(uint32_t passIndex)
+    {
+        Merged.clear();
+        MergeStamp += 1;
 
-HRESULT IDXLDebugDevice::SetFeatureMask(D3D12_DEBUG_FEATURE mask)
-{
-    return ToNative()->SetFeatureMask(mask);
-}
+        const Pass& pass = Passes[passIndex];
+        for (uint32_t usageIdx = pass.FirstUsage; usageIdx < pass.FirstUsage + pass.NumUsages; ++usageIdx)
+        {
+            const Usage& usage = SortedUsages[usageIdx];
+            Resource& resource = Resources[usage.Resource];
+            if (resource.MergeStamp != MergeStamp)
+            {
+                resource.MergeStamp = MergeStamp;
+                resource.MergedIndex = uint32_t(Merged.size());
+                Merged.push_back({ .Resource = usage.Resource, .State = usage.State });
+                continue;
+            }
 
-D3D12_DEBUG_FEATURE IDXLDebugDevice::GetFeatureMask()
-{
-    return ToNative()->GetFeatureMask();
-}
+            TrackedResourceState& merged = Merged[resource.MergedIndex].State;
+            DXL_ASSERT(merged.Layout == usage.State.Layout, "Pass %s uses a texture in two different layouts", pass.Name);
+            merged.Sync |= usage.State.Sync;
+            merged.Access |= usage.State.Access;
+        }
+    }
 
-HRESULT IDXLDebugDevice::ReportLiveDeviceObjects(D3D12_RLDO_FLAGS flags)
-{
-    return ToNative()->ReportLiveDeviceObjects(flags);
-}
+    void SortUsages()
+    {
+        for (Pass& pass : Passes)
+            pass.NumUsages = 0;
+        for (const Usage& usage : Usages)
+            Passes[usage.Pass].NumUsages += 1;
 
-HRESULT IDXLDebugDevice::SetDebugParameter(D3D12_DEBUG_DEVICE_PARAMETER_TYPE type, const void*data, uint32_t dataSize)
-{
-    return ToNative()->SetDebugParameter(type, data, dataSize);
-}
+        uint32_t firstUsage = 0;
+        for (Pass& pass : Passes)
+        {
+            pass.FirstUsage = firstUsage;
+            firstUsage += pass.NumUsages;
+            pass.NumUsages = 0;
+        }
 
-HRESULT IDXLDebugDevice::GetDebugParameter(D3D12_DEBUG_DEVICE_PARAMETER_TYPE type, void* data, uint32_t dataSize)
-{
-    return ToNative()->GetDebugParameter(type, data, dataSize);
-}
+        SortedUsages.resize(Usages.size());
+        for (const Usage& usage : Usages)
+        {
+            Pass& pass = Passes[usage.Pass];
+            SortedUsages[pass.FirstUsage + pass.NumUsages] = usage;
+            pass.NumUsages += 1;
+        }
+    }
 
-// == IDXLDebugCommandQueue ======================================================
+    // Walks backwards from the passes that have side effects or write to imported resources, keeping the passes that
+    // write anything that a kept pass reads
+    void CullPasses()
+    {
+        NeededResources.assign(Resources.size(), 0);
+        for (uint32_t passIdx = uint32_t(Passes.size()); passIdx-- > 0; )
+        {
+            Pass& pass = Passes[passIdx];
+            bool isAlive = pass.HasSideEffects;
+            for (uint32_t usageIdx = pass.FirstUsage; usageIdx < pass.FirstUsage + pass.NumUsages && isAlive == false; ++usageIdx)
+            {
+                const Usage& usage = SortedUsages[usageIdx];
+                isAlive = usage.IsWrite && (Resources[usage.Resource].IsImported || NeededResources[usage.Resource]);
+            }
 
-#if DXL_ENABLE_EXTENSIONS
+            pass.IsCulled = isAlive == false;
+            if (pass.IsCulled)
+                continue;
 
-IDXLDebugCommandQueue IDXLDebugCommandQueue::FromCommandQueue(IDXLCommandQueue commandQueue)
-{
-    ID3D12DebugCommandQueue1* debugQueue = nullptr;    
-    DXL_HANDLE_HRESULT_MSG(commandQueue->QueryInterface(IID_PPV_ARGS(&debugQueue)), "Failed to QueryInterface debug command queue interface from IDXLCommandQueue. Did you enable the debug layer?");
-    return IDXLDebugCommandQueue(debugQueue);
-}
+            for (uint32_t usageIdx = pass.FirstUsage; usageIdx < pass.FirstUsage + pass.NumUsages; ++usageIdx)
+            {
+                const Usage& usage = SortedUsages[usageIdx];
+                if (usage.IsWrite == false)
+                    NeededResources[usage.Resource] = 1;
+            }
+        }
 
-#endif
+        AlivePasses.clear();
+        for (uint32_t passIdx = 0; passIdx < uint32_t(Passes.size()); ++passIdx)
+        {
+            Passes[passIdx].CompiledIndex = Passes[passIdx].IsCulled ? RenderGraph::InvalidIndex : uint32_t(AlivePasses.size());
+            if (Passes[passIdx].IsCulled == false)
+                AlivePasses.push_back(passIdx);
+        }
+    }
 
-void IDXLDebugCommandQueue::AssertResourceAccess(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_ACCESS access)
-{
-    ToNative()->AssertResourceAccess(resource, subresource, access);
-}
+    void PlaceTransientResources()
+    {
+        // The first pass that uses a transient resource is where it gets acquired, in the state of that first use
+        for (uint32_t passIdx : AlivePasses)
+        {
+            MergePassUsages(passIdx);
+            for (const MergedUsage& merged : Merged)
+            {
+                Resource& resource = Resources[merged.Resource];
+                if (resource.FirstPass == RenderGraph::InvalidIndex)
+                {
+                    resource.FirstPass = passIdx;
+                    resource.Current = merged.State;
+                }
+                resource.LastPass = passIdx;
+            }
+        }
 
-void IDXLDebugCommandQueue::AssertTextureLayout(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_LAYOUT layout)
-{
-    ToNative()->AssertTextureLayout(resource, subresource, layout);
-}
+        TransientResourceAllocator* allocator = Params.TransientAllocator;
+        if (allocator == nullptr)
+            return;
 
-// == IDXLDebugCommandList ======================================================
+        allocator->Reset();
+        for (Resource& resource : Resources)
+        {
+            if (resource.IsImported || resource.FirstPass == RenderGraph::InvalidIndex)
+                continue;
 
-#if DXL_ENABLE_EXTENSIONS
+            const TransientResourceDesc transientDesc =
+            {
+                .Desc = resource.Desc,
+                .OptimizedClearValue = resource.HasClearValue ? &resource.ClearValue : nullptr,
+                .FirstPass = Passes[resource.FirstPass].CompiledIndex,
+                .LastPass = Passes[resource.LastPass].CompiledIndex,
+                .FirstSync = resource.Current.Sync,
+                .FirstAccess = resource.Current.Access,
+                .FirstLayout = resource.IsTexture ? resource.Current.Layout : D3D12_BARRIER_LAYOUT_UNDEFINED,
+            };
+            resource.TransientIndex = allocator->AddResource(transientDesc);
+        }
 
-IDXLDebugCommandList IDXLDebugCommandList::FromCommandList(IDXLCommandList commandList)
-{
-    ID3D12DebugCommandList3* debugList = nullptr;
-    DXL_HANDLE_HRESULT_MSG(commandList->QueryInterface(IID_PPV_ARGS(&debugList)), "Failed to QueryInterface debug command list interface from IDXLCommandList. Did you enable the debug layer?");
-    return IDXLDebugCommandList(debugList);
-}
+        allocator->Compile();
 
-#endif
+        for (Resource& resource : Resources)
+        {
+            if (resource.TransientIndex != RenderGraph::InvalidIndex)
+                resource.NativeResource = allocator->GetResource(resource.TransientIndex);
+        }
 
-HRESULT IDXLDebugCommandList::SetFeatureMask(D3D12_DEBUG_FEATURE mask)
-{
-    return ToNative()->SetFeatureMask(mask);
-}
+        for (uint32_t passIdx : AlivePasses)
+        {
+            BarrierBatch& batch = Batches[passIdx];
+            allocator->GetAcquireBarriers(Passes[passIdx].CompiledIndex, batch.TextureBarriers, batch.BufferBarriers);
+        }
+    }
 
-D3D12_DEBUG_FEATURE IDXLDebugCommandList::GetFeatureMask()
-{
-    return ToNative()->GetFeatureMask();
-}
+    BarrierLocation AddBarrier(uint32_t batchIndex, const Resource& resource, const TrackedResourceState& before, const TrackedResourceState& after)
+    {
+        BarrierBatch& batch = Batches[batchIndex];
+        if (resource.IsTexture)
+        {
+            batch.TextureBarriers.push_back(MakeTextureBarrier(resource.NativeResource, before, after));
+            return { .Batch = batchIndex, .Index = uint32_t(batch.TextureBarriers.size() - 1) };
+        }
 
-HRESULT IDXLDebugCommandList::SetDebugParameter(D3D12_DEBUG_COMMAND_LIST_PARAMETER_TYPE type, const void*data, uint32_t dataSize)
-{
-    return ToNative()->SetDebugParameter(type, data, dataSize);
-}
+        batch.BufferBarriers.push_back(MakeBufferBarrier(resource.NativeResource, before, after));
+        return { .Batch = batchIndex, .Index = uint32_t(batch.BufferBarriers.size() - 1) };
+    }
 
-HRESULT IDXLDebugCommandList::GetDebugParameter(D3D12_DEBUG_COMMAND_LIST_PARAMETER_TYPE type, void* data, uint32_t dataSize)
-{
-    return ToNative()->GetDebugParameter(type, data, dataSize);
-}
+    // Adds more sync and access to the after side of a barrier that's already been recorded
+    void WidenBarrier(const BarrierLocation& location, const Resource& resource, D3D12_BARRIER_SYNC sync, D3D12_BARRIER_ACCESS access)
+    {
+        BarrierBatch& batch = Batches[location.Batch];
+        D3D12_BARRIER_SYNC& syncAfter = resource.IsTexture ? batch.TextureBarriers[location.Index].SyncAfter : batch.BufferBarriers[location.Index].SyncAfter;
+        D3D12_BARRIER_ACCESS& accessAfter = resource.IsTexture ? batch.TextureBarriers[location.Index].AccessAfter : batch.BufferBarriers[location.Index].AccessAfter;
+
+        // The beginning of a split barrier stays SYNC_SPLIT
+        if (syncAfter != D3D12_BARRIER_SYNC_SPLIT)
+            syncAfter |= sync;
+        accessAfter |= access;
+    }
+
+    // Records the transition at batchIndex, or splits it so that it starts right after the resource's last use when
+    // there are passes in between
+    void Transition(uint32_t batchIndex, Resource& resource, const TrackedResourceState& after)
+    {
+        const TrackedResourceState& before = resource.Current;
+
+        // Reads in the same layout can overlap. When the new read uses sync or access that the resource wasn't already
+        // made visible to, the barrier that transitioned it for the earlier reads gets widened to cover this one too.
+        // Without one (e.g. the initial state of an imported resource) the new read needs a barrier of its own.
+        if (IsReadOnlyAccess(before.Access) && IsReadOnlyAccess(after.Access) && before.Layout == after.Layout)
+        {
+            const bool isSubset = (after.Sync & ~before.Sync) == 0 && (after.Access & ~before.Access) == 0;
+            if (isSubset == false && resource.LastBarrier.Batch != RenderGraph::InvalidIndex)
+            {
+                WidenBarrier(resource.LastBarrier, resource, after.Sync, after.Access);
+                if (resource.LastSplitBegin.Batch != RenderGraph::InvalidIndex)
+                    WidenBarrier(resource.LastSplitBegin, resource, after.Sync, after.Access);
+            }
+            else if (isSubset == false)
+            {
+                TrackedResourceState merged = before;
+                merged.Sync |= after.Sync;
+                merged.Access |= after.Access;
+                resource.LastBarrier = AddBarrier(batchIndex, resource, before, merged);
+                resource.LastSplitBegin = { };
+                Stats.NumBarriers += 1;
+            }
 
-void IDXLDebugCommandList::AssertResourceAccess(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_ACCESS access)
-{
-    ToNative()->AssertResourceAccess(resource, subresource, access);
-}
+            resource.Current.Sync |= after.Sync;
+            resource.Current.Access |= after.Access;
+            return;
+        }
 
-void IDXLDebugCommandList::AssertTextureLayout(IDXLResource resource, uint32_t subresource, D3D12_BARRIER_LAYOUT layout)
-{
-    ToNative()->AssertTextureLayout(resource, subresource, layout);
-}
+        const uint32_t lastCompiledIdx = resource.LastPass != RenderGraph::InvalidIndex ? Passes[resource.LastPass].CompiledIndex : RenderGraph::InvalidIndex;
+        const uint32_t compiledIdx = batchIndex < Passes.size() ? Passes[batchIndex].CompiledIndex : uint32_t(AlivePasses.size());
+        if (Params.EnableSplitBarriers && lastCompiledIdx != RenderGraph::InvalidIndex && compiledIdx > lastCompiledIdx + 1)
+        {
+            TrackedResourceState splitBegin = after;
+            splitBegin.Sync = D3D12_BARRIER_SYNC_SPLIT;
+            resource.LastSplitBegin = AddBarrier(AlivePasses[lastCompiledIdx + 1], resource, before, splitBegin);
 
-// == IDXLDebugInfoQueue ======================================================
+            TrackedResourceState splitEnd = before;
+            splitEnd.Sync = D3D12_BARRIER_SYNC_SPLIT;
+            resource.LastBarrier = AddBarrier(batchIndex, resource, splitEnd, after);
 
-#if DXL_ENABLE_EXTENSIONS
+            Stats.NumSplitBarriers += 1;
+        }
+        else
+        {
+            resource.LastBarrier = AddBarrier(batchIndex, resource, before, after);
+            resource.LastSplitBegin = { };
+        }
 
-IDXLDebugInfoQueue IDXLDebugInfoQueue::FromDevice(IDXLDevice device)
-{
-    ID3D12InfoQueue1* infoQueue = nullptr;    
-    DXL_HANDLE_HRESULT_MSG(device->QueryInterface(IID_PPV_ARGS(&infoQueue)), "Failed to QueryInterface debug command info queue interface from IDXLDevice. Did you enable the debug layer?");
-    return IDXLDebugInfoQueue(infoQueue);
-}
+        Stats.NumBarriers += 1;
+        resource.Current = after;
+    }
+};
 
-#endif
+RenderGraph::RenderGraph() = default;
 
-HRESULT IDXLDebugInfoQueue::RegisterMessageCallback(D3D12MessageFunc callbackFunc, D3D12_MESSAGE_CALLBACK_FLAGS callbackFilterFlags, void* context, DWORD* outCallbackCookie)
+RenderGraph::~RenderGraph()
 {
-    return ToNative()->RegisterMessageCallback(callbackFunc, callbackFilterFlags, context, outCallbackCookie);
+    Shutdown();
 }
 
-HRESULT IDXLDebugInfoQueue::UnregisterMessageCallback(DWORD callbackCookie)
+void RenderGraph::Initialize(RenderGraphParams params)
 {
-    return ToNative()->UnregisterMessageCallback(callbackCookie);
-}
+    DXL_ASSERT(state == nullptr, "RenderGraph is already initialized");
 
-void IDXLDebugInfoQueue::SetMuteDebugOutput(bool mute)
-{
-    ToNative()->SetMuteDebugOutput(mute);
+    state = std::make_unique<RenderGraphState>();
+    state->Params = params;
 }
 
-bool IDXLDebugInfoQueue::GetMuteDebugOutput()
+void RenderGraph::Shutdown()
 {
-    return ToNative()->GetMuteDebugOutput();
-}
-
-#endif // DXL_ENABLE_DEVELOPER_ONLY_FEATURES
+    if (state == nullptr)
+        return;
 
-#if DXL_ENABLE_EXTENSIONS
+    state.reset();
+}
 
-static void DefaultDebugLayerCallback([[maybe_unused]] D3D12_MESSAGE_CATEGORY category, D3D12_MESSAGE_SEVERITY severity, [[maybe_unused]] D3D12_MESSAGE_ID ID, const char* description, [[maybe_unused]] void* context)
+void RenderGraph::Reset()
 {
-    if (severity == D3D12_MESSAGE_SEVERITY_MESSAGE || severity == D3D12_MESSAGE_SEVERITY_MESSAGE)
-    {
-        PrintMessage("D3D Debug Layer: %s", description);
-        return;
-    }
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
 
-    PrintMessage("D3D Debug Layer Error: %s", description);
-    if (IsDebuggerPresent() == false)
-        ShowMessageBox("D3D Debug Layer Error: %s", description);
-    __debugbreak();
+    state->Resources.clear();
+    state->Usages.clear();
+    state->Passes.clear();
+    state->IsCompiled = false;
 }
 
-std::string GetDefaultAgilitySDKPath()
+uint32_t RenderGraph::ImportTexture(IDXLResource texture, RenderGraphUsage initialUsage)
 {
-    const char* sdkRelativePath = "..\\..\\..\\..\\..\\AgilitySDK\\bin\\x64";
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
 
-    char exePath[MAX_PATH] = { };
-    GetModuleFileNameA(nullptr, exePath, DXL_ARRAY_SIZE(exePath));
-    std::string sdkPath = GetDirectoryFromFilePath(exePath) + sdkRelativePath;
-    return ResolveFilePath(sdkPath.c_str());
+    RenderGraphState::Resource resource;
+    resource.NativeResource = texture;
+    resource.IsTexture = true;
+    resource.IsImported = true;
+    resource.Initial = { .Sync = initialUsage.Sync, .Access = initialUsage.Access, .Layout = initialUsage.Layout, .IsTexture = true };
+    return state->AddResource(std::move(resource));
 }
 
-CreateDeviceResult CreateDevice(CreateDeviceParams params)
+uint32_t RenderGraph::ImportBuffer(IDXLResource buffer, RenderGraphUsage initialUsage)
 {
-    ComPtr<IDXGIFactory7> factory;
-    HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
-    if (FAILED(hr))
-        return { IDXLDevice(), hr, "Failed to create DXGI factory" };
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
 
-    ComPtr<IDXGIAdapter4> adapter;
-    hr = factory->EnumAdapterByGpuPreference(0, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE, IID_PPV_ARGS(&adapter));
-    if (FAILED(hr))
-        return { IDXLDevice(), hr, "Failed to enumerate a DXGI adapter" };
+    RenderGraphState::Resource resource;
+    resource.NativeResource = buffer;
+    resource.IsImported = true;
+    resource.Initial = { .Sync = initialUsage.Sync, .Access = initialUsage.Access };
+    return state->AddResource(std::move(resource));
+}
 
-    DXGI_ADAPTER_DESC1 desc = { };
-    adapter->GetDesc1(&desc);
-    PrintMessage("Creating D3D12 device on adapter '%ls'", desc.Description);
+uint32_t RenderGraph::CreateTexture(const D3D12_RESOURCE_DESC1& desc, const D3D12_CLEAR_VALUE* optimizedClearValue)
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(state->Params.TransientAllocator != nullptr, "RenderGraph needs a TransientResourceAllocator to create textures");
 
-    ComPtr<ID3D12SDKConfiguration1> sdkConfig;
-    hr = D3D12GetInterface(CLSID_D3D12SDKConfiguration, IID_PPV_ARGS(&sdkConfig));
-    if (FAILED(hr))
-        return { IDXLDevice(), hr, "Failed to aquire the D3D12 SDK configuration interface" };
+    RenderGraphState::Resource resource;
+    resource.IsTexture = true;
+    resource.Desc = desc;
+    resource.HasClearValue = optimizedClearValue != nullptr;
+    if (resource.HasClearValue)
+        resource.ClearValue = *optimizedClearValue;
+    return state->AddResource(std::move(resource));
+}
 
-    ComPtr<ID3D12DeviceFactory> deviceFactory;
-    hr = sdkConfig->CreateDeviceFactory(D3D12_SDK_VERSION, params.AgilitySDKPath.c_str(), IID_PPV_ARGS(&deviceFactory));
-    if (FAILED(hr))
-        return { IDXLDevice(), hr, MakeString("Failed to create a D3D12 device factory using Agility SDK Path '%s'. Did you pass the wrong AgilitySDKPath?", params.AgilitySDKPath.c_str()) };
+uint32_t RenderGraph::CreateBuffer(uint64_t size, D3D12_RESOURCE_FLAGS flags)
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(state->Params.TransientAllocator != nullptr, "RenderGraph needs a TransientResourceAllocator to create buffers");
 
-#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
-    if (params.EnableDebugLayer)
+    RenderGraphState::Resource resource;
+    resource.Desc =
     {
-        ComPtr<ID3D12Debug1> d3d12debug;
-        if (SUCCEEDED(deviceFactory->GetConfigurationInterface(CLSID_D3D12Debug, DXL_PPV_ARGS(d3d12debug.GetAddressOf()))))
-        {
-            d3d12debug->EnableDebugLayer();
-            PrintMessage("Enabled D3D12 debug layer");
-        }
-
-        if (params.EnableGPUBasedValidation)
-            d3d12debug->SetEnableGPUBasedValidation(true);
-    }
-#endif
-
-    ComPtr<ID3D12Device14> device;
-    hr = deviceFactory->CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
-    if (FAILED(hr))
-        return { IDXLDevice(), hr, "Failed to create D3D12 device from the device factory" };
-
-    D3D12_FEATURE_DATA_D3D12_OPTIONS12 options12 = { };
-    device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options12, sizeof(options12));
-    if(options12.EnhancedBarriersSupported == false)
-        return { IDXLDevice(), E_FAIL, "The selected GPU does not support enhanced barriers, which is required for DXLatest" };
+        .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+        .Width = size,
+        .Height = 1,
+        .DepthOrArraySize = 1,
+        .MipLevels = 1,
+        .SampleDesc = { .Count = 1 },
+        .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        .Flags = flags,
+    };
+    return state->AddResource(std::move(resource));
+}
 
-#if DXL_ENABLE_DEVELOPER_ONLY_FEATURES
-    {
-        ComPtr<ID3D12InfoQueue1> infoQueue;
-        if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&infoQueue))))
-        {
-            D3D12MessageFunc callback = params.DebugLayerCallbackFunction ? params.DebugLayerCallbackFunction : DefaultDebugLayerCallback;
+void RenderGraph::SetFinalUsage(uint32_t resourceIndex, RenderGraphUsage finalUsage)
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(resourceIndex < state->Resources.size(), "Render graph resource index %u is out of range", resourceIndex);
 
-            DWORD callbackCookie = 0;
-            infoQueue->RegisterMessageCallback(callback, D3D12_MESSAGE_CALLBACK_FLAG_NONE, nullptr, &callbackCookie);
-        }
-    }
-#endif
+    RenderGraphState::Resource& resource = state->Resources[resourceIndex];
+    DXL_ASSERT(resource.IsImported, "Only imported resources can have a final usage");
 
-    device->AddRef();
-    return { device.Get(), S_OK };
+    resource.Final = { .Sync = finalUsage.Sync, .Access = finalUsage.Access, .Layout = resource.IsTexture ? finalUsage.Layout : D3D12_BARRIER_LAYOUT_UNDEFINED, .IsTexture = resource.IsTexture };
+    resource.HasFinalUsage = true;
+    state->IsCompiled = false;
 }
 
-void Release(IUnknown*& unknown)
+uint32_t RenderGraph::AddPass(const char* name, RenderGraphPassFunction function)
 {
-    if (unknown)
-    {
-        unknown->Release();
-        unknown = nullptr;
-    }
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+
+    state->Passes.push_back({ .Name = name, .Function = std::move(function) });
+    state->IsCompiled = false;
+    return uint32_t(state->Passes.size() - 1);
 }
 
-void Release(IDXLBase& base)
+void RenderGraph::SetSideEffects(uint32_t passIndex)
 {
-    if (base)
-    {
-        base->Release();
-        base = IDXLBase();
-    }
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(passIndex < state->Passes.size(), "Render graph pass index %u is out of range", passIndex);
+
+    state->Passes[passIndex].HasSideEffects = true;
+    state->IsCompiled = false;
 }
 
-namespace Helpers
+void RenderGraph::Read(uint32_t passIndex, uint32_t resourceIndex, RenderGraphUsage usage)
 {
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    state->AddUsage(passIndex, resourceIndex, usage, false);
+}
 
-std::string GetDefaultDXCPath()
+void RenderGraph::Write(uint32_t passIndex, uint32_t resourceIndex, RenderGraphUsage usage)
 {
-    const char* relativePath = "..\\..\\..\\..\\..\\dxc\\bin\\x64\\dxcompiler.dll";
-
-    char exePath[MAX_PATH] = { };
-    GetModuleFileNameA(nullptr, exePath, DXL_ARRAY_SIZE(exePath));
-    std::string dllPath = GetDirectoryFromFilePath(exePath) + relativePath;
-    return ResolveFilePath(dllPath.c_str());
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    state->AddUsage(passIndex, resourceIndex, usage, true);
 }
 
-static const char* ShaderTypeStrings[] =
+void RenderGraph::Compile()
 {
-    "vertex",
-    "hull",
-    "domain",
-    "geometry",
-    "amplification",
-    "mesh",
-    "pixel",
-    "compute",
-    "lib"
-};
-static_assert(DXL_ARRAY_SIZE(ShaderTypeStrings) == uint32_t(ShaderType::NumTypes));
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_TRACE_SCOPE("RenderGraph::Compile");
 
-static const wchar_t* ShaderProfileStrings[] =
-{
-    L"vs_6_8",
-    L"hs_6_8",
-    L"ds_6_8",
-    L"gs_6_8",
-    L"as_6_8",
-    L"ms_6_8",
-    L"ps_6_8",
-    L"cs_6_8",
-    L"lib_6_8"
-};
-static_assert(DXL_ARRAY_SIZE(ShaderProfileStrings) == uint32_t(ShaderType::NumTypes));
+    const uint64_t startTime = GetTraceTime();
+    const uint32_t numPasses = uint32_t(state->Passes.size());
 
-CompiledShader CompileShaderFromFile(CompileShaderParams params)
-{
-    if (uint32_t(params.Type) >= uint32_t(ShaderType::NumTypes))
+    state->Stats = { .NumPasses = numPasses };
+    for (RenderGraphState::Resource& resource : state->Resources)
     {
-        DXL_ERROR(E_FAIL, "Invalid ShaderType passed to CompileShaderFromFile");
-        return {};
+        resource.Current = resource.Initial;
+        resource.FirstPass = InvalidIndex;
+        resource.LastPass = InvalidIndex;
+        resource.TransientIndex = InvalidIndex;
+        if (resource.IsImported == false)
+            resource.NativeResource = IDXLResource();
     }
 
-    if (FileExists(params.FilePath) == false)
+    // There's a batch before each pass, plus one after the last pass for the final usages
+    if (state->Batches.size() < numPasses + 1)
+        state->Batches.resize(numPasses + 1);
+    for (uint32_t batchIdx = 0; batchIdx <= numPasses; ++batchIdx)
+        state->Batches[batchIdx].Clear();
+
+    state->SortUsages();
+    state->CullPasses();
+    state->PlaceTransientResources();
+
+    for (RenderGraphState::Resource& resource : state->Resources)
     {
-        DXL_ERROR(E_FAIL, MakeString("Shader file path '%s' does not exist", params.FilePath).c_str());
-        return {};
+        if (resource.IsImported)
+            resource.Current = resource.Initial;
+        resource.LastPass = InvalidIndex;
+        resource.LastBarrier = { };
+        resource.LastSplitBegin = { };
     }
 
-    static HMODULE dxcModule = nullptr;
-    if (dxcModule == nullptr)
+    for (uint32_t passIdx : state->AlivePasses)
     {
-        if (FileExists(params.PathToDXC.c_str()) == false)
+        state->MergePassUsages(passIdx);
+        for (const RenderGraphState::MergedUsage& merged : state->Merged)
         {
-            DXL_ERROR(E_FAIL, MakeString("dxcompiler.dll file path '%s' does not exist", params.PathToDXC.c_str()).c_str());
-            return {};
-        }
+            // Transient resources are already in the state of their first use after the acquire barrier
+            RenderGraphState::Resource& resource = state->Resources[merged.Resource];
+            if (resource.IsImported || resource.FirstPass != passIdx)
+                state->Transition(passIdx, resource, merged.State);
 
-        dxcModule = ::LoadLibrary(params.PathToDXC.c_str());
-        if (dxcModule == nullptr)
-        {
-            DXL_ERROR(E_FAIL, MakeString("Failed to load dxcompiler.dll from path '%s'", params.PathToDXC.c_str()).c_str());
-            return {};
+            resource.LastPass = passIdx;
         }
     }
 
-    static DxcCreateInstanceProc dxcCreateInstance = (DxcCreateInstanceProc)::GetProcAddress(dxcModule, "DxcCreateInstance");
-    DXL_ASSERT(dxcCreateInstance != nullptr, "Failed to find DxcCreateInstance from dxil.dll");
-
-    ComPtr<IDxcUtils> utils;
-    DXL_HANDLE_HRESULT_MSG(dxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils)), "Failed to create IDxcUtils instance");
-
-    ComPtr<IDxcCompiler3> compiler;
-    DXL_HANDLE_HRESULT_MSG(dxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler)), "Failed to create IDxcUtils instance");
-
-    std::vector<DxcDefine> dxcDefines;
-    std::vector<WideStringConverter> defineStrings;
-    if (params.Defines.Count > 0)
+    for (RenderGraphState::Resource& resource : state->Resources)
     {
-        dxcDefines.reserve(params.Defines.Count);
-        defineStrings.reserve(params.Defines.Count);
-        for (const PreprocessorDefine& define : params.Defines)
-        {
-            const wchar_t* defineName = defineStrings.emplace_back(define.Name).wideString;
-            const wchar_t* defineValue = defineStrings.emplace_back(MakeString("%i", define.Value).c_str()).wideString;
-            dxcDefines.emplace_back(defineName, defineValue);
-        }
+        if (resource.HasFinalUsage)
+            state->Transition(numPasses, resource, resource.Final);
     }
 
-    std::vector<const wchar_t*> compileArgs;
-    compileArgs.emplace_back(L"-HV 2021");
-    compileArgs.emplace_back(L"-enable-16bit-types");
-    if (params.WarningsAsErrors)
-        compileArgs.emplace_back(L"-WX");
-    compileArgs.emplace_back(params.EnableOptimizations ? L"-O3" : L"-O0");
-    if (params.EnableDebugInfo)
+    state->Stats.NumCulledPasses = numPasses - uint32_t(state->AlivePasses.size());
+    for (uint32_t batchIdx = 0; batchIdx <= numPasses; ++batchIdx)
     {
-        compileArgs.emplace_back(L"-Zi");
-        compileArgs.emplace_back(L"-Qembed_debug");
+        const RenderGraphState::BarrierBatch& batch = state->Batches[batchIdx];
+        if (batch.TextureBarriers.size() > 0 || batch.BufferBarriers.size() > 0)
+            state->Stats.NumBarrierCalls += 1;
     }
-    if (params.RowMajorByDefault)
-        compileArgs.emplace_back(L"-Zpr");
 
-    std::vector<WideStringConverter> includeDirs;
-    if (params.IncludeDirectories.Count > 0)
+    state->Stats.CompileTimeMS = double(GetTraceTime() - startTime) / 1000000.0;
+    state->IsCompiled = true;
+}
+
+void RenderGraph::Execute(IDXLCommandList commandList)
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(state->IsCompiled, "RenderGraph needs to be compiled before it's executed");
+
+    auto recordBatch = [&](uint32_t batchIdx)
     {
-        includeDirs.reserve(params.IncludeDirectories.Count);
-        for (const char* includeDir : params.IncludeDirectories)
+        const RenderGraphState::BarrierBatch& batch = state->Batches[batchIdx];
+        D3D12_BARRIER_GROUP groups[2] = { };
+        uint32_t numGroups = 0;
+        if (batch.BufferBarriers.size() > 0)
         {
-            const wchar_t* includeDirW = includeDirs.emplace_back(includeDir).wideString;
-            compileArgs.emplace_back(L"-I");
-            compileArgs.emplace_back(includeDirW);
+            groups[numGroups].Type = D3D12_BARRIER_TYPE_BUFFER;
+            groups[numGroups].NumBarriers = uint32_t(batch.BufferBarriers.size());
+            groups[numGroups].pBufferBarriers = batch.BufferBarriers.data();
+            numGroups += 1;
+        }
+        if (batch.TextureBarriers.size() > 0)
+        {
+            groups[numGroups].Type = D3D12_BARRIER_TYPE_TEXTURE;
+            groups[numGroups].NumBarriers = uint32_t(batch.TextureBarriers.size());
+            groups[numGroups].pTextureBarriers = batch.TextureBarriers.data();
+            numGroups += 1;
         }
-    }
-
-    const wchar_t* profileString = ShaderProfileStrings[uint32_t(params.Type)];
-    const char* entryPoint = params.Type != ShaderType::Library ? params.EntryPoint : "";
-
-    ComPtr<IDxcCompilerArgs> dxcCompilerArgs;
-    DXL_HANDLE_HRESULT_MSG(utils->BuildArguments(WideStringConverter(params.FilePath).wideString, WideStringConverter(entryPoint).wideString, profileString, compileArgs.data(), uint32_t(compileArgs.size()), dxcDefines.data(), uint32_t(dxcDefines.size()), &dxcCompilerArgs), "Failed to build DXC compile args");
 
-    ComPtr<IDxcIncludeHandler> includeHandler;
-    DXL_HANDLE_HRESULT_MSG(utils->CreateDefaultIncludeHandler(&includeHandler), "Failed to create default include handler");
+        if (commandList && numGroups > 0)
+            commandList.Barrier(numGroups, groups);
+    };
 
-    while (true)
+    for (uint32_t passIdx : state->AlivePasses)
     {
-        ComPtr<IDxcBlobEncoding> sourceCode;
-        DXL_HANDLE_HRESULT_MSG(utils->LoadFile(WideStringConverter(params.FilePath).wideString, nullptr, &sourceCode), "Failed to create IDxcBlobEncoding from the file path");
-
-        DxcBuffer sourceBuffer;
-        sourceBuffer.Ptr = sourceCode->GetBufferPointer();
-        sourceBuffer.Size = sourceCode->GetBufferSize();
-        sourceBuffer.Encoding = 0;
+        recordBatch(passIdx);
 
-        ComPtr<IDxcResult> operationResult;
-        DXL_HANDLE_HRESULT_MSG(compiler->Compile(&sourceBuffer, dxcCompilerArgs->GetArguments(), dxcCompilerArgs->GetCount(), includeHandler.Get(), IID_PPV_ARGS(&operationResult)), "IDxcCompiler3::Compile failed unexpectedly");
-
-        HRESULT hr = S_OK;
-        operationResult->GetStatus(&hr);
-        if (SUCCEEDED(hr))
+        const RenderGraphState::Pass& pass = state->Passes[passIdx];
+        if (pass.Function)
         {
-            ComPtr<IDxcBlob> compiledShader;
-            DXL_HANDLE_HRESULT_MSG(operationResult->GetResult(&compiledShader), "Failed to get compiled shader data from dxc result");
-
-            const size_t byteCodeSize = compiledShader->GetBufferSize();
+            TraceScope traceScope(pass.Name, "RenderGraph");
+            pass.Function(commandList);
+        }
+    }
 
-            CompiledShader result;
-            result.Bytecode.resize(byteCodeSize);
-            memcpy(result.Bytecode.data(), compiledShader->GetBufferPointer(), byteCodeSize);
-            result.Type = params.Type;
+    recordBatch(uint32_t(state->Passes.size()));
+}
 
-            return result;
-        }
-        else
-        {
-            ComPtr<IDxcBlobEncoding> errorMessages;
-            operationResult->GetErrorBuffer(&errorMessages);
+IDXLResource RenderGraph::GetResource(uint32_t resourceIndex) const
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(resourceIndex < state->Resources.size(), "Render graph resource index %u is out of range", resourceIndex);
+    return state->Resources[resourceIndex].NativeResource;
+}
 
-            const char* errMsgStr = reinterpret_cast<const char*>(errorMessages->GetBufferPointer());
-            std::string fullMessage = MakeString("Error compiling shader file \"%s\" - ", params.FilePath);
-            fullMessage += errMsgStr;
+bool RenderGraph::IsPassCulled(uint32_t passIndex) const
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(state->IsCompiled, "RenderGraph needs to be compiled first");
+    DXL_ASSERT(passIndex < state->Passes.size(), "Render graph pass index %u is out of range", passIndex);
+    return state->Passes[passIndex].IsCulled;
+}
 
-            if (params.LoopOnError)
-            {
-                // Pop up a message box allowing user to retry compilation
-                int32_t retVal = MessageBox(nullptr, fullMessage.c_str(), "Shader Compilation Error", MB_RETRYCANCEL);
-                if (retVal != IDRETRY)
-                {
-                    DXL_ERROR(E_FAIL, fullMessage.c_str());
-                    break;
-                }
-            }
-            else
-            {
-                DXL_ERROR(E_FAIL, fullMessage.c_str());
-                break;
-            }
-        }
-    }
+void RenderGraph::GetPassBarriers(uint32_t passIndex, std::vector<D3D12_TEXTURE_BARRIER>& textureBarriers, std::vector<D3D12_BUFFER_BARRIER>& bufferBarriers) const
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    DXL_ASSERT(state->IsCompiled, "RenderGraph needs to be compiled first");
+    DXL_ASSERT(passIndex <= state->Passes.size(), "Render graph pass index %u is out of range", passIndex);
 
-    return { };
+    const RenderGraphState::BarrierBatch& batch = state->Batches[passIndex];
+    textureBarriers.insert(textureBarriers.end(), batch.TextureBarriers.begin(), batch.TextureBarriers.end());
+    bufferBarriers.insert(bufferBarriers.end(), batch.BufferBarriers.begin(), batch.BufferBarriers.end());
 }
 
-} // namespace Helpers
+RenderGraphStats RenderGraph::GetStats() const
+{
+    DXL_ASSERT(state != nullptr, "RenderGraph isn't initialized");
+    return state->Stats;
+}
 
 #endif // DXL_ENABLE_EXTENSIONS
 
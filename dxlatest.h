@@ -34,6 +34,8 @@
 #if DXL_ENABLE_EXTENSIONS
 #include <vector>
 #include <string>
+#include <memory>
+#include <functional>
 #endif
 
 namespace DXL
@@ -354,6 +356,44 @@ public:
     DXL_INTERFACE_BOILERPLATE(IDXLCommandSignature, ID3D12CommandSignature);
 };
 
+#if DXL_ENABLE_EXTENSIONS
+
+// Opt-in behavior for command lists created through IDXLDevice::CreateCommandList. Command lists that are wrapped
+// directly from a native pointer don't have any of these features enabled and forward every call immediately.
+enum DXL_COMMAND_LIST_FEATURE_FLAGS
+{
+    DXL_COMMAND_LIST_FEATURE_FLAG_NONE = 0,
+
+    // The single-barrier Barrier() overloads append to a pending list that is submitted with one Barrier() call right
+    // before the next draw, dispatch, copy, clear, resolve, query, render pass, or Close(). Barrier groups keep the
+    // order the barriers were recorded in.
+    DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS = 0x1,
+
+    // SetPipelineState, Set*RootSignature, IASetPrimitiveTopology, RSSetViewports, RSSetScissorRects, SetDescriptorHeaps,
+    // and OMSetRenderTargets are dropped when their arguments match what was last set on the command list. If you set
+    // state through the native interface, call InvalidateStateCache() afterwards.
+    DXL_COMMAND_LIST_FEATURE_FLAG_FILTER_REDUNDANT_STATE = 0x2,
+
+    // Root constants and root CBV/SRV/UAV arguments are recorded into a staging block and only the values that changed
+    // are sent right before the next draw, dispatch, or ExecuteIndirect, with adjacent constants merged into one call.
+    // Only applies to root signatures created through IDXLDevice::CreateRootSignature(D3D12_ROOT_SIGNATURE_DESC2), other
+    // root signatures have their arguments forwarded immediately.
+    DXL_COMMAND_LIST_FEATURE_FLAG_DEFER_ROOT_ARGUMENTS = 0x4,
+
+    DXL_COMMAND_LIST_FEATURE_FLAG_DEFAULT = DXL_COMMAND_LIST_FEATURE_FLAG_NONE,
+};
+DEFINE_ENUM_FLAG_OPERATORS(DXL_COMMAND_LIST_FEATURE_FLAGS);
+
+struct DXL_COMMAND_LIST_STATE_FILTER_STATS
+{
+    uint64_t CallsForwarded = 0;
+    uint64_t CallsElided = 0;
+};
+
+class CommandListState;
+
+#endif
+
 class IDXLCommandList : public IDXLDeviceChild
 {
 public:
@@ -385,6 +425,16 @@ public:
     void Barrier(D3D12_GLOBAL_BARRIER barrier);
     void Barrier(D3D12_BUFFER_BARRIER barrier);
     void Barrier(D3D12_TEXTURE_BARRIER barrier);
+
+    // Submits any barriers batched by DXL_COMMAND_LIST_FEATURE_FLAG_BATCH_BARRIERS. This happens automatically before
+    // any GPU work is recorded, so you only need this before recording commands through the native interface.
+    void FlushBarriers();
+
+    // Forgets all state tracked by DXL_COMMAND_LIST_FEATURE_FLAG_FILTER_REDUNDANT_STATE, so the next call to each setter
+    // is forwarded to the native command list
+    void InvalidateStateCache();
+    DXL_COMMAND_LIST_STATE_FILTER_STATS GetStateFilterStats() const;
+    void ResetStateFilterStats();
 #endif
 
     void ResolveSubresource(IDXLResource dstResource, uint32_t dstSubresource, IDXLResource srcResource, uint32_t srcSubresource, DXGI_FORMAT format);
@@ -506,6 +556,23 @@ public:
     void BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* desc, uint32_t numPostbuildInfoDescs, const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* postbuildInfoDescs);
     void EmitRaytracingAccelerationStructurePostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* desc, uint32_t numSourceAccelerationStructures, const D3D12_GPU_VIRTUAL_ADDRESS* sourceAccelerationStructureData);
     void CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS destAccelerationStructureData, D3D12_GPU_VIRTUAL_ADDRESS sourceAccelerationStructureData, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode);
+
+#if DXL_ENABLE_EXTENSIONS
+private:
+
+    // The state lives in the native command list's private data, so every wrapper of the same list shares it.
+    // The lookup is cached until the wrapper is pointed at a different list.
+    CommandListState* GetExtensionState() const
+    {
+        if (extensionStateOwner != nativeInterface)
+            LookUpExtensionState();
+        return cachedExtensionState;
+    }
+    void LookUpExtensionState() const;
+
+    mutable IUnknown* extensionStateOwner = nullptr;
+    mutable CommandListState* cachedExtensionState = nullptr;
+#endif
 };
 
 class IDXLCommandQueue : public IDXLPageable
@@ -583,6 +650,38 @@ struct DXL_MESH_SHADER_GRAPHICS_PSO_DESC
     D3D12_RT_FORMAT_ARRAY RenderTargetFormats = { };
 };
 
+struct DXL_HASH128
+{
+    uint64_t Lo = 0;
+    uint64_t Hi = 0;
+
+    bool operator==(const DXL_HASH128& other) const = default;
+};
+
+struct DXL_PSO_CACHE_STATS
+{
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t Inserts = 0;
+    uint64_t NumPipelines = 0;
+};
+
+namespace Helpers
+{
+
+// Hashes everything that affects the compiled pipeline: shader bytecode, fixed-function state, formats, and the root
+// signature. Root signatures made by IDXLDevice::CreateRootSignature are hashed by their serialized contents, others
+// by address. These are the keys used by the device PSO cache.
+DXL_HASH128 HashPSODesc(const DXL_SIMPLE_GRAPHICS_PSO_DESC& desc);
+DXL_HASH128 HashPSODesc(const DXL_MESH_SHADER_GRAPHICS_PSO_DESC& desc);
+DXL_HASH128 HashPSODesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+
+} // namespace Helpers
+
+class DeviceState;
+struct CreateDeviceParams;
+struct CreateDeviceResult;
+
 #endif
 
 class IDXLDevice : public IDXLObject
@@ -604,7 +703,7 @@ public:
 #if DXL_ENABLE_EXTENSIONS
     IDXLCommandQueue CreateCommandQueue(D3D12_COMMAND_QUEUE_DESC desc);
     IDXLCommandAllocator CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type);
-    IDXLCommandList CreateCommandList(D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags = D3D12_COMMAND_LIST_FLAG_NONE);
+    IDXLCommandList CreateCommandList(D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags = D3D12_COMMAND_LIST_FLAG_NONE, DXL_COMMAND_LIST_FEATURE_FLAGS features = DXL_COMMAND_LIST_FEATURE_FLAG_DEFAULT);
 #endif
 
     HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, REFIID riid, void** outPipelineState);
@@ -620,6 +719,14 @@ public:
     IDXLPipelineState CreateGraphicsPSO(DXL_MESH_SHADER_GRAPHICS_PSO_DESC desc);
     IDXLStateObject CreateStateObject(D3D12_STATE_OBJECT_DESC desc);
     IDXLStateObject AddToStateObject(D3D12_STATE_OBJECT_DESC addition, IDXLStateObject stateObjectToGrowFrom);
+
+    // Only available on devices created with CreateDeviceParams::EnablePSOCache. The cache holds a reference to every
+    // PSO and root signature in it (and therefore to the device), so it has to be cleared before the device can be
+    // destroyed. This is done by Release(IDXLDevice&), or call ClearPSOCache() yourself if you release the device some
+    // other way.
+    // ClearPSOCache() must not be called while other threads are creating PSOs.
+    DXL_PSO_CACHE_STATS GetPSOCacheStats() const;
+    void ClearPSOCache();
 #endif
 
     HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* descriptorHeapDesc, REFIID riid, void** outHeap);
@@ -773,6 +880,13 @@ public:
     HRESULT SetStablePowerState(bool enable);
     HRESULT SetBackgroundProcessingMode(D3D12_BACKGROUND_PROCESSING_MODE mode, D3D12_MEASUREMENTS_ACTION measurementsAction, HANDLE eventToSignalUponCompletion, BOOL* outFurtherMeasurementsDesired);
 #endif
+
+#if DXL_ENABLE_EXTENSIONS
+private:
+    friend CreateDeviceResult CreateDevice(CreateDeviceParams params);
+
+    DeviceState* extensionState = nullptr;
+#endif
 };
 
 class IDXLSwapChain : public IDXLBase
@@ -928,6 +1042,9 @@ struct CreateDeviceParams
     bool EnableDebugLayer = false;
     bool EnableGPUBasedValidation = true;
     D3D12MessageFunc DebugLayerCallbackFunction = nullptr;
+
+    // Makes CreateGraphicsPSO/CreateComputePSO return an existing PSO when called with an identical description
+    bool EnablePSOCache = false;
 };
 
 struct CreateDeviceResult
@@ -942,6 +1059,10 @@ CreateDeviceResult CreateDevice(CreateDeviceParams params);
 void Release(IUnknown*& unknown);
 void Release(IDXLBase& base);
 
+// Clears the device's PSO cache (see IDXLDevice::ClearPSOCache) before releasing it, since the cached PSOs would
+// otherwise keep the device alive
+void Release(IDXLDevice& device);
+
 template<typename TInterface> IID GetIID(TInterface** ptrToInterface) { return __uuidof(**ptrToInterface); }
 template<typename TDXLInterface> IID GetIID([[maybe_unused]] TDXLInterface* ptrToInterface) { return TDXLInterface::InterfaceID(); }
 
@@ -977,11 +1098,20 @@ struct PreprocessorDefine
     const int32_t Value = 0;
 };
 
+struct ShaderDependency
+{
+    std::string FilePath;
+    DXL_HASH128 ContentHash;
+};
+
 struct CompiledShader
 {
     std::vector<uint8_t> Bytecode;
     ShaderType Type = ShaderType::Invalid;
 
+    // The source file followed by every file that it included, with the hashes of their contents when compiled
+    std::vector<ShaderDependency> Dependencies;
+
     D3D12_SHADER_BYTECODE ToD3D12Bytecode() const
     {
         return { .pShaderBytecode = Bytecode.data(), .BytecodeLength = Bytecode.size() };
@@ -993,6 +1123,9 @@ struct CompiledShader
     }
 };
 
+// Called when a compile fails and LoopOnError is set, return true to retry the compile
+using ShaderCompileRetryFunction = bool(*)(const char* errorMessage);
+
 struct CompileShaderParams
 {
     ShaderType Type = ShaderType::Invalid;
@@ -1001,17 +1134,1424 @@ struct CompileShaderParams
     Span<const PreprocessorDefine> Defines = { };
     Span<const char*> IncludeDirectories = { };
     bool LoopOnError = true;
+    ShaderCompileRetryFunction RetryCallback = nullptr;    // Uses a retry/cancel message box when null
     bool WarningsAsErrors = true;
     bool EnableOptimizations = true;
     bool EnableDebugInfo = false;
     bool RowMajorByDefault = true;
     std::string PathToDXC = GetDefaultDXCPath();
+
+    // Compiled bytecode is cached in this directory when it's set, keyed by the source, includes, arguments, and DXC version
+    std::string CacheDirectory;
+    uint64_t CacheSizeLimit = 1024ull * 1024 * 1024;
+};
+
+struct CompileShaderResult
+{
+    CompiledShader Shader;
+    HRESULT Result = S_OK;
+    std::string ErrorMessage;
 };
 
 CompiledShader CompileShaderFromFile(CompileShaderParams params);
 
+// Compiles all of the shaders on a pool of threads (0 uses one per hardware thread), with one DXC compiler per thread
+// and include files shared between all compiles. Errors are returned per shader instead of going through the error
+// callback, and LoopOnError is ignored. Results are in the same order as the params.
+std::vector<CompileShaderResult> CompileShadersBatch(Span<const CompileShaderParams> params, uint32_t numThreads = 0);
+
+// Included files are loaded once and shared by all compiles in the process, and reloaded when their size or write
+// time changes. This frees the loaded files.
+void ClearShaderIncludeCache();
+
+// Hashes the current contents of a file, for adding files that shaders depend on outside of compilation (such as
+// generated headers) to a ShaderDependencyGraph. A file that can't be read gets a zero hash.
+ShaderDependency GetShaderDependency(const char* filePath);
+
+class ShaderDependencyGraphState;
+
+// Tracks the files that compiled shaders depend on, so that only the shaders affected by a file change need to be
+// recompiled. Shaders are identified by an arbitrary ID chosen by the caller.
+class ShaderDependencyGraph
+{
+
+public:
+
+    ShaderDependencyGraph();
+    ~ShaderDependencyGraph();
+
+    ShaderDependencyGraph(const ShaderDependencyGraph&) = delete;
+    ShaderDependencyGraph& operator=(const ShaderDependencyGraph&) = delete;
+
+    // Replaces any dependencies that were previously added for the same shader
+    void AddShader(uint64_t shaderID, Span<const ShaderDependency> dependencies);
+    void RemoveShader(uint64_t shaderID);
+    void Clear();
+
+    uint32_t NumShaders() const;
+
+    // Returns the shaders that depend on the file, either directly or through an include
+    std::vector<uint64_t> GetDependentShaders(const char* filePath) const;
+
+    // Re-hashes the files whose size or write time changed since they were last checked, and returns the shaders
+    // that were compiled with different contents for at least one of their files (or depend on a file that's gone)
+    std::vector<uint64_t> FindStaleShaders();
+
+    // The number of times that FindStaleShaders saw a file change after it was first checked
+    uint64_t NumFileChanges() const;
+
+private:
+
+    std::unique_ptr<ShaderDependencyGraphState> state;
+};
+
 } // namespace Helpers
 
-#endif  // DXL_ENABLE_EXTENSIONS
+enum class PipelinePriority : uint32_t
+{
+    // Needed for something that's about to be drawn, always compiled ahead of any prewarm requests
+    Immediate = 0,
+
+    // Speculative compiles ahead of first use, which get dropped when the queue is full
+    Prewarm,
+
+    NumValues
+};
+
+struct PipelineCompilerParams
+{
+    IDXLDevice Device;
+    uint32_t NumThreads = 0;                // 0 uses one less than the number of hardware threads
+    uint32_t MaxQueuedRequests = 1024;
+};
+
+class PipelineCompileJob;
+
+// Future-like handle to a PSO that's being compiled by a PipelineCompiler. Copies refer to the same request, and the
+// PSO is released along with the last copy.
+class PipelineRequest
+{
+
+public:
+
+    bool IsValid() const;
+    bool IsReady() const;
+
+    // Dropped prewarm requests and requests still queued at Shutdown never become ready, and Wait() returns null
+    bool IsCancelled() const;
+
+    // Blocks until the PSO is compiled. If no worker has picked up the request yet, it's compiled on the calling thread.
+    IDXLPipelineState Wait() const;
+
+    // Returns the compiled PSO if it's ready, otherwise the fallback PSO (which may be null)
+    IDXLPipelineState GetPSO() const;
+    void SetFallback(IDXLPipelineState fallbackPSO);
+
+private:
+
+    friend class PipelineCompiler;
+
+    std::shared_ptr<PipelineCompileJob> job;
+};
+
+class PipelineCompilerState;
+
+// Compiles PSOs on a pool of worker threads. The shader bytecode and root signatures referenced by the descs need
+// to stay alive until the request is ready.
+class PipelineCompiler
+{
+
+public:
+
+    PipelineCompiler();
+    ~PipelineCompiler();
+
+    PipelineCompiler(const PipelineCompiler&) = delete;
+    PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+    void Initialize(PipelineCompilerParams params);
+    void Shutdown();
+
+    // When the queue is full, prewarm requests come back invalid and immediate requests replace the oldest prewarm one
+    PipelineRequest CompileGraphicsPSO(DXL_SIMPLE_GRAPHICS_PSO_DESC desc, PipelinePriority priority = PipelinePriority::Immediate);
+    PipelineRequest CompileGraphicsPSO(DXL_MESH_SHADER_GRAPHICS_PSO_DESC desc, PipelinePriority priority = PipelinePriority::Immediate);
+    PipelineRequest CompileComputePSO(D3D12_COMPUTE_PIPELINE_STATE_DESC desc, PipelinePriority priority = PipelinePriority::Immediate);
+
+    // Runs an arbitrary function that produces a PSO on the workers, with the same scheduling as the other requests
+    PipelineRequest Compile(std::function<IDXLPipelineState()> compileFunction, PipelinePriority priority = PipelinePriority::Immediate);
+
+    uint32_t NumQueuedRequests() const;
+
+private:
+
+    std::unique_ptr<PipelineCompilerState> state;
+};
+
+struct ShaderHotReloaderParams
+{
+    bool StartWatcherThread = true;         // Otherwise changes are only picked up by calling ProcessChanges
+    uint32_t PollIntervalMS = 100;          // How often the watcher thread checks the file stamps
+    uint32_t DebounceMS = 200;              // Files need to stop changing for this long before they're compiled
+    uint32_t NumCompileThreads = 0;         // 0 uses one per hardware thread
+
+    // Called after a shader is compiled, with a null error message if it succeeded. Errors are printed if not set.
+    std::function<void(uint64_t shaderID, const char* errorMessage)> OnShaderCompiled;
+
+    // Called with each PSO that gets replaced or removed, so that it can be released once the GPU is done with it.
+    // If this isn't set the PSOs are kept alive until Shutdown.
+    std::function<void(IDXLPipelineState retiredPSO)> OnPSORetired;
+
+    // Replacements for the clock and for CompileShadersBatch, for testing without waiting or DXC
+    std::function<uint64_t()> GetTimeMS;
+    std::function<std::vector<Helpers::CompileShaderResult>(Span<const Helpers::CompileShaderParams> params)> CompileFunction;
+};
+
+class ShaderHotReloaderState;
+
+// Watches the files that shaders depend on by polling their file stamps, and recompiles the shaders on a background
+// thread when they change. Registered PSOs are rebuilt on the same thread and swapped in once they're ready, and
+// shaders that fail to compile keep their previous bytecode.
+class ShaderHotReloader
+{
+
+public:
+
+    ShaderHotReloader();
+    ~ShaderHotReloader();
+
+    ShaderHotReloader(const ShaderHotReloader&) = delete;
+    ShaderHotReloader& operator=(const ShaderHotReloader&) = delete;
+
+    void Initialize(ShaderHotReloaderParams params = { });
+    void Shutdown();
+
+    // Compiles the shader on the calling thread and starts watching it. The params are copied, and the ID stays
+    // valid even if the first compile fails.
+    uint64_t AddShader(const Helpers::CompileShaderParams& params);
+    void RemoveShader(uint64_t shaderID);
+
+    // Returns the most recent bytecode that compiled successfully, which can be empty if it never did
+    std::shared_ptr<const Helpers::CompiledShader> GetShader(uint64_t shaderID) const;
+
+    // The create function is called right away on the calling thread, and then again on the watcher thread whenever
+    // one of the shaders changes. It should get its bytecode through GetShader.
+    uint64_t AddPipeline(Span<const uint64_t> shaderIDs, std::function<IDXLPipelineState()> createFunction);
+    void RemovePipeline(uint64_t pipelineID);
+
+    // The returned PSO is owned by the reloader, and stays alive until it gets retired
+    IDXLPipelineState GetPipeline(uint64_t pipelineID) const;
+
+    // Synchronously recompiles any shaders whose files changed and rebuilds their PSOs, returning the number of
+    // shaders that compiled successfully. This is what the watcher thread runs on every poll. Nothing is compiled
+    // until DebounceMS has passed since the last change that was seen, so an editor that's still writing the file
+    // doesn't trigger a compile.
+    uint32_t ProcessChanges();
+
+private:
+
+    std::unique_ptr<ShaderHotReloaderState> state;
+};
+
+struct UploadRingParams
+{
+    IDXLDevice Device;                      // If null the ring uses CPU memory with fake GPU addresses, for testing
+    IDXLFence Fence;                        // Compared against the values passed to Retire
+    uint64_t Size = 16 * 1024 * 1024;
+    uint64_t BlockSize = 64 * 1024;         // Threads allocate out of blocks of this size without taking a lock
+};
+
+struct UploadAllocation
+{
+    void* CPUAddress = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS GPUAddress = 0;
+    IDXLResource Resource;                  // Owned by the ring, and null for a ring without a device
+    uint64_t Offset = 0;                    // Offset of the allocation within the resource
+    uint64_t Size = 0;
+
+    bool IsValid() const { return CPUAddress != nullptr; }
+};
+
+class UploadRingState;
+
+// Linear allocator for per-frame upload data, backed by a persistently mapped UPLOAD buffer that's used as a ring.
+// Allocate is thread safe, but Retire shouldn't race with allocations for the frame being retired.
+class UploadRing
+{
+
+public:
+
+    static constexpr uint64_t MaxAlignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+    UploadRing();
+    ~UploadRing();
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    void Initialize(UploadRingParams params);
+    void Shutdown();
+
+    // Blocks on the fence if the ring is full, and returns an invalid allocation if it can't fit. The alignment needs
+    // to be a power of 2 that's no larger than MaxAlignment.
+    UploadAllocation Allocate(uint64_t size, uint64_t alignment);
+    UploadAllocation AllocateConstantBuffer(uint64_t size) { return Allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT); }
+    UploadAllocation AllocateRawBuffer(uint64_t size) { return Allocate(size, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT); }
+
+    // Tags everything allocated since the previous call with the fence value that's signaled after the GPU uses it
+    void Retire(uint64_t fenceValue);
+
+    // Frees everything that was retired with a fence value <= completedValue, which Allocate does when it's full
+    void ReleaseCompleted(uint64_t completedValue);
+
+    IDXLResource GetResource() const;
+    uint64_t GetBytesInUse() const;
+
+private:
+
+    std::unique_ptr<UploadRingState> state;
+};
+
+struct OffsetAllocation
+{
+    uint64_t Offset = UINT64_MAX;
+    uint64_t Size = 0;
+    uint32_t NodeIndex = UINT32_MAX;
+
+    bool IsValid() const { return NodeIndex != UINT32_MAX; }
+};
+
+struct OffsetAllocatorStats
+{
+    uint64_t Size = 0;
+    uint64_t UsedSize = 0;
+    uint64_t LargestFreeRegion = 0;
+    uint32_t NumAllocations = 0;
+    uint32_t NumFreeRegions = 0;
+
+    // 0 when all of the free space is in one region, approaching 1 as it gets split into smaller regions
+    float Fragmentation = 0.0f;
+};
+
+class OffsetAllocatorState;
+
+// Two-level segregated fit (TLSF) allocator that manages offsets into a range without touching any memory, which
+// makes allocating and freeing O(1). Offsets and sizes are rounded up to the granularity.
+class OffsetAllocator
+{
+
+public:
+
+    OffsetAllocator();
+    ~OffsetAllocator();
+
+    OffsetAllocator(const OffsetAllocator&) = delete;
+    OffsetAllocator& operator=(const OffsetAllocator&) = delete;
+
+    void Initialize(uint64_t size, uint64_t granularity = 1);
+    void Shutdown();
+
+    // Returns an invalid allocation if there isn't a large enough free region. The alignment must be a power of 2.
+    OffsetAllocation Allocate(uint64_t size, uint64_t alignment = 1);
+    void Free(OffsetAllocation allocation);
+
+    OffsetAllocatorStats GetStats() const;
+
+private:
+
+    std::unique_ptr<OffsetAllocatorState> state;
+};
+
+struct ResourceAllocatorParams
+{
+    IDXLDevice Device;
+    uint64_t HeapSize = 64 * 1024 * 1024;
+    uint64_t DedicatedThreshold = 32 * 1024 * 1024;     // Resources at least this large get their own committed resource
+};
+
+struct ResourceAllocation
+{
+    IDXLResource Resource;
+    IDXLHeap Heap;                  // Null for committed resources
+    uint64_t HeapOffset = 0;
+    uint64_t Size = 0;
+
+    // Used by the allocator to find the memory when freeing
+    uint32_t PoolIndex = UINT32_MAX;
+    uint32_t HeapIndex = UINT32_MAX;
+    OffsetAllocation HeapAllocation;
+
+    bool IsValid() const { return Resource != nullptr; }
+};
+
+struct ResourceHeapStats
+{
+    D3D12_HEAP_TYPE HeapType = D3D12_HEAP_TYPE_DEFAULT;
+    D3D12_HEAP_FLAGS HeapFlags = D3D12_HEAP_FLAG_NONE;
+    OffsetAllocatorStats Stats;
+};
+
+class ResourceAllocatorState;
+
+// Places resources in pooled heaps, falling back to committed resources for ones that are too large
+class ResourceAllocator
+{
+
+public:
+
+    ResourceAllocator();
+    ~ResourceAllocator();
+
+    ResourceAllocator(const ResourceAllocator&) = delete;
+    ResourceAllocator& operator=(const ResourceAllocator&) = delete;
+
+    void Initialize(ResourceAllocatorParams params);
+    void Shutdown();
+
+    ResourceAllocation CreateResource(
+        D3D12_HEAP_TYPE heapType,
+        D3D12_RESOURCE_DESC1 desc,
+        D3D12_BARRIER_LAYOUT initialLayout = D3D12_BARRIER_LAYOUT_UNDEFINED,
+        const D3D12_CLEAR_VALUE* optimizedClearValue = nullptr,
+        Span<const DXGI_FORMAT> castableFormats = Span<const DXGI_FORMAT>()
+    );
+
+    // Releases the resource and returns its memory to the heap, so the GPU needs to be done with it
+    void Free(ResourceAllocation& allocation);
+
+    std::vector<ResourceHeapStats> GetHeapStats() const;
+
+private:
+
+    std::unique_ptr<ResourceAllocatorState> state;
+};
+
+struct BindlessDescriptorHeapParams
+{
+    IDXLDevice Device;                      // If null the heap is simulated with fake handles, for testing
+    IDXLFence Fence;                        // Compared against the values passed to Retire
+    D3D12_DESCRIPTOR_HEAP_TYPE Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    uint32_t NumPersistentDescriptors = 16 * 1024;
+    uint32_t NumTransientDescriptors = 16 * 1024;
+    bool ShaderVisible = true;              // Ignored for RTV and DSV heaps, which can't be shader visible
+};
+
+struct DescriptorAllocation
+{
+    uint32_t Index = UINT32_MAX;            // Index into ResourceDescriptorHeap/SamplerDescriptorHeap in SM 6.6
+    uint32_t Count = 0;
+    D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle = { };
+    D3D12_GPU_DESCRIPTOR_HANDLE GPUHandle = { };
+
+    bool IsValid() const { return Index != UINT32_MAX; }
+};
+
+class BindlessDescriptorHeapState;
+
+// Descriptor heap with persistent descriptors at the start and a ring of per-frame transient descriptors at the end.
+// Everything except Retire is thread safe. Shader-visible sampler heaps are limited to 2048 descriptors.
+class BindlessDescriptorHeap
+{
+
+public:
+
+    BindlessDescriptorHeap();
+    ~BindlessDescriptorHeap();
+
+    BindlessDescriptorHeap(const BindlessDescriptorHeap&) = delete;
+    BindlessDescriptorHeap& operator=(const BindlessDescriptorHeap&) = delete;
+
+    void Initialize(BindlessDescriptorHeapParams params);
+    void Shutdown();
+
+    // Returns an invalid allocation if all of the persistent descriptors are in use
+    DescriptorAllocation AllocatePersistent();
+    void FreePersistent(DescriptorAllocation& allocation);
+
+    // Contiguous descriptors that are valid until the frame they're retired with completes. Blocks on the fence if
+    // the ring is full.
+    DescriptorAllocation AllocateTransient(uint32_t count);
+
+    // Tags the transient descriptors and persistent frees since the previous call with the frame's fence value
+    void Retire(uint64_t fenceValue);
+
+    // Frees everything that was retired with a fence value <= completedValue, which allocations do when they're full
+    void ReleaseCompleted(uint64_t completedValue);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(uint32_t index) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(uint32_t index) const;
+    IDXLDescriptorHeap GetHeap() const;
+    uint32_t GetNumPersistentAllocated() const;
+
+private:
+
+    std::unique_ptr<BindlessDescriptorHeapState> state;
+};
+
+struct DescriptorCacheParams
+{
+    IDXLDevice Device;                                  // If null no descriptors are written, for testing
+    BindlessDescriptorHeap* ResourceHeap = nullptr;     // CBV/SRV/UAV descriptors are persistent allocations from this heap
+    BindlessDescriptorHeap* SamplerHeap = nullptr;      // Sampler descriptors are persistent allocations from this heap
+};
+
+struct DescriptorCacheStats
+{
+    uint32_t NumViews = 0;
+    uint32_t NumSamplers = 0;
+    uint32_t NumEvictedViews = 0;           // Evicted views that still need to be released
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+};
+
+class DescriptorCacheState;
+
+// Returns the existing descriptor, with its reference count bumped, for views and samplers that were already created.
+// A resource's views are evicted when it's destroyed. Safe to call from any thread.
+class DescriptorCache
+{
+
+public:
+
+    DescriptorCache();
+    ~DescriptorCache();
+
+    DescriptorCache(const DescriptorCache&) = delete;
+    DescriptorCache& operator=(const DescriptorCache&) = delete;
+
+    void Initialize(DescriptorCacheParams params);
+    void Shutdown();
+
+    // These return an invalid allocation if the heap is out of persistent descriptors
+    DescriptorAllocation CreateShaderResourceView(IDXLResource resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+    DescriptorAllocation CreateUnorderedAccessView(IDXLResource resource, IDXLResource counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc);
+    DescriptorAllocation CreateConstantBufferView(IDXLResource resource, const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc);    // resource is the buffer containing BufferLocation
+    DescriptorAllocation CreateSampler(const D3D12_SAMPLER_DESC2& desc);
+
+    // Drops a reference, and frees the descriptor once nothing references it
+    void ReleaseView(DescriptorAllocation& descriptor);
+    void ReleaseSampler(DescriptorAllocation& descriptor);
+
+    // Removes the resource's views from the cache, which happens automatically when it's destroyed. Evicted views keep
+    // their descriptors until they're released.
+    void EvictResource(IDXLResource resource);
+
+    DescriptorCacheStats GetStats() const;
+
+private:
+
+    std::unique_ptr<DescriptorCacheState> state;
+};
+
+struct CommandListPoolParams
+{
+    IDXLDevice Device;                      // If null the pool only tracks allocator slots, for testing
+    IDXLFence Fence;                        // Compared against the values passed to Submit
+    DXL_COMMAND_LIST_FEATURE_FLAGS Features = DXL_COMMAND_LIST_FEATURE_FLAG_DEFAULT;
+    float TrimRatio = 4.0f;                 // Allocators whose high-water mark exceeds this multiple of the average get recreated
+    uint64_t MinTrimCommands = 1024;        // Allocators below this high-water mark are never recreated
+};
+
+struct PooledCommandList
+{
+    IDXLCommandAllocator Allocator;
+    IDXLCommandList CommandList;
+    D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_NONE;
+    uint32_t AllocatorIndex = UINT32_MAX;
 
-} // namespace DXL
\ No newline at end of file
+    bool IsValid() const { return AllocatorIndex != UINT32_MAX; }
+};
+
+struct CommandListPoolStats
+{
+    uint32_t NumAllocators = 0;
+    uint32_t NumAllocatorsInFlight = 0;
+    uint32_t NumCommandLists = 0;
+    uint64_t NumTrimmed = 0;
+    uint64_t HighWaterMark = 0;             // Largest number of commands passed to Submit
+};
+
+class CommandListPoolState;
+
+// Hands out command allocator and command list pairs for any queue type, creating more as needed. An allocator is
+// only reset and reused once the fence passes the value it was submitted with, while the command list can be reused
+// right away. Safe to call from any thread.
+class CommandListPool
+{
+
+public:
+
+    CommandListPool();
+    ~CommandListPool();
+
+    CommandListPool(const CommandListPool&) = delete;
+    CommandListPool& operator=(const CommandListPool&) = delete;
+
+    void Initialize(CommandListPoolParams params);
+    void Shutdown();
+
+    // Returns a command list that's been reset with its allocator and is ready for recording
+    PooledCommandList Acquire(D3D12_COMMAND_LIST_TYPE type);
+
+    // Returns the pair to the pool after the command list was executed, with the fence value that's signaled after
+    // it on the queue. Passing 0 returns a list that was never closed or executed, and it gets closed here. D3D12
+    // can't report how much memory an allocator holds on to, so numCommands is an estimate of how much was recorded
+    // (e.g. draws and dispatches), used to find oversized allocators.
+    void Submit(PooledCommandList& commandList, uint64_t fenceValue, uint64_t numCommands = 0);
+
+    // Makes allocators submitted with a fence value <= completedValue available again. This happens automatically
+    // in Acquire when there's a fence, but it can be useful when the completed value is already known.
+    void ReleaseCompleted(uint64_t completedValue);
+
+    CommandListPoolStats GetStats(D3D12_COMMAND_LIST_TYPE type) const;
+
+private:
+
+    std::unique_ptr<CommandListPoolState> state;
+};
+
+struct RecordedCommandList
+{
+    IDXLCommandList CommandList;
+    uint32_t SegmentIndex = UINT32_MAX;     // UINT32_MAX for command lists that only hold barriers between segments
+    uint32_t NumBarriers = 0;               // Number of barriers in a command list between segments
+};
+
+using ExecuteCommandListsCallback = std::function<void(Span<const RecordedCommandList> commandLists)>;
+
+struct ParallelCommandRecorderParams
+{
+    CommandListPool* Pool = nullptr;        // Command lists for segments and the barriers between them come from here
+    IDXLCommandQueue Queue;
+    D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    uint32_t NumThreads = 0;                // 0 means one per core, minus one for the thread calling RecordAndExecute
+    ExecuteCommandListsCallback OnExecute;  // Called instead of Queue.ExecuteCommandLists if set, e.g. for testing
+};
+
+class CommandSegmentState;
+
+// A slice of a frame recorded on one thread
+class CommandSegment
+{
+
+public:
+
+    IDXLCommandList CommandList;
+    uint32_t SegmentIndex = 0;
+    uint64_t NumCommands = 0;               // Optional estimate of the recorded work, passed to CommandListPool::Submit
+
+    // Transition a whole resource. The first transition of each resource in a segment isn't recorded: it's resolved
+    // against the state the previous segments left the resource in, and issued between the segments at submission.
+    void TextureBarrier(IDXLResource texture, D3D12_BARRIER_SYNC syncAfter, D3D12_BARRIER_ACCESS accessAfter, D3D12_BARRIER_LAYOUT layoutAfter);
+    void BufferBarrier(IDXLResource buffer, D3D12_BARRIER_SYNC syncAfter, D3D12_BARRIER_ACCESS accessAfter);
+
+private:
+
+    friend class ParallelCommandRecorderState;
+
+    CommandSegmentState* state = nullptr;
+};
+
+using RecordSegmentFunction = std::function<void(CommandSegment& segment)>;
+
+class ParallelCommandRecorderState;
+
+// Records the segments of a frame on a pool of worker threads, and executes them in their original order with one
+// ExecuteCommandLists call. The state of every resource transitioned through CommandSegment is tracked across segments
+// and frames, so each segment can be recorded without knowing what ran before it.
+class ParallelCommandRecorder
+{
+
+public:
+
+    ParallelCommandRecorder();
+    ~ParallelCommandRecorder();
+
+    ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+    ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+    void Initialize(ParallelCommandRecorderParams params);
+    void Shutdown();
+
+    // Blocks until every segment is recorded and submitted. The fence value is the one that's signaled on the queue
+    // after the command lists, and is used to recycle them.
+    void RecordAndExecute(Span<const RecordSegmentFunction> segments, uint64_t fenceValue);
+
+    // Sets the state a resource is in before the next frame, which is otherwise assumed to match its first use. Use
+    // D3D12_BARRIER_LAYOUT_UNDEFINED for buffers.
+    void SetResourceState(IDXLResource resource, D3D12_BARRIER_SYNC sync, D3D12_BARRIER_ACCESS access, D3D12_BARRIER_LAYOUT layout);
+
+    // Stops tracking a resource, which needs to happen before it's released
+    void RemoveResource(IDXLResource resource);
+
+private:
+
+    std::unique_ptr<ParallelCommandRecorderState> state;
+};
+
+struct TimelineParams
+{
+    IDXLDevice Device;
+    IDXLCommandQueue Queue;                 // Signal() signals the fence on this queue
+    IDXLFence Fence;                        // Created from the device if null
+    uint64_t InitialValue = 0;
+};
+
+class TimelineState;
+
+// Monotonic fence timeline. Signal() hands out tickets, IsComplete() only goes to the fence when the ticket is newer
+// than the last completed value it saw, and waits borrow an event from a process-wide pool. Safe to call from any thread.
+class Timeline
+{
+
+public:
+
+    Timeline();
+    ~Timeline();
+
+    Timeline(const Timeline&) = delete;
+    Timeline& operator=(const Timeline&) = delete;
+
+    void Initialize(TimelineParams params);
+    void Shutdown();
+
+    // Signals the next value on the queue and returns it as the ticket
+    uint64_t Signal();
+    uint64_t GetLastSignaled() const;
+
+    bool IsComplete(uint64_t ticket);
+
+    // Refreshes the cached value from the fence
+    uint64_t GetCompletedValue();
+
+    // Returns false if the timeout elapsed first
+    bool Wait(uint64_t ticket, uint32_t timeout = INFINITE);
+
+    // Signals and waits for everything submitted to the queue so far
+    void WaitForIdle();
+
+    // Waits on several timelines with one event through SetEventOnMultipleFenceCompletion, either for all of the
+    // tickets or for any one of them. All of the timelines need to use the same device.
+    static bool WaitMultiple(Span<Timeline* const> timelines, Span<const uint64_t> tickets, D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags = D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL, uint32_t timeout = INFINITE);
+
+    IDXLFence GetFence() const;
+
+private:
+
+    std::unique_ptr<TimelineState> state;
+};
+
+struct FramePacerParams
+{
+    IDXLSwapChain SwapChain;                // Needs DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT. If null, timings come from AddSample.
+    IDXLCommandQueue Queue;                 // Used to convert GPU timestamps passed to SetGPUFrameEnd
+    uint32_t SyncInterval = 1;              // Should match what's passed to Present
+    uint32_t InitialFrameLatency = 2;
+    uint32_t MinFrameLatency = 1;
+    uint32_t MaxFrameLatency = 3;
+    float TargetLatencyMS = 0.0f;           // Input-to-display target, 0 keeps latency as low as it goes without missing refreshes
+    uint32_t AdjustmentWindow = 60;         // Number of frames between latency adjustments
+    uint32_t MaxMissedPerWindow = 1;        // More frames than this missing their refresh raises the latency
+};
+
+// Timings for one frame, as measured by BeginFrame/EndFrame. Zero means unknown.
+struct FramePacerSample
+{
+    double LatencyWaitMS = 0.0;             // Time blocked on the swap chain's latency waitable object
+    double PresentIntervalMS = 0.0;
+    double InputToDisplayMS = 0.0;          // From the end of BeginFrame to the vblank the frame was shown on
+    uint32_t MissedRefreshes = 0;
+};
+
+struct FramePacerStats
+{
+    uint32_t FrameLatency = 0;
+    double LatencyWaitMS = 0.0;             // These are exponential moving averages
+    double PresentIntervalMS = 0.0;
+    double InputToDisplayMS = 0.0;
+    double CPUToGPUMS = 0.0;                // From EndFrame to the GPU timestamp passed to SetGPUFrameEnd
+    uint64_t NumMissedRefreshes = 0;
+};
+
+class FramePacerState;
+
+// Waits on the swap chain's frame latency waitable object before each frame, measures latency through the swap
+// chain's frame statistics, and adjusts the maximum frame latency: it goes up when frames miss their refresh and
+// comes back down once they stop, backing off further each time a lower latency doesn't hold. Call everything from
+// the thread that presents.
+class FramePacer
+{
+
+public:
+
+    FramePacer();
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    void Initialize(FramePacerParams params);
+    void Shutdown();
+
+    // Call before sampling input, returns the index of the new frame
+    uint64_t BeginFrame();
+
+    // Call right after Present
+    void EndFrame();
+
+    // GPU timestamp for the end of a frame's work (e.g. from a timestamp query), converted to CPU time through the
+    // queue's clock calibration
+    void SetGPUFrameEnd(uint64_t frameIndex, uint64_t gpuTimestamp);
+
+    // Runs the control loop on a sample, EndFrame calls this with measured timings. Useful for simulation.
+    void AddSample(const FramePacerSample& sample);
+
+    // The number of frames the CPU should let the GPU fall behind before waiting on it
+    uint32_t GetFrameLatency() const;
+    FramePacerStats GetStats() const;
+
+private:
+
+    std::unique_ptr<FramePacerState> state;
+};
+
+using GPUTimestampFunction = std::function<uint64_t()>;
+
+struct GPUProfilerParams
+{
+    IDXLDevice Device;                      // If null timestamps come from FakeTimestamps, for testing
+    IDXLCommandQueue Queue;                 // The direct or compute queue that the profiled command lists execute on
+    IDXLFence Fence;                        // Compared against the values passed to EndFrame
+    uint32_t MaxScopesPerFrame = 1024;
+    uint32_t NumFramesInFlight = 3;         // Results are read back this many frames later
+    GPUTimestampFunction FakeTimestamps;
+    uint64_t FakeTimestampFrequency = 1000000;
+};
+
+struct GPUProfileScope
+{
+    const char* Name = nullptr;
+    uint32_t Parent = UINT32_MAX;           // Index of the enclosing scope in the same frame
+    uint32_t Depth = 0;
+    double StartMS = 0.0;                   // CPU time (QueryPerformanceCounter) in milliseconds, through the queue's clock calibration
+    double EndMS = 0.0;
+};
+
+struct GPUProfileFrame
+{
+    uint64_t FrameIndex = UINT64_MAX;
+    std::vector<GPUProfileScope> Scopes;    // In the order they began, so parents come before their children
+};
+
+struct GPUProfileNodeStats
+{
+    const char* Name = nullptr;
+    uint32_t Parent = UINT32_MAX;           // Index of the parent node
+    uint32_t Depth = 0;
+    uint64_t NumSamples = 0;
+    double LastMS = 0.0;
+    double MinMS = 0.0;
+    double AvgMS = 0.0;
+    double MaxMS = 0.0;
+};
+
+class GPUProfilerState;
+
+// Hierarchical GPU timer. Each scope writes a pair of timestamps from the current frame's section of a query heap,
+// the frame's queries are resolved with one ResolveQueryData call in EndFrame, and the results are read back once the
+// fence passes that frame. Scope names need to outlive the profiler (e.g. string literals). Scopes aren't thread-safe,
+// so record them on one thread or use one profiler per thread.
+class GPUProfiler
+{
+
+public:
+
+    GPUProfiler();
+    ~GPUProfiler();
+
+    GPUProfiler(const GPUProfiler&) = delete;
+    GPUProfiler& operator=(const GPUProfiler&) = delete;
+
+    void Initialize(GPUProfilerParams params);
+    void Shutdown();
+
+    // Reads back any finished frames, and waits on the fence if the oldest frame's queries need to be reused
+    void BeginFrame();
+
+    // BeginScope returns false if the frame is out of queries, in which case EndScope shouldn't be called
+    bool BeginScope(IDXLCommandList commandList, const char* name);
+    void EndScope(IDXLCommandList commandList);
+
+    // Resolves the frame's queries on the command list, which needs to execute before the fence is signaled with fenceValue
+    void EndFrame(IDXLCommandList commandList, uint64_t fenceValue);
+
+    // The most recent frame that was read back
+    const GPUProfileFrame& GetLastFrame() const;
+
+    // Statistics for every scope seen so far, merged by their name and parent. Parents come before their children.
+    std::vector<GPUProfileNodeStats> GetStats() const;
+    void ResetStats();
+
+    uint64_t GetNumDroppedScopes() const;
+
+private:
+
+    std::unique_ptr<GPUProfilerState> state;
+};
+
+// Times the commands recorded while it's in scope
+class ScopedGPUTimer
+{
+
+public:
+
+    ScopedGPUTimer(GPUProfiler& profiler, IDXLCommandList commandList, const char* name) : profiler(profiler), commandList(commandList)
+    {
+        started = profiler.BeginScope(commandList, name);
+    }
+
+    ~ScopedGPUTimer()
+    {
+        if (started)
+            profiler.EndScope(commandList);
+    }
+
+    ScopedGPUTimer(const ScopedGPUTimer&) = delete;
+    ScopedGPUTimer& operator=(const ScopedGPUTimer&) = delete;
+
+private:
+
+    GPUProfiler& profiler;
+    IDXLCommandList commandList;
+    bool started = false;
+};
+
+struct TraceEvent
+{
+    const char* Name = nullptr;             // Names and categories need to outlive the sink (e.g. string literals)
+    const char* Category = nullptr;
+    uint64_t StartNS = 0;                   // From GetTraceTime()
+    uint64_t DurationNS = 0;
+    uint32_t ThreadID = 0;
+};
+
+struct TraceThreadName
+{
+    uint32_t ThreadID = 0;
+    std::string Name;
+};
+
+struct TraceSinkParams
+{
+    uint32_t EventsPerThread = 16 * 1024;   // Events a thread can buffer before the flush catches up, after that they're dropped
+    uint32_t FlushIntervalMS = 10;
+    bool StartFlushThread = true;           // Otherwise call Flush() yourself
+};
+
+class TraceSinkState;
+
+// Collects DXL_TRACE_SCOPE and GPUProfiler scopes, and writes them as Chrome trace event JSON. Only one sink can be
+// initialized at a time, and scopes that end during or after Shutdown are dropped.
+class TraceSink
+{
+
+public:
+
+    TraceSink();
+    ~TraceSink();
+
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+
+    void Initialize(TraceSinkParams params);
+    void Shutdown();
+
+    // Names the calling thread in the trace
+    void SetThreadName(const char* name);
+
+    // Adds the scopes of a frame that GPUProfiler read back, on a separate track for each track name
+    void AddGPUFrame(const GPUProfileFrame& frame, const char* trackName = "GPU");
+
+    // Moves buffered events into the trace
+    void Flush();
+
+    // Flushes and writes everything recorded so far
+    bool WriteChromeTrace(const char* filePath);
+
+    void Clear();
+    uint64_t GetNumEvents() const;
+    uint64_t GetNumDroppedEvents() const;
+
+private:
+
+    std::unique_ptr<TraceSinkState> state;
+};
+
+// Nanoseconds on the QueryPerformanceCounter clock, the same as the CPU times in GPUProfileScope
+uint64_t GetTraceTime();
+
+std::string FormatChromeTrace(Span<const TraceEvent> events, Span<const TraceThreadName> threadNames = Span<const TraceThreadName>());
+
+// Records the lifetime of the object on the active TraceSink, if there is one
+class TraceScope
+{
+
+public:
+
+    explicit TraceScope(const char* name, const char* category = "DXL");
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+
+    const char* name = nullptr;
+    const char* category = nullptr;
+    uint64_t startTime = 0;
+};
+
+struct TextureFootprints
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;    // Offsets are relative to the start of the first subresource
+    std::vector<uint32_t> NumRows;
+    std::vector<uint64_t> RowSizes;                             // Bytes of actual data in each row, without the pitch padding
+    uint64_t TotalSize = 0;
+};
+
+// Without a device the footprints are computed on the CPU, which only handles single-plane formats
+TextureFootprints ComputeTextureFootprints(IDXLDevice device, const D3D12_RESOURCE_DESC1& desc);
+
+// Copies subresources into staging memory laid out as footprints.Layouts[firstSubresource...], re-pitching each row
+void PackSubresources(void* stagingMemory, const TextureFootprints& footprints, uint32_t firstSubresource, Span<const D3D12_SUBRESOURCE_DATA> subresources);
+
+struct TextureUploaderParams
+{
+    IDXLDevice Device;                      // If null uploads are only packed into CPU memory, for testing
+    IDXLCommandQueue CopyQueue;             // A D3D12_COMMAND_LIST_TYPE_COPY queue that the copies are executed on
+    uint64_t StagingSize = 64 * 1024 * 1024;
+};
+
+struct TextureUploaderStats
+{
+    uint64_t NumUploads = 0;
+    uint64_t NumSubresources = 0;
+    uint64_t NumBytes = 0;
+    uint64_t NumFlushes = 0;
+    uint32_t NumCachedFootprints = 0;
+};
+
+class TextureUploaderState;
+
+// Packs texture uploads into a staging ring and batches the copies on a copy queue until Flush(). Destination textures
+// need to be in a layout that copy queues can access. Safe to call from any thread.
+class TextureUploader
+{
+
+public:
+
+    TextureUploader();
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    void Initialize(TextureUploaderParams params);
+    void Shutdown();
+
+    // Returns the fence value that's signaled once the copies are done, or 0 if a subresource doesn't fit in the
+    // staging ring. The copies are executed by the next Flush(), which also happens when the ring fills up.
+    uint64_t Upload(IDXLResource dstTexture, const D3D12_RESOURCE_DESC1& desc, Span<const D3D12_SUBRESOURCE_DATA> subresources, uint32_t firstSubresource = 0);
+
+    // Executes the pending copies and returns the fence value that they signal
+    uint64_t Flush();
+
+    // Makes the queue wait on the GPU for the copies that signal fenceValue, which need to have been flushed
+    void QueueWait(IDXLCommandQueue queue, uint64_t fenceValue);
+
+    bool IsComplete(uint64_t fenceValue);
+    void WaitForIdle();
+
+    const TextureFootprints& GetFootprints(const D3D12_RESOURCE_DESC1& desc);
+    TextureUploaderStats GetStats() const;
+    IDXLFence GetFence() const;
+
+private:
+
+    std::unique_ptr<TextureUploaderState> state;
+};
+
+struct ReadbackManagerParams
+{
+    IDXLDevice Device;                      // If null buffers are CPU memory and no copies are recorded, for testing
+    IDXLFence Fence;                        // Compared against the values passed to Submit, optional when ProcessCompleted is used
+    uint64_t MinBufferSize = 64 * 1024;     // Buffers are pooled in power of 2 sizes starting from this
+    uint32_t MaxFreeBuffersPerSize = 4;     // Free buffers beyond this are released instead of pooled
+    bool StartWorkerThread = true;          // Otherwise callbacks run on the thread that calls Update/ProcessCompleted
+};
+
+struct ReadbackData
+{
+    uint64_t Ticket = 0;
+    const void* Data = nullptr;
+    uint64_t Size = 0;
+
+    // Only filled out for textures, where each row starts at a multiple of Footprint.RowPitch
+    D3D12_SUBRESOURCE_FOOTPRINT Footprint = { };
+    uint32_t NumRows = 0;
+    uint64_t RowSize = 0;
+};
+
+// The data is only valid for the duration of the call
+using ReadbackCallback = std::function<void(const ReadbackData& data)>;
+
+struct ReadbackManagerStats
+{
+    uint32_t NumPending = 0;                // Recorded or waiting on the GPU
+    uint32_t NumReady = 0;                  // Completed and waiting for Read()
+    uint32_t NumBuffers = 0;
+    uint32_t NumFreeBuffers = 0;
+    uint64_t NumBytesAllocated = 0;
+};
+
+class ReadbackManagerState;
+
+// Copies buffers and textures into pooled READBACK buffers without blocking on the GPU. Completed data goes to the
+// ticket's callback, or waits for Read() if it didn't have one. Safe to call from any thread.
+class ReadbackManager
+{
+
+public:
+
+    ReadbackManager();
+    ~ReadbackManager();
+
+    ReadbackManager(const ReadbackManager&) = delete;
+    ReadbackManager& operator=(const ReadbackManager&) = delete;
+
+    void Initialize(ReadbackManagerParams params);
+
+    // Runs the callbacks of completed copies and drops the rest. Without a fence the GPU needs to be idle, and copies
+    // that were never submitted must not be executed afterwards.
+    void Shutdown();
+
+    // Returns the ticket for the copy. The source needs to be in a layout/state that it can be copied from.
+    uint64_t ReadBuffer(IDXLCommandList commandList, IDXLResource srcBuffer, uint64_t srcOffset, uint64_t size, ReadbackCallback callback = nullptr);
+    uint64_t ReadTexture(IDXLCommandList commandList, IDXLResource srcTexture, const D3D12_RESOURCE_DESC1& desc, uint32_t subresource, ReadbackCallback callback = nullptr);
+
+    // Tags everything recorded since the previous call with the fence value that's signaled after it's executed
+    void Submit(uint64_t fenceValue);
+
+    // Checks the fence without waiting, and processes everything that completed
+    void Update();
+    void ProcessCompleted(uint64_t completedValue);
+
+    bool IsReady(uint64_t ticket) const;
+
+    // Calls the function with a ready ticket's data and frees the ticket, or returns false if it isn't ready
+    bool Read(uint64_t ticket, const ReadbackCallback& function);
+
+    // Frees a ticket without reading it, whether or not the copy finished
+    void Discard(uint64_t ticket);
+
+    // Waits for the worker thread to finish running the callbacks for everything that already completed
+    void WaitForCallbacks();
+
+    ReadbackManagerStats GetStats() const;
+
+private:
+
+    std::unique_ptr<ReadbackManagerState> state;
+};
+
+struct ResidencyManagerParams
+{
+    IDXLDevice Device;                      // If null nothing is actually made resident or evicted, for simulating the policy
+    IDXLFence Fence;                        // Compared against the values passed to ExecuteCommandLists, optional when ProcessCompleted is used
+    uint64_t Budget = 0;                    // e.g. from IDXGIAdapter3::QueryVideoMemoryInfo, 0 means nothing gets evicted
+    float EvictionTarget = 0.9f;            // Going over budget evicts down to this fraction of it, so that evictions happen in batches
+};
+
+// Handles of the objects that a set of command lists use, filled out while recording them
+struct ResidencySet
+{
+    std::vector<uint32_t> Handles;
+
+    void Insert(uint32_t handle) { Handles.push_back(handle); }
+    void Clear() { Handles.clear(); }
+};
+
+struct ResidencyManagerStats
+{
+    uint32_t NumObjects = 0;
+    uint32_t NumResident = 0;
+    uint64_t ResidentBytes = 0;
+    uint64_t Budget = 0;
+    uint64_t NumMadeResident = 0;
+    uint64_t NumEvicted = 0;
+    uint64_t BytesMadeResident = 0;
+    uint64_t BytesEvicted = 0;
+    uint64_t NumOverBudget = 0;             // Submissions that still didn't fit after evicting everything that could be evicted
+};
+
+class ResidencyManagerState;
+
+// Decides which heaps and committed resources are resident. Objects are kept in an LRU ordered by when they were last
+// submitted, and before command lists are executed the objects that they use are made resident with
+// EnqueueMakeResident, with the queue waiting on the fence that it signals. When that goes over budget, the least
+// recently used objects that the GPU is done with get evicted in one batch. Safe to call from any thread.
+class ResidencyManager
+{
+
+public:
+
+    static constexpr uint32_t InvalidHandle = UINT32_MAX;
+
+    ResidencyManager();
+    ~ResidencyManager();
+
+    ResidencyManager(const ResidencyManager&) = delete;
+    ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+    void Initialize(ResidencyManagerParams params);
+    void Shutdown();
+
+    // Objects are resident when they're created, unless they were created with D3D12_HEAP_FLAG_CREATE_NOT_RESIDENT.
+    // Without a device the pageable is never used, so it can be null.
+    uint32_t TrackObject(ID3D12Pageable* pageable, uint64_t size, bool isResident = true);
+
+    // The GPU needs to be done with the object
+    void UntrackObject(uint32_t handle);
+
+    void SetPriority(uint32_t handle, D3D12_RESIDENCY_PRIORITY priority);
+
+    // Makes everything in the sets resident and executes the command lists. The fence value needs to be signaled on
+    // the queue after this returns. There's only one timeline of fence values, so every submission needs to go to the
+    // same queue. Objects used on another queue can't be told apart from ones the GPU is done with.
+    void ExecuteCommandLists(IDXLCommandQueue queue, Span<ID3D12CommandList* const> commandLists, Span<const ResidencySet* const> residencySets, uint64_t fenceValue);
+
+    // Lets objects last used with a fence value <= completedValue be evicted. ExecuteCommandLists does this
+    // automatically when there's a fence.
+    void ProcessCompleted(uint64_t completedValue);
+
+    void SetBudget(uint64_t budget);
+    bool IsResident(uint32_t handle) const;
+    ResidencyManagerStats GetStats() const;
+
+private:
+
+    std::unique_ptr<ResidencyManagerState> state;
+};
+
+struct TransientPackingRequest
+{
+    uint64_t Size = 0;
+    uint64_t Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    uint32_t FirstPass = 0;
+    uint32_t LastPass = 0;                  // Inclusive
+    uint32_t HeapGroup = 0;                 // Resources can only share heaps with resources in the same group
+};
+
+struct TransientPlacement
+{
+    uint32_t HeapIndex = UINT32_MAX;
+    uint64_t Offset = 0;
+};
+
+struct TransientHeapLayout
+{
+    uint32_t HeapGroup = 0;
+    uint64_t Size = 0;
+};
+
+// Places resources so that two resources only share memory when their pass ranges don't overlap. Resources are placed
+// largest first at the lowest offset that doesn't collide with anything already placed that's alive at the same
+// time, and a heap only gets added to a group when a resource won't fit under maxHeapSize in any of its heaps. Each
+// resource is only checked against the placed resources that start close enough to overlap with it, but with long
+// lifetimes that can be all of them, so this is O(n^2) in the worst case.
+void PackTransientResources(Span<const TransientPackingRequest> requests, uint64_t maxHeapSize, std::vector<TransientPlacement>& placements, std::vector<TransientHeapLayout>& heaps);
+
+struct TransientResourceAllocatorParams
+{
+    IDXLDevice Device;                      // If null only placements are computed (with estimated sizes), for testing
+    IDXLFence Fence;                        // Compared against the values passed to Retire
+    uint64_t MaxHeapSize = 256 * 1024 * 1024;
+};
+
+struct TransientResourceDesc
+{
+    D3D12_RESOURCE_DESC1 Desc = { };
+    const D3D12_CLEAR_VALUE* OptimizedClearValue = nullptr;
+    uint32_t FirstPass = 0;
+    uint32_t LastPass = 0;                  // Inclusive
+
+    // How the first pass uses the resource, which is where the aliasing barrier transitions it to
+    D3D12_BARRIER_SYNC FirstSync = D3D12_BARRIER_SYNC_ALL;
+    D3D12_BARRIER_ACCESS FirstAccess = D3D12_BARRIER_ACCESS_COMMON;
+    D3D12_BARRIER_LAYOUT FirstLayout = D3D12_BARRIER_LAYOUT_COMMON;
+};
+
+struct TransientResourceStats
+{
+    uint32_t NumResources = 0;
+    uint32_t NumHeaps = 0;
+    uint32_t NumResourcesCreated = 0;       // In the last Compile, the rest were reused from the previous one
+    uint64_t HeapBytes = 0;
+    uint64_t UnaliasedBytes = 0;            // What the resources would need without aliasing
+};
+
+class TransientResourceAllocatorState;
+
+// Places per-frame resources that only live for a few passes into shared heaps, aliasing the memory of resources whose
+// pass ranges don't overlap. Add the frame's resources, then Compile() places them and creates the placed resources,
+// reusing resources and heaps from the previous frame when their placement didn't change. Before a pass, the resources
+// that it uses first need to take over their memory with the barriers from GetAcquireBarriers, which discard the
+// previous contents, so the first pass has to fully write them. Not thread safe.
+class TransientResourceAllocator
+{
+
+public:
+
+    TransientResourceAllocator();
+    ~TransientResourceAllocator();
+
+    TransientResourceAllocator(const TransientResourceAllocator&) = delete;
+    TransientResourceAllocator& operator=(const TransientResourceAllocator&) = delete;
+
+    void Initialize(TransientResourceAllocatorParams params);
+    void Shutdown();
+
+    // Starts a new frame of resources. Resources from the previous frame stay valid until the next Compile.
+    void Reset();
+
+    // Returns the index of the resource in this frame
+    uint32_t AddResource(const TransientResourceDesc& desc);
+
+    void Compile();
+
+    IDXLResource GetResource(uint32_t resourceIndex) const;
+    TransientPlacement GetPlacement(uint32_t resourceIndex) const;
+
+    // Appends the barriers for the resources whose first pass is passIndex
+    void GetAcquireBarriers(uint32_t passIndex, std::vector<D3D12_TEXTURE_BARRIER>& textureBarriers, std::vector<D3D12_BUFFER_BARRIER>& bufferBarriers) const;
+
+    // Records the barriers from GetAcquireBarriers on the command list, with a single Barrier call
+    void AcquireResources(IDXLCommandList commandList, uint32_t passIndex) const;
+
+    // Resources and heaps replaced by Compile are released once the fence passes the value of the next Retire call
+    void Retire(uint64_t fenceValue);
+    void ReleaseCompleted(uint64_t completedValue);
+
+    TransientResourceStats GetStats() const;
+
+private:
+
+    std::unique_ptr<TransientResourceAllocatorState> state;
+};
+
+// How a pass uses a resource. Buffers ignore the layout.
+struct RenderGraphUsage
+{
+    D3D12_BARRIER_SYNC Sync = D3D12_BARRIER_SYNC_NONE;
+    D3D12_BARRIER_ACCESS Access = D3D12_BARRIER_ACCESS_NO_ACCESS;
+    D3D12_BARRIER_LAYOUT Layout = D3D12_BARRIER_LAYOUT_UNDEFINED;
+};
+
+using RenderGraphPassFunction = std::function<void(IDXLCommandList commandList)>;
+
+struct RenderGraphParams
+{
+    TransientResourceAllocator* TransientAllocator = nullptr;  // Needed for CreateTexture/CreateBuffer
+    bool EnableSplitBarriers = true;
+};
+
+struct RenderGraphStats
+{
+    uint32_t NumPasses = 0;
+    uint32_t NumCulledPasses = 0;
+    uint32_t NumBarriers = 0;
+    uint32_t NumSplitBarriers = 0;          // Counted once, although each one is recorded as a begin and an end barrier
+    uint32_t NumBarrierCalls = 0;
+    double CompileTimeMS = 0.0;
+};
+
+class RenderGraphState;
+
+// Records a frame as a list of passes that declare how they use each resource. Compile() culls passes whose results
+// are never used, places transient resources through the TransientResourceAllocator, and works out the minimal
+// enhanced barriers between passes. Execute() then records all the transitions at each pass boundary with one
+// Barrier() call. When there are passes in between two uses of a resource, the transition is split so that it can
+// overlap with them. Names need to outlive the graph (e.g. string literals). Compile() is linear in the number of passes
+// and usages, except for placing the transient resources, which is O(n^2) in the number of them (see
+// PackTransientResources). Not thread safe.
+class RenderGraph
+{
+
+public:
+
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    RenderGraph();
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    void Initialize(RenderGraphParams params);
+    void Shutdown();
+
+    // Clears the passes and resources for the next frame
+    void Reset();
+
+    // Resources that live outside of the graph, in the state they're in before it executes. Passes that write to them
+    // are never culled.
+    uint32_t ImportTexture(IDXLResource texture, RenderGraphUsage initialUsage);
+    uint32_t ImportBuffer(IDXLResource buffer, RenderGraphUsage initialUsage);
+
+    // Resources that only exist for the frame, with memory that's aliased with other transient resources. Their first
+    // use discards the contents, so it has to fully write them.
+    uint32_t CreateTexture(const D3D12_RESOURCE_DESC1& desc, const D3D12_CLEAR_VALUE* optimizedClearValue = nullptr);
+    uint32_t CreateBuffer(uint64_t size, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+
+    // Transitions an imported resource to this usage after the last pass (e.g. the back buffer to PRESENT)
+    void SetFinalUsage(uint32_t resourceIndex, RenderGraphUsage finalUsage);
+
+    uint32_t AddPass(const char* name, RenderGraphPassFunction function);
+
+    // Passes with side effects are never culled
+    void SetSideEffects(uint32_t passIndex);
+
+    void Read(uint32_t passIndex, uint32_t resourceIndex, RenderGraphUsage usage);
+    void Write(uint32_t passIndex, uint32_t resourceIndex, RenderGraphUsage usage);
+
+    void Compile();
+
+    // Records the passes that weren't culled, along with their barriers. Without a command list only the pass functions
+    // are called.
+    void Execute(IDXLCommandList commandList);
+
+    // Only valid after Compile for transient resources
+    IDXLResource GetResource(uint32_t resourceIndex) const;
+
+    bool IsPassCulled(uint32_t passIndex) const;
+
+    // The barriers that Execute records before a pass, or after the last one when passIndex is the number of passes
+    void GetPassBarriers(uint32_t passIndex, std::vector<D3D12_TEXTURE_BARRIER>& textureBarriers, std::vector<D3D12_BUFFER_BARRIER>& bufferBarriers) const;
+
+    RenderGraphStats GetStats() const;
+
+private:
+
+    std::unique_ptr<RenderGraphState> state;
+};
+
+#endif  // DXL_ENABLE_EXTENSIONS
+
+} // namespace DXL
+
+#if DXL_ENABLE_EXTENSIONS
+#define DXL_TRACE_CONCAT_INNER(a, b) a##b
+#define DXL_TRACE_CONCAT(a, b) DXL_TRACE_CONCAT_INNER(a, b)
+#define DXL_TRACE_SCOPE(name) DXL::TraceScope DXL_TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define DXL_TRACE_SCOPE(name)
+#endif
\ No newline at end of file